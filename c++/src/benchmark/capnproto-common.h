@@ -101,6 +101,37 @@ struct Packed {
   }
 };
 
+template <typename Inner>
+class TrustedReader: public Inner {
+  // Wraps a MessageReader so that getRoot() reads through a TrustedMessageReader.
+
+public:
+  template <typename... Params>
+  TrustedReader(Params&&... params): Inner(kj::fwd<Params>(params)...), trusted(*this) {}
+
+  template <typename RootType>
+  typename RootType::Reader getRoot() {
+    return trusted.template getRoot<RootType>();
+  }
+
+private:
+  TrustedMessageReader trusted;
+};
+
+struct Trusted {
+  // Same bytes as Uncompressed, but the receiver reads them without bounds checks or traversal
+  // limits, as if it had validated the messages once when storing them. Since each message is
+  // only read once here, validation itself is not included; see validateMessage().
+
+  typedef kj::FdInputStream& BufferedInput;
+  typedef TrustedReader<InputStreamMessageReader> MessageReader;
+  typedef TrustedReader<Uncompressed::ArrayMessageReader> ArrayMessageReader;
+
+  static inline void write(kj::OutputStream& output, MessageBuilder& builder) {
+    writeMessage(output, builder);
+  }
+};
+
 #if HAVE_SNAPPY
 static byte snappyReadBuffer[SNAPPY_BUFFER_SIZE];
 static byte snappyWriteBuffer[SNAPPY_BUFFER_SIZE];
@@ -405,6 +436,7 @@ struct BenchmarkMethods {
 struct BenchmarkTypes {
   typedef capnp::Uncompressed Uncompressed;
   typedef capnp::Packed Packed;
+  typedef capnp::Trusted Trusted;
 #if HAVE_SNAPPY
   typedef capnp::SnappyCompressed SnappyCompressed;
 #endif  // HAVE_SNAPPY
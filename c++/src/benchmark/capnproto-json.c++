@@ -0,0 +1,152 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Compares the two ways of encoding a message as JSON: building a kj::String with
+// JsonCodec::encode(value), versus streaming it with JsonCodec::encode(value, output).  The
+// output goes to a stream that discards it, so only the encoding itself is measured.
+//
+// Usage:  capnproto-json [iters [cars]]
+
+#include "carsales.capnp.h"
+#include "common.h"
+#include <capnp/compat/json.h>
+#include <capnp/message.h>
+#include <kj/io.h>
+#include <kj/string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <iostream>
+#include <iomanip>
+
+namespace capnp {
+namespace benchmark {
+namespace capnp {
+
+void randomCar(Car::Builder car) {
+  static const char* const MAKES[] = { "Toyota", "GM", "Ford", "Honda", "Tesla" };
+  static const char* const MODELS[] = { "Camry", "Prius", "Volt", "Accord", "Leaf", "Model S" };
+
+  car.setMake(MAKES[fastRand(sizeof(MAKES) / sizeof(MAKES[0]))]);
+  car.setModel(MODELS[fastRand(sizeof(MODELS) / sizeof(MODELS[0]))]);
+  car.setColor((Color)fastRand((uint)Color::SILVER + 1));
+  car.setSeats(2 + fastRand(6));
+  car.setDoors(2 + fastRand(3));
+  for (auto wheel: car.initWheels(4)) {
+    wheel.setDiameter(25 + fastRand(15));
+    wheel.setAirPressure(30 + fastRandDouble(20));
+    wheel.setSnowTires(fastRand(16) == 0);
+  }
+  car.setLength(170 + fastRand(150));
+  car.setWidth(48 + fastRand(36));
+  car.setHeight(54 + fastRand(48));
+  car.setWeight(car.getLength() * car.getWidth() * car.getHeight() / 200);
+  auto engine = car.initEngine();
+  engine.setHorsepower(100 * fastRand(400));
+  engine.setCylinders(4 + 2 * fastRand(3));
+  engine.setCc(800 + fastRand(10000));
+  engine.setUsesGas(true);
+  engine.setUsesElectric(fastRand(2));
+  car.setFuelCapacity(10.0 + fastRandDouble(30.0));
+  car.setFuelLevel(fastRandDouble(car.getFuelCapacity()));
+  car.setHasPowerWindows(fastRand(2));
+  car.setHasPowerSteering(fastRand(2));
+  car.setHasCruiseControl(fastRand(2));
+  car.setCupHolders(fastRand(12));
+  car.setHasNavSystem(fastRand(2));
+}
+
+class DiscardingOutputStream: public kj::OutputStream {
+public:
+  uint64_t bytes = 0;
+
+  void write(const void* buffer, size_t size) override {
+    bytes += size;
+  }
+};
+
+uint64_t cpuNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+long peakRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+void report(const char* name, uint64_t bytes, uint64_t nanos) {
+  std::cout << std::setw(30) << std::left << name
+            << std::setw(10) << std::right << nanos / 1000000 << " ms"
+            << std::setw(10) << std::right << std::fixed << std::setprecision(1)
+            << (bytes / 1048576.0) / (nanos / 1000000000.0) << " MiB/s"
+            << std::setw(10) << std::right << peakRssKb() / 1024 << " MB peak RSS"
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  uint iters = argc > 1 ? strtoul(argv[1], nullptr, 0) : 20;
+  uint carCount = argc > 2 ? strtoul(argv[2], nullptr, 0) : 20000;
+
+  MallocMessageBuilder message;
+  auto cars = message.initRoot<ParkingLot>().initCars(carCount);
+  for (auto car: cars) {
+    randomCar(car);
+  }
+  auto lot = message.getRoot<ParkingLot>().asReader();
+
+  JsonCodec json;
+  DiscardingOutputStream sizer;
+  json.encode(lot, sizer);
+  std::cout << "Encoding " << carCount << " cars, " << sizer.bytes
+            << " bytes of JSON, " << iters << " times" << std::endl;
+
+  // Streaming first, since it should barely move the peak RSS of the process.
+  {
+    DiscardingOutputStream output;
+    uint64_t start = cpuNanos();
+    for (uint i = 0; i < iters; i++) {
+      json.encode(lot, output);
+    }
+    report("encode() to stream", output.bytes, cpuNanos() - start);
+  }
+
+  {
+    DiscardingOutputStream output;
+    uint64_t start = cpuNanos();
+    for (uint i = 0; i < iters; i++) {
+      kj::String text = json.encode(lot);
+      output.write(text.begin(), text.size());
+    }
+    report("encode() to kj::String", output.bytes, cpuNanos() - start);
+  }
+
+  return 0;
+}
+
+}  // namespace capnp
+}  // namespace benchmark
+}  // namespace capnp
+
+int main(int argc, char* argv[]) {
+  return capnp::benchmark::capnp::main(argc, argv);
+}
@@ -0,0 +1,180 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Measures how readPackedMessagesParallel() scales with the number of threads, unpacking a buffer
+// of packed carsales messages such as a bulk replay would read from disk.
+//
+// Usage:  capnproto-packed-parallel [messages [maxThreads]]
+
+#include "carsales.capnp.h"
+#include "common.h"
+#include <capnp/serialize-packed.h>
+#include <capnp/message.h>
+#include <kj/io.h>
+#include <time.h>
+#include <iostream>
+#include <iomanip>
+
+namespace capnp {
+namespace benchmark {
+namespace capnp {
+
+template <typename ReaderOrBuilder>
+uint64_t carValue(ReaderOrBuilder car) {
+  // Do not think too hard about realism.
+
+  uint64_t result = 0;
+
+  result += car.getSeats() * 200;
+  result += car.getDoors() * 350;
+  for (auto wheel: car.getWheels()) {
+    result += wheel.getDiameter() * wheel.getDiameter();
+    result += wheel.getSnowTires() ? 100 : 0;
+  }
+
+  result += car.getLength() * car.getWidth() * car.getHeight() / 50;
+
+  auto engine = car.getEngine();
+  result += engine.getHorsepower() * 40;
+  if (engine.getUsesElectric()) {
+    if (engine.getUsesGas()) {
+      // hybrid
+      result += 5000;
+    } else {
+      result += 3000;
+    }
+  }
+
+  result += car.getHasPowerWindows() ? 100 : 0;
+  result += car.getHasPowerSteering() ? 200 : 0;
+  result += car.getHasCruiseControl() ? 400 : 0;
+  result += car.getHasNavSystem() ? 2000 : 0;
+
+  result += car.getCupHolders() * 25;
+
+  return result;
+}
+
+void randomCar(Car::Builder car) {
+  // Do not think too hard about realism.
+
+  static const char* const MAKES[] = { "Toyota", "GM", "Ford", "Honda", "Tesla" };
+  static const char* const MODELS[] = { "Camry", "Prius", "Volt", "Accord", "Leaf", "Model S" };
+
+  car.setMake(MAKES[fastRand(sizeof(MAKES) / sizeof(MAKES[0]))]);
+  car.setModel(MODELS[fastRand(sizeof(MODELS) / sizeof(MODELS[0]))]);
+
+  car.setColor((Color)fastRand((uint)Color::SILVER + 1));
+  car.setSeats(2 + fastRand(6));
+  car.setDoors(2 + fastRand(3));
+
+  for (auto wheel: car.initWheels(4)) {
+    wheel.setDiameter(25 + fastRand(15));
+    wheel.setAirPressure(30 + fastRandDouble(20));
+    wheel.setSnowTires(fastRand(16) == 0);
+  }
+
+  car.setLength(170 + fastRand(150));
+  car.setWidth(48 + fastRand(36));
+  car.setHeight(54 + fastRand(48));
+  car.setWeight(car.getLength() * car.getWidth() * car.getHeight() / 200);
+
+  auto engine = car.initEngine();
+  engine.setHorsepower(100 * fastRand(400));
+  engine.setCylinders(4 + 2 * fastRand(3));
+  engine.setCc(800 + fastRand(10000));
+  engine.setUsesGas(true);
+  engine.setUsesElectric(fastRand(2));
+
+  car.setFuelCapacity(10.0 + fastRandDouble(30.0));
+  car.setFuelLevel(fastRandDouble(car.getFuelCapacity()));
+  car.setHasPowerWindows(fastRand(2));
+  car.setHasPowerSteering(fastRand(2));
+  car.setHasCruiseControl(fastRand(2));
+  car.setCupHolders(fastRand(12));
+  car.setHasNavSystem(fastRand(2));
+}
+
+uint64_t wallNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int main(int argc, char* argv[]) {
+  uint messageCount = argc > 1 ? strtoul(argv[1], nullptr, 0) : 20000;
+  uint maxThreads = argc > 2 ? strtoul(argv[2], nullptr, 0) : sysconf(_SC_NPROCESSORS_ONLN);
+
+  kj::VectorOutputStream packed;
+  uint64_t expected = 0;
+  for (uint i = 0; i < messageCount; i++) {
+    MallocMessageBuilder message;
+    for (auto car: message.initRoot<ParkingLot>().initCars(fastRand(200))) {
+      randomCar(car);
+      expected += carValue(car);
+    }
+    writePackedMessage(packed, message);
+  }
+  auto bytes = packed.getArray();
+
+  std::cout << messageCount << " messages, " << bytes.size() / 1048576 << " MiB packed"
+            << std::endl;
+  std::cout << std::setw(8) << std::right << "Threads"
+            << std::setw(12) << std::right << "Time (ms)"
+            << std::setw(16) << std::right << "Packed MiB/s"
+            << std::setw(10) << std::right << "Speedup" << std::endl;
+
+  uint64_t baseline = 0;
+  for (uint threads = 1; threads <= kj::max(maxThreads, 1u); threads *= 2) {
+    uint64_t total = 0;
+    uint64_t start = wallNanos();
+    readPackedMessagesParallel(bytes, threads, [&total](size_t, MessageReader& message) {
+      uint64_t value = 0;
+      for (auto car: message.getRoot<ParkingLot>().getCars()) {
+        value += carValue(car);
+      }
+      __atomic_fetch_add(&total, value, __ATOMIC_RELAXED);
+    });
+    uint64_t nanos = wallNanos() - start;
+    if (total != expected) {
+      std::cerr << "wrong total with " << threads << " threads" << std::endl;
+      return 1;
+    }
+    if (threads == 1) baseline = nanos;
+
+    std::cout << std::setw(8) << std::right << threads
+              << std::setw(12) << std::right << nanos / 1000000
+              << std::setw(16) << std::right << std::fixed << std::setprecision(1)
+              << (bytes.size() / 1048576.0) / (nanos / 1000000000.0)
+              << std::setw(9) << std::right << std::setprecision(2)
+              << double(baseline) / nanos << "x" << std::endl;
+  }
+
+  return 0;
+}
+
+}  // namespace capnp
+}  // namespace benchmark
+}  // namespace capnp
+
+int main(int argc, char* argv[]) {
+  return capnp::benchmark::capnp::main(argc, argv);
+}
@@ -266,6 +266,9 @@ uint64_t doBenchmark3(const std::string& mode, const std::string& reuse,
   } else if (compression == "packed") {
     return doBenchmark2<BenchmarkTypes, TestCase, typename BenchmarkTypes::Packed>(
         mode, reuse, iters);
+  } else if (compression == "trusted") {
+    return doBenchmark2<BenchmarkTypes, TestCase, typename BenchmarkTypes::Trusted>(
+        mode, reuse, iters);
 #if HAVE_SNAPPY
   } else if (compression == "snappy") {
     return doBenchmark2<BenchmarkTypes, TestCase, typename BenchmarkTypes::SnappyCompressed>(
@@ -158,6 +158,7 @@ struct BenchmarkMethods {
 struct BenchmarkTypes {
   typedef void Uncompressed;
   typedef void Packed;
+  typedef void Trusted;
 #if HAVE_SNAPPY
   typedef void SnappyCompressed;
 #endif  // HAVE_SNAPPY
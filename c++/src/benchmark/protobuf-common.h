@@ -342,6 +342,7 @@ struct BenchmarkMethods {
 struct BenchmarkTypes {
   typedef protobuf::Uncompressed Uncompressed;
   typedef protobuf::Uncompressed Packed;
+  typedef protobuf::Uncompressed Trusted;
 #if HAVE_SNAPPY
   typedef protobuf::SnappyCompressed SnappyCompressed;
 #endif  // HAVE_SNAPPY
@@ -122,7 +122,8 @@ enum class Reuse {
 enum class Compression {
   NONE,
   PACKED,
-  SNAPPY
+  SNAPPY,
+  TRUSTED
 };
 
 TestResult runTest(Product product, TestCase testCase, Mode mode, Reuse reuse,
@@ -183,6 +184,9 @@ TestResult runTest(Product product, TestCase testCase, Mode mode, Reuse reuse,
     case Compression::SNAPPY:
       argv[3] = strdup("snappy");
       break;
+    case Compression::TRUSTED:
+      argv[3] = strdup("trusted");
+      break;
   }
 
   char itersStr[64];
@@ -266,6 +270,24 @@ void reportResults(const char* name, uint64_t iters, TestResult results) {
        << endl;
 }
 
+void reportThroughput(const char* name, uint64_t bytes, int64_t nanos) {
+  // Reports how many (unpacked) bytes per second of user CPU time were processed.  `nanos` is
+  // usually a difference between two runs, so it can come out zero or negative when the
+  // difference is lost in measurement noise; there's no meaningful rate to print then.
+  cout << setw(40) << left << name;
+  if (nanos <= 0) {
+    cout << setw(10) << right << "n/a" << " (time delta not measurable)" << endl;
+    return;
+  }
+  std::ios::fmtflags flags = cout.flags();
+  std::streamsize precision = cout.precision();
+  cout << setw(10) << right << fixed << setprecision(1)
+       << (bytes / 1048576.0) / (nanos / 1000000000.0) << " MiB/s"
+       << endl;
+  cout.flags(flags);
+  cout.precision(precision);
+}
+
 void reportComparisonHeader() {
   cout << setw(40) << left << "Measure"
        << setw(15) << right << "Protobuf"
@@ -456,6 +478,9 @@ int main(int argc, char* argv[]) {
     case Compression::SNAPPY:
       cout << "* Snappy compression" << endl;
       break;
+    case Compression::TRUSTED:
+      cout << "* no compression, Cap'n Proto reads without bounds checks" << endl;
+      break;
   }
 
   cout << endl;
@@ -507,6 +532,12 @@ int main(int argc, char* argv[]) {
       Product::CAPNPROTO, testCase, mode, Reuse::YES, Compression::PACKED, iters);
   capnpPacked.objectSize = capnpBase.objectSize;
   reportResults("Cap'n Proto packed I/O", iters, capnpPacked);
+  reportThroughput("Cap'n Proto packed I/O throughput", capnp.messageSize,
+      (int64_t)capnpPacked.time.user - (int64_t)capnpBase.time.user);
+  TestResult capnpTrusted = runTest(
+      Product::CAPNPROTO, testCase, mode, Reuse::YES, Compression::TRUSTED, iters);
+  capnpTrusted.objectSize = capnpBase.objectSize;
+  reportResults("Cap'n Proto trusted I/O", iters, capnpTrusted);
 
   size_t protobufBinarySize = fileSize("protobuf-" + std::string(testCaseName(testCase)));
   size_t capnpBinarySize = fileSize("capnproto-" + std::string(testCaseName(testCase)));
@@ -565,6 +596,8 @@ int main(int argc, char* argv[]) {
         Product::CAPNPROTO, testCase, mode, Reuse::YES, Compression::PACKED, iters);
     oldCapnpPacked.objectSize = oldCapnpBase.objectSize;
     reportResults("Old Cap'n Proto packed I/O", iters, oldCapnpPacked);
+    reportThroughput("Old Cap'n Proto packed I/O throughput", oldCapnp.messageSize,
+        (int64_t)oldCapnpPacked.time.user - (int64_t)oldCapnpBase.time.user);
 
     oldCapnpBinarySize = fileSize("capnproto-" + std::string(testCaseName(testCase)));
     oldCapnpCodeSize = fileSize(std::string(testCaseName(testCase)) + ".capnp.c++")
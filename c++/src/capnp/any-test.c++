@@ -316,6 +316,123 @@ TEST(Any, Equals) {
   EXPECT_EQ(Equality::EQUAL, anyA.equals(anyB));
 }
 
+TEST(Any, EqualsIgnoresTrailingNullPointers) {
+  MallocMessageBuilder builderA;
+  auto a = builderA.getRoot<AnyPointer>().initAsAnyStruct(1, 1);
+  a.getDataSection()[0] = 5;
+  a.getPointerSection()[0].setAs<Text>("foo");
+
+  MallocMessageBuilder builderB;
+  auto b = builderB.getRoot<AnyPointer>().initAsAnyStruct(3, 4);
+  b.getDataSection()[0] = 5;
+  b.getPointerSection()[0].setAs<Text>("foo");
+
+  EXPECT_EQ(Equality::EQUAL, a.equals(b));
+  EXPECT_EQ(Equality::EQUAL, b.equals(a));
+
+  b.getPointerSection()[3].setAs<Text>("bar");
+  EXPECT_EQ(Equality::NOT_EQUAL, a.equals(b));
+  EXPECT_EQ(Equality::NOT_EQUAL, b.equals(a));
+}
+
+TEST(Any, Hash) {
+  MallocMessageBuilder builderA;
+  auto rootA = builderA.getRoot<test::TestAllTypes>();
+  initTestMessage(rootA);
+
+  // Tiny segments force lots of far pointers.
+  MallocMessageBuilder builderB(1, AllocationStrategy::FIXED_SIZE);
+  auto rootB = builderB.getRoot<test::TestAllTypes>();
+  initTestMessage(rootB);
+  ASSERT_GT(builderB.getSegmentsForOutput().size(), 1u);
+
+  auto anyA = builderA.getRoot<AnyPointer>().asReader();
+  auto anyB = builderB.getRoot<AnyPointer>().asReader();
+  EXPECT_EQ(Equality::EQUAL, anyA.equals(anyB));
+  EXPECT_EQ(hash(anyA), hash(anyB));
+  EXPECT_EQ(hash(rootA.asReader()), hash(rootB.asReader()));
+  EXPECT_EQ(hash(anyA.getAs<AnyStruct>()), hash(rootA.asReader()));
+  EXPECT_EQ(hash(rootA.asReader().getStructList()), hash(rootB.asReader().getStructList()));
+
+  // The canonical form hashes the same.
+  {
+    auto words = AnyStruct::Reader(rootB.asReader()).canonicalize();
+    kj::ArrayPtr<const word> segments[1] = {words};
+    SegmentArrayMessageReader reader(segments);
+    EXPECT_EQ(hash(anyA), hash(reader.getRoot<AnyPointer>()));
+  }
+
+  rootA.setBoolField(false);
+  EXPECT_NE(hash(anyA), hash(anyB));
+  rootB.setBoolField(false);
+  EXPECT_EQ(hash(anyA), hash(anyB));
+
+  rootA.getStructField().setTextField("buzz");
+  EXPECT_NE(hash(anyA), hash(anyB));
+  rootB.getStructField().setTextField("buzz");
+  EXPECT_EQ(hash(anyA), hash(anyB));
+
+  rootB.getStructList()[1].setTextField("my NEW structlist 2");
+  EXPECT_NE(hash(anyA), hash(anyB));
+  rootA.getStructList()[1].setTextField("my NEW structlist 2");
+  EXPECT_EQ(hash(anyA), hash(anyB));
+
+  rootA.getBoolList().set(2, true);
+  EXPECT_NE(hash(anyA), hash(anyB));
+  rootB.getBoolList().set(2, true);
+  EXPECT_EQ(hash(anyA), hash(anyB));
+
+  // Null and empty differ.
+  MallocMessageBuilder empty;
+  EXPECT_NE(hash(empty.getRoot<AnyPointer>().asReader()),
+            hash(empty.getRoot<test::TestAllTypes>().asReader()));
+}
+
+TEST(Any, HashIgnoresLayout) {
+  // Structs padded with zeros and null pointers, as written by a newer version of a schema, hash
+  // like their truncated versions.
+  MallocMessageBuilder builderA;
+  auto a = builderA.getRoot<AnyPointer>().initAsAnyStruct(1, 1);
+  a.getDataSection()[0] = 5;
+  a.getPointerSection()[0].setAs<Text>("foo");
+
+  MallocMessageBuilder builderB;
+  auto b = builderB.getRoot<AnyPointer>().initAsAnyStruct(3, 4);
+  b.getDataSection()[0] = 5;
+  b.getPointerSection()[0].setAs<Text>("foo");
+
+  EXPECT_EQ(hash(a.asReader()), hash(b.asReader()));
+  b.getPointerSection()[3].setAs<Text>("bar");
+  EXPECT_NE(hash(a.asReader()), hash(b.asReader()));
+
+  // A list of pointers compares equal to a list of structs holding the same pointers.
+  MallocMessageBuilder builderC;
+  auto texts = builderC.getRoot<AnyPointer>().initAs<List<Text>>(2);
+  texts.set(0, "foo");
+  texts.set(1, "bar");
+
+  MallocMessageBuilder builderD;
+  auto structs = builderD.getRoot<AnyPointer>().initAsListOfAnyStruct(1, 2, 2);
+  structs[0].getPointerSection()[0].setAs<Text>("foo");
+  structs[1].getPointerSection()[0].setAs<Text>("bar");
+
+  auto c = builderC.getRoot<AnyPointer>().asReader();
+  auto d = builderD.getRoot<AnyPointer>().asReader();
+  EXPECT_EQ(Equality::EQUAL, c.equals(d));
+  EXPECT_EQ(Equality::EQUAL, d.equals(c));
+  EXPECT_EQ(hash(c), hash(d));
+
+  // But data lists only equal data lists of the same element size.
+  MallocMessageBuilder builderE;
+  builderE.getRoot<AnyPointer>().initAs<List<uint64_t>>(2);
+  MallocMessageBuilder builderF;
+  builderF.getRoot<AnyPointer>().initAsListOfAnyStruct(1, 0, 2);
+  auto e = builderE.getRoot<AnyPointer>().asReader();
+  auto f = builderF.getRoot<AnyPointer>().asReader();
+  EXPECT_EQ(Equality::NOT_EQUAL, e.equals(f));
+  EXPECT_EQ(Equality::NOT_EQUAL, f.equals(e));
+}
+
 }  // namespace
 }  // namespace _ (private)
 }  // namespace capnp
@@ -122,6 +122,14 @@ Equality AnyStruct::Reader::equals(AnyStruct::Reader right) {
     }
   }
 
+  // Any extra pointers on either side must be null, just as extra data must be zero.
+  for (; i < ptrsL.size(); i++) {
+    if (!ptrsL[i].isNull()) return Equality::NOT_EQUAL;
+  }
+  for (; i < ptrsR.size(); i++) {
+    if (!ptrsR[i].isNull()) return Equality::NOT_EQUAL;
+  }
+
   return eqResult;
 }
 
@@ -160,6 +168,10 @@ Equality AnyList::Reader::equals(AnyList::Reader right) {
       }
     case ElementSize::POINTER:
     case ElementSize::INLINE_COMPOSITE: {
+      if (right.getElementSize() != ElementSize::POINTER &&
+          right.getElementSize() != ElementSize::INLINE_COMPOSITE) {
+        return Equality::NOT_EQUAL;
+      }
       auto llist = as<List<AnyStruct>>();
       auto rlist = right.as<List<AnyStruct>>();
       for(size_t i = 0; i < size(); i++) {
@@ -238,4 +250,19 @@ bool AnyList::Reader::operator==(AnyList::Reader right) {
   KJ_UNREACHABLE;
 }
 
+// =======================================================================================
+// Hashing
+
+uint64_t hash(AnyStruct::Reader value) {
+  return value._reader.hash();
+}
+
+uint64_t hash(AnyList::Reader value) {
+  return value._reader.hash();
+}
+
+uint64_t hash(AnyPointer::Reader value) {
+  return value.reader.hash();
+}
+
 }  // namespace capnp
@@ -139,6 +139,7 @@ struct AnyPointer {
     friend class Orphanage;
     friend class CapReaderContext;
     friend struct _::PointerHelpers<AnyPointer>;
+    friend uint64_t hash(AnyPointer::Reader value);
   };
 
   class Builder {
@@ -471,6 +472,11 @@ public:
   kj::Array<word> canonicalize() {
     return _reader.canonicalize();
   }
+  size_t canonicalize(kj::OutputStream& output) {
+    return _reader.canonicalize(output);
+  }
+  // Returns the canonical form of this struct, or writes it to `output` without materializing
+  // it, returning its size in words. See StructReader::canonicalize().
 
   Equality equals(AnyStruct::Reader right);
   bool operator==(AnyStruct::Reader right);
@@ -489,6 +495,7 @@ private:
   template <typename, Kind>
   friend struct _::PointerHelpers;
   friend class Orphanage;
+  friend uint64_t hash(AnyStruct::Reader value);
 };
 
 class AnyStruct::Builder {
@@ -648,6 +655,7 @@ private:
   template <typename, Kind>
   friend struct _::PointerHelpers;
   friend class Orphanage;
+  friend uint64_t hash(AnyList::Reader value);
 };
 
 class AnyList::Builder {
@@ -688,6 +696,22 @@ private:
   friend class Orphanage;
 };
 
+// =======================================================================================
+// Hashing
+
+uint64_t hash(AnyStruct::Reader value);
+uint64_t hash(AnyList::Reader value);
+uint64_t hash(AnyPointer::Reader value);
+// Computes a 64-bit hash of the content of the given object and everything it points to, such
+// that any two objects that compare EQUAL via equals() have the same hash. Like equals(), the hash
+// only depends on content, not on encoding: it is unaffected by how the message is split into
+// segments, by far pointers, and by trailing zeros or null pointers left over from older or newer
+// versions of the schema. Capabilities all hash the same.
+//
+// Unlike hashing the output of canonicalize(), this reads the message in place in a single pass
+// and does not allocate. Hash values are the same on all platforms, but they may change between
+// versions of Cap'n Proto, so don't store them persistently.
+
 // =======================================================================================
 // Pipeline helpers
 //
@@ -73,15 +73,24 @@ SegmentReader* ReaderArena::tryGetSegment(SegmentId id) {
     }
   }
 
+  SegmentTable* table = __atomic_load_n(&segmentTable, __ATOMIC_ACQUIRE);
+  if (table != nullptr && id.value < table->slots.size()) {
+    SegmentReader* result = __atomic_load_n(&table->slots[id.value], __ATOMIC_ACQUIRE);
+    if (result != nullptr) {
+      return result;
+    }
+  }
+
+  return tryGetSegmentSlow(id);
+}
+
+SegmentReader* ReaderArena::tryGetSegmentSlow(SegmentId id) {
   auto lock = moreSegments.lockExclusive();
 
-  SegmentMap* segments = nullptr;
-  KJ_IF_MAYBE(s, *lock) {
-    auto iter = s->get()->find(id.value);
-    if (iter != s->get()->end()) {
-      return iter->second;
-    }
-    segments = *s;
+  // Re-check under the lock, in case another thread initialized the segment in the meantime.
+  SegmentTable* table = segmentTable;
+  if (table != nullptr && id.value < table->slots.size() && table->slots[id.value] != nullptr) {
+    return table->slots[id.value];
   }
 
   kj::ArrayPtr<const word> newSegment = message->getSegment(id.value);
@@ -89,16 +98,28 @@ SegmentReader* ReaderArena::tryGetSegment(SegmentId id) {
     return nullptr;
   }
 
-  if (*lock == nullptr) {
-    // OK, the segment exists, so allocate the map.
-    auto s = kj::heap<SegmentMap>();
-    segments = s;
-    *lock = kj::mv(s);
+  if (table == nullptr || id.value >= table->slots.size()) {
+    // The segment exists, so grow the table to fit it. Old tables stay alive (chained through
+    // `previous`) because other threads may be concurrently reading from them.
+    size_t newSize = kj::max(kj::max(size_t(4), size_t(id.value) + 1),
+                             table == nullptr ? size_t(0) : table->slots.size() * 2);
+    auto newTable = kj::heap<SegmentTable>();
+    newTable->slots = kj::heapArray<SegmentReader*>(newSize);
+    memset(newTable->slots.begin(), 0, newSize * sizeof(SegmentReader*));
+    if (table != nullptr) {
+      memcpy(newTable->slots.begin(), table->slots.begin(),
+             table->slots.size() * sizeof(SegmentReader*));
+    }
+    newTable->previous = kj::mv(lock->table);
+    table = newTable;
+    lock->table = kj::mv(newTable);
+    __atomic_store_n(&segmentTable, table, __ATOMIC_RELEASE);
   }
 
   auto segment = kj::heap<SegmentReader>(this, id, newSegment, &readLimiter);
   SegmentReader* result = segment;
-  segments->insert(std::make_pair(id.value, mv(segment)));
+  lock->readers.add(kj::mv(segment));
+  __atomic_store_n(&table->slots[id.value], result, __ATOMIC_RELEASE);
   return result;
 }
 
@@ -37,7 +37,6 @@
 #include "common.h"
 #include "message.h"
 #include "layout.h"
-#include <unordered_map>
 
 #if !CAPNP_LITE
 #include "capability.h"
@@ -214,6 +213,8 @@ public:
   ~ReaderArena() noexcept(false);
   KJ_DISALLOW_COPY(ReaderArena);
 
+  inline void resetReadLimit(WordCount64 limit) { readLimiter.reset(limit); }
+
   // implements Arena ------------------------------------------------
   SegmentReader* tryGetSegment(SegmentId id) override;
   void reportReadLimitReached() override;
@@ -225,15 +226,33 @@ private:
   // Optimize for single-segment messages so that small messages are handled quickly.
   SegmentReader segment0;
 
-  typedef std::unordered_map<uint, kj::Own<SegmentReader>> SegmentMap;
-  kj::MutexGuarded<kj::Maybe<kj::Own<SegmentMap>>> moreSegments;
-  // We need to mutex-guard the segment map because we lazily initialize segments when they are
-  // first requested, but a Reader is allowed to be used concurrently in multiple threads.  Luckily
-  // this only applies to large messages.
-  //
-  // TODO(perf):  Thread-local thing instead?  Some kind of lockless map?  Or do sharing of data
-  //   in a different way, where you have to construct a new MessageReader in each thread (but
-  //   possibly backed by the same data)?
+  struct SegmentTable {
+    // Fixed-capacity table of segments other than segment0, indexed by segment ID. Once a table
+    // has been published, its capacity never changes; growing means publishing a new, larger
+    // table. Slots are filled in lazily and published with release semantics so that lookups
+    // need only a pair of acquire loads.
+
+    kj::Array<SegmentReader*> slots;
+    kj::Maybe<kj::Own<SegmentTable>> previous;
+    // Tables are replaced but never freed until the arena is destroyed, since another thread may
+    // still be reading the old one.
+  };
+
+  SegmentTable* segmentTable = nullptr;
+  // Current table, or null if no segment other than segment0 has been requested yet. Accessed
+  // atomically; only ever replaced while `moreSegments` is locked.
+
+  struct MoreSegments {
+    kj::Maybe<kj::Own<SegmentTable>> table;
+    kj::Vector<kj::Own<SegmentReader>> readers;
+  };
+  kj::MutexGuarded<MoreSegments> moreSegments;
+  // We lazily initialize segments when they are first requested, but a Reader is allowed to be
+  // used concurrently in multiple threads. Lookups of segments that have already been
+  // initialized go through `segmentTable` without taking the lock; only the first request for
+  // each segment does. Luckily this only applies to large messages.
+
+  SegmentReader* tryGetSegmentSlow(SegmentId id);
 };
 
 class BuilderArena final: public Arena {
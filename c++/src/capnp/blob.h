@@ -102,7 +102,8 @@ public:
   inline Builder(kj::Array<byte>& value): ArrayPtr<byte>(value) {}
   inline Builder(ArrayPtr<byte> value): ArrayPtr<byte>(value) {}
 
-  inline Data::Reader asReader() const { return Data::Reader(*this); }
+  inline Data::Reader asReader() const { return Data::Reader(begin(), size()); }
+  // (Not `Data::Reader(*this)`, which C++20 resolves to `operator Reader()`, recursively.)
   inline operator Reader() const { return asReader(); }
 };
 
@@ -22,6 +22,8 @@
 #include "message.h"
 #include "any.h"
 #include <kj/debug.h>
+#include <kj/io.h>
+#include <kj/vector.h>
 #include <kj/test.h>
 #include "test-util.h"
 
@@ -37,8 +39,116 @@ KJ_TEST("canonicalize yields cannonical message") {
 
   initTestMessage(root);
 
-  canonicalize(root.asReader());
-  //Will assert if canonicalize failed to do so
+  auto canonicalWords = canonicalize(root.asReader());
+
+  kj::ArrayPtr<const word> segments[1] = { canonicalWords };
+  SegmentArrayMessageReader canonical(kj::arrayPtr(segments, 1));
+  KJ_ASSERT(canonical.isCanonical());
+  checkTestMessage(canonical.getRoot<TestAllTypes>());
+}
+
+kj::Array<word> canonicalizeByCopying(AnyPointer::Reader root) {
+  // The straightforward way to canonicalize: a canonical deep copy into a segment large enough to
+  // hold it all.
+  MallocMessageBuilder builder(root.targetSize().wordCount + 16);
+  builder.initRoot<AnyPointer>().setCanonical(root);
+  auto segments = builder.getSegmentsForOutput();
+  KJ_ASSERT(segments.size() == 1);
+  return kj::heapArray<word>(segments[0]);
+}
+
+class WordCollector: public kj::OutputStream {
+public:
+  kj::Vector<byte> bytes;
+  void write(const void* buffer, size_t size) override {
+    bytes.addAll(reinterpret_cast<const byte*>(buffer),
+                 reinterpret_cast<const byte*>(buffer) + size);
+  }
+};
+
+void expectCanonicalizationAgrees(MessageReader& reader) {
+  auto expected = canonicalizeByCopying(reader.getRoot<AnyPointer>());
+  auto actual = reader.getRoot<AnyStruct>().canonicalize();
+  KJ_EXPECT(actual.asBytes() == expected.asBytes());
+
+  WordCollector stream;
+  size_t size = reader.getRoot<AnyStruct>().canonicalize(stream);
+  KJ_EXPECT(size == expected.size());
+  KJ_EXPECT(stream.bytes.asPtr() == expected.asBytes());
+}
+
+KJ_TEST("canonicalize matches a canonical copy, materialized or streamed") {
+  {
+    // Small segments, so that the source is spread over many segments with far pointers.
+    MallocMessageBuilder builder(1, AllocationStrategy::FIXED_SIZE);
+    initTestMessage(builder.initRoot<TestAllTypes>());
+    KJ_ASSERT(builder.getSegmentsForOutput().size() > 1);
+    SegmentArrayMessageReader reader(builder.getSegmentsForOutput());
+    expectCanonicalizationAgrees(reader);
+  }
+
+  {
+    // Struct lists whose elements truncate to different sizes, and trailing null pointers.
+    MallocMessageBuilder builder;
+    auto root = builder.initRoot<TestAllTypes>();
+    auto list = root.initStructList(3);
+    list[0].setUInt8Field(1);
+    list[1].setFloat64Field(2.5);
+    list[1].setTextField("foo");
+    list[2].initStructField().setInt32Field(-3);
+    root.setTextField("bar");
+    root.initBoolList(11).set(9, true);
+    root.initStructField();
+    SegmentArrayMessageReader reader(builder.getSegmentsForOutput());
+    expectCanonicalizationAgrees(reader);
+  }
+
+  {
+    // Large enough that the stream output bypasses its buffer.
+    MallocMessageBuilder builder;
+    auto root = builder.initRoot<TestAllTypes>();
+    auto data = root.initDataField(100000);
+    for (uint i = 0; i < data.size(); i++) data[i] = i * 7;
+    root.initUInt64List(5000).set(4999, 1);
+    SegmentArrayMessageReader reader(builder.getSegmentsForOutput());
+    expectCanonicalizationAgrees(reader);
+  }
+
+  {
+    // Empty root struct.
+    MallocMessageBuilder builder;
+    builder.initRoot<TestAllTypes>();
+    SegmentArrayMessageReader reader(builder.getSegmentsForOutput());
+    expectCanonicalizationAgrees(reader);
+    KJ_EXPECT(canonicalize(reader.getRoot<TestAllTypes>()).size() == 1);
+  }
+}
+
+KJ_TEST("canonicalize a one-bit struct") {
+  // Reading a bool list element as a struct gives a struct whose data section is a single bit,
+  // sharing its byte with the following elements.
+  MallocMessageBuilder builder;
+  auto list = builder.initRoot<TestAllTypes>().initBoolList(2);
+  list.set(1, true);
+  ListReader listReader = PointerHelpers<List<bool>>::getInternalReader(list.asReader());
+  AnyStruct::Reader element(listReader.getStructElement(0 * ELEMENTS));
+
+  // False truncates to an empty struct, whose pointer has offset -1.
+  auto words = element.canonicalize();
+  KJ_ASSERT(words.size() == 1);
+  KJ_EXPECT(words.asBytes().asConst() == kj::arrayPtr(
+      reinterpret_cast<const byte*>("\xfc\xff\xff\xff\0\0\0\0"), 8));
+
+  // True is one data word holding just that bit.
+  list.set(0, true);
+  words = element.canonicalize();
+  KJ_ASSERT(words.size() == 2);
+  KJ_EXPECT(words.asBytes().asConst() == kj::arrayPtr(
+      reinterpret_cast<const byte*>("\0\0\0\0\1\0\0\0\1\0\0\0\0\0\0\0"), 16));
+
+  WordCollector stream;
+  KJ_EXPECT(element.canonicalize(stream) == 2);
+  KJ_EXPECT(stream.bytes.asPtr() == words.asBytes());
 }
 
 KJ_TEST("isCanonical requires pointer preorder") {
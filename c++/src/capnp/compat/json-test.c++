@@ -183,6 +183,78 @@ KJ_TEST("encode union") {
   KJ_EXPECT(json.encode(root) == "{\"before\":\"a\",\"middle\":44,\"bar\":321,\"after\":\"c\"}");
 }
 
+class StringOutputStream: public kj::OutputStream {
+  // Unbuffered stream that collects everything written to it, so that the streaming encoder has to
+  // do its own buffering.
+
+public:
+  kj::String getText() {
+    return kj::heapString(chars.asPtr());
+  }
+
+  void write(const void* buffer, size_t size) override {
+    chars.addAll(kj::arrayPtr(reinterpret_cast<const char*>(buffer), size));
+  }
+
+private:
+  kj::Vector<char> chars;
+};
+
+template <typename T>
+kj::String encodeToStream(const JsonCodec& json, T&& value) {
+  StringOutputStream output;
+  json.encode(kj::fwd<T>(value), output);
+  return output.getText();
+}
+
+KJ_TEST("stream encoding") {
+  MallocMessageBuilder message;
+  auto root = message.getRoot<TestAllTypes>();
+  initTestMessage(root);
+  root.setTextField("quote \" slash / control \x01\n end");
+
+  JsonCodec json;
+  KJ_EXPECT(encodeToStream(json, root) == json.encode(root));
+
+  // A BufferedOutputStream is written to directly.
+  kj::VectorOutputStream bufferedOutput;
+  json.encode(root, bufferedOutput);
+  auto written = bufferedOutput.getArray();
+  KJ_EXPECT(kj::heapString(reinterpret_cast<const char*>(written.begin()), written.size()) ==
+            json.encode(root));
+
+  // Output much larger than the internal buffer.
+  auto list = root.initStructList(1000);
+  for (auto element: list) {
+    initTestMessage(element);
+  }
+  auto expected = json.encode(root);
+  KJ_EXPECT(expected.size() > 100000);
+  KJ_EXPECT(encodeToStream(json, root) == expected);
+
+  // Pretty-printing falls back to encoding up front, but gives the same text.
+  json.setPrettyPrint(true);
+  KJ_EXPECT(encodeToStream(json, root) == json.encode(root));
+}
+
+KJ_TEST("stream encoding union") {
+  MallocMessageBuilder message;
+  auto root = message.getRoot<test::TestUnionDefaults>();
+  root.getS16s8s64s8Set();
+  root.getS0sps1s32Set();
+  root.getUnnamed1();
+  root.getUnnamed2();
+
+  // A null pointer that is not the union's default member is written as null.
+  root.getS0sps1s32Set().getUnion1().initU1f0sp(0);
+  root.getS0sps1s32Set().getUnion1().disownU1f0sp();
+
+  JsonCodec json;
+  auto text = encodeToStream(json, root.asReader());
+  KJ_EXPECT(text == json.encode(root), text);
+  KJ_EXPECT(strstr(text.cStr(), "\"u1f0sp\":null") != nullptr, text);
+}
+
 KJ_TEST("decode all types") {
   JsonCodec json;
 #define CASE(s, f) \
@@ -326,6 +398,58 @@ KJ_TEST("decode test message") {
   KJ_EXPECT(root.toString().flatten() == decodedRoot.toString().flatten());
 }
 
+KJ_TEST("direct decode matches decoding through JsonValue") {
+  JsonCodec json;
+
+  auto check = [&](kj::StringPtr input) {
+    MallocMessageBuilder message;
+    auto root = message.initRoot<TestAllTypes>();
+    json.decode(input, root);
+
+    MallocMessageBuilder jsonMessage;
+    auto jsonRoot = jsonMessage.initRoot<JsonValue>();
+    json.decodeRaw(input, jsonRoot);
+    MallocMessageBuilder expectedMessage;
+    auto expected = expectedMessage.initRoot<TestAllTypes>();
+    json.decode(jsonRoot.asReader(), expected);
+
+    KJ_EXPECT(root.toString().flatten() == expected.toString().flatten(), input);
+  };
+
+  check(" \n{ \"textField\" : \"a\" ,\t\"int32Field\":\r\n5 } \n");
+  check(R"({"textField":"quote \" and backslash \\ in a string long enough to be scanned in chunks"})");
+  check(R"({"textField":"0123456789abcde\"","textList":["0123456789abcdef\\","\u004a\u006B",""]})");
+  check(R"({"unknown":{"a":[1,{"b":"]}\"[{,"},[[]]],"c":null},"int8List":[1,2,3]})");
+  check(R"({"int32List":[],"textList":["a,b","[c]","{d}"],"dataList":[[],[1],[2,3]]})");
+  check(R"({"structList":[{"textField":"x","int8List":[4,5]},{},null,{"structField":{}}]})");
+  check(R"({"structField":{"structList":[{"textList":["deep"]}]},"enumList":["foo","bar"]})");
+  check(R"({"voidField":[1,2,{"x":"y"}],"textField":"first","textField":"second"})");
+
+  MallocMessageBuilder message;
+  auto root = message.initRoot<TestAllTypes>();
+  json.decode(R"({"textField":"\u004a\u004B\t"})", root);
+  KJ_EXPECT(root.getTextField().asString() == kj::StringPtr("JK\t"));
+
+  // Values of unknown fields are skipped, but must still be valid JSON.
+  KJ_EXPECT_THROW_MESSAGE("Unexpected input",
+      json.decode(R"({"unknown":[1,,2],"int8Field":1})", root));
+  KJ_EXPECT_THROW_MESSAGE("Invalid escape",
+      json.decode(R"({"unknown":"\q"})", root));
+  KJ_EXPECT_THROW_MESSAGE("Unexpected input",
+      json.decode(R"({"int8List":[1,2,]})", root));
+  KJ_EXPECT_THROW_MESSAGE("ends prematurely",
+      json.decode(R"({"textList":["abc)", root));
+  KJ_EXPECT_THROW_MESSAGE("Input remains", json.decode(R"({} {})", root));
+  KJ_EXPECT_THROW_MESSAGE("Top level json value must be object", json.decode("[]", root));
+
+  json.setMaxNestingDepth(3);
+  json.decode(R"({"structField":{"int8List":[1]}})", root);
+  KJ_EXPECT_THROW_MESSAGE("nested too deeply",
+      json.decode(R"({"structField":{"structField":{"int8List":[1]}}})", root));
+  KJ_EXPECT_THROW_MESSAGE("nested too deeply",
+      json.decode(R"({"unknown":[[[1]]]})", root));
+}
+
 KJ_TEST("basic json decoding") {
   // TODO(cleanup): this test is a mess!
   JsonCodec json;
@@ -653,6 +777,7 @@ KJ_TEST("register handler") {
   root.setOld1(123);
   root.setOld2("foo");
   KJ_EXPECT(json.encode(root) == "{\"old1\":\"123\",\"old2\":Frob(123,\"foo\")}");
+  KJ_EXPECT(encodeToStream(json, root.asReader()) == json.encode(root));
 }
 
 KJ_TEST("register field handler") {
@@ -667,6 +792,7 @@ KJ_TEST("register field handler") {
   root.setBaz("abcd");
   root.setCorge("efg");
   KJ_EXPECT(json.encode(root) == "{\"corge\":Frob(123,\"efg\"),\"baz\":\"abcd\"}");
+  KJ_EXPECT(encodeToStream(json, root.asReader()) == json.encode(root));
 }
 
 class TestCapabilityHandler: public JsonCodec::Handler<test::TestInterface> {
@@ -23,12 +23,17 @@
 #include <math.h>    // for HUGEVAL to check for overflow in strtod
 #include <stdlib.h>  // strtod
 #include <errno.h>   // for strtod errors
+#include <string.h>
 #include <unordered_map>
 #include <capnp/orphan.h>
 #include <kj/debug.h>
 #include <kj/function.h>
 #include <kj/vector.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace capnp {
 
 namespace {
@@ -45,6 +50,42 @@ struct FieldHash {
   }
 };
 
+template <typename Func>
+void forEachEncodedField(DynamicStruct::Reader structValue, Func&& func) {
+  // Calls `func(field, isNullUnionMember)` for each field of `structValue` that appears in its JSON
+  // encoding, in order. Non-union fields are included when they are non-null. The active union
+  // member is included in index order among them, and is encoded as null if it is a null pointer
+  // that still has to be written because it is not the union's default member.
+
+  auto which = structValue.which();
+  bool unionFieldIsNull = false;
+
+  KJ_IF_MAYBE(field, which) {
+    // Even if the union field is null, if it is not the default field of the union then we
+    // have to print it anyway.
+    unionFieldIsNull = !structValue.has(*field);
+    if (field->getProto().getDiscriminantValue() == 0 && unionFieldIsNull) {
+      which = nullptr;
+    }
+  }
+
+  for (auto field: structValue.getSchema().getNonUnionFields()) {
+    KJ_IF_MAYBE(unionField, which) {
+      if (unionField->getIndex() < field.getIndex()) {
+        func(*unionField, unionFieldIsNull);
+        which = nullptr;
+      }
+    }
+    if (structValue.has(field)) {
+      func(field, false);
+    }
+  }
+  KJ_IF_MAYBE(unionField, which) {
+    // Union field not printed yet; must be last.
+    func(*unionField, unionFieldIsNull);
+  }
+}
+
 }  // namespace
 
 struct JsonCodec::Impl {
@@ -111,31 +152,47 @@ struct JsonCodec::Impl {
     KJ_FAIL_ASSERT("unknown JsonValue type", static_cast<uint>(value.which()));
   }
 
-  kj::String encodeString(kj::StringPtr chars) const {
+  static kj::ArrayPtr<const char> escapeChar(char c, char (&scratch)[6]) {
+    // Returns the escape sequence for `c`, or an empty array if `c` can appear in a JSON string
+    // as-is. `scratch` is used to build \u escapes.
+
     static const char HEXDIGITS[] = "0123456789abcdef";
+    switch (c) {
+      case '\"': return kj::StringPtr("\\\"");
+      case '\\': return kj::StringPtr("\\\\");
+      case '/' : return kj::StringPtr("\\/" );
+      case '\b': return kj::StringPtr("\\b");
+      case '\f': return kj::StringPtr("\\f");
+      case '\n': return kj::StringPtr("\\n");
+      case '\r': return kj::StringPtr("\\r");
+      case '\t': return kj::StringPtr("\\t");
+      default:
+        if (c >= 0 && c < 0x20) {
+          uint8_t c2 = c;
+          scratch[0] = '\\';
+          scratch[1] = 'u';
+          scratch[2] = '0';
+          scratch[3] = '0';
+          scratch[4] = HEXDIGITS[c2 / 16];
+          scratch[5] = HEXDIGITS[c2 % 16];
+          return kj::arrayPtr(scratch, 6);
+        } else {
+          return nullptr;
+        }
+    }
+  }
+
+  kj::String encodeString(kj::StringPtr chars) const {
     kj::Vector<char> escaped(chars.size() + 3);
+    char scratch[6];
 
     escaped.add('"');
     for (char c: chars) {
-      switch (c) {
-        case '\"': escaped.addAll(kj::StringPtr("\\\"")); break;
-        case '\\': escaped.addAll(kj::StringPtr("\\\\")); break;
-        case '/' : escaped.addAll(kj::StringPtr("\\/" )); break;
-        case '\b': escaped.addAll(kj::StringPtr("\\b")); break;
-        case '\f': escaped.addAll(kj::StringPtr("\\f")); break;
-        case '\n': escaped.addAll(kj::StringPtr("\\n")); break;
-        case '\r': escaped.addAll(kj::StringPtr("\\r")); break;
-        case '\t': escaped.addAll(kj::StringPtr("\\t")); break;
-        default:
-          if (c >= 0 && c < 0x20) {
-            escaped.addAll(kj::StringPtr("\\u00"));
-            uint8_t c2 = c;
-            escaped.add(HEXDIGITS[c2 / 16]);
-            escaped.add(HEXDIGITS[c2 % 16]);
-          } else {
-            escaped.add(c);
-          }
-          break;
+      auto escape = escapeChar(c, scratch);
+      if (escape.size() == 0) {
+        escaped.add(c);
+      } else {
+        escaped.addAll(escape);
       }
     }
     escaped.add('"');
@@ -183,6 +240,110 @@ struct JsonCodec::Impl {
 
     return kj::strTree(prefix, kj::StringTree(kj::mv(elements), delim), suffix);
   }
+
+  // ---------------------------------------------------------------------------
+  // Streaming output. These always produce the compact (non-pretty-printed) form.
+
+  static void writeChars(kj::ArrayPtr<const char> chars, kj::BufferedOutputStream& output) {
+    output.write(chars.begin(), chars.size());
+  }
+
+  static void writeNumber(double value, kj::BufferedOutputStream& output) {
+    // Formats exactly like encodeRaw() formats a JsonValue number.
+    writeChars(kj::toCharSequence(value), output);
+  }
+
+  static void writeString(kj::ArrayPtr<const char> chars, kj::BufferedOutputStream& output) {
+    // Streaming equivalent of encodeString(). Runs of characters that need no escaping are written
+    // with a single call.
+
+    char scratch[6];
+    writeChars(kj::StringPtr("\""), output);
+    const char* runStart = chars.begin();
+    for (const char* pos = chars.begin(); pos != chars.end(); ++pos) {
+      auto escape = escapeChar(*pos, scratch);
+      if (escape.size() != 0) {
+        writeChars(kj::arrayPtr(runStart, pos), output);
+        writeChars(escape, output);
+        runStart = pos + 1;
+      }
+    }
+    writeChars(kj::arrayPtr(runStart, chars.end()), output);
+    writeChars(kj::StringPtr("\""), output);
+  }
+
+  void encodeRaw(JsonValue::Reader value, kj::BufferedOutputStream& output) const {
+    switch (value.which()) {
+      case JsonValue::NULL_:
+        writeChars(kj::StringPtr("null"), output);
+        return;
+      case JsonValue::BOOLEAN:
+        writeChars(value.getBoolean() ? kj::StringPtr("true") : kj::StringPtr("false"), output);
+        return;
+      case JsonValue::NUMBER:
+        writeNumber(value.getNumber(), output);
+        return;
+
+      case JsonValue::STRING:
+        writeString(value.getString(), output);
+        return;
+
+      case JsonValue::ARRAY: {
+        writeChars(kj::StringPtr("["), output);
+        bool first = true;
+        for (auto element: value.getArray()) {
+          if (!first) writeChars(kj::StringPtr(","), output);
+          first = false;
+          encodeRaw(element, output);
+        }
+        writeChars(kj::StringPtr("]"), output);
+        return;
+      }
+
+      case JsonValue::OBJECT: {
+        writeChars(kj::StringPtr("{"), output);
+        bool first = true;
+        for (auto field: value.getObject()) {
+          if (!first) writeChars(kj::StringPtr(","), output);
+          first = false;
+          writeString(field.getName(), output);
+          writeChars(kj::StringPtr(":"), output);
+          encodeRaw(field.getValue(), output);
+        }
+        writeChars(kj::StringPtr("}"), output);
+        return;
+      }
+
+      case JsonValue::CALL: {
+        auto call = value.getCall();
+        writeChars(call.getFunction(), output);
+        writeChars(kj::StringPtr("("), output);
+        bool first = true;
+        for (auto param: call.getParams()) {
+          if (!first) writeChars(kj::StringPtr(","), output);
+          first = false;
+          encodeRaw(param, output);
+        }
+        writeChars(kj::StringPtr(")"), output);
+        return;
+      }
+    }
+
+    KJ_FAIL_ASSERT("unknown JsonValue type", static_cast<uint>(value.which()));
+  }
+
+  template <typename Func>
+  static void withBufferedOutput(kj::OutputStream& output, Func&& func) {
+    KJ_IF_MAYBE(bufferedOutputPtr,
+                kj::dynamicDowncastIfAvailable<kj::BufferedOutputStream>(output)) {
+      func(*bufferedOutputPtr);
+    } else {
+      kj::byte buffer[8192];
+      kj::BufferedOutputStreamWrapper bufferedOutput(output, kj::arrayPtr(buffer, sizeof(buffer)));
+      func(bufferedOutput);
+      bufferedOutput.flush();
+    }
+  }
 };
 
 JsonCodec::JsonCodec()
@@ -202,13 +363,6 @@ kj::String JsonCodec::encode(DynamicValue::Reader value, Type type) const {
   return encodeRaw(json);
 }
 
-void JsonCodec::decode(kj::ArrayPtr<const char> input, DynamicStruct::Builder output) const {
-  MallocMessageBuilder message;
-  auto json = message.getRoot<JsonValue>();
-  decodeRaw(input, json);
-  decode(json, output);
-}
-
 Orphan<DynamicValue> JsonCodec::decode(
     kj::ArrayPtr<const char> input, Type type, Orphanage orphanage) const {
   MallocMessageBuilder message;
@@ -217,11 +371,35 @@ Orphan<DynamicValue> JsonCodec::decode(
   return decode(json, type, orphanage);
 }
 
+void JsonCodec::encode(DynamicValue::Reader value, Type type, kj::OutputStream& output) const {
+  if (impl->prettyPrint) {
+    auto text = encode(value, type);
+    output.write(text.begin(), text.size());
+    return;
+  }
+
+  Impl::withBufferedOutput(output, [&](kj::BufferedOutputStream& bufferedOutput) {
+    encodeStream(value, type, bufferedOutput);
+  });
+}
+
 kj::String JsonCodec::encodeRaw(JsonValue::Reader value) const {
   bool multiline = false;
   return impl->encodeRaw(value, 0, multiline, false).flatten();
 }
 
+void JsonCodec::encodeRaw(JsonValue::Reader value, kj::OutputStream& output) const {
+  if (impl->prettyPrint) {
+    auto text = encodeRaw(value);
+    output.write(text.begin(), text.size());
+    return;
+  }
+
+  Impl::withBufferedOutput(output, [&](kj::BufferedOutputStream& bufferedOutput) {
+    impl->encodeRaw(value, bufferedOutput);
+  });
+}
+
 void JsonCodec::encode(DynamicValue::Reader input, Type type, JsonValue::Builder output) const {
   // TODO(soon): For interfaces, check for handlers on superclasses, per documentation...
   // TODO(soon): For branded types, should we check for handlers on the generic?
@@ -302,64 +480,22 @@ void JsonCodec::encode(DynamicValue::Reader input, Type type, JsonValue::Builder
     }
     case schema::Type::STRUCT: {
       auto structValue = input.as<capnp::DynamicStruct>();
-      auto nonUnionFields = structValue.getSchema().getNonUnionFields();
-
-      KJ_STACK_ARRAY(bool, hasField, nonUnionFields.size(), 32, 128);
 
       uint fieldCount = 0;
-      for (auto i: kj::indices(nonUnionFields)) {
-        fieldCount += (hasField[i] = structValue.has(nonUnionFields[i]));
-      }
-
-      // We try to write the union field, if any, in proper order with the rest.
-      auto which = structValue.which();
-      bool unionFieldIsNull = false;
-
-      KJ_IF_MAYBE(field, which) {
-        // Even if the union field is null, if it is not the default field of the union then we
-        // have to print it anyway.
-        unionFieldIsNull = !structValue.has(*field);
-        if (field->getProto().getDiscriminantValue() != 0 || !unionFieldIsNull) {
-          ++fieldCount;
-        } else {
-          which = nullptr;
-        }
-      }
+      forEachEncodedField(structValue, [&](StructSchema::Field, bool) { ++fieldCount; });
 
       auto object = output.initObject(fieldCount);
 
       size_t pos = 0;
-      for (auto i: kj::indices(nonUnionFields)) {
-        auto field = nonUnionFields[i];
-        KJ_IF_MAYBE(unionField, which) {
-          if (unionField->getIndex() < field.getIndex()) {
-            auto outField = object[pos++];
-            outField.setName(unionField->getProto().getName());
-            if (unionFieldIsNull) {
-              outField.initValue().setNull();
-            } else {
-              encodeField(*unionField, structValue.get(*unionField), outField.initValue());
-            }
-            which = nullptr;
-          }
-        }
-        if (hasField[i]) {
-          auto outField = object[pos++];
-          outField.setName(field.getProto().getName());
-          encodeField(field, structValue.get(field), outField.initValue());
-        }
-      }
-      if (which != nullptr) {
-        // Union field not printed yet; must be last.
-        auto unionField = KJ_ASSERT_NONNULL(which);
+      forEachEncodedField(structValue, [&](StructSchema::Field field, bool isNull) {
         auto outField = object[pos++];
-        outField.setName(unionField.getProto().getName());
-        if (unionFieldIsNull) {
+        outField.setName(field.getProto().getName());
+        if (isNull) {
           outField.initValue().setNull();
         } else {
-          encodeField(unionField, structValue.get(unionField), outField.initValue());
+          encodeField(field, structValue.get(field), outField.initValue());
         }
-      }
+      });
       KJ_ASSERT(pos == fieldCount);
       break;
     }
@@ -383,6 +519,133 @@ void JsonCodec::encodeField(StructSchema::Field field, DynamicValue::Reader inpu
   encode(input, field.getType(), output);
 }
 
+void JsonCodec::encodeStream(DynamicValue::Reader input, Type type,
+                             kj::BufferedOutputStream& output) const {
+  // Mirrors encode(DynamicValue::Reader, Type, JsonValue::Builder), but writes text directly.
+  // Keep the two in sync.
+
+  auto iter = impl->typeHandlers.find(type);
+  if (iter != impl->typeHandlers.end()) {
+    MallocMessageBuilder message;
+    auto json = message.getRoot<JsonValue>();
+    iter->second->encodeBase(*this, input, json);
+    impl->encodeRaw(json.asReader(), output);
+    return;
+  }
+
+  switch (type.which()) {
+    case schema::Type::VOID:
+      Impl::writeChars(kj::StringPtr("null"), output);
+      break;
+    case schema::Type::BOOL:
+      Impl::writeChars(input.as<bool>() ? kj::StringPtr("true") : kj::StringPtr("false"), output);
+      break;
+    case schema::Type::INT8:
+    case schema::Type::INT16:
+    case schema::Type::INT32:
+    case schema::Type::UINT8:
+    case schema::Type::UINT16:
+    case schema::Type::UINT32:
+      Impl::writeNumber(input.as<double>(), output);
+      break;
+    case schema::Type::FLOAT32:
+    case schema::Type::FLOAT64:
+      {
+        double value = input.as<double>();
+        // Inf, -inf and NaN are not allowed in the JSON spec. Storing into string.
+        if (kj::inf() == value) {
+          Impl::writeChars(kj::StringPtr("\"Infinity\""), output);
+        } else if (-kj::inf() == value) {
+          Impl::writeChars(kj::StringPtr("\"-Infinity\""), output);
+        } else if (kj::isNaN(value)) {
+          Impl::writeChars(kj::StringPtr("\"NaN\""), output);
+        } else {
+          Impl::writeNumber(value, output);
+        }
+      }
+      break;
+    case schema::Type::INT64:
+      Impl::writeString(kj::toCharSequence(input.as<int64_t>()), output);
+      break;
+    case schema::Type::UINT64:
+      Impl::writeString(kj::toCharSequence(input.as<uint64_t>()), output);
+      break;
+    case schema::Type::TEXT:
+      Impl::writeString(input.as<Text>(), output);
+      break;
+    case schema::Type::DATA: {
+      Impl::writeChars(kj::StringPtr("["), output);
+      bool first = true;
+      for (byte b: input.as<Data>()) {
+        if (!first) Impl::writeChars(kj::StringPtr(","), output);
+        first = false;
+        Impl::writeNumber(b, output);
+      }
+      Impl::writeChars(kj::StringPtr("]"), output);
+      break;
+    }
+    case schema::Type::LIST: {
+      auto elementType = type.asList().getElementType();
+      Impl::writeChars(kj::StringPtr("["), output);
+      bool first = true;
+      for (auto element: input.as<DynamicList>()) {
+        if (!first) Impl::writeChars(kj::StringPtr(","), output);
+        first = false;
+        encodeStream(element, elementType, output);
+      }
+      Impl::writeChars(kj::StringPtr("]"), output);
+      break;
+    }
+    case schema::Type::ENUM: {
+      auto e = input.as<DynamicEnum>();
+      KJ_IF_MAYBE(symbol, e.getEnumerant()) {
+        Impl::writeString(symbol->getProto().getName(), output);
+      } else {
+        Impl::writeNumber(e.getRaw(), output);
+      }
+      break;
+    }
+    case schema::Type::STRUCT: {
+      auto structValue = input.as<capnp::DynamicStruct>();
+      Impl::writeChars(kj::StringPtr("{"), output);
+      bool first = true;
+      forEachEncodedField(structValue, [&](StructSchema::Field field, bool isNull) {
+        if (!first) Impl::writeChars(kj::StringPtr(","), output);
+        first = false;
+        Impl::writeString(field.getProto().getName(), output);
+        Impl::writeChars(kj::StringPtr(":"), output);
+        if (isNull) {
+          Impl::writeChars(kj::StringPtr("null"), output);
+        } else {
+          encodeFieldStream(field, structValue.get(field), output);
+        }
+      });
+      Impl::writeChars(kj::StringPtr("}"), output);
+      break;
+    }
+    case schema::Type::INTERFACE:
+      KJ_FAIL_REQUIRE("don't know how to JSON-encode capabilities; "
+                      "please register a JsonCodec::Handler for this");
+    case schema::Type::ANY_POINTER:
+      KJ_FAIL_REQUIRE("don't know how to JSON-encode AnyPointer; "
+                      "please register a JsonCodec::Handler for this");
+  }
+}
+
+void JsonCodec::encodeFieldStream(StructSchema::Field field, DynamicValue::Reader input,
+                                  kj::BufferedOutputStream& output) const {
+  auto iter = impl->fieldHandlers.find(field);
+  if (iter != impl->fieldHandlers.end()) {
+    MallocMessageBuilder message;
+    auto json = message.getRoot<JsonValue>();
+    iter->second->encodeBase(*this, input, json);
+    impl->encodeRaw(json.asReader(), output);
+    return;
+  }
+
+  encodeStream(input, field.getType(), output);
+}
+
 namespace {
 
 template <typename SetFn, typename DecodeArrayFn, typename DecodeObjectFn>
@@ -662,12 +925,214 @@ public:
     });
   }
 
+  kj::ArrayPtr<const char> consumeStringChars() {
+    // Consumes characters up to (not including) the next '"', '\\' or NUL, or the end of input.
+    // This is the inner loop of string parsing, so it looks at 16 bytes at a time where SSE2 is
+    // available.
+
+    const char* pos = wrapped.begin();
+    const char* end = wrapped.end();
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i nul = _mm_setzero_si128();
+    while (end - pos >= 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+      __m128i special = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+          _mm_cmpeq_epi8(chunk, nul));
+      uint mask = _mm_movemask_epi8(special);
+      if (mask != 0) {
+        pos += kj::countTrailingZeros(mask);
+        return consumeTo(pos);
+      }
+      pos += 16;
+    }
+#endif
+
+    while (pos < end && *pos != '"' && *pos != '\\' && *pos != '\0') ++pos;
+    return consumeTo(pos);
+  }
+
+  kj::ArrayPtr<const char> consumeNumber() {
+    auto numArrayPtr = consumeCustom([](Input& input) {
+      input.tryConsume('-');
+      if (!input.tryConsume('0')) {
+        input.consumeOne([](char c) { return '1' <= c && c <= '9'; });
+        input.consumeWhile([](char c) { return '0' <= c && c <= '9'; });
+      }
+
+      if (input.tryConsume('.')) {
+        input.consumeWhile([](char c) { return '0' <= c && c <= '9'; });
+      }
+
+      if (input.tryConsume('e') || input.tryConsume('E')) {
+        input.tryConsume('+') || input.tryConsume('-');
+        input.consumeWhile([](char c) { return '0' <= c && c <= '9'; });
+      }
+    });
+
+    KJ_REQUIRE(numArrayPtr.size() > 0, "Expected number in JSON input.");
+    return numArrayPtr;
+  }
+
+  kj::ArrayPtr<const char> consumeQuotedStringRaw(bool& hasEscapes) {
+    // Consumes a string literal and returns its body without unescaping it. `hasEscapes` is set
+    // if the body contains any escape sequences; they are validated later, by unescapeString().
+
+    consume('"');
+    auto originalPos = wrapped.begin();
+    hasEscapes = false;
+
+    for (;;) {
+      consumeStringChars();
+      char c = nextChar();
+      if (c == '"') break;
+      KJ_REQUIRE(c == '\\', "JSON message ends prematurely.");
+      hasEscapes = true;
+      advance();
+      advance(nextChar() == 'u' ? 5 : 1);
+    }
+
+    auto result = kj::arrayPtr(originalPos, wrapped.begin());
+    advance();
+    return result;
+  }
+
+  size_t countArrayElements() {
+    // Given that the input is positioned at the '[' of an array, counts the array's elements
+    // without consuming anything, by scanning for commas outside of strings and nested values.
+    // The scan does not validate; malformed input is rejected when it is actually parsed.
+
+    KJ_REQUIRE(nextChar() == '[', "Unexpected input in JSON message.");
+    const char* pos = wrapped.begin() + 1;
+    const char* end = wrapped.end();
+
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) ++pos;
+    if (pos == end || *pos == ']') return 0;
+
+    size_t count = 1;
+    uint depth = 0;
+    while (pos < end) {
+      switch (*pos++) {
+        case '"': {
+          Input str(kj::arrayPtr(pos, end));
+          for (;;) {
+            str.consumeStringChars();
+            if (str.exhausted() || str.wrapped.front() != '\\') break;
+            str.advance(kj::min(str.wrapped.size(), size_t(2)));
+          }
+          pos = str.wrapped.begin() + (str.wrapped.size() > 0);
+          break;
+        }
+        case '[': case '{':
+          ++depth;
+          break;
+        case ']': case '}':
+          if (depth == 0) return count;
+          --depth;
+          break;
+        case ',':
+          if (depth == 0) ++count;
+          break;
+        case '\0':
+          return count;
+        default:
+          break;
+      }
+    }
+    return count;
+  }
 
 private:
   kj::ArrayPtr<const char> wrapped;
 
+  kj::ArrayPtr<const char> consumeTo(const char* pos) {
+    auto result = kj::arrayPtr(wrapped.begin(), pos);
+    wrapped = kj::arrayPtr(pos, wrapped.end());
+    return result;
+  }
 };  // class Input
 
+double parseNumber(kj::ArrayPtr<const char> numberStr) {
+  // strtod() needs a NUL-terminated string.
+  KJ_STACK_ARRAY(char, terminated, numberStr.size() + 1, 64, 256);
+  memcpy(terminated.begin(), numberStr.begin(), numberStr.size());
+  terminated[numberStr.size()] = '\0';
+
+  char *endPtr;
+
+  errno = 0;
+  double value = strtod(terminated.begin(), &endPtr);
+
+  KJ_ASSERT(endPtr != terminated.begin(), "strtod should not fail! Is consumeNumber wrong?");
+  KJ_REQUIRE((value != HUGE_VAL && value != -HUGE_VAL) || errno != ERANGE,
+      "Overflow in JSON number.");
+  KJ_REQUIRE(value != 0.0 || errno != ERANGE,
+      "Underflow in JSON number.");
+
+  return value;
+}
+
+// TODO(someday): This won't work if/when surrogates are handled.
+char unescapeCodePoint(kj::ArrayPtr<const char> hex) {
+  KJ_REQUIRE(hex.size() == 4);
+  int codePoint = 0;
+
+  for (int i = 0; i < 4; ++i) {
+    char c = hex[i];
+    codePoint <<= 4;
+
+    if ('0' <= c && c <= '9') {
+      codePoint |= c - '0';
+    } else if ('a' <= c && c <= 'f') {
+      codePoint |= c - 'a' + 10;
+    } else if ('A' <= c && c <= 'F') {
+      codePoint |= c - 'A' + 10;
+    } else {
+      KJ_FAIL_REQUIRE("Invalid hex digit in unicode escape.", c);
+    }
+  }
+
+  // TODO(soon): Support at least basic multi-lingual plane, ie ignore surrogates.
+  KJ_REQUIRE(codePoint < 128, "non-ASCII unicode escapes are not supported (yet!)");
+  return 0x7f & static_cast<char>(codePoint);
+}
+
+size_t unescapeString(kj::ArrayPtr<const char> raw, char* out) {
+  // Decodes the body of a string literal, as returned by Input::consumeQuotedStringRaw(), into
+  // `out`, which must have room for raw.size() chars. Returns the decoded length.
+
+  char* outPos = out;
+  Input input(raw);
+  for (;;) {
+    auto chars = input.consumeStringChars();
+    memcpy(outPos, chars.begin(), chars.size());
+    outPos += chars.size();
+    if (input.exhausted()) break;
+
+    input.consume('\\');
+    switch (input.nextChar()) {
+      case '"' : *outPos++ = '"' ; input.advance(); break;
+      case '\\': *outPos++ = '\\'; input.advance(); break;
+      case '/' : *outPos++ = '/' ; input.advance(); break;
+      case 'b' : *outPos++ = '\b'; input.advance(); break;
+      case 'f' : *outPos++ = '\f'; input.advance(); break;
+      case 'n' : *outPos++ = '\n'; input.advance(); break;
+      case 'r' : *outPos++ = '\r'; input.advance(); break;
+      case 't' : *outPos++ = '\t'; input.advance(); break;
+      case 'u' :
+        input.consume('u');
+        *outPos++ = unescapeCodePoint(input.consume(size_t(4)));
+        break;
+      default: KJ_FAIL_REQUIRE("Invalid escape in JSON string."); break;
+    }
+  }
+
+  return outPos - out;
+}
+
 class Parser {
 public:
   Parser(size_t maxNestingDepth, kj::ArrayPtr<const char> input) :
@@ -694,19 +1159,7 @@ public:
   }
 
   void parseNumber(JsonValue::Builder& output) {
-    auto numberStr = consumeNumber();
-    char *endPtr;
-
-    errno = 0;
-    double value = strtod(numberStr.begin(), &endPtr);
-
-    KJ_ASSERT(endPtr != numberStr.begin(), "strtod should not fail! Is consumeNumber wrong?");
-    KJ_REQUIRE((value != HUGE_VAL && value != -HUGE_VAL) || errno != ERANGE,
-        "Overflow in JSON number.");
-    KJ_REQUIRE(value != 0.0 || errno != ERANGE,
-        "Underflow in JSON number.");
-
-    output.setNumber(value);
+    output.setNumber(capnp::parseNumber(input.consumeNumber()));
   }
 
   void parseString(JsonValue::Builder& output) {
@@ -798,104 +1251,326 @@ public:
 
 private:
   kj::String consumeQuotedString() {
-    input.consume('"');
-    // TODO(perf): Avoid copy / alloc if no escapes encoutered.
-    // TODO(perf): Get statistics on string size and preallocate?
-    kj::Vector<char> decoded;
-
-    do {
-      auto stringValue = input.consumeWhile([](const char chr) {
-          return chr != '"' && chr != '\\';
-      });
+    bool hasEscapes;
+    auto raw = input.consumeQuotedStringRaw(hasEscapes);
+    if (!hasEscapes) {
+      return kj::heapString(raw);
+    }
+
+    KJ_STACK_ARRAY(char, decoded, raw.size(), 256, 4096);
+    return kj::heapString(decoded.begin(), unescapeString(raw, decoded.begin()));
+  }
+
+  const size_t maxNestingDepth;
+  Input input;
+  size_t nestingDepth;
 
-      decoded.addAll(stringValue);
-
-      if (input.nextChar() == '\\') {  // handle escapes.
-        input.advance();
-        switch(input.nextChar()) {
-          case '"' : decoded.add('"' ); input.advance(); break;
-          case '\\': decoded.add('\\'); input.advance(); break;
-          case '/' : decoded.add('/' ); input.advance(); break;
-          case 'b' : decoded.add('\b'); input.advance(); break;
-          case 'f' : decoded.add('\f'); input.advance(); break;
-          case 'n' : decoded.add('\n'); input.advance(); break;
-          case 'r' : decoded.add('\r'); input.advance(); break;
-          case 't' : decoded.add('\t'); input.advance(); break;
-          case 'u' :
-            input.consume('u');
-            unescapeAndAppend(input.consume(size_t(4)), decoded);
-            break;
-          default: KJ_FAIL_REQUIRE("Invalid escape in JSON string."); break;
-        }
-      }
 
-    } while(input.nextChar() != '"');
+};  // class Parser
+
+class StructDecoder {
+  // Decodes JSON text straight into a DynamicStruct::Builder, in a single pass and without building
+  // a JsonValue first. Accepts the same inputs as decodeRaw() followed by
+  // JsonCodec::decode(JsonValue::Reader, DynamicStruct::Builder), including validating the syntax
+  // of values for unknown fields, but since it stops at the first problem, input that is wrong in
+  // more than one way may be reported differently.
+  //
+  // List sizes must be known before a list can be initialized, so on reaching an array this first
+  // scans ahead to count its elements (Input::countArrayElements()). Nested arrays are therefore
+  // scanned once per level of nesting, which is bounded by the maximum nesting depth.
 
-    input.consume('"');
-    decoded.add('\0');
+public:
+  StructDecoder(size_t maxNestingDepth, kj::ArrayPtr<const char> input) :
+    maxNestingDepth(maxNestingDepth), input(input), nestingDepth(0) {}
 
-    // TODO(perf): This copy can be eliminated, but I can't find the kj::wayToDoIt();
-    return kj::String(decoded.releaseAsArray());
+  void decodeRoot(DynamicStruct::Builder output) {
+    input.consumeWhitespace();
+    KJ_REQUIRE(!input.exhausted(), "JSON message ends prematurely.");
+    KJ_REQUIRE(input.nextChar() == '{', "Top level json value must be object");
+    decodeObject(output);
+    input.consumeWhitespace();
+    KJ_REQUIRE(input.exhausted(), "Input remains after parsing JSON.");
   }
 
-  kj::String consumeNumber() {
-    auto numArrayPtr = input.consumeCustom([](Input& input) {
-      input.tryConsume('-');
-      if (!input.tryConsume('0')) {
-        input.consumeOne([](char c) { return '1' <= c && c <= '9'; });
-        input.consumeWhile([](char c) { return '0' <= c && c <= '9'; });
-      }
+private:
+  const size_t maxNestingDepth;
+  Input input;
+  size_t nestingDepth;
+  kj::Vector<char> scratch;
 
-      if (input.tryConsume('.')) {
-        input.consumeWhile([](char c) { return '0' <= c && c <= '9'; });
-      }
+  struct FieldSlot {
+    DynamicStruct::Builder parent;
+    StructSchema::Field field;
 
-      if (input.tryConsume('e') || input.tryConsume('E')) {
-        input.tryConsume('+') || input.tryConsume('-');
-        input.consumeWhile([](char c) { return '0' <= c && c <= '9'; });
+    void set(DynamicValue::Reader value) { parent.set(field, value); }
+    DynamicValue::Builder init(uint size) { return parent.init(field, size); }
+    DynamicStruct::Builder initStruct() { return parent.init(field).as<DynamicStruct>(); }
+  };
+
+  struct ElementSlot {
+    DynamicList::Builder parent;
+    uint index;
+
+    void set(DynamicValue::Reader value) { parent.set(index, value); }
+    DynamicValue::Builder init(uint size) { return parent.init(index, size); }
+    DynamicStruct::Builder initStruct() { return parent[index].as<DynamicStruct>(); }
+  };
+
+  void enter() {
+    KJ_REQUIRE(++nestingDepth <= maxNestingDepth, "JSON message nested too deeply.");
+  }
+
+  template <typename Func>
+  void forEachElement(char open, char close, Func&& func) {
+    // Consumes a JSON array or object, calling func() with the input positioned at each element.
+
+    input.consume(open);
+    enter();
+    KJ_DEFER(--nestingDepth);
+
+    bool expectComma = false;
+    while (input.consumeWhitespace(), input.nextChar() != close) {
+      if (expectComma) {
+        input.consume(',');
+        input.consumeWhitespace();
+        KJ_REQUIRE(input.nextChar() != close, "Unexpected input in JSON message.");
       }
-    });
+      func();
+      input.consumeWhitespace();
+      expectComma = true;
+    }
 
-    KJ_REQUIRE(numArrayPtr.size() > 0, "Expected number in JSON input.");
+    input.consume(close);
+  }
+
+  kj::StringPtr decodeStringToScratch() {
+    // Decodes a string literal into `scratch` and returns it, NUL-terminated. Used for strings
+    // that are only looked at, not stored, such as field and enumerant names.
 
-    kj::Vector<char> number;
-    number.addAll(numArrayPtr);
-    number.add('\0');
+    bool hasEscapes;
+    auto raw = input.consumeQuotedStringRaw(hasEscapes);
+    scratch.resize(raw.size() + 1);
+    size_t size = raw.size();
+    if (hasEscapes) {
+      size = unescapeString(raw, scratch.begin());
+    } else {
+      memcpy(scratch.begin(), raw.begin(), raw.size());
+    }
+    scratch[size] = '\0';
+    return kj::StringPtr(scratch.begin(), size);
+  }
+
+  template <typename Slot>
+  void decodeText(Slot slot) {
+    // Decodes a string literal directly into the message. Only strings containing escapes make
+    // an intermediate copy, since their length is not known until they are unescaped.
+
+    bool hasEscapes;
+    auto raw = input.consumeQuotedStringRaw(hasEscapes);
+    if (hasEscapes) {
+      scratch.resize(raw.size());
+      raw = kj::arrayPtr(scratch.begin(), unescapeString(raw, scratch.begin()));
+    }
+    auto text = slot.init(raw.size()).template as<Text>();
+    memcpy(text.begin(), raw.begin(), raw.size());
+  }
+
+  template <typename Slot>
+  void decodeData(Slot slot) {
+    auto data = slot.init(input.countArrayElements()).template as<Data>();
+
+    uint i = 0;
+    forEachElement('[', ']', [&]() {
+      KJ_REQUIRE(i < data.size(), "Unexpected input in JSON message.");
+      auto x = capnp::parseNumber(input.consumeNumber());
+      KJ_REQUIRE(byte(x) == x, "Number in byte array is not an integer in [0, 255]");
+      data[i++] = byte(x);
+    });
+    KJ_REQUIRE(i == data.size(), "Unexpected input in JSON message.");
+  }
 
-    return kj::String(number.releaseAsArray());
+  template <typename Slot>
+  void decodeList(ListSchema schema, Slot slot) {
+    auto list = slot.init(input.countArrayElements()).template as<DynamicList>();
+
+    auto elementType = schema.getElementType();
+    uint i = 0;
+    forEachElement('[', ']', [&]() {
+      KJ_REQUIRE(i < list.size(), "Unexpected input in JSON message.");
+      decodeValue(elementType, ElementSlot { list, i++ });
+    });
+    KJ_REQUIRE(i == list.size(), "Unexpected input in JSON message.");
   }
 
-  // TODO(someday): This "interface" is ugly, and won't work if/when surrogates are handled.
-  void unescapeAndAppend(kj::ArrayPtr<const char> hex, kj::Vector<char>& target) {
-    KJ_REQUIRE(hex.size() == 4);
-    int codePoint = 0;
+  void decodeObject(DynamicStruct::Builder output) {
+    auto schema = output.getSchema();
+    forEachElement('{', '}', [&]() {
+      auto name = decodeStringToScratch();
+      auto maybeField = schema.findFieldByName(name);
 
-    for (int i = 0; i < 4; ++i) {
-      char c = hex[i];
-      codePoint <<= 4;
+      input.consumeWhitespace();
+      input.consume(':');
+      input.consumeWhitespace();
 
-      if ('0' <= c && c <= '9') {
-        codePoint |= c - '0';
-      } else if ('a' <= c && c <= 'f') {
-        codePoint |= c - 'a';
-      } else if ('A' <= c && c <= 'F') {
-        codePoint |= c - 'A';
+      KJ_IF_MAYBE(field, maybeField) {
+        decodeValue(field->getType(), FieldSlot { output, *field });
       } else {
-        KJ_FAIL_REQUIRE("Invalid hex digit in unicode escape.", c);
+        // Unknown json fields are ignored to allow schema evolution
+        skipValue();
       }
-    }
+    });
+  }
+
+  template <typename Slot>
+  void decodeValue(Type type, Slot slot) {
+    // Counterpart of decodeField() for the two-pass decoder; keep the two in sync.
 
-    // TODO(soon): Support at least basic multi-lingual plane, ie ignore surrogates.
-    KJ_REQUIRE(codePoint < 128, "non-ASCII unicode escapes are not supported (yet!)");
-    target.add(0x7f & static_cast<char>(codePoint));
+    KJ_REQUIRE(!input.exhausted(), "JSON message ends prematurely.");
+    char c = input.nextChar();
+    bool isNumber = c == '-' || ('0' <= c && c <= '9');
+
+    switch (type.which()) {
+      case schema::Type::VOID:
+        skipValue();
+        break;
+      case schema::Type::BOOL:
+        if (c == 't') {
+          input.consume(kj::StringPtr("true"));
+          slot.set(true);
+        } else if (c == 'f') {
+          input.consume(kj::StringPtr("false"));
+          slot.set(false);
+        } else {
+          KJ_FAIL_REQUIRE("Expected boolean value");
+        }
+        break;
+      case schema::Type::INT8:
+      case schema::Type::INT16:
+      case schema::Type::INT32:
+      case schema::Type::INT64:
+        // Relies on range check in DynamicValue::Reader::as<IntType>
+        if (isNumber) {
+          slot.set(capnp::parseNumber(input.consumeNumber()));
+        } else if (c == '"') {
+          slot.set(decodeStringToScratch().parseAs<int64_t>());
+        } else {
+          KJ_FAIL_REQUIRE("Expected integer value");
+        }
+        break;
+      case schema::Type::UINT8:
+      case schema::Type::UINT16:
+      case schema::Type::UINT32:
+      case schema::Type::UINT64:
+        // Relies on range check in DynamicValue::Reader::as<IntType>
+        if (isNumber) {
+          slot.set(capnp::parseNumber(input.consumeNumber()));
+        } else if (c == '"') {
+          slot.set(decodeStringToScratch().parseAs<uint64_t>());
+        } else {
+          KJ_FAIL_REQUIRE("Expected integer value");
+        }
+        break;
+      case schema::Type::FLOAT32:
+      case schema::Type::FLOAT64:
+        if (c == 'n') {
+          input.consume(kj::StringPtr("null"));
+          slot.set(kj::nan());
+        } else if (isNumber) {
+          slot.set(capnp::parseNumber(input.consumeNumber()));
+        } else if (c == '"') {
+          slot.set(decodeStringToScratch().parseAs<double>());
+        } else {
+          KJ_FAIL_REQUIRE("Expected float value");
+        }
+        break;
+      case schema::Type::TEXT:
+        if (c == '"') {
+          decodeText(slot);
+        } else {
+          KJ_FAIL_REQUIRE("Expected text value");
+        }
+        break;
+      case schema::Type::DATA:
+        if (c == '[') {
+          decodeData(slot);
+        } else {
+          KJ_FAIL_REQUIRE("Expected data value");
+        }
+        break;
+      case schema::Type::LIST:
+        if (c == 'n') {
+          input.consume(kj::StringPtr("null"));
+        } else if (c == '[') {
+          decodeList(type.asList(), slot);
+        } else {
+          KJ_FAIL_REQUIRE("Expected list value");
+        }
+        break;
+      case schema::Type::ENUM:
+        if (c == '"') {
+          slot.set(Text::Reader(decodeStringToScratch()));
+        } else {
+          KJ_FAIL_REQUIRE("Expected enum value");
+        }
+        break;
+      case schema::Type::STRUCT:
+        if (c == 'n') {
+          input.consume(kj::StringPtr("null"));
+        } else if (c == '{') {
+          decodeObject(slot.initStruct());
+        } else {
+          KJ_FAIL_REQUIRE("Expected object value");
+        }
+        break;
+      case schema::Type::INTERFACE:
+        KJ_FAIL_REQUIRE("don't know how to JSON-decode capabilities; "
+                        "JsonCodec::Handler not implemented yet :(");
+      case schema::Type::ANY_POINTER:
+        KJ_FAIL_REQUIRE("don't know how to JSON-decode AnyPointer; "
+                        "JsonCodec::Handler not implemented yet :(");
+    }
   }
 
-  const size_t maxNestingDepth;
-  Input input;
-  size_t nestingDepth;
+  void skipString() {
+    bool hasEscapes;
+    auto raw = input.consumeQuotedStringRaw(hasEscapes);
+    if (hasEscapes) {
+      // Validate the escapes.
+      scratch.resize(raw.size());
+      unescapeString(raw, scratch.begin());
+    }
+  }
 
+  void skipValue() {
+    // Consumes and validates one value without storing it.
 
-};  // class Parser
+    KJ_REQUIRE(!input.exhausted(), "JSON message ends prematurely.");
+    switch (input.nextChar()) {
+      case 'n': input.consume(kj::StringPtr("null"));  break;
+      case 'f': input.consume(kj::StringPtr("false")); break;
+      case 't': input.consume(kj::StringPtr("true"));  break;
+      case '"':
+        skipString();
+        break;
+      case '[':
+        forEachElement('[', ']', [&]() { skipValue(); });
+        break;
+      case '{':
+        forEachElement('{', '}', [&]() {
+          skipString();
+          input.consumeWhitespace();
+          input.consume(':');
+          input.consumeWhitespace();
+          skipValue();
+        });
+        break;
+      case '-': case '0': case '1': case '2': case '3':
+      case '4': case '5': case '6': case '7': case '8':
+      case '9': capnp::parseNumber(input.consumeNumber()); break;
+      default: KJ_FAIL_REQUIRE("Unexpected input in JSON message.");
+    }
+  }
+};  // class StructDecoder
 
 }  // namespace
 
@@ -907,6 +1582,12 @@ void JsonCodec::decodeRaw(kj::ArrayPtr<const char> input, JsonValue::Builder out
   KJ_REQUIRE(parser.inputExhausted(), "Input remains after parsing JSON.");
 }
 
+void JsonCodec::decode(kj::ArrayPtr<const char> input, DynamicStruct::Builder output) const {
+  // Type and field handlers are not applied when decoding yet (see decode(JsonValue::Reader, ...)),
+  // so there is no need for an intermediate JsonValue.
+  StructDecoder(impl->maxNestingDepth, input).decodeRoot(output);
+}
+
 // -----------------------------------------------------------------------------
 
 Orphan<DynamicValue> JsonCodec::HandlerBase::decodeBase(
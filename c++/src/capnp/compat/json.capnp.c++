@@ -153,10 +153,11 @@ static const ::capnp::_::RawSchema* const d_8825ffaa852cda72[] = {
   &s_c27855d853a937cc,
 };
 static const uint16_t m_8825ffaa852cda72[] = {4, 1, 6, 0, 2, 5, 3};
+static const uint16_t h_8825ffaa852cda72[] = {2, 65535, 65535, 65535, 0, 65535, 4, 65535, 3, 6, 5, 65535, 65535, 65535, 65535, 1};
 static const uint16_t i_8825ffaa852cda72[] = {0, 1, 2, 3, 4, 5, 6};
 const ::capnp::_::RawSchema s_8825ffaa852cda72 = {
   0x8825ffaa852cda72, b_8825ffaa852cda72.words, 138, d_8825ffaa852cda72, m_8825ffaa852cda72,
-  3, 7, i_8825ffaa852cda72, nullptr, nullptr, { &s_8825ffaa852cda72, nullptr, nullptr, 0, 0, nullptr }
+  h_8825ffaa852cda72, 3, 7, i_8825ffaa852cda72, nullptr, nullptr, { &s_8825ffaa852cda72, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<49> b_c27855d853a937cc = {
@@ -216,10 +217,11 @@ static const ::capnp::_::RawSchema* const d_c27855d853a937cc[] = {
   &s_8825ffaa852cda72,
 };
 static const uint16_t m_c27855d853a937cc[] = {0, 1};
+static const uint16_t h_c27855d853a937cc[] = {65535, 65535, 0, 1};
 static const uint16_t i_c27855d853a937cc[] = {0, 1};
 const ::capnp::_::RawSchema s_c27855d853a937cc = {
   0xc27855d853a937cc, b_c27855d853a937cc.words, 49, d_c27855d853a937cc, m_c27855d853a937cc,
-  1, 2, i_c27855d853a937cc, nullptr, nullptr, { &s_c27855d853a937cc, nullptr, nullptr, 0, 0, nullptr }
+  h_c27855d853a937cc, 1, 2, i_c27855d853a937cc, nullptr, nullptr, { &s_c27855d853a937cc, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<54> b_9bbf84153dd4bb60 = {
@@ -284,10 +286,11 @@ static const ::capnp::_::RawSchema* const d_9bbf84153dd4bb60[] = {
   &s_8825ffaa852cda72,
 };
 static const uint16_t m_9bbf84153dd4bb60[] = {0, 1};
+static const uint16_t h_9bbf84153dd4bb60[] = {65535, 0, 65535, 1};
 static const uint16_t i_9bbf84153dd4bb60[] = {0, 1};
 const ::capnp::_::RawSchema s_9bbf84153dd4bb60 = {
   0x9bbf84153dd4bb60, b_9bbf84153dd4bb60.words, 54, d_9bbf84153dd4bb60, m_9bbf84153dd4bb60,
-  1, 2, i_9bbf84153dd4bb60, nullptr, nullptr, { &s_9bbf84153dd4bb60, nullptr, nullptr, 0, 0, nullptr }
+  h_9bbf84153dd4bb60, 1, 2, i_9bbf84153dd4bb60, nullptr, nullptr, { &s_9bbf84153dd4bb60, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 }  // namespace schemas
@@ -25,6 +25,7 @@
 #include <capnp/schema.h>
 #include <capnp/dynamic.h>
 #include <capnp/compat/json.capnp.h>
+#include <kj/io.h>
 
 namespace capnp {
 
@@ -85,6 +86,18 @@ public:
   // not distinguish between e.g. int32 and int64, which in JSON are handled differently. Most
   // of the time, though, you can use the single-argument templated version of `encode()` instead.
 
+  template <typename T>
+  void encode(T&& value, kj::OutputStream& output) const;
+  void encode(DynamicValue::Reader value, Type type, kj::OutputStream& output) const;
+  // Like encode() above, but write the text to `output` as it is produced instead of building a
+  // JsonValue tree and a kj::String first, so memory use does not grow with the size of the
+  // value. Handlers are still honored; the output of each handler is built as a (small) JsonValue
+  // and then written out. If `output` is not a kj::BufferedOutputStream, writes are buffered
+  // internally. The text is identical to what encode() returns.
+  //
+  // Pretty-printing decides on a layout for each array or object by looking at the encoded sizes
+  // of its elements, so when it is enabled the whole value is encoded up front and then written.
+
   void decode(kj::ArrayPtr<const char> input, DynamicStruct::Builder output) const;
   // Decode JSON text directly into a struct builder. This only works for structs since lists
   // need to be allocated with the correct size in advance.
@@ -122,6 +135,7 @@ public:
   // for calling from Handler implementations.
 
   kj::String encodeRaw(JsonValue::Reader value) const;
+  void encodeRaw(JsonValue::Reader value, kj::OutputStream& output) const;
   void decodeRaw(kj::ArrayPtr<const char> input, JsonValue::Builder output) const;
   // Translate JsonValue <-> text.
 
@@ -201,6 +215,10 @@ private:
 
   void encodeField(StructSchema::Field field, DynamicValue::Reader input,
                    JsonValue::Builder output) const;
+  void encodeStream(DynamicValue::Reader input, Type type,
+                    kj::BufferedOutputStream& output) const;
+  void encodeFieldStream(StructSchema::Field field, DynamicValue::Reader input,
+                         kj::BufferedOutputStream& output) const;
   void decodeArray(List<JsonValue>::Reader input, DynamicList::Builder output) const;
   void decodeObject(List<JsonValue::Field>::Reader input, DynamicStruct::Builder output) const;
   void addTypeHandlerImpl(Type type, HandlerBase& handler);
@@ -216,6 +234,12 @@ kj::String JsonCodec::encode(T&& value) {
   return encode(DynamicValue::Reader(ReaderFor<Base>(kj::fwd<T>(value))), Type::from<Base>());
 }
 
+template <typename T>
+void JsonCodec::encode(T&& value, kj::OutputStream& output) const {
+  typedef FromAny<kj::Decay<T>> Base;
+  encode(DynamicValue::Reader(ReaderFor<Base>(kj::fwd<T>(value))), Type::from<Base>(), output);
+}
+
 template <typename T>
 inline Orphan<T> JsonCodec::decode(kj::ArrayPtr<const char> input, Orphanage orphanage) const {
   return decode(input, Type::from<T>(), orphanage).template releaseAs<T>();
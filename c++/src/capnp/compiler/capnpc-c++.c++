@@ -128,6 +128,24 @@ kj::Array<uint> makeMembersByName(MemberList&& members) {
   return KJ_MAP(member, sorted) { return member.getIndex(); };
 }
 
+template <typename MemberList>
+kj::Array<uint> makeMembersByNameHash(MemberList&& members) {
+  // Builds the open-addressed table that the runtime probes in findSchemaMemberByName().
+
+  if (members.size() == 0) return nullptr;
+
+  auto table = kj::heapArray<uint>(_::memberNameHashTableSize(members.size()));
+  for (auto& slot: table) slot = _::EMPTY_MEMBER_SLOT;
+
+  uint mask = table.size() - 1;
+  for (auto member: members) {
+    uint slot = _::hashMemberName(member.getProto().getName()) & mask;
+    while (table[slot] != _::EMPTY_MEMBER_SLOT) slot = (slot + 1) & mask;
+    table[slot] = member.getIndex();
+  }
+  return table;
+}
+
 kj::StringPtr baseName(kj::StringPtr path) {
   KJ_IF_MAYBE(slashPos, path.findLast('/')) {
     return path.slice(*slashPos + 1);
@@ -2596,11 +2614,13 @@ private:
     enumerateDeps(proto, deps);
 
     kj::Array<uint> membersByName;
+    kj::Array<uint> membersByNameHash;
     kj::Array<uint> membersByDiscrim;
     switch (proto.which()) {
       case schema::Node::STRUCT: {
         auto structSchema = schema.asStruct();
         membersByName = makeMembersByName(structSchema.getFields());
+        membersByNameHash = makeMembersByNameHash(structSchema.getFields());
         auto builder = kj::heapArrayBuilder<uint>(structSchema.getFields().size());
         for (auto field: structSchema.getUnionFields()) {
           builder.add(field.getIndex());
@@ -2613,9 +2633,11 @@ private:
       }
       case schema::Node::ENUM:
         membersByName = makeMembersByName(schema.asEnum().getEnumerants());
+        membersByNameHash = makeMembersByNameHash(schema.asEnum().getEnumerants());
         break;
       case schema::Node::INTERFACE:
         membersByName = makeMembersByName(schema.asInterface().getMethods());
+        membersByNameHash = makeMembersByNameHash(schema.asInterface().getMethods());
         break;
       default:
         break;
@@ -2639,6 +2661,10 @@ private:
             "static const uint16_t m_", hexId, "[] = {",
             kj::StringTree(KJ_MAP(index, membersByName) { return kj::strTree(index); }, ", "),
             "};\n"),
+        membersByNameHash.size() == 0 ? kj::strTree() : kj::strTree(
+            "static const uint16_t h_", hexId, "[] = {",
+            kj::StringTree(KJ_MAP(index, membersByNameHash) { return kj::strTree(index); }, ", "),
+            "};\n"),
         membersByDiscrim.size() == 0 ? kj::strTree() : kj::strTree(
             "static const uint16_t i_", hexId, "[] = {",
             kj::StringTree(KJ_MAP(index, membersByDiscrim) { return kj::strTree(index); }, ", "),
@@ -2649,7 +2675,8 @@ private:
         "  0x", hexId, ", b_", hexId, ".words, ", rawSchema.size(), ", ",
         deps.size() == 0 ? kj::strTree("nullptr") : kj::strTree("d_", hexId), ", ",
         membersByName.size() == 0 ? kj::strTree("nullptr") : kj::strTree("m_", hexId), ",\n",
-        "  ", deps.size(), ", ", membersByName.size(), ", ",
+        "  ", membersByNameHash.size() == 0 ? kj::strTree("nullptr") : kj::strTree("h_", hexId),
+        ", ", deps.size(), ", ", membersByName.size(), ", ",
         membersByDiscrim.size() == 0 ? kj::strTree("nullptr") : kj::strTree("i_", hexId),
         ", nullptr, nullptr, { &s_", hexId, ", nullptr, ",
         brandDeps.size() == 0 ? kj::strTree("nullptr, 0, 0") : kj::strTree(
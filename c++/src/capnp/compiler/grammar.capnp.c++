@@ -76,10 +76,11 @@ static const ::capnp::_::AlignedData<66> b_e75816b56529d464 = {
 ::capnp::word const* const bp_e75816b56529d464 = b_e75816b56529d464.words;
 #if !CAPNP_LITE
 static const uint16_t m_e75816b56529d464[] = {2, 1, 0};
+static const uint16_t h_e75816b56529d464[] = {2, 65535, 0, 65535, 65535, 1, 65535, 65535};
 static const uint16_t i_e75816b56529d464[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_e75816b56529d464 = {
   0xe75816b56529d464, b_e75816b56529d464.words, 66, nullptr, m_e75816b56529d464,
-  0, 3, i_e75816b56529d464, nullptr, nullptr, { &s_e75816b56529d464, nullptr, nullptr, 0, 0, nullptr }
+  h_e75816b56529d464, 0, 3, i_e75816b56529d464, nullptr, nullptr, { &s_e75816b56529d464, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<66> b_991c7a3693d62cf2 = {
@@ -153,10 +154,11 @@ static const ::capnp::_::AlignedData<66> b_991c7a3693d62cf2 = {
 ::capnp::word const* const bp_991c7a3693d62cf2 = b_991c7a3693d62cf2.words;
 #if !CAPNP_LITE
 static const uint16_t m_991c7a3693d62cf2[] = {2, 1, 0};
+static const uint16_t h_991c7a3693d62cf2[] = {2, 65535, 0, 65535, 65535, 1, 65535, 65535};
 static const uint16_t i_991c7a3693d62cf2[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_991c7a3693d62cf2 = {
   0x991c7a3693d62cf2, b_991c7a3693d62cf2.words, 66, nullptr, m_991c7a3693d62cf2,
-  0, 3, i_991c7a3693d62cf2, nullptr, nullptr, { &s_991c7a3693d62cf2, nullptr, nullptr, 0, 0, nullptr }
+  h_991c7a3693d62cf2, 0, 3, i_991c7a3693d62cf2, nullptr, nullptr, { &s_991c7a3693d62cf2, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<66> b_90f2a60678fd2367 = {
@@ -230,10 +232,11 @@ static const ::capnp::_::AlignedData<66> b_90f2a60678fd2367 = {
 ::capnp::word const* const bp_90f2a60678fd2367 = b_90f2a60678fd2367.words;
 #if !CAPNP_LITE
 static const uint16_t m_90f2a60678fd2367[] = {2, 1, 0};
+static const uint16_t h_90f2a60678fd2367[] = {2, 65535, 0, 65535, 65535, 1, 65535, 65535};
 static const uint16_t i_90f2a60678fd2367[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_90f2a60678fd2367 = {
   0x90f2a60678fd2367, b_90f2a60678fd2367.words, 66, nullptr, m_90f2a60678fd2367,
-  0, 3, i_90f2a60678fd2367, nullptr, nullptr, { &s_90f2a60678fd2367, nullptr, nullptr, 0, 0, nullptr }
+  h_90f2a60678fd2367, 0, 3, i_90f2a60678fd2367, nullptr, nullptr, { &s_90f2a60678fd2367, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<262> b_8e207d4dfe54d0de = {
@@ -510,10 +513,11 @@ static const ::capnp::_::RawSchema* const d_8e207d4dfe54d0de[] = {
   &s_e75816b56529d464,
 };
 static const uint16_t m_8e207d4dfe54d0de[] = {13, 11, 10, 15, 9, 3, 14, 6, 12, 2, 1, 5, 8, 4, 7, 0};
+static const uint16_t h_8e207d4dfe54d0de[] = {9, 6, 65535, 1, 2, 3, 11, 12, 65535, 65535, 65535, 65535, 65535, 65535, 15, 65535, 65535, 7, 65535, 65535, 14, 65535, 65535, 13, 4, 0, 65535, 65535, 10, 8, 5, 65535};
 static const uint16_t i_8e207d4dfe54d0de[] = {0, 1, 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 14, 15, 8, 9};
 const ::capnp::_::RawSchema s_8e207d4dfe54d0de = {
   0x8e207d4dfe54d0de, b_8e207d4dfe54d0de.words, 262, d_8e207d4dfe54d0de, m_8e207d4dfe54d0de,
-  5, 16, i_8e207d4dfe54d0de, nullptr, nullptr, { &s_8e207d4dfe54d0de, nullptr, nullptr, 0, 0, nullptr }
+  h_8e207d4dfe54d0de, 5, 16, i_8e207d4dfe54d0de, nullptr, nullptr, { &s_8e207d4dfe54d0de, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<65> b_c90246b71adedbaa = {
@@ -590,10 +594,11 @@ static const ::capnp::_::RawSchema* const d_c90246b71adedbaa[] = {
   &s_e75816b56529d464,
 };
 static const uint16_t m_c90246b71adedbaa[] = {1, 0, 2};
+static const uint16_t h_c90246b71adedbaa[] = {65535, 65535, 2, 65535, 65535, 65535, 1, 0};
 static const uint16_t i_c90246b71adedbaa[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_c90246b71adedbaa = {
   0xc90246b71adedbaa, b_c90246b71adedbaa.words, 65, d_c90246b71adedbaa, m_c90246b71adedbaa,
-  2, 3, i_c90246b71adedbaa, nullptr, nullptr, { &s_c90246b71adedbaa, nullptr, nullptr, 0, 0, nullptr }
+  h_c90246b71adedbaa, 2, 3, i_c90246b71adedbaa, nullptr, nullptr, { &s_c90246b71adedbaa, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<55> b_aee8397040b0df7a = {
@@ -660,10 +665,11 @@ static const ::capnp::_::RawSchema* const d_aee8397040b0df7a[] = {
   &s_c90246b71adedbaa,
 };
 static const uint16_t m_aee8397040b0df7a[] = {0, 1};
+static const uint16_t h_aee8397040b0df7a[] = {65535, 0, 65535, 1};
 static const uint16_t i_aee8397040b0df7a[] = {0, 1};
 const ::capnp::_::RawSchema s_aee8397040b0df7a = {
   0xaee8397040b0df7a, b_aee8397040b0df7a.words, 55, d_aee8397040b0df7a, m_aee8397040b0df7a,
-  2, 2, i_aee8397040b0df7a, nullptr, nullptr, { &s_aee8397040b0df7a, nullptr, nullptr, 0, 0, nullptr }
+  h_aee8397040b0df7a, 2, 2, i_aee8397040b0df7a, nullptr, nullptr, { &s_aee8397040b0df7a, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<49> b_aa28e1400d793359 = {
@@ -724,10 +730,11 @@ static const ::capnp::_::RawSchema* const d_aa28e1400d793359[] = {
   &s_e75816b56529d464,
 };
 static const uint16_t m_aa28e1400d793359[] = {1, 0};
+static const uint16_t h_aa28e1400d793359[] = {65535, 0, 1, 65535};
 static const uint16_t i_aa28e1400d793359[] = {0, 1};
 const ::capnp::_::RawSchema s_aa28e1400d793359 = {
   0xaa28e1400d793359, b_aa28e1400d793359.words, 49, d_aa28e1400d793359, m_aa28e1400d793359,
-  2, 2, i_aa28e1400d793359, nullptr, nullptr, { &s_aa28e1400d793359, nullptr, nullptr, 0, 0, nullptr }
+  h_aa28e1400d793359, 2, 2, i_aa28e1400d793359, nullptr, nullptr, { &s_aa28e1400d793359, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<677> b_96efe787c17e83bb = {
@@ -1426,10 +1433,11 @@ static const ::capnp::_::RawSchema* const d_96efe787c17e83bb[] = {
   &s_eb971847d617c0b9,
 };
 static const uint16_t m_96efe787c17e83bb[] = {18, 3, 40, 37, 39, 22, 41, 34, 31, 32, 24, 25, 26, 23, 35, 36, 33, 28, 29, 30, 27, 21, 9, 6, 5, 10, 11, 13, 7, 15, 1, 16, 17, 20, 19, 0, 2, 38, 4, 12, 14, 8};
+static const uint16_t h_96efe787c17e83bb[] = {5, 3, 10, 2, 24, 65535, 65535, 8, 65535, 65535, 65535, 65535, 15, 20, 6, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 31, 37, 65535, 65535, 39, 12, 22, 30, 26, 65535, 19, 65535, 65535, 34, 65535, 65535, 23, 65535, 65535, 65535, 28, 16, 17, 32, 65535, 65535, 65535, 40, 36, 65535, 65535, 65535, 65535, 65535, 4, 65535, 65535, 65535, 29, 65535, 7, 65535, 65535, 65535, 65535, 27, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 9, 65535, 65535, 33, 65535, 38, 65535, 65535, 65535, 65535, 41, 65535, 1, 65535, 65535, 65535, 65535, 65535, 0, 13, 18, 35, 65535, 65535, 65535, 65535, 65535, 65535, 11, 65535, 65535, 65535, 14, 65535, 65535, 65535, 65535, 65535, 21, 65535, 25, 65535, 65535, 65535};
 static const uint16_t i_96efe787c17e83bb[] = {7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 39, 40, 41, 0, 1, 2, 3, 4, 5, 6, 38};
 const ::capnp::_::RawSchema s_96efe787c17e83bb = {
   0x96efe787c17e83bb, b_96efe787c17e83bb.words, 677, d_96efe787c17e83bb, m_96efe787c17e83bb,
-  12, 42, i_96efe787c17e83bb, nullptr, nullptr, { &s_96efe787c17e83bb, nullptr, nullptr, 0, 0, nullptr }
+  h_96efe787c17e83bb, 12, 42, i_96efe787c17e83bb, nullptr, nullptr, { &s_96efe787c17e83bb, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<67> b_d5e71144af1ce175 = {
@@ -1504,10 +1512,11 @@ static const ::capnp::_::AlignedData<67> b_d5e71144af1ce175 = {
 ::capnp::word const* const bp_d5e71144af1ce175 = b_d5e71144af1ce175.words;
 #if !CAPNP_LITE
 static const uint16_t m_d5e71144af1ce175[] = {2, 0, 1};
+static const uint16_t h_d5e71144af1ce175[] = {2, 65535, 65535, 65535, 65535, 1, 0, 65535};
 static const uint16_t i_d5e71144af1ce175[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_d5e71144af1ce175 = {
   0xd5e71144af1ce175, b_d5e71144af1ce175.words, 67, nullptr, m_d5e71144af1ce175,
-  0, 3, i_d5e71144af1ce175, nullptr, nullptr, { &s_d5e71144af1ce175, nullptr, nullptr, 0, 0, nullptr }
+  h_d5e71144af1ce175, 0, 3, i_d5e71144af1ce175, nullptr, nullptr, { &s_d5e71144af1ce175, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<45> b_d00489d473826290 = {
@@ -1564,10 +1573,11 @@ static const ::capnp::_::RawSchema* const d_d00489d473826290[] = {
   &s_fb5aeed95cdf6af9,
 };
 static const uint16_t m_d00489d473826290[] = {0, 1};
+static const uint16_t h_d00489d473826290[] = {65535, 65535, 0, 1};
 static const uint16_t i_d00489d473826290[] = {0, 1};
 const ::capnp::_::RawSchema s_d00489d473826290 = {
   0xd00489d473826290, b_d00489d473826290.words, 45, d_d00489d473826290, m_d00489d473826290,
-  2, 2, i_d00489d473826290, nullptr, nullptr, { &s_d00489d473826290, nullptr, nullptr, 0, 0, nullptr }
+  h_d00489d473826290, 2, 2, i_d00489d473826290, nullptr, nullptr, { &s_d00489d473826290, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<53> b_fb5aeed95cdf6af9 = {
@@ -1632,10 +1642,11 @@ static const ::capnp::_::RawSchema* const d_fb5aeed95cdf6af9[] = {
   &s_d00489d473826290,
 };
 static const uint16_t m_fb5aeed95cdf6af9[] = {1, 0};
+static const uint16_t h_fb5aeed95cdf6af9[] = {1, 65535, 65535, 0};
 static const uint16_t i_fb5aeed95cdf6af9[] = {0, 1};
 const ::capnp::_::RawSchema s_fb5aeed95cdf6af9 = {
   0xfb5aeed95cdf6af9, b_fb5aeed95cdf6af9.words, 53, d_fb5aeed95cdf6af9, m_fb5aeed95cdf6af9,
-  2, 2, i_fb5aeed95cdf6af9, nullptr, nullptr, { &s_fb5aeed95cdf6af9, nullptr, nullptr, 0, 0, nullptr }
+  h_fb5aeed95cdf6af9, 2, 2, i_fb5aeed95cdf6af9, nullptr, nullptr, { &s_fb5aeed95cdf6af9, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<28> b_94099c3f9eb32d6b = {
@@ -1672,7 +1683,7 @@ static const ::capnp::_::AlignedData<28> b_94099c3f9eb32d6b = {
 #if !CAPNP_LITE
 const ::capnp::_::RawSchema s_94099c3f9eb32d6b = {
   0x94099c3f9eb32d6b, b_94099c3f9eb32d6b.words, 28, nullptr, nullptr,
-  0, 0, nullptr, nullptr, nullptr, { &s_94099c3f9eb32d6b, nullptr, nullptr, 0, 0, nullptr }
+  nullptr, 0, 0, nullptr, nullptr, nullptr, { &s_94099c3f9eb32d6b, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<87> b_b3f66e7a79d81bcd = {
@@ -1771,10 +1782,11 @@ static const ::capnp::_::RawSchema* const d_b3f66e7a79d81bcd[] = {
   &s_fffe08a9a697d2a5,
 };
 static const uint16_t m_b3f66e7a79d81bcd[] = {3, 0, 2, 1};
+static const uint16_t h_b3f66e7a79d81bcd[] = {3, 65535, 0, 65535, 65535, 1, 2, 65535};
 static const uint16_t i_b3f66e7a79d81bcd[] = {0, 1, 2, 3};
 const ::capnp::_::RawSchema s_b3f66e7a79d81bcd = {
   0xb3f66e7a79d81bcd, b_b3f66e7a79d81bcd.words, 87, d_b3f66e7a79d81bcd, m_b3f66e7a79d81bcd,
-  2, 4, i_b3f66e7a79d81bcd, nullptr, nullptr, { &s_b3f66e7a79d81bcd, nullptr, nullptr, 0, 0, nullptr }
+  h_b3f66e7a79d81bcd, 2, 4, i_b3f66e7a79d81bcd, nullptr, nullptr, { &s_b3f66e7a79d81bcd, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<110> b_fffe08a9a697d2a5 = {
@@ -1898,10 +1910,11 @@ static const ::capnp::_::RawSchema* const d_fffe08a9a697d2a5[] = {
   &s_e75816b56529d464,
 };
 static const uint16_t m_fffe08a9a697d2a5[] = {2, 3, 5, 0, 4, 1};
+static const uint16_t h_fffe08a9a697d2a5[] = {5, 2, 65535, 65535, 65535, 65535, 0, 65535, 65535, 65535, 65535, 65535, 65535, 1, 4, 3};
 static const uint16_t i_fffe08a9a697d2a5[] = {0, 1, 2, 3, 4, 5};
 const ::capnp::_::RawSchema s_fffe08a9a697d2a5 = {
   0xfffe08a9a697d2a5, b_fffe08a9a697d2a5.words, 110, d_fffe08a9a697d2a5, m_fffe08a9a697d2a5,
-  4, 6, i_fffe08a9a697d2a5, nullptr, nullptr, { &s_fffe08a9a697d2a5, nullptr, nullptr, 0, 0, nullptr }
+  h_fffe08a9a697d2a5, 4, 6, i_fffe08a9a697d2a5, nullptr, nullptr, { &s_fffe08a9a697d2a5, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<51> b_e5104515fd88ea47 = {
@@ -1964,10 +1977,11 @@ static const ::capnp::_::RawSchema* const d_e5104515fd88ea47[] = {
   &s_fffe08a9a697d2a5,
 };
 static const uint16_t m_e5104515fd88ea47[] = {0, 1};
+static const uint16_t h_e5104515fd88ea47[] = {65535, 65535, 1, 0};
 static const uint16_t i_e5104515fd88ea47[] = {0, 1};
 const ::capnp::_::RawSchema s_e5104515fd88ea47 = {
   0xe5104515fd88ea47, b_e5104515fd88ea47.words, 51, d_e5104515fd88ea47, m_e5104515fd88ea47,
-  2, 2, i_e5104515fd88ea47, nullptr, nullptr, { &s_e5104515fd88ea47, nullptr, nullptr, 0, 0, nullptr }
+  h_e5104515fd88ea47, 2, 2, i_e5104515fd88ea47, nullptr, nullptr, { &s_e5104515fd88ea47, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<65> b_89f0c973c103ae96 = {
@@ -2044,10 +2058,11 @@ static const ::capnp::_::RawSchema* const d_89f0c973c103ae96[] = {
   &s_991c7a3693d62cf2,
 };
 static const uint16_t m_89f0c973c103ae96[] = {2, 1, 0};
+static const uint16_t h_89f0c973c103ae96[] = {65535, 65535, 2, 65535, 0, 1, 65535, 65535};
 static const uint16_t i_89f0c973c103ae96[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_89f0c973c103ae96 = {
   0x89f0c973c103ae96, b_89f0c973c103ae96.words, 65, d_89f0c973c103ae96, m_89f0c973c103ae96,
-  2, 3, i_89f0c973c103ae96, nullptr, nullptr, { &s_89f0c973c103ae96, nullptr, nullptr, 0, 0, nullptr }
+  h_89f0c973c103ae96, 2, 3, i_89f0c973c103ae96, nullptr, nullptr, { &s_89f0c973c103ae96, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<34> b_e93164a80bfe2ccf = {
@@ -2093,10 +2108,11 @@ static const ::capnp::_::RawSchema* const d_e93164a80bfe2ccf[] = {
   &s_96efe787c17e83bb,
 };
 static const uint16_t m_e93164a80bfe2ccf[] = {0};
+static const uint16_t h_e93164a80bfe2ccf[] = {0, 65535};
 static const uint16_t i_e93164a80bfe2ccf[] = {0};
 const ::capnp::_::RawSchema s_e93164a80bfe2ccf = {
   0xe93164a80bfe2ccf, b_e93164a80bfe2ccf.words, 34, d_e93164a80bfe2ccf, m_e93164a80bfe2ccf,
-  2, 1, i_e93164a80bfe2ccf, nullptr, nullptr, { &s_e93164a80bfe2ccf, nullptr, nullptr, 0, 0, nullptr }
+  h_e93164a80bfe2ccf, 2, 1, i_e93164a80bfe2ccf, nullptr, nullptr, { &s_e93164a80bfe2ccf, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<49> b_b348322a8dcf0d0c = {
@@ -2157,10 +2173,11 @@ static const ::capnp::_::RawSchema* const d_b348322a8dcf0d0c[] = {
   &s_96efe787c17e83bb,
 };
 static const uint16_t m_b348322a8dcf0d0c[] = {0, 1};
+static const uint16_t h_b348322a8dcf0d0c[] = {65535, 0, 1, 65535};
 static const uint16_t i_b348322a8dcf0d0c[] = {0, 1};
 const ::capnp::_::RawSchema s_b348322a8dcf0d0c = {
   0xb348322a8dcf0d0c, b_b348322a8dcf0d0c.words, 49, d_b348322a8dcf0d0c, m_b348322a8dcf0d0c,
-  2, 2, i_b348322a8dcf0d0c, nullptr, nullptr, { &s_b348322a8dcf0d0c, nullptr, nullptr, 0, 0, nullptr }
+  h_b348322a8dcf0d0c, 2, 2, i_b348322a8dcf0d0c, nullptr, nullptr, { &s_b348322a8dcf0d0c, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<43> b_8f2622208fb358c8 = {
@@ -2216,10 +2233,11 @@ static const ::capnp::_::RawSchema* const d_8f2622208fb358c8[] = {
   &s_d0d1a21de617951f,
 };
 static const uint16_t m_8f2622208fb358c8[] = {1, 0};
+static const uint16_t h_8f2622208fb358c8[] = {65535, 0, 65535, 1};
 static const uint16_t i_8f2622208fb358c8[] = {0, 1};
 const ::capnp::_::RawSchema s_8f2622208fb358c8 = {
   0x8f2622208fb358c8, b_8f2622208fb358c8.words, 43, d_8f2622208fb358c8, m_8f2622208fb358c8,
-  3, 2, i_8f2622208fb358c8, nullptr, nullptr, { &s_8f2622208fb358c8, nullptr, nullptr, 0, 0, nullptr }
+  h_8f2622208fb358c8, 3, 2, i_8f2622208fb358c8, nullptr, nullptr, { &s_8f2622208fb358c8, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<51> b_d0d1a21de617951f = {
@@ -2282,10 +2300,11 @@ static const ::capnp::_::RawSchema* const d_d0d1a21de617951f[] = {
   &s_8f2622208fb358c8,
 };
 static const uint16_t m_d0d1a21de617951f[] = {0, 1};
+static const uint16_t h_d0d1a21de617951f[] = {65535, 65535, 1, 0};
 static const uint16_t i_d0d1a21de617951f[] = {0, 1};
 const ::capnp::_::RawSchema s_d0d1a21de617951f = {
   0xd0d1a21de617951f, b_d0d1a21de617951f.words, 51, d_d0d1a21de617951f, m_d0d1a21de617951f,
-  2, 2, i_d0d1a21de617951f, nullptr, nullptr, { &s_d0d1a21de617951f, nullptr, nullptr, 0, 0, nullptr }
+  h_d0d1a21de617951f, 2, 2, i_d0d1a21de617951f, nullptr, nullptr, { &s_d0d1a21de617951f, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<40> b_992a90eaf30235d3 = {
@@ -2337,10 +2356,11 @@ static const ::capnp::_::RawSchema* const d_992a90eaf30235d3[] = {
   &s_96efe787c17e83bb,
 };
 static const uint16_t m_992a90eaf30235d3[] = {0};
+static const uint16_t h_992a90eaf30235d3[] = {0, 65535};
 static const uint16_t i_992a90eaf30235d3[] = {0};
 const ::capnp::_::RawSchema s_992a90eaf30235d3 = {
   0x992a90eaf30235d3, b_992a90eaf30235d3.words, 40, d_992a90eaf30235d3, m_992a90eaf30235d3,
-  2, 1, i_992a90eaf30235d3, nullptr, nullptr, { &s_992a90eaf30235d3, nullptr, nullptr, 0, 0, nullptr }
+  h_992a90eaf30235d3, 2, 1, i_992a90eaf30235d3, nullptr, nullptr, { &s_992a90eaf30235d3, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<42> b_eb971847d617c0b9 = {
@@ -2395,10 +2415,11 @@ static const ::capnp::_::RawSchema* const d_eb971847d617c0b9[] = {
   &s_c6238c7d62d65173,
 };
 static const uint16_t m_eb971847d617c0b9[] = {0, 1};
+static const uint16_t h_eb971847d617c0b9[] = {65535, 1, 65535, 0};
 static const uint16_t i_eb971847d617c0b9[] = {0, 1};
 const ::capnp::_::RawSchema s_eb971847d617c0b9 = {
   0xeb971847d617c0b9, b_eb971847d617c0b9.words, 42, d_eb971847d617c0b9, m_eb971847d617c0b9,
-  3, 2, i_eb971847d617c0b9, nullptr, nullptr, { &s_eb971847d617c0b9, nullptr, nullptr, 0, 0, nullptr }
+  h_eb971847d617c0b9, 3, 2, i_eb971847d617c0b9, nullptr, nullptr, { &s_eb971847d617c0b9, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<51> b_c6238c7d62d65173 = {
@@ -2461,10 +2482,11 @@ static const ::capnp::_::RawSchema* const d_c6238c7d62d65173[] = {
   &s_eb971847d617c0b9,
 };
 static const uint16_t m_c6238c7d62d65173[] = {1, 0};
+static const uint16_t h_c6238c7d62d65173[] = {65535, 1, 65535, 0};
 static const uint16_t i_c6238c7d62d65173[] = {0, 1};
 const ::capnp::_::RawSchema s_c6238c7d62d65173 = {
   0xc6238c7d62d65173, b_c6238c7d62d65173.words, 51, d_c6238c7d62d65173, m_c6238c7d62d65173,
-  2, 2, i_c6238c7d62d65173, nullptr, nullptr, { &s_c6238c7d62d65173, nullptr, nullptr, 0, 0, nullptr }
+  h_c6238c7d62d65173, 2, 2, i_c6238c7d62d65173, nullptr, nullptr, { &s_c6238c7d62d65173, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<230> b_9cb9e86e3198037f = {
@@ -2706,10 +2728,11 @@ static const ::capnp::_::RawSchema* const d_9cb9e86e3198037f[] = {
   &s_96efe787c17e83bb,
 };
 static const uint16_t m_9cb9e86e3198037f[] = {12, 2, 3, 4, 6, 1, 8, 9, 10, 11, 5, 7, 0};
+static const uint16_t h_9cb9e86e3198037f[] = {65535, 65535, 65535, 65535, 5, 10, 65535, 1, 65535, 65535, 65535, 6, 3, 0, 9, 65535, 2, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 7, 8, 65535, 65535, 4, 12, 11, 65535};
 static const uint16_t i_9cb9e86e3198037f[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
 const ::capnp::_::RawSchema s_9cb9e86e3198037f = {
   0x9cb9e86e3198037f, b_9cb9e86e3198037f.words, 230, d_9cb9e86e3198037f, m_9cb9e86e3198037f,
-  2, 13, i_9cb9e86e3198037f, nullptr, nullptr, { &s_9cb9e86e3198037f, nullptr, nullptr, 0, 0, nullptr }
+  h_9cb9e86e3198037f, 2, 13, i_9cb9e86e3198037f, nullptr, nullptr, { &s_9cb9e86e3198037f, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<34> b_84e4f3f5a807605c = {
@@ -2754,10 +2777,11 @@ static const ::capnp::_::RawSchema* const d_84e4f3f5a807605c[] = {
   &s_96efe787c17e83bb,
 };
 static const uint16_t m_84e4f3f5a807605c[] = {0};
+static const uint16_t h_84e4f3f5a807605c[] = {65535, 0};
 static const uint16_t i_84e4f3f5a807605c[] = {0};
 const ::capnp::_::RawSchema s_84e4f3f5a807605c = {
   0x84e4f3f5a807605c, b_84e4f3f5a807605c.words, 34, d_84e4f3f5a807605c, m_84e4f3f5a807605c,
-  1, 1, i_84e4f3f5a807605c, nullptr, nullptr, { &s_84e4f3f5a807605c, nullptr, nullptr, 0, 0, nullptr }
+  h_84e4f3f5a807605c, 1, 1, i_84e4f3f5a807605c, nullptr, nullptr, { &s_84e4f3f5a807605c, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 }  // namespace schemas
@@ -208,10 +208,11 @@ static const ::capnp::_::RawSchema* const d_91cc55cd57de5419[] = {
   &s_91cc55cd57de5419,
 };
 static const uint16_t m_91cc55cd57de5419[] = {9, 6, 8, 3, 0, 2, 4, 5, 7, 1};
+static const uint16_t h_91cc55cd57de5419[] = {8, 65535, 65535, 9, 2, 3, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 5, 6, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 1, 65535, 65535, 65535, 65535, 65535, 4, 0, 7};
 static const uint16_t i_91cc55cd57de5419[] = {0, 1, 2, 3, 4, 5, 6, 9, 7, 8};
 const ::capnp::_::RawSchema s_91cc55cd57de5419 = {
   0x91cc55cd57de5419, b_91cc55cd57de5419.words, 195, d_91cc55cd57de5419, m_91cc55cd57de5419,
-  1, 10, i_91cc55cd57de5419, nullptr, nullptr, { &s_91cc55cd57de5419, nullptr, nullptr, 0, 0, nullptr }
+  h_91cc55cd57de5419, 1, 10, i_91cc55cd57de5419, nullptr, nullptr, { &s_91cc55cd57de5419, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<119> b_c6725e678d60fa37 = {
@@ -342,10 +343,11 @@ static const ::capnp::_::RawSchema* const d_c6725e678d60fa37[] = {
   &s_c6725e678d60fa37,
 };
 static const uint16_t m_c6725e678d60fa37[] = {2, 3, 5, 1, 4, 0};
+static const uint16_t h_c6725e678d60fa37[] = {5, 65535, 2, 0, 65535, 65535, 65535, 1, 65535, 65535, 65535, 65535, 65535, 4, 3, 65535};
 static const uint16_t i_c6725e678d60fa37[] = {1, 2, 0, 3, 4, 5};
 const ::capnp::_::RawSchema s_c6725e678d60fa37 = {
   0xc6725e678d60fa37, b_c6725e678d60fa37.words, 119, d_c6725e678d60fa37, m_c6725e678d60fa37,
-  2, 6, i_c6725e678d60fa37, nullptr, nullptr, { &s_c6725e678d60fa37, nullptr, nullptr, 0, 0, nullptr }
+  h_c6725e678d60fa37, 2, 6, i_c6725e678d60fa37, nullptr, nullptr, { &s_c6725e678d60fa37, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<38> b_9e69a92512b19d18 = {
@@ -394,10 +396,11 @@ static const ::capnp::_::RawSchema* const d_9e69a92512b19d18[] = {
   &s_91cc55cd57de5419,
 };
 static const uint16_t m_9e69a92512b19d18[] = {0};
+static const uint16_t h_9e69a92512b19d18[] = {65535, 0};
 static const uint16_t i_9e69a92512b19d18[] = {0};
 const ::capnp::_::RawSchema s_9e69a92512b19d18 = {
   0x9e69a92512b19d18, b_9e69a92512b19d18.words, 38, d_9e69a92512b19d18, m_9e69a92512b19d18,
-  1, 1, i_9e69a92512b19d18, nullptr, nullptr, { &s_9e69a92512b19d18, nullptr, nullptr, 0, 0, nullptr }
+  h_9e69a92512b19d18, 1, 1, i_9e69a92512b19d18, nullptr, nullptr, { &s_9e69a92512b19d18, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<40> b_a11f97b9d6c73dd4 = {
@@ -448,10 +451,11 @@ static const ::capnp::_::RawSchema* const d_a11f97b9d6c73dd4[] = {
   &s_c6725e678d60fa37,
 };
 static const uint16_t m_a11f97b9d6c73dd4[] = {0};
+static const uint16_t h_a11f97b9d6c73dd4[] = {65535, 0};
 static const uint16_t i_a11f97b9d6c73dd4[] = {0};
 const ::capnp::_::RawSchema s_a11f97b9d6c73dd4 = {
   0xa11f97b9d6c73dd4, b_a11f97b9d6c73dd4.words, 40, d_a11f97b9d6c73dd4, m_a11f97b9d6c73dd4,
-  1, 1, i_a11f97b9d6c73dd4, nullptr, nullptr, { &s_a11f97b9d6c73dd4, nullptr, nullptr, 0, 0, nullptr }
+  h_a11f97b9d6c73dd4, 1, 1, i_a11f97b9d6c73dd4, nullptr, nullptr, { &s_a11f97b9d6c73dd4, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 }  // namespace schemas
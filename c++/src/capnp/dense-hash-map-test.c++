@@ -0,0 +1,89 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "rpc-stats.h"
+#define CAPNP_PRIVATE
+#include "dense-hash-map.h"
+#include <kj/compat/gtest.h>
+#include <set>
+
+namespace capnp {
+namespace _ {  // private
+namespace {
+
+TEST(DenseHashMap, InsertFindErase) {
+  DenseHashMap<uint32_t, uint> map;
+
+  // IDs stepping by a power of two all share their low bits.
+  for (uint i = 0; i < 1000; i++) {
+    EXPECT_TRUE(map.insert(i << 8, i));
+  }
+  EXPECT_FALSE(map.insert(5 << 8, 0));
+  EXPECT_EQ(1000u, map.size());
+
+  for (uint i = 0; i < 1000; i += 2) {
+    EXPECT_TRUE(map.erase(i << 8));
+  }
+  EXPECT_FALSE(map.erase(0));
+  EXPECT_EQ(500u, map.size());
+
+  for (uint i = 0; i < 1000; i++) {
+    KJ_IF_MAYBE(value, map.find(i << 8)) {
+      EXPECT_EQ(1, i % 2);
+      EXPECT_EQ(i, *value);
+    } else {
+      EXPECT_EQ(0, i % 2);
+    }
+  }
+}
+
+TEST(DenseHashMap, AlignedPointers) {
+  // Pointers to heap objects are 8- or 16-byte aligned, so the low bits of their hash must not be
+  // what picks the slot.
+
+  for (uintptr_t alignment: {8, 16}) {
+    DenseHashMap<const void*, uintptr_t> map;
+    uintptr_t base = 0x7f0012340000ull & ~(alignment - 1);
+
+    for (uintptr_t i = 0; i < 1024; i++) {
+      EXPECT_TRUE(map.insert(reinterpret_cast<const void*>(base + i * alignment), i));
+    }
+    for (uintptr_t i = 0; i < 1024; i++) {
+      KJ_IF_MAYBE(value, map.find(reinterpret_cast<const void*>(base + i * alignment))) {
+        EXPECT_EQ(i, *value);
+      } else {
+        ADD_FAILURE() << "missing key";
+      }
+    }
+
+    // With 2048 slots, 1024 keys should land on many distinct home slots.  Keeping the low bits of
+    // the hash instead would leave at most 2048 / alignment of them reachable.
+    std::set<uint64_t> homes;
+    for (uintptr_t i = 0; i < 1024; i++) {
+      homes.insert(hashKey(reinterpret_cast<const void*>(base + i * alignment)) >> (64 - 11));
+    }
+    EXPECT_GT(homes.size(), 512u);
+  }
+}
+
+}  // namespace
+}  // namespace _ (private)
+}  // namespace capnp
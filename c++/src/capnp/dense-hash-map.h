@@ -0,0 +1,172 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CAPNP_DENSE_HASH_MAP_H_
+#define CAPNP_DENSE_HASH_MAP_H_
+
+#if defined(__GNUC__) && !defined(CAPNP_HEADER_WARNINGS)
+#pragma GCC system_header
+#endif
+
+#ifndef CAPNP_PRIVATE
+#error "This header is only meant to be included by Cap'n Proto's own source code."
+#endif
+
+#include <kj/common.h>
+#include <kj/array.h>
+
+namespace capnp {
+namespace _ {  // private
+
+inline uint64_t hashKey(uint32_t key) {
+  // Fibonacci hashing.  DenseHashMap uses the top bits of the product, which depend on every bit
+  // of the key, so IDs that step by powers of two spread across the table as well as runs of
+  // consecutive IDs do.
+  return key * 0x9e3779b97f4a7c15ull;
+}
+
+inline uint64_t hashKey(const void* key) {
+  // Likewise; the low bits of an aligned pointer are always zero, which is fine since only the
+  // top bits of the product are used.
+  return reinterpret_cast<uintptr_t>(key) * 0x9e3779b97f4a7c15ull;
+}
+
+template <typename Key, typename Value>
+class DenseHashMap {
+  // Open-addressed hash map with linear probing, for small keys such as IDs and pointers. The key
+  // type needs a hashKey() overload, found by ordinary or argument-dependent lookup, returning a
+  // uint64_t whose high bits are well mixed: a table of 2^n slots uses the top n bits. Entries live
+  // inline in a single array, so there is no allocation per entry. Inserting may move entries, so
+  // do not hold references into the map across an insert.
+
+public:
+  kj::Maybe<Value&> find(Key key) {
+    if (count > 0) {
+      for (uint i = home(key);; i = (i + 1) & mask()) {
+        Slot& slot = slots[i];
+        if (!slot.used) {
+          return nullptr;
+        } else if (slot.key == key) {
+          return slot.value;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  bool insert(Key key, Value value) {
+    // Inserts the entry if the key is not already present. Returns false if it was.
+
+    if ((count + 1) * 4 > slots.size() * 3) {
+      rehash(kj::max(slots.size() * 2, size_t(16)));
+    }
+
+    for (uint i = home(key);; i = (i + 1) & mask()) {
+      Slot& slot = slots[i];
+      if (!slot.used) {
+        slot.key = key;
+        slot.value = kj::mv(value);
+        slot.used = true;
+        ++count;
+        return true;
+      } else if (slot.key == key) {
+        return false;
+      }
+    }
+  }
+
+  bool erase(Key key) {
+    // Removes the entry with the given key. Returns false if there was no such entry.
+
+    if (count == 0) return false;
+
+    uint i = home(key);
+    for (;; i = (i + 1) & mask()) {
+      Slot& slot = slots[i];
+      if (!slot.used) {
+        return false;
+      } else if (slot.key == key) {
+        break;
+      }
+    }
+
+    // Shift back later entries in the same probe run so that lookups never need tombstones.
+    for (uint j = (i + 1) & mask();; j = (j + 1) & mask()) {
+      Slot& next = slots[j];
+      if (!next.used) break;
+      uint nextHome = home(next.key);
+      // Move `next` into the hole at `i` unless its home lies cyclically in (i, j].
+      if (((j - nextHome) & mask()) >= ((j - i) & mask())) {
+        slots[i].key = next.key;
+        slots[i].value = kj::mv(next.value);
+        i = j;
+      }
+    }
+
+    slots[i].used = false;
+    slots[i].value = Value();
+    --count;
+    return true;
+  }
+
+  template <typename Func>
+  void forEach(Func&& func) {
+    for (auto& slot: slots) {
+      if (slot.used) {
+        func(slot.key, slot.value);
+      }
+    }
+  }
+
+  size_t size() const { return count; }
+
+private:
+  struct Slot {
+    Key key;
+    Value value;
+    bool used = false;
+  };
+
+  kj::Array<Slot> slots;
+  size_t count = 0;
+  uint shift = 64;
+  // 64 minus log2(slots.size()).
+
+  inline uint mask() const { return slots.size() - 1; }
+  inline uint home(Key key) const { return hashKey(key) >> shift; }
+
+  void rehash(size_t newSize) {
+    auto oldSlots = kj::mv(slots);
+    slots = kj::heapArray<Slot>(newSize);
+    shift = 64 - kj::countTrailingZeros(newSize);
+    count = 0;
+    for (auto& slot: oldSlots) {
+      if (slot.used) {
+        insert(slot.key, kj::mv(slot.value));
+      }
+    }
+  }
+};
+
+}  // namespace _ (private)
+}  // namespace capnp
+
+#endif  // CAPNP_DENSE_HASH_MAP_H_
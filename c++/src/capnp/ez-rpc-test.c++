@@ -22,6 +22,7 @@
 #include "ez-rpc.h"
 #include "test-util.h"
 #include <kj/compat/gtest.h>
+#include <kj/vector.h>
 
 namespace capnp {
 namespace _ {
@@ -68,6 +69,48 @@ TEST(EzRpc, DeprecatedNames) {
       .getCallSequenceRequest().send().wait(server.getWaitScope()).getN());
 }
 
+TEST(EzRpc, MultiThreadedServer) {
+  // Each server thread gets its own TestInterfaceImpl with its own call counter.
+  constexpr uint THREADS = 4;
+  constexpr uint CLIENTS = 16;
+  constexpr uint CALLS = 4;
+  int callCounts[THREADS] = {0, 0, 0, 0};
+  uint threadsStarted = 0;
+
+  {
+    EzRpcMultiThreadedServer server([&]() -> Capability::Client {
+      uint i = __atomic_fetch_add(&threadsStarted, 1, __ATOMIC_RELAXED);
+      return kj::heap<TestInterfaceImpl>(callCounts[i]);
+    }, "localhost", 0, THREADS);
+
+    auto& waitScope = server.getWaitScope();
+    uint port = server.getPort().wait(waitScope);
+    EXPECT_EQ(THREADS, __atomic_load_n(&threadsStarted, __ATOMIC_RELAXED));
+
+    kj::Vector<kj::Own<EzRpcClient>> clients;
+    kj::Vector<RemotePromise<test::TestInterface::FooResults>> promises;
+    for (uint i = 0; i < CLIENTS; i++) {
+      clients.add(kj::heap<EzRpcClient>("localhost", port));
+      auto cap = clients.back()->getMain<test::TestInterface>();
+      for (uint j = 0; j < CALLS; j++) {
+        auto request = cap.fooRequest();
+        request.setI(123);
+        request.setJ(true);
+        promises.add(request.send());
+      }
+    }
+
+    for (auto& promise: promises) {
+      EXPECT_EQ("foo", promise.wait(waitScope).getX());
+    }
+  }
+
+  // The server threads have been joined, so their counters can be read now.
+  int total = 0;
+  for (auto count: callCounts) total += count;
+  EXPECT_EQ(CLIENTS * CALLS, total);
+}
+
 }  // namespace
 }  // namespace _
 }  // namespace capnp
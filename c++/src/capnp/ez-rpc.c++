@@ -25,7 +25,10 @@
 #include <kj/async-io.h>
 #include <kj/debug.h>
 #include <kj/threadlocal.h>
+#include <kj/thread.h>
+#include <kj/vector.h>
 #include <map>
+#include <unistd.h>
 
 namespace capnp {
 
@@ -355,4 +358,146 @@ kj::LowLevelAsyncIoProvider& EzRpcServer::getLowLevelIoProvider() {
   return impl->context->getLowLevelIoProvider();
 }
 
+// =======================================================================================
+
+struct EzRpcMultiThreadedServer::Impl final: public kj::TaskSet::ErrorHandler {
+  kj::Own<EzRpcContext> context;
+
+  kj::Function<Capability::Client()> bootstrapFactory;
+  kj::String bindAddress;
+  ReaderOptions readerOpts;
+  // Read (but not modified) by the server threads.
+
+  kj::Vector<kj::AsyncIoProvider::PipeThread> threads;
+  // Each server thread runs until its end of the pipe is disconnected.  Declared after the
+  // fields above so that the threads are stopped before those are destroyed.
+
+  kj::ForkedPromise<uint> portPromise;
+
+  kj::TaskSet tasks;
+
+  Impl(kj::Function<Capability::Client()> bootstrapFactory, kj::StringPtr bindAddress,
+       uint defaultPort, uint threadCount, ReaderOptions readerOpts)
+      : context(EzRpcContext::getThreadLocal()), bootstrapFactory(kj::mv(bootstrapFactory)),
+        bindAddress(kj::heapString(bindAddress)), readerOpts(readerOpts),
+        portPromise(nullptr), tasks(*this) {
+    if (threadCount == 0) {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      threadCount = n > 0 ? n : 1;
+    }
+
+    // Start one thread first so that we know the port (in case the kernel picks it), then start
+    // the rest on the same port.
+    portPromise = startThread(defaultPort).then([this,threadCount](uint port) {
+      auto promises = kj::heapArrayBuilder<kj::Promise<void>>(threadCount - 1);
+      for (uint i = 1; i < threadCount; i++) {
+        promises.add(startThread(port).then([port](uint threadPort) {
+          KJ_ASSERT(threadPort == port);
+        }));
+      }
+      return kj::joinPromises(promises.finish()).then([port]() { return port; });
+    }).fork();
+    tasks.add(portPromise.addBranch().then([](uint) {}));
+  }
+
+  kj::Promise<uint> startThread(uint port) {
+    auto thread = context->getIoProvider().newPipeThread(
+        [this,port](kj::AsyncIoProvider& ioProvider, kj::AsyncIoStream& pipe,
+                    kj::WaitScope& waitScope) {
+      serve(ioProvider, pipe, waitScope, port);
+    });
+
+    // The thread reports the port it ended up listening on.
+    auto& pipe = *thread.pipe;
+    threads.add(kj::mv(thread));
+    auto buffer = kj::heap<uint32_t>();
+    auto promise = pipe.read(buffer.get(), sizeof(*buffer));
+    return promise.then(kj::mvCapture(buffer, [](kj::Own<uint32_t>&& buffer) -> uint {
+      return *buffer;
+    }));
+  }
+
+  void serve(kj::AsyncIoProvider& ioProvider, kj::AsyncIoStream& pipe, kj::WaitScope& waitScope,
+             uint port) {
+    // Runs on a server thread.
+
+    auto listener = ioProvider.getNetwork().parseAddress(bindAddress, port)
+        .wait(waitScope)->listenShared();
+
+    Capability::Client bootstrap = bootstrapFactory();
+
+    uint32_t actualPort = listener->getPort();
+    pipe.write(&actualPort, sizeof(actualPort)).wait(waitScope);
+
+    ThreadServer server(kj::mv(bootstrap), readerOpts);
+    server.acceptLoop(kj::mv(listener));
+
+    // Serve until the main thread drops its end of the pipe.
+    byte dummy;
+    pipe.tryRead(&dummy, 1, 1).then([](size_t) {}).wait(waitScope);
+  }
+
+  struct ThreadServer final: public kj::TaskSet::ErrorHandler {
+    // The accept loop and connections of a single server thread.
+
+    Capability::Client bootstrap;
+    ReaderOptions readerOpts;
+    kj::TaskSet tasks;
+
+    struct ServerContext {
+      kj::Own<kj::AsyncIoStream> stream;
+      TwoPartyVatNetwork network;
+      RpcSystem<rpc::twoparty::VatId> rpcSystem;
+
+      ServerContext(kj::Own<kj::AsyncIoStream>&& stream, Capability::Client bootstrap,
+                    ReaderOptions readerOpts)
+          : stream(kj::mv(stream)),
+            network(*this->stream, rpc::twoparty::Side::SERVER, readerOpts),
+            rpcSystem(makeRpcServer(network, kj::mv(bootstrap))) {}
+    };
+
+    ThreadServer(Capability::Client bootstrap, ReaderOptions readerOpts)
+        : bootstrap(kj::mv(bootstrap)), readerOpts(readerOpts), tasks(*this) {}
+
+    void acceptLoop(kj::Own<kj::ConnectionReceiver>&& listener) {
+      auto ptr = listener.get();
+      tasks.add(ptr->accept().then(kj::mvCapture(kj::mv(listener),
+          [this](kj::Own<kj::ConnectionReceiver>&& listener,
+                 kj::Own<kj::AsyncIoStream>&& connection) {
+        acceptLoop(kj::mv(listener));
+
+        auto server = kj::heap<ServerContext>(kj::mv(connection), bootstrap, readerOpts);
+
+        // Arrange to destroy the server context when all references are gone, or when the
+        // thread shuts down (which will destroy the TaskSet).
+        tasks.add(server->network.onDisconnect().attach(kj::mv(server)));
+      })));
+    }
+
+    void taskFailed(kj::Exception&& exception) override {
+      KJ_LOG(ERROR, exception);
+    }
+  };
+
+  void taskFailed(kj::Exception&& exception) override {
+    kj::throwFatalException(kj::mv(exception));
+  }
+};
+
+EzRpcMultiThreadedServer::EzRpcMultiThreadedServer(
+    kj::Function<Capability::Client()> bootstrapFactory, kj::StringPtr bindAddress,
+    uint defaultPort, uint threadCount, ReaderOptions readerOpts)
+    : impl(kj::heap<Impl>(kj::mv(bootstrapFactory), bindAddress, defaultPort, threadCount,
+                          readerOpts)) {}
+
+EzRpcMultiThreadedServer::~EzRpcMultiThreadedServer() noexcept(false) {}
+
+kj::Promise<uint> EzRpcMultiThreadedServer::getPort() {
+  return impl->portPromise.addBranch();
+}
+
+kj::WaitScope& EzRpcMultiThreadedServer::getWaitScope() {
+  return impl->context->getWaitScope();
+}
+
 }  // namespace capnp
@@ -28,6 +28,7 @@
 
 #include "rpc.h"
 #include "message.h"
+#include <kj/function.h>
 
 struct sockaddr;
 
@@ -236,6 +237,44 @@ private:
   kj::Own<Impl> impl;
 };
 
+class EzRpcMultiThreadedServer {
+  // Like EzRpcServer, but serves connections on several threads at once.  Each thread runs its
+  // own event loop with its own listening socket, all bound to the same address with
+  // `kj::NetworkAddress::listenShared()` so that the kernel spreads incoming connections across
+  // the threads.  This lets a single process use every core.
+  //
+  // Capabilities belong to the thread that created them, so instead of a main interface the
+  // server takes a factory, which is called once on each server thread to create that thread's
+  // bootstrap capability.  The factory may be called from several threads at once.
+  //
+  // Requires Linux 3.9 or later, or FreeBSD 12 or later (which has SO_REUSEPORT_LB).  On other
+  // systems, including macOS, the server threads fail to listen and `getPort()` rejects.
+
+public:
+  EzRpcMultiThreadedServer(kj::Function<Capability::Client()> bootstrapFactory,
+                           kj::StringPtr bindAddress, uint defaultPort = 0, uint threadCount = 0,
+                           ReaderOptions readerOpts = ReaderOptions());
+  // Starts `threadCount` server threads, or one per online CPU if `threadCount` is zero.
+  //
+  // If the port is zero, the first thread lets the kernel choose a port and the other threads
+  // then bind to the same one.  In this case `bindAddress` must not contain an explicit port
+  // number; pass zero as `defaultPort` instead.
+
+  ~EzRpcMultiThreadedServer() noexcept(false);
+  // Stops all server threads, dropping their connections.
+
+  kj::Promise<uint> getPort();
+  // Get the IP port number on which the server is listening.  Resolves once all threads are
+  // listening.
+
+  kj::WaitScope& getWaitScope();
+  // Get the `WaitScope` for the calling thread's event loop (not the server threads').
+
+private:
+  struct Impl;
+  kj::Own<Impl> impl;
+};
+
 // =======================================================================================
 // inline implementation details
 
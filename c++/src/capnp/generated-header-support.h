@@ -194,8 +194,13 @@ struct RawSchema {
   // TODO(someday):  Make this a hashtable.
 
   const uint16_t* membersByName;
-  // Indexes of members sorted by name.  Used to implement name lookup.
-  // TODO(someday):  Make this a hashtable.
+  // Indexes of members sorted by name.
+
+  const uint16_t* membersByNameHash;
+  // Hash table of member indexes, used to implement name lookup. It has
+  // memberNameHashTableSize(memberCount) slots, each containing a member index or
+  // EMPTY_MEMBER_SLOT, and is probed linearly starting from slot hashMemberName(name). Null if
+  // there are no members.
 
   uint32_t dependencyCount;
   uint32_t memberCount;
@@ -233,6 +238,25 @@ struct RawSchema {
   // bound to `AnyPointer`.
 };
 
+static constexpr uint16_t EMPTY_MEMBER_SLOT = 0xffff;
+
+inline uint32_t hashMemberName(kj::ArrayPtr<const char> name) {
+  // FNV-1a. The code generator and the runtime must agree on this, since generated code contains
+  // tables built with it.
+  uint32_t hash = 2166136261u;
+  for (char c: name) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return hash;
+}
+
+inline uint memberNameHashTableSize(uint memberCount) {
+  // Smallest power of two that keeps the table at most half full.
+  uint size = 1;
+  while (size < memberCount * 2) size <<= 1;
+  return size;
+}
+
 inline bool RawBrandedSchema::isUnbound() const {
   // The unbound schema is the only one that has no scopes but is not the default schema.
   return scopeCount == 0 && this != &generic->defaultBrand;
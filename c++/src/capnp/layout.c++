@@ -22,6 +22,8 @@
 #define CAPNP_PRIVATE
 #include "layout.h"
 #include <kj/debug.h>
+#include <kj/io.h>
+#include <kj/vector.h>
 #include "arena.h"
 #include <string.h>
 #include <stdlib.h>
@@ -289,6 +291,104 @@ struct SegmentAnd {
   T value;
 };
 
+class StructuralHasher {
+  // Accumulates the 64-bit hash computed by WireHelpers::hashPointer() and friends.
+  //
+  // Bulk data is mixed with four independent multiply-rotate lanes (the same round as xxHash64)
+  // so that the CPU can overlap their multiplies. Everything else is mixed in one word at a time,
+  // with only one multiply depending on the previous state, which keeps the dependency chain
+  // through a run of small objects short; finish() makes up for the weaker mixing.
+  //
+  // Unlike the string scanning in compat/json.c++, this does not use SSE2 even where it is
+  // available: the round is a full 64x64-bit multiply, and SSE2 can only multiply 32-bit halves,
+  // so emulating it takes three vector multiplies plus shifts per lane. Four scalar lanes already
+  // keep the multiplier busy, so vector lanes would be slower for the same hash.
+
+public:
+  enum Tag {
+    // Marks what follows in the hash input. Each tag is combined with a size into one word.
+
+    NULL_RUN = 1,
+    STRUCT,
+    STRUCT_END,
+    STRUCT_LIST,
+    DATA_LIST,
+    CAPABILITY
+  };
+
+  static inline uint64_t tag(Tag tag, uint64_t size) {
+    return size << 8 | tag;
+  }
+
+  inline void add(uint64_t value) {
+    state = rotl(state ^ (value * PRIME2), 31) * PRIME1;
+  }
+
+  void addBytes(const byte* bytes, size_t size) {
+    // The caller is expected to have mixed in the size already.
+
+    const byte* end = bytes + size;
+    if (size >= 32) {
+      uint64_t v1 = state + PRIME1 + PRIME2;
+      uint64_t v2 = state + PRIME2;
+      uint64_t v3 = state;
+      uint64_t v4 = state - PRIME1;
+      do {
+        v1 = round(v1, load(bytes));
+        v2 = round(v2, load(bytes + 8));
+        v3 = round(v3, load(bytes + 16));
+        v4 = round(v4, load(bytes + 24));
+        bytes += 32;
+      } while (end - bytes >= 32);
+      state = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    }
+
+    for (; end - bytes >= 8; bytes += 8) {
+      add(load(bytes));
+    }
+
+    if (bytes < end) {
+      byte tail[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+      memcpy(tail, bytes, end - bytes);
+      add(load(tail));
+    }
+  }
+
+  uint64_t finish() const {
+    uint64_t h = state;
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+  }
+
+private:
+  static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+  static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+  static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ull;
+  static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+  uint64_t state = PRIME5;
+
+  static inline uint64_t rotl(uint64_t x, uint bits) {
+    return (x << bits) | (x >> (64 - bits));
+  }
+
+  static inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    return rotl(acc, 31) * PRIME1;
+  }
+
+  static inline uint64_t load(const byte* bytes) {
+    // Load as little-endian so that the hash does not depend on the host's byte order.
+    WireValue<uint64_t> value;
+    memcpy(&value, bytes, sizeof(value));
+    return value.get();
+  }
+};
+
 }  // namespace
 
 struct WireHelpers {
@@ -748,6 +848,184 @@ struct WireHelpers {
     return result;
   }
 
+  // -----------------------------------------------------------------
+  // Hashing
+  //
+  // Mirrors AnyStruct::Reader::equals() and friends: structs are hashed with trailing zero bytes
+  // and trailing null pointers removed, lists of pointers and lists of structs are both hashed
+  // element-wise as structs, and everything else is hashed by content. Like totalSize(), this
+  // walks the wire data directly rather than constructing readers, but makes the same checks that
+  // reading would, including charging the read limiter.
+
+  static void hashStruct(SegmentReader* segment, const byte* data, uint dataBytes,
+                         const WirePointer* pointers, uint pointerCount, int nestingLimit,
+                         StructuralHasher& hasher) {
+    while (dataBytes > 0 && data[dataBytes - 1] == 0) {
+      --dataBytes;
+    }
+    hasher.add(StructuralHasher::tag(StructuralHasher::STRUCT, dataBytes));
+    hasher.addBytes(data, dataBytes);
+
+    // Null pointers are only mixed in once we know they aren't trailing.
+    uint nullCount = 0;
+    for (uint i = 0; i < pointerCount; i++) {
+      if (pointers[i].isNull()) {
+        ++nullCount;
+      } else {
+        if (nullCount > 0) {
+          hasher.add(StructuralHasher::tag(StructuralHasher::NULL_RUN, nullCount));
+          nullCount = 0;
+        }
+        hashPointer(segment, pointers + i, nestingLimit, hasher);
+      }
+    }
+    hasher.add(StructuralHasher::tag(StructuralHasher::STRUCT_END, 0));
+  }
+
+  static void hashList(SegmentReader* segment, const byte* ptr, ElementSize elementSize,
+                       uint count, uint stepBits, uint structDataBits, uint structPointerCount,
+                       int nestingLimit, StructuralHasher& hasher) {
+    switch (elementSize) {
+      case ElementSize::POINTER:
+      case ElementSize::INLINE_COMPOSITE:
+        // equals() compares these element-wise as structs, regardless of encoding.
+        hasher.add(StructuralHasher::tag(StructuralHasher::STRUCT_LIST, count));
+        for (uint i = 0; i < count; i++) {
+          const byte* element = ptr + uint64_t(i) * stepBits / BITS_PER_BYTE;
+          hashStruct(segment, element, structDataBits / BITS_PER_BYTE,
+                     reinterpret_cast<const WirePointer*>(element + structDataBits / BITS_PER_BYTE),
+                     structPointerCount, nestingLimit, hasher);
+        }
+        break;
+
+      default: {
+        hasher.add(StructuralHasher::tag(StructuralHasher::DATA_LIST, count) |
+                   static_cast<uint>(elementSize) << 4);
+        uint64_t bits = uint64_t(count) * stepBits;
+        size_t bytes = bits / BITS_PER_BYTE;
+        hasher.addBytes(ptr, bytes);
+        if (bits % BITS_PER_BYTE != 0) {
+          // Ignore the padding bits after the last element.
+          hasher.add(ptr[bytes] & ((1u << (bits % BITS_PER_BYTE)) - 1));
+        }
+        break;
+      }
+    }
+  }
+
+  static void hashPointer(SegmentReader* segment, const WirePointer* ref, int nestingLimit,
+                          StructuralHasher& hasher) {
+    if (ref->isNull()) {
+      hasher.add(StructuralHasher::tag(StructuralHasher::NULL_RUN, 1));
+      return;
+    }
+
+    KJ_REQUIRE(nestingLimit > 0, "Message is too deeply-nested.") {
+      return;
+    }
+    --nestingLimit;
+
+    const word* ptr = followFars(ref, ref->target(), segment);
+    if (ptr == nullptr) return;  // followFars() already reported the error.
+
+    switch (ref->kind()) {
+      case WirePointer::STRUCT: {
+        KJ_REQUIRE(boundsCheck(segment, ptr, ptr + ref->structRef.wordSize()),
+                   "Message contained out-of-bounds struct pointer.") {
+          return;
+        }
+        WordCount dataSize = ref->structRef.dataSize.get();
+        hashStruct(segment, reinterpret_cast<const byte*>(ptr),
+                   dataSize * BYTES_PER_WORD / BYTES,
+                   reinterpret_cast<const WirePointer*>(ptr + dataSize),
+                   ref->structRef.ptrCount.get() / POINTERS, nestingLimit, hasher);
+        break;
+      }
+      case WirePointer::LIST: {
+        ElementSize elementSize = ref->listRef.elementSize();
+        switch (elementSize) {
+          case ElementSize::VOID:
+          case ElementSize::BIT:
+          case ElementSize::BYTE:
+          case ElementSize::TWO_BYTES:
+          case ElementSize::FOUR_BYTES:
+          case ElementSize::EIGHT_BYTES: {
+            ElementCount count = ref->listRef.elementCount();
+            auto step = dataBitsPerElement(elementSize);
+            WordCount64 totalWords = roundBitsUpToWords(ElementCount64(count) * step);
+            KJ_REQUIRE(boundsCheck(segment, ptr, ptr + totalWords),
+                       "Message contained out-of-bounds list pointer.") {
+              return;
+            }
+            hashList(segment, reinterpret_cast<const byte*>(ptr), elementSize,
+                     count / ELEMENTS, step * ELEMENTS / BITS, 0, 0, nestingLimit, hasher);
+            break;
+          }
+          case ElementSize::POINTER: {
+            ElementCount count = ref->listRef.elementCount();
+            KJ_REQUIRE(boundsCheck(segment, ptr, ptr + count * (WORDS_PER_POINTER / ELEMENTS)),
+                       "Message contained out-of-bounds list pointer.") {
+              return;
+            }
+            hashList(segment, reinterpret_cast<const byte*>(ptr), elementSize, count / ELEMENTS,
+                     BITS_PER_POINTER / BITS, 0, 1, nestingLimit, hasher);
+            break;
+          }
+          case ElementSize::INLINE_COMPOSITE: {
+            WordCount wordCount = ref->listRef.inlineCompositeWordCount();
+            KJ_REQUIRE(boundsCheck(segment, ptr, ptr + wordCount + POINTER_SIZE_IN_WORDS),
+                       "Message contained out-of-bounds list pointer.") {
+              return;
+            }
+
+            const WirePointer* tag = reinterpret_cast<const WirePointer*>(ptr);
+            ElementCount count = tag->inlineCompositeListElementCount();
+
+            KJ_REQUIRE(tag->kind() == WirePointer::STRUCT,
+                       "INLINE_COMPOSITE lists of non-STRUCT type are not supported.") {
+              return;
+            }
+
+            auto wordsPerElement = tag->structRef.wordSize() / ELEMENTS;
+            KJ_REQUIRE(ElementCount64(count) * wordsPerElement <= wordCount,
+                       "INLINE_COMPOSITE list's elements overrun its word count.") {
+              return;
+            }
+
+            if (wordsPerElement * (1 * ELEMENTS) == 0 * WORDS) {
+              // Watch out for lists of zero-sized structs, which can claim to be arbitrarily large
+              // without having sent actual data.
+              KJ_REQUIRE(amplifiedRead(segment, count * (1 * WORDS / ELEMENTS)),
+                         "Message contains amplified list pointer.") {
+                return;
+              }
+            }
+
+            hashList(segment, reinterpret_cast<const byte*>(ptr + POINTER_SIZE_IN_WORDS),
+                     elementSize, count / ELEMENTS,
+                     wordsPerElement * BITS_PER_WORD * ELEMENTS / BITS,
+                     tag->structRef.dataSize.get() * BITS_PER_WORD / BITS,
+                     tag->structRef.ptrCount.get() / POINTERS, nestingLimit, hasher);
+            break;
+          }
+        }
+        break;
+      }
+      case WirePointer::FAR:
+        KJ_FAIL_ASSERT("Unexpected FAR pointer.") {
+          break;
+        }
+        break;
+      case WirePointer::OTHER:
+        KJ_REQUIRE(ref->isCapability(), "Unknown pointer type.") {
+          break;
+        }
+        // equals() can't compare capabilities, so they all hash the same.
+        hasher.add(StructuralHasher::tag(StructuralHasher::CAPABILITY, 0));
+        break;
+    }
+  }
+
   // -----------------------------------------------------------------
   // Copy from an unchecked message.
 
@@ -2323,6 +2601,389 @@ struct WireHelpers {
       return Data::Reader(reinterpret_cast<const byte*>(ptr), size);
     }
   }
+
+  // -----------------------------------------------------------------
+  // Canonicalization
+  //
+  // Canonicalization takes two passes. The first walks the input through the usual readers, so
+  // that everything is validated and counted against the read limit once, and computes the
+  // canonical layout of every object: its truncated section sizes and the total size of
+  // everything it points to. With all sizes known, the second pass can compute each pointer's
+  // offset before writing the pointer, so it writes the output strictly in order, exactly once,
+  // working only from what the first pass recorded. That lets it write into an array of exactly
+  // the right size, or feed a stream directly.
+  //
+  // The first pass records one CanonicalObject per pointer it visits. Each struct, pointer list,
+  // or struct list reserves a contiguous block of entries for its own pointers before recursing
+  // into them; a struct list's block is preceded by one more entry, holding its tag. The second
+  // pass visits objects in the same order, so it finds each block exactly when it needs it, by
+  // advancing a cursor.
+
+  struct CanonicalObject {
+    // There is one of these for every pointer in the message, so it is kept to three words. The
+    // section sizes that the second pass needs are read back out of the canonical pointer (or
+    // tag) rather than stored separately.
+
+    const byte* source;
+    // Where the object's content starts in the input: a struct's data section, or a list's first
+    // element (past the tag, for struct lists).
+
+    uint64_t pointerBits;
+    // The canonical pointer to the object, except that the offset is left zero since it depends
+    // on where the pointer ends up. Empty structs get their canonical offset of -1 right away, so
+    // that only null pointers are all zero. In a struct list's tag entry, the canonical tag.
+
+    uint32_t totalWords;
+    // Canonical size of the object plus everything it points to. See canonicalSize().
+
+    uint32_t sourceBits;
+    // Size of a struct's data section in the input, or bits per element of a list in the input.
+    // In a struct list's tag entry, size of each element's data section in the input.
+
+    inline WirePointer& pointer() { return *reinterpret_cast<WirePointer*>(&pointerBits); }
+    inline const WirePointer& pointer() const {
+      return *reinterpret_cast<const WirePointer*>(&pointerBits);
+    }
+
+    inline uint dataWords() const { return pointer().structRef.dataSize.get() / WORDS; }
+    inline uint pointerCount() const { return pointer().structRef.ptrCount.get() / POINTERS; }
+    // Truncated section sizes of a struct, or (in a tag entry) of the elements of a struct list.
+  };
+  static_assert(sizeof(CanonicalObject) <= 3 * sizeof(word), "CanonicalObject has grown.");
+
+  typedef kj::Vector<CanonicalObject> CanonicalLayout;
+
+  static bool isZero(const byte* bytes, uint size) {
+    if (size == sizeof(word)) {
+      uint64_t value;
+      memcpy(&value, bytes, sizeof(value));
+      return value == 0;
+    }
+    for (uint i = 0; i < size; i++) {
+      if (bytes[i] != 0) return false;
+    }
+    return true;
+  }
+
+  static uint canonicalDataBytes(const byte* data, uint dataBits) {
+    // Returns the size of a struct's data section in bytes once trailing zero words have been
+    // truncated.
+
+    if (dataBits == 1) {
+      // A 1-bit struct (from a list of bools) truncates to nothing if the bit is false.
+      return data[0] & 1;
+    }
+
+    KJ_REQUIRE(dataBits % 8 == 0) {
+      return 0;
+    }
+
+    uint size = dataBits / 8;
+    while (size > 0) {
+      uint window = size % sizeof(word);
+      if (window == 0) window = sizeof(word);
+      if (!isZero(data + size - window, window)) break;
+      size -= window;
+    }
+    return size;
+  }
+
+  static uint canonicalPointerCount(const WirePointer* pointers, uint count) {
+    while (count > 0 && pointers[count - 1].isNull()) {
+      --count;
+    }
+    return count;
+  }
+
+  static uint32_t canonicalSize(uint64_t totalWords) {
+    // Pointer offsets are 30-bit signed word counts, so no object in a canonical message can
+    // reach further than 2^29 words. Checking this for every object, rather than only for the
+    // root, is what lets CanonicalObject::totalWords be 32 bits.
+
+    KJ_REQUIRE(totalWords < (1u << 29), "Message is too large to canonicalize.");
+    return totalWords;
+  }
+
+  static CanonicalObject measureCanonicalObject(
+      const PointerReader& src, CanonicalLayout& layout) {
+    switch (src.getPointerType()) {
+      case PointerType::NULL_:
+        break;
+      case PointerType::STRUCT:
+        return measureCanonicalStruct(src.getStruct(nullptr), layout);
+      case PointerType::LIST:
+        return measureCanonicalList(src.getListAnySize(nullptr), layout);
+      case PointerType::CAPABILITY:
+        KJ_FAIL_REQUIRE("Cannot create a canonical message with a capability") {
+          break;
+        }
+        break;
+    }
+
+    CanonicalObject result;
+    memset(&result, 0, sizeof(result));
+    return result;
+  }
+
+  static CanonicalObject measureCanonicalStruct(const StructReader& value, CanonicalLayout& layout) {
+    CanonicalObject result;
+    memset(&result, 0, sizeof(result));
+    result.source = reinterpret_cast<const byte*>(value.data);
+    result.sourceBits = value.dataSize / BITS;
+
+    uint dataWords = roundBytesUpToWords(
+        canonicalDataBytes(result.source, result.sourceBits) * BYTES) / WORDS;
+    uint pointerCount = canonicalPointerCount(value.pointers, value.pointerCount / POINTERS);
+    uint64_t totalWords = dataWords + pointerCount;
+
+    if (totalWords == 0) {
+      result.pointer().setKindAndTargetForEmptyStruct();
+    } else {
+      result.pointer().setKindWithZeroOffset(WirePointer::STRUCT);
+    }
+    result.pointer().structRef.set(dataWords * WORDS, pointerCount * POINTERS);
+
+    size_t base = layout.size();
+    for (uint i = 0; i < pointerCount; i++) {
+      layout.add();
+    }
+    for (uint i = 0; i < pointerCount; i++) {
+      CanonicalObject child = measureCanonicalObject(value.getPointerField(i * POINTERS), layout);
+      totalWords += child.totalWords;
+      layout[base + i] = child;
+    }
+
+    result.totalWords = canonicalSize(totalWords);
+    return result;
+  }
+
+  static CanonicalObject measureCanonicalList(const ListReader& value, CanonicalLayout& layout) {
+    CanonicalObject result;
+    memset(&result, 0, sizeof(result));
+    result.pointer().setKindWithZeroOffset(WirePointer::LIST);
+    result.source = value.ptr;
+    result.sourceBits = value.step * ELEMENTS / BITS;
+
+    uint count = value.elementCount / ELEMENTS;
+    uint64_t totalWords;
+
+    switch (value.elementSize) {
+      case ElementSize::INLINE_COMPOSITE: {
+        // Every element gets the largest truncated size of any element.
+        uint sourceDataBits = value.structDataSize / BITS;
+        uint sourcePointerCount = value.structPointerCount / POINTERS;
+        uint stepBytes = result.sourceBits / 8;
+        uint dataWords = 0;
+        uint pointerCount = 0;
+        for (uint i = 0; i < count; i++) {
+          const byte* element = result.source + i * stepBytes;
+          dataWords = kj::max(dataWords, roundBytesUpToWords(
+              canonicalDataBytes(element, sourceDataBits) * BYTES) / WORDS);
+          pointerCount = kj::max(pointerCount, canonicalPointerCount(
+              reinterpret_cast<const WirePointer*>(element + sourceDataBits / 8),
+              sourcePointerCount));
+        }
+
+        uint64_t elementWords = dataWords + pointerCount;
+        result.pointer().listRef.setInlineComposite(elementWords * count * WORDS);
+        totalWords = POINTER_SIZE_IN_WORDS / WORDS + elementWords * count;
+
+        CanonicalObject tag;
+        memset(&tag, 0, sizeof(tag));
+        tag.pointer().setKindAndInlineCompositeListElementCount(
+            WirePointer::STRUCT, count * ELEMENTS);
+        tag.pointer().structRef.set(dataWords * WORDS, pointerCount * POINTERS);
+        tag.sourceBits = sourceDataBits;
+        layout.add(tag);
+
+        size_t base = layout.size();
+        for (uint i = 0; i < count * pointerCount; i++) {
+          layout.add();
+        }
+        for (uint i = 0; i < count; i++) {
+          StructReader element = value.getStructElement(i * ELEMENTS);
+          for (uint j = 0; j < pointerCount; j++) {
+            CanonicalObject child =
+                measureCanonicalObject(element.getPointerField(j * POINTERS), layout);
+            totalWords += child.totalWords;
+            layout[base + i * pointerCount + j] = child;
+          }
+        }
+        break;
+      }
+
+      case ElementSize::POINTER: {
+        result.pointer().listRef.set(ElementSize::POINTER, value.elementCount);
+        totalWords = count;
+
+        size_t base = layout.size();
+        for (uint i = 0; i < count; i++) {
+          layout.add();
+        }
+        for (uint i = 0; i < count; i++) {
+          CanonicalObject child =
+              measureCanonicalObject(value.getPointerElement(i * ELEMENTS), layout);
+          totalWords += child.totalWords;
+          layout[base + i] = child;
+        }
+        break;
+      }
+
+      default:
+        result.pointer().listRef.set(value.elementSize, value.elementCount);
+        totalWords = roundBitsUpToWords(ElementCount64(value.elementCount) * value.step) / WORDS;
+        break;
+    }
+
+    result.totalWords = canonicalSize(totalWords);
+    return result;
+  }
+
+  template <typename Output>
+  static void writeCanonicalPointer(const CanonicalObject& object, uint64_t& targetPos,
+                                    Output& output) {
+    // Writes a pointer to `object`, which is to be placed at `targetPos`, and advances `targetPos`
+    // past it.
+
+    uint64_t pointerBits = object.pointerBits;
+    WirePointer& pointer = *reinterpret_cast<WirePointer*>(&pointerBits);
+    if (!pointer.isNull() &&
+        !(pointer.kind() == WirePointer::STRUCT && object.totalWords == 0)) {
+      uint64_t offset = targetPos - output.wordPosition() - 1;
+      pointer.offsetAndKind.set((offset << 2) | pointer.kind());
+    }
+    output.write(&pointer, sizeof(pointer));
+    targetPos += object.totalWords;
+  }
+
+  template <typename Output>
+  static void writeCanonicalData(const byte* data, uint dataBits, uint canonicalWords,
+                                 Output& output) {
+    byte bit;
+    if (dataBits == 1) {
+      // A struct read from a bool list element; only the lowest bit of the byte is its own.
+      bit = data[0] & 1;
+      data = &bit;
+      dataBits = 8;
+    }
+
+    uint size = kj::min(dataBits / 8, canonicalWords * sizeof(word));
+    output.write(data, size);
+    output.writeZeros(canonicalWords * sizeof(word) - size);
+  }
+
+  template <typename Output>
+  static void writeCanonicalObject(const CanonicalObject& object, size_t& cursor,
+                                   const CanonicalLayout& layout, Output& output) {
+    if (object.pointer().isNull()) return;
+
+    switch (object.pointer().kind()) {
+      case WirePointer::STRUCT:
+        writeCanonicalStruct(object, cursor, layout, output);
+        break;
+      case WirePointer::LIST:
+        writeCanonicalList(object, cursor, layout, output);
+        break;
+      default:
+        KJ_UNREACHABLE;
+    }
+  }
+
+  template <typename Output>
+  static void writeCanonicalStruct(const CanonicalObject& object, size_t& cursor,
+                                   const CanonicalLayout& layout, Output& output) {
+    uint dataWords = object.dataWords();
+    uint pointerCount = object.pointerCount();
+    uint64_t targetPos = output.wordPosition() + dataWords + pointerCount;
+
+    writeCanonicalData(object.source, object.sourceBits, dataWords, output);
+
+    size_t base = cursor;
+    cursor += pointerCount;
+    for (uint i = 0; i < pointerCount; i++) {
+      writeCanonicalPointer(layout[base + i], targetPos, output);
+    }
+    for (uint i = 0; i < pointerCount; i++) {
+      writeCanonicalObject(layout[base + i], cursor, layout, output);
+    }
+  }
+
+  template <typename Output>
+  static void writeCanonicalList(const CanonicalObject& object, size_t& cursor,
+                                 const CanonicalLayout& layout, Output& output) {
+    switch (object.pointer().listRef.elementSize()) {
+      case ElementSize::INLINE_COMPOSITE: {
+        const CanonicalObject& tag = layout[cursor++];
+        uint count = tag.pointer().inlineCompositeListElementCount() / ELEMENTS;
+        uint dataWords = tag.dataWords();
+        uint pointerCount = tag.pointerCount();
+        uint64_t elementWords = dataWords + pointerCount;
+        uint64_t targetPos = output.wordPosition() + POINTER_SIZE_IN_WORDS / WORDS +
+                             elementWords * count;
+        size_t base = cursor;
+        cursor += count * pointerCount;
+
+        output.write(&tag.pointer(), sizeof(WirePointer));
+
+        uint stepBytes = object.sourceBits / 8;
+        for (uint i = 0; i < count; i++) {
+          writeCanonicalData(object.source + i * stepBytes, tag.sourceBits, dataWords, output);
+          for (uint j = 0; j < pointerCount; j++) {
+            writeCanonicalPointer(layout[base + i * pointerCount + j], targetPos, output);
+          }
+        }
+        for (uint i = 0; i < count * pointerCount; i++) {
+          writeCanonicalObject(layout[base + i], cursor, layout, output);
+        }
+        break;
+      }
+
+      case ElementSize::POINTER: {
+        uint count = object.pointer().listRef.elementCount() / ELEMENTS;
+        uint64_t targetPos = output.wordPosition() + count;
+        size_t base = cursor;
+        cursor += count;
+        for (uint i = 0; i < count; i++) {
+          writeCanonicalPointer(layout[base + i], targetPos, output);
+        }
+        for (uint i = 0; i < count; i++) {
+          writeCanonicalObject(layout[base + i], cursor, layout, output);
+        }
+        break;
+      }
+
+      default: {
+        // Zero any bits past the last element so that the padding is canonical too.
+        uint count = object.pointer().listRef.elementCount() / ELEMENTS;
+        uint64_t bits = uint64_t(count) * object.sourceBits;
+        size_t bytes = bits / 8;
+        output.write(object.source, bytes);
+        if (bits % 8 != 0) {
+          byte last = object.source[bytes] & ((1u << (bits % 8)) - 1);
+          output.write(&last, 1);
+          ++bytes;
+        }
+        output.writeZeros(object.totalWords * sizeof(word) - bytes);
+        break;
+      }
+    }
+  }
+
+  static CanonicalObject measureCanonicalRoot(const StructReader& root,
+                                              CanonicalLayout& layout) {
+    return measureCanonicalStruct(root, layout);
+  }
+
+  template <typename Output>
+  static void writeCanonicalRoot(const CanonicalObject& root, const CanonicalLayout& layout,
+                                 Output& output) {
+    uint64_t targetPos = POINTER_SIZE_IN_WORDS / WORDS;
+    writeCanonicalPointer(root, targetPos, output);
+
+    size_t cursor = 0;
+    writeCanonicalStruct(root, cursor, layout, output);
+    KJ_ASSERT(cursor == layout.size());
+  }
 };
 
 // =======================================================================================
@@ -2537,6 +3198,16 @@ MessageSizeCounts PointerReader::targetSize() const {
                             : WireHelpers::totalSize(segment, pointer, nestingLimit);
 }
 
+uint64_t PointerReader::hash() const {
+  StructuralHasher hasher;
+  if (pointer == nullptr) {
+    hasher.add(StructuralHasher::tag(StructuralHasher::NULL_RUN, 1));
+  } else {
+    WireHelpers::hashPointer(segment, pointer, nestingLimit, hasher);
+  }
+  return hasher.finish();
+}
+
 PointerType PointerReader::getPointerType() const {
   if(pointer == nullptr || pointer->isNull()) {
     return PointerType::NULL_;
@@ -2715,6 +3386,14 @@ StructBuilder StructBuilder::imbue(CapTableBuilder* capTable) {
 // =======================================================================================
 // StructReader
 
+uint64_t StructReader::hash() const {
+  StructuralHasher hasher;
+  WireHelpers::hashStruct(segment, reinterpret_cast<const byte*>(data),
+                          dataSize / BITS_PER_BYTE / BYTES, pointers, pointerCount / POINTERS,
+                          nestingLimit, hasher);
+  return hasher.finish();
+}
+
 MessageSizeCounts StructReader::totalSize() const {
   MessageSizeCounts result = {
     WireHelpers::roundBitsUpToWords(dataSize) + pointerCount * WORDS_PER_POINTER, 0 };
@@ -2732,17 +3411,104 @@ MessageSizeCounts StructReader::totalSize() const {
   return result;
 }
 
+namespace {
+
+class CanonicalArrayOutput {
+  // Output for WireHelpers' canonical writer that fills in a preallocated array.
+
+public:
+  explicit CanonicalArrayOutput(kj::ArrayPtr<word> array)
+      : begin(array.asBytes().begin()), pos(begin), end(array.asBytes().end()) {}
+
+  inline uint64_t wordPosition() const { return (pos - begin) / sizeof(word); }
+
+  inline void write(const void* data, size_t size) {
+    KJ_DASSERT(end - pos >= size);
+    memcpy(pos, data, size);
+    pos += size;
+  }
+
+  inline void writeZeros(size_t size) {
+    KJ_DASSERT(end - pos >= size);
+    memset(pos, 0, size);
+    pos += size;
+  }
+
+  inline bool isFull() const { return pos == end; }
+
+private:
+  byte* begin;
+  byte* pos;
+  byte* end;
+};
+
+class CanonicalStreamOutput {
+  // Output for WireHelpers' canonical writer that feeds a stream, through a buffer.
+
+public:
+  explicit CanonicalStreamOutput(kj::OutputStream& inner): inner(inner) {}
+
+  inline uint64_t wordPosition() const { return (flushed + fill) / sizeof(word); }
+
+  void write(const void* data, size_t size) {
+    if (size > sizeof(buffer) - fill) {
+      flush();
+      if (size >= sizeof(buffer)) {
+        inner.write(data, size);
+        flushed += size;
+        return;
+      }
+    }
+    memcpy(buffer + fill, data, size);
+    fill += size;
+  }
+
+  void writeZeros(size_t size) {
+    while (size > 0) {
+      if (fill == sizeof(buffer)) flush();
+      size_t n = kj::min(size, sizeof(buffer) - fill);
+      memset(buffer + fill, 0, n);
+      fill += n;
+      size -= n;
+    }
+  }
+
+  void flush() {
+    if (fill > 0) {
+      inner.write(buffer, fill);
+      flushed += fill;
+      fill = 0;
+    }
+  }
+
+private:
+  kj::OutputStream& inner;
+  uint64_t flushed = 0;
+  size_t fill = 0;
+  byte buffer[8192];
+};
+
+}  // namespace
+
 kj::Array<word> StructReader::canonicalize() {
-  WordCount size = totalSize().wordCount + POINTER_SIZE_IN_WORDS;
-  kj::Array<word> backing = kj::heapArray<word>(size / WORDS);
-  memset(backing.begin(), 0, backing.asBytes().size());
-  FlatMessageBuilder builder(backing);
-  _::PointerHelpers<AnyPointer>::getInternalBuilder(builder.initRoot<AnyPointer>()).setStruct(*this, true);
-  KJ_ASSERT(builder.isCanonical());
-  auto output = builder.getSegmentsForOutput()[0];
-  kj::Array<word> trunc = kj::heapArray<word>(output.size());
-  memcpy(trunc.begin(), output.begin(), output.asBytes().size());
-  return trunc;
+  WireHelpers::CanonicalLayout layout;
+  auto root = WireHelpers::measureCanonicalRoot(*this, layout);
+
+  auto result = kj::heapArray<word>(POINTER_SIZE_IN_WORDS / WORDS + root.totalWords);
+  CanonicalArrayOutput output(result);
+  WireHelpers::writeCanonicalRoot(root, layout, output);
+  KJ_ASSERT(output.isFull());
+  return result;
+}
+
+size_t StructReader::canonicalize(kj::OutputStream& stream) {
+  WireHelpers::CanonicalLayout layout;
+  auto root = WireHelpers::measureCanonicalRoot(*this, layout);
+
+  CanonicalStreamOutput output(stream);
+  WireHelpers::writeCanonicalRoot(root, layout, output);
+  output.flush();
+  return POINTER_SIZE_IN_WORDS / WORDS + root.totalWords;
 }
 
 CapTableReader* StructReader::getCapTable() {
@@ -2904,6 +3670,14 @@ kj::ArrayPtr<const byte> ListReader::asRawBytes() {
       WireHelpers::roundBitsUpToBytes(elementCount * (structDataSize / ELEMENTS)) / BYTES);
 }
 
+uint64_t ListReader::hash() const {
+  StructuralHasher hasher;
+  WireHelpers::hashList(segment, ptr, elementSize, elementCount / ELEMENTS, step * ELEMENTS / BITS,
+                        structDataSize / BITS, structPointerCount / POINTERS, nestingLimit,
+                        hasher);
+  return hasher.finish();
+}
+
 StructReader ListReader::getStructElement(ElementCount index) const {
   KJ_REQUIRE(nestingLimit > 0,
              "Message is too deeply-nested or contains cycles.  See capnp::ReaderOptions.") {
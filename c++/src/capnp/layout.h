@@ -58,6 +58,10 @@
 // and blow away NaN payloads, because no one uses them anyway.
 #endif
 
+namespace kj {
+  class OutputStream;
+}
+
 namespace capnp {
 
 #if !CAPNP_LITE
@@ -126,7 +130,7 @@ template <> struct ElementSizeForType<Void> { static constexpr ElementSize value
 template <> struct ElementSizeForType<bool> { static constexpr ElementSize value = ElementSize::BIT; };
 
 // Lists and blobs are pointers, not structs.
-template <typename T, bool b> struct ElementSizeForType<List<T, b>> {
+template <typename T, Kind k> struct ElementSizeForType<List<T, k>> {
   static constexpr ElementSize value = ElementSize::POINTER;
 };
 template <> struct ElementSizeForType<Text> {
@@ -412,6 +416,10 @@ public:
   inline bool isNull() const { return getPointerType() == PointerType::NULL_; }
   PointerType getPointerType() const;
 
+  uint64_t hash() const;
+  // Hash the content of the target object and everything to which it points.  See capnp::hash()
+  // in any.h.
+
   StructReader getStruct(const word* defaultValue) const;
   ListReader getList(ElementSize expectedElementSize, const word* defaultValue) const;
   ListReader getListAnySize(const word* defaultValue) const;
@@ -572,6 +580,11 @@ public:
   inline _::ListReader getPointerSectionAsList();
 
   kj::Array<word> canonicalize();
+  size_t canonicalize(kj::OutputStream& output);
+  // Writes the canonical form of this struct, as a single-segment message without a segment
+  // table, either into a new array or to a stream. The stream version never materializes the
+  // whole output, making it suitable for feeding a hash function; it returns the size written,
+  // in words.
 
   template <typename T>
   KJ_ALWAYS_INLINE(bool hasDataField(ElementCount offset) const);
@@ -600,6 +613,10 @@ public:
   // use the result as a hint for allocating the first segment, do the copy, and then throw an
   // exception if it overruns.
 
+  uint64_t hash() const;
+  // Hash the content of the struct and everything to which it points.  See capnp::hash() in
+  // any.h.
+
   CapTableReader* getCapTable();
   // Gets the capability context in which this object is operating.
 
@@ -755,6 +772,9 @@ public:
 
   kj::ArrayPtr<const byte> asRawBytes();
 
+  uint64_t hash() const;
+  // Hash the content of the list and everything to which it points.  See capnp::hash() in any.h.
+
   template <typename T>
   KJ_ALWAYS_INLINE(T getDataElement(ElementCount index) const);
   // Get the element of the given type at the given index.
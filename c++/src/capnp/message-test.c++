@@ -25,6 +25,7 @@
 #include <kj/vector.h>
 #include <kj/debug.h>
 #include <kj/compat/gtest.h>
+#include <algorithm>
 
 namespace capnp {
 namespace _ {  // private
@@ -48,6 +49,97 @@ TEST(Message, MallocBuilderWithFirstSegment) {
   EXPECT_EQ(16u, segment.size());
 }
 
+TEST(Message, ResettableBuilder) {
+  MessageBuilderPool pool;
+
+  ResettableMessageBuilder builder(pool, 16, AllocationStrategy::FIXED_SIZE);
+
+  initTestMessage(builder.initRoot<TestAllTypes>());
+  checkTestMessage(builder.getRoot<TestAllTypes>());
+  auto firstSegments = builder.getSegmentsForOutput();
+  EXPECT_GT(firstSegments.size(), 1u);
+  const word* first = firstSegments[0].begin();
+  kj::Vector<const word*> more;
+  for (auto segment: firstSegments.slice(1, firstSegments.size())) {
+    more.add(segment.begin());
+  }
+
+  for (uint i = 0; i < 3; i++) {
+    builder.reset();
+    EXPECT_EQ(0u, builder.getSegmentsForOutput().size());
+
+    // The new message must not see any leftovers from the old one.
+    auto root = builder.initRoot<TestAllTypes>();
+    checkTestMessageAllZero(root.asReader());
+
+    initTestMessage(root);
+    checkTestMessage(builder.getRoot<TestAllTypes>());
+
+    // The first segment is kept and the others are recycled through the pool.
+    auto segments = builder.getSegmentsForOutput();
+    EXPECT_EQ(first, segments[0].begin());
+    for (auto segment: segments.slice(1, segments.size())) {
+      EXPECT_TRUE(std::find(more.begin(), more.end(), segment.begin()) != more.end());
+    }
+  }
+}
+
+TEST(Message, ResettableBuilderZeroesSegments) {
+  MessageBuilderPool pool;
+  const word* firstSegment;
+
+  {
+    ResettableMessageBuilder builder(pool);
+    initTestMessage(builder.initRoot<TestAllTypes>());
+    firstSegment = builder.getSegmentsForOutput()[0].begin();
+  }
+
+  {
+    // A new builder gets the same (now zeroed) segment from the pool.
+    ResettableMessageBuilder builder(pool);
+    auto segment = builder.allocateSegment(1);
+    EXPECT_EQ(firstSegment, segment.begin());
+    for (auto& w: segment) {
+      EXPECT_EQ(0u, *reinterpret_cast<uint64_t*>(&w));
+    }
+  }
+
+  {
+    // A pool with no room to cache anything still works.
+    MessageBuilderPool tinyPool(0);
+    ResettableMessageBuilder builder(tinyPool, 0, AllocationStrategy::FIXED_SIZE);
+    initTestMessage(builder.initRoot<TestAllTypes>());
+    builder.reset();
+    initTestMessage(builder.initRoot<TestAllTypes>());
+    checkTestMessage(builder.getRoot<TestAllTypes>());
+  }
+}
+
+TEST(Message, ResettableBuilderLeavesExternalDataAlone) {
+  // Read-only, so zeroing it on reset would crash.
+  alignas(8) static const byte EXTERNAL[16] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16
+  };
+
+  MessageBuilderPool pool;
+  ResettableMessageBuilder builder(pool);
+
+  for (uint i = 0; i < 2; i++) {
+    auto root = builder.initRoot<TestAllTypes>();
+    root.adoptDataField(builder.getOrphanage().referenceExternalData(
+        Data::Reader(EXTERNAL, sizeof(EXTERNAL))));
+    EXPECT_EQ(2u, builder.getSegmentsForOutput().size());
+    EXPECT_EQ(Data::Reader(EXTERNAL, sizeof(EXTERNAL)), root.asReader().getDataField());
+
+    builder.reset();
+    EXPECT_EQ(1, EXTERNAL[0]);
+    EXPECT_EQ(16, EXTERNAL[15]);
+  }
+
+  // The pool's own segment was still zeroed.
+  checkTestMessageAllZero(builder.initRoot<TestAllTypes>().asReader());
+}
+
 class TestInitMessageBuilder: public MessageBuilder {
 public:
   TestInitMessageBuilder(kj::ArrayPtr<SegmentInit> segments): MessageBuilder(segments) {}
@@ -168,6 +260,74 @@ TEST(Message, ReadWriteDataStruct) {
   checkTestMessageAllZero(defaultValue<TestAllTypes>());
 }
 
+TEST(Message, TrustedReader) {
+  ReaderOptions tinyLimit;
+  tinyLimit.traversalLimitInWords = 16;
+  tinyLimit.nestingLimit = 1;
+
+  {
+    MallocMessageBuilder builder(4096);
+    initTestMessage(builder.initRoot<TestAllTypes>());
+    auto segments = builder.getSegmentsForOutput();
+    ASSERT_EQ(1u, segments.size());
+
+    SegmentArrayMessageReader checked(segments);
+    validateMessage(checked);
+
+    SegmentArrayMessageReader limited(segments, tinyLimit);
+    TrustedMessageReader trusted(limited);
+    checkTestMessage(trusted.getRoot<TestAllTypes>());
+    checkTestMessage(trusted.getRoot<TestAllTypes>());
+    KJ_EXPECT_THROW_MESSAGE("traversal limit",
+        checkTestMessage(limited.getRoot<TestAllTypes>()));
+  }
+
+  {
+    MallocMessageBuilder builder(1, AllocationStrategy::FIXED_SIZE);
+    initTestMessage(builder.initRoot<TestAllTypes>());
+    auto segments = builder.getSegmentsForOutput();
+    ASSERT_GT(segments.size(), 1u);
+
+    SegmentArrayMessageReader checked(segments);
+    validateMessage(checked);
+
+    SegmentArrayMessageReader limited(segments, tinyLimit);
+    TrustedMessageReader trusted(limited);
+    checkTestMessage(trusted.getRoot<TestAllTypes>());
+    checkTestMessage(trusted.getRoot<TestAllTypes>());
+
+    // The trusted reader didn't lift the underlying reader's limit.
+    KJ_EXPECT_THROW_MESSAGE("traversal limit",
+        checkTestMessage(limited.getRoot<TestAllTypes>()));
+  }
+}
+
+TEST(Message, ValidateMessage) {
+  MallocMessageBuilder builder(4096);
+  initTestMessage(builder.initRoot<TestAllTypes>());
+  auto segment = builder.getSegmentsForOutput()[0];
+
+  {
+    kj::ArrayPtr<const word> truncated[1] = { segment.slice(0, segment.size() - 1) };
+    SegmentArrayMessageReader reader(truncated);
+    KJ_EXPECT_THROW_MESSAGE("out-of-bounds", validateMessage(reader));
+  }
+
+  {
+    ReaderOptions options;
+    options.nestingLimit = 1;
+    SegmentArrayMessageReader reader(builder.getSegmentsForOutput(), options);
+    KJ_EXPECT_THROW_MESSAGE("nested", validateMessage(reader));
+  }
+
+  {
+    ReaderOptions options;
+    options.traversalLimitInWords = segment.size() / 2;
+    SegmentArrayMessageReader reader(builder.getSegmentsForOutput(), options);
+    KJ_EXPECT_THROW_MESSAGE("traversal limit", validateMessage(reader));
+  }
+}
+
 // TODO(test):  More tests.
 
 }  // namespace
@@ -22,6 +22,7 @@
 #define CAPNP_PRIVATE
 #include "message.h"
 #include <kj/debug.h>
+#include <kj/array.h>
 #include "arena.h"
 #include "orphan.h"
 #include <stdlib.h>
@@ -103,6 +104,39 @@ AnyPointer::Reader MessageReader::getRootInternal() {
       segment->getStartPtr(), options.nestingLimit));
 }
 
+void validateMessage(MessageReader& message) {
+  // totalSize() visits every object in the message, with the same checks that reading it does.
+  message.getRoot<AnyPointer>().targetSize();
+}
+
+TrustedMessageReader::TrustedMessageReader(MessageReader& message)
+    : arena(kj::heap<_::ReaderArena>(&message)) {
+  arena->resetReadLimit(uint64_t(kj::maxValue) * WORDS);
+}
+
+TrustedMessageReader::~TrustedMessageReader() noexcept(false) {}
+
+AnyPointer::Reader TrustedMessageReader::getRootInternal() {
+  _::SegmentReader* segment = arena->tryGetSegment(_::SegmentId(0));
+  KJ_REQUIRE(segment != nullptr &&
+             segment->containsInterval(segment->getStartPtr(), segment->getStartPtr() + 1),
+             "Message did not contain a root pointer.") {
+    return AnyPointer::Reader();
+  }
+
+  // const_cast here is safe because dummyCapTableReader has no state.
+  auto capTable = const_cast<DummyCapTableReader*>(&dummyCapTableReader);
+
+  if (arena->tryGetSegment(_::SegmentId(1)) == nullptr) {
+    // Without a segment, the reader neither bounds-checks nor counts reads.
+    return AnyPointer::Reader(_::PointerReader::getRoot(
+        nullptr, capTable, segment->getStartPtr(), kj::maxValue));
+  } else {
+    return AnyPointer::Reader(_::PointerReader::getRoot(
+        segment, capTable, segment->getStartPtr(), kj::maxValue));
+  }
+}
+
 // -------------------------------------------------------------------
 
 MessageBuilder::MessageBuilder(): allocatedArena(false) {}
@@ -119,6 +153,13 @@ MessageBuilder::MessageBuilder(kj::ArrayPtr<SegmentInit> segments)
   allocatedArena = true;
 }
 
+void MessageBuilder::discardArena() {
+  if (allocatedArena) {
+    kj::dtor(*arena());
+    allocatedArena = false;
+  }
+}
+
 _::SegmentBuilder* MessageBuilder::getRootSegment() {
   if (allocatedArena) {
     return arena()->getSegment(_::SegmentId(0));
@@ -184,6 +225,15 @@ SegmentArrayMessageReader::SegmentArrayMessageReader(
     kj::ArrayPtr<const kj::ArrayPtr<const word>> segments, ReaderOptions options)
     : MessageReader(options), segments(segments) {}
 
+SegmentArrayMessageReader::SegmentArrayMessageReader(
+    kj::Array<kj::Array<const word>> segmentsParam, ReaderOptions options)
+    : MessageReader(options), ownedSegments(kj::mv(segmentsParam)) {
+  ownedSegmentPtrs = KJ_MAP(segment, ownedSegments) -> kj::ArrayPtr<const word> {
+    return segment;
+  };
+  segments = ownedSegmentPtrs;
+}
+
 SegmentArrayMessageReader::~SegmentArrayMessageReader() noexcept(false) {}
 
 kj::ArrayPtr<const word> SegmentArrayMessageReader::getSegment(uint id) {
@@ -282,6 +332,127 @@ kj::ArrayPtr<word> MallocMessageBuilder::allocateSegment(uint minimumSize) {
 
 // -------------------------------------------------------------------
 
+namespace {
+
+uint sizeClass(uint words) {
+  // Returns the smallest i such that 2^i >= words.
+  return words <= 1 ? 0 : 64 - kj::countLeadingZeros(words - 1);
+}
+
+}  // namespace
+
+MessageBuilderPool::MessageBuilderPool(size_t maxCachedWords): maxCachedWords(maxCachedWords) {}
+
+MessageBuilderPool::~MessageBuilderPool() noexcept(false) {
+  for (auto& freeList: freeLists) {
+    for (word* segment: freeList) {
+      free(segment);
+    }
+  }
+}
+
+kj::ArrayPtr<word> MessageBuilderPool::allocate(uint minimumSize) {
+  uint i = sizeClass(minimumSize);
+  KJ_REQUIRE(i < kj::size(freeLists), "Segment too large.", minimumSize);
+  size_t size = size_t(1) << i;
+
+  if (!freeLists[i].empty()) {
+    word* result = freeLists[i].back();
+    freeLists[i].removeLast();
+    cachedWords -= size;
+    return kj::arrayPtr(result, size);
+  }
+
+  void* result = calloc(size, sizeof(word));
+  if (result == nullptr) {
+    KJ_FAIL_SYSCALL("calloc(size, sizeof(word))", ENOMEM, size);
+  }
+  return kj::arrayPtr(reinterpret_cast<word*>(result), size);
+}
+
+void MessageBuilderPool::release(kj::ArrayPtr<word> segment) {
+  // `segment` must have come from allocate() and must be zeroed.
+  if (cachedWords + segment.size() <= maxCachedWords) {
+    freeLists[sizeClass(segment.size())].add(segment.begin());
+    cachedWords += segment.size();
+  } else {
+    free(segment.begin());
+  }
+}
+
+ResettableMessageBuilder::ResettableMessageBuilder(
+    MessageBuilderPool& pool, uint firstSegmentWords, AllocationStrategy allocationStrategy)
+    : pool(pool), firstSegmentWords(firstSegmentWords), nextSize(firstSegmentWords),
+      allocationStrategy(allocationStrategy), returnedFirstSegment(false) {}
+
+ResettableMessageBuilder::~ResettableMessageBuilder() noexcept(false) {
+  zeroUsedSpace();
+  if (firstSegment != nullptr) {
+    pool.release(firstSegment);
+  }
+  for (auto segment: moreSegments) {
+    pool.release(segment);
+  }
+}
+
+void ResettableMessageBuilder::reset() {
+  zeroUsedSpace();
+  discardArena();
+
+  for (auto segment: moreSegments) {
+    pool.release(segment);
+  }
+  moreSegments.clear();
+
+  nextSize = firstSegmentWords;
+  returnedFirstSegment = false;
+}
+
+void ResettableMessageBuilder::zeroUsedSpace() {
+  // Every word the message wrote lies within the used portion of some segment, so zeroing just
+  // those is enough to make all of our segments fully zero again.  The message may also contain
+  // segments added by `Orphanage::referenceExternalData()`, which belong to the caller (and may
+  // be read-only), so only the segments that came from the pool are touched.
+  for (auto segment: getSegmentsForOutput()) {
+    word* begin = const_cast<word*>(segment.begin());
+    bool ours = begin == firstSegment.begin();
+    for (auto& more: moreSegments) {
+      if (ours) break;
+      ours = begin == more.begin();
+    }
+    if (ours) {
+      memset(begin, 0, segment.size() * sizeof(word));
+    }
+  }
+}
+
+kj::ArrayPtr<word> ResettableMessageBuilder::allocateSegment(uint minimumSize) {
+  if (!returnedFirstSegment) {
+    if (firstSegment.size() < kj::max(minimumSize, nextSize)) {
+      // We don't have a first segment yet (or ours is too small, which in practice never happens
+      // since minimumSize is always 1 for the first segment).
+      if (firstSegment != nullptr) {
+        pool.release(firstSegment);
+      }
+      firstSegment = pool.allocate(kj::max(minimumSize, nextSize));
+    }
+    returnedFirstSegment = true;
+
+    // After the first segment, we want nextSize to equal the total size allocated so far.
+    if (allocationStrategy == AllocationStrategy::GROW_HEURISTICALLY) {
+      nextSize = firstSegment.size();
+    }
+    return firstSegment;
+  }
+
+  auto result = pool.allocate(kj::max(minimumSize, nextSize));
+  moreSegments.add(result);
+  if (allocationStrategy == AllocationStrategy::GROW_HEURISTICALLY) nextSize += result.size();
+  return result;
+}
+
+// -------------------------------------------------------------------
+
 FlatMessageBuilder::FlatMessageBuilder(kj::ArrayPtr<word> array): array(array), allocated(false) {}
 FlatMessageBuilder::~FlatMessageBuilder() noexcept(false) {}
 
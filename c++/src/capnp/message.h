@@ -22,6 +22,7 @@
 #include <kj/common.h>
 #include <kj/memory.h>
 #include <kj/mutex.h>
+#include <kj/vector.h>
 #include <kj/debug.h>
 #include "common.h"
 #include "layout.h"
@@ -136,6 +137,52 @@ private:
   AnyPointer::Reader getRootInternal();
 };
 
+void validateMessage(MessageReader& message);
+// Traverses the entire message, checking everything that reading it could check -- bounds, far
+// pointers, nesting depth (against ReaderOptions::nestingLimit), and the traversal limit -- and
+// throws an exception if anything is wrong. A message that passes can from then on be read with
+// TrustedMessageReader, for as long as its content doesn't change. Typically you'd validate a
+// message once, when first receiving it from an untrusted source, then store it somewhere only
+// you can write, e.g. a MessageLogWriter, and read it as trusted from then on.
+//
+// Validation counts against `message`'s traversal limit like any other read.
+
+class TrustedMessageReader {
+  // Reads a message without bounds checks or traversal limit accounting.
+  //
+  // THE MESSAGE MUST HAVE PASSED validateMessage(). If it hasn't, reading it this way can crash or
+  // read arbitrary memory, just like readMessageUnchecked().
+  //
+  // Single-segment messages are read with no checks at all, like readMessageUnchecked() does.
+  // Following a pointer from one segment to another requires looking up the target segment and
+  // checking it, so multi-segment messages are still bounds-checked, but without traversal or
+  // nesting limits. Build messages with a first segment large enough to hold them all (e.g. by
+  // passing a large `firstSegmentWords` to MallocMessageBuilder) to get the full benefit.
+  //
+  // Messages written by Cap'n Proto never contain far pointers within a single segment. If a
+  // single-segment message does, reading such a pointer throws an exception (it doesn't read out
+  // of bounds).
+  //
+  // Reads through a TrustedMessageReader don't touch `message`'s own traversal limit, so readers
+  // obtained from `message` directly are still limited as usual.
+
+public:
+  explicit TrustedMessageReader(MessageReader& message);
+  // `message` must remain valid for as long as readers obtained from this object are in use.
+  ~TrustedMessageReader() noexcept(false);
+  KJ_DISALLOW_COPY(TrustedMessageReader);
+
+  template <typename RootType>
+  typename RootType::Reader getRoot();
+  // Get the root struct of the message, interpreting it as the given struct type.
+
+private:
+  kj::Own<_::ReaderArena> arena;
+  // Our own view of `message`'s segments, with no traversal limit.
+
+  AnyPointer::Reader getRootInternal();
+};
+
 class MessageBuilder {
   // Abstract interface for an object used to allocate and build a message.  Subclasses of
   // MessageBuilder are responsible for allocating the space in which the message will be written.
@@ -227,6 +274,13 @@ public:
   bool isCanonical();
   // Check whether the message builder is in canonical form
 
+protected:
+  void discardArena();
+  // Destroys the message's contents, returning the builder to the state it was in right after
+  // construction.  The next access will call allocateSegment() afresh.  Segments previously
+  // returned by allocateSegment() are no longer referenced and may be reused by the subclass once
+  // it has zeroed them; call getSegmentsForOutput() *before* this to learn which words were used.
+
 private:
   void* arenaSpace[22];
   // Space in which we can construct a BuilderArena.  We don't use BuilderArena directly here
@@ -318,6 +372,11 @@ public:
   // Creates a message pointing at the given segment array, without taking ownership of the
   // segments.  All arrays passed in must remain valid until the MessageReader is destroyed.
 
+  explicit SegmentArrayMessageReader(kj::Array<kj::Array<const word>> segments,
+                                     ReaderOptions options = ReaderOptions());
+  // Creates a message which takes ownership of the given segments.  This is useful for adopting
+  // buffers which a transport has already filled in, one per segment, without copying them.
+
   KJ_DISALLOW_COPY(SegmentArrayMessageReader);
   ~SegmentArrayMessageReader() noexcept(false);
 
@@ -325,6 +384,10 @@ public:
 
 private:
   kj::ArrayPtr<const kj::ArrayPtr<const word>> segments;
+
+  kj::Array<kj::Array<const word>> ownedSegments;
+  kj::Array<kj::ArrayPtr<const word>> ownedSegmentPtrs;
+  // Only when constructed with owned segments.
 };
 
 enum class AllocationStrategy: uint8_t {
@@ -393,6 +456,77 @@ private:
   kj::Maybe<kj::Own<MoreSegments>> moreSegments;
 };
 
+class MessageBuilderPool {
+  // A cache of zeroed segments for use by ResettableMessageBuilder.  Segment sizes are rounded up
+  // to a power of two, and segments released by builders are kept on a free list for their size.
+  // Since builders zero only the words they actually used before releasing a segment, a program
+  // that builds a steady stream of similarly-sized messages does no allocation at all once the
+  // pool is warm.
+  //
+  // A pool is not thread-safe.  Give each thread (or each event loop) its own pool; that way the
+  // free lists are effectively thread-local and need no locking.  The pool must outlive all
+  // builders that use it.
+
+public:
+  explicit MessageBuilderPool(size_t maxCachedWords = 1u << 20);
+  // At most `maxCachedWords` words worth of released segments are kept for reuse; beyond that,
+  // released segments are freed.
+
+  KJ_DISALLOW_COPY(MessageBuilderPool);
+  ~MessageBuilderPool() noexcept(false);
+
+private:
+  kj::Vector<word*> freeLists[32];
+  // freeLists[i] holds zeroed segments of 2^i words.
+
+  size_t cachedWords = 0;
+  size_t maxCachedWords;
+
+  kj::ArrayPtr<word> allocate(uint minimumSize);
+  void release(kj::ArrayPtr<word> segment);
+
+  friend class ResettableMessageBuilder;
+};
+
+class ResettableMessageBuilder: public MessageBuilder {
+  // A MessageBuilder which obtains its segments from a MessageBuilderPool and which can be reset
+  // and reused to build another message.  Resetting (or destroying) the builder zeroes only the
+  // words the message actually used, rather than the whole segment.
+  //
+  // The first segment is kept across resets, so a long-lived builder reused for one message per
+  // request does no allocation in steady state as long as the messages fit in it.  Any further
+  // segments go back to the pool on reset.
+
+public:
+  explicit ResettableMessageBuilder(MessageBuilderPool& pool,
+      uint firstSegmentWords = SUGGESTED_FIRST_SEGMENT_WORDS,
+      AllocationStrategy allocationStrategy = SUGGESTED_ALLOCATION_STRATEGY);
+  // Like the MallocMessageBuilder constructor of the same shape, except that segments come from
+  // `pool`.
+
+  KJ_DISALLOW_COPY(ResettableMessageBuilder);
+  virtual ~ResettableMessageBuilder() noexcept(false);
+
+  void reset();
+  // Discards the message built so far so that the builder may be used to build a new message.
+  // All readers and builders pointing into the old message become invalid.
+
+  virtual kj::ArrayPtr<word> allocateSegment(uint minimumSize) override;
+
+private:
+  MessageBuilderPool& pool;
+  uint firstSegmentWords;
+  uint nextSize;
+  AllocationStrategy allocationStrategy;
+
+  kj::ArrayPtr<word> firstSegment;
+  bool returnedFirstSegment;
+
+  kj::Vector<kj::ArrayPtr<word>> moreSegments;
+
+  void zeroUsedSpace();
+};
+
 class FlatMessageBuilder: public MessageBuilder {
   // THIS IS NOT THE CLASS YOU'RE LOOKING FOR.
   //
@@ -433,6 +567,11 @@ inline typename RootType::Reader MessageReader::getRoot() {
   return getRootInternal().getAs<RootType>();
 }
 
+template <typename RootType>
+inline typename RootType::Reader TrustedMessageReader::getRoot() {
+  return getRootInternal().getAs<RootType>();
+}
+
 template <typename RootType>
 inline typename RootType::Builder MessageBuilder::initRoot() {
   return getRootInternal().initAs<RootType>();
@@ -503,6 +642,13 @@ kj::Array<word> canonicalize(T&& reader) {
     return _::PointerHelpers<FromReader<T>>::getInternalReader(reader).canonicalize();
 }
 
+template <typename T>
+size_t canonicalize(T&& reader, kj::OutputStream& output) {
+    return _::PointerHelpers<FromReader<T>>::getInternalReader(reader).canonicalize(output);
+}
+// Writes the canonical form of `reader` to `output` without materializing it, e.g. to feed a
+// hash function. Returns the number of words written.
+
 }  // namespace capnp
 
 #endif  // CAPNP_MESSAGE_H_
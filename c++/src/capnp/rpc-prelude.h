@@ -31,6 +31,7 @@
 
 #include "capability.h"
 #include "persistent.capnp.h"
+#include "rpc-stats.h"
 
 namespace capnp {
 
@@ -95,6 +96,7 @@ private:
   Capability::Client baseBootstrap(AnyStruct::Reader vatId);
   Capability::Client baseRestore(AnyStruct::Reader vatId, AnyPointer::Reader objectId);
   void baseSetFlowLimit(size_t words);
+  void baseSetStats(RpcStats& stats);
 
   template <typename>
   friend class capnp::RpcSystem;
@@ -0,0 +1,160 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "rpc-stats.h"
+#include "rpc-twoparty.h"
+#include "test-util.h"
+#include <kj/async-io.h>
+#include <kj/compat/gtest.h>
+
+namespace capnp {
+namespace _ {
+namespace {
+
+const RpcStats::Method& findMethod(const RpcStats::Snapshot& snapshot,
+                                   uint64_t interfaceId, uint16_t methodId) {
+  for (auto& method: snapshot.methods) {
+    if (method.interfaceId == interfaceId && method.methodId == methodId) {
+      return method;
+    }
+  }
+  KJ_FAIL_ASSERT("method not found", interfaceId, methodId);
+}
+
+TEST(RpcStats, TwoParty) {
+  auto io = kj::setupAsyncIo();
+  auto pipe = io.provider->newTwoWayPipe();
+  int callCount = 0;
+
+  RpcStats stats;
+
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[1], rpc::twoparty::Side::SERVER);
+  auto server = makeRpcServer(serverNetwork, kj::heap<TestInterfaceImpl>(callCount));
+  server.setStats(stats);
+
+  {
+    TwoPartyVatNetwork clientNetwork(*pipe.ends[0], rpc::twoparty::Side::CLIENT);
+    auto rpcClient = makeRpcClient(clientNetwork);
+    rpcClient.setStats(stats);
+
+    MallocMessageBuilder vatId(8);
+    vatId.initRoot<rpc::twoparty::VatId>().setSide(rpc::twoparty::Side::SERVER);
+    auto client = rpcClient.bootstrap(vatId.getRoot<rpc::twoparty::VatId>())
+        .castAs<test::TestInterface>();
+
+    for (uint i = 0; i < 3; i++) {
+      auto request = client.fooRequest();
+      request.setI(123);
+      request.setJ(true);
+      EXPECT_EQ("foo", request.send().wait(io.waitScope).getX());
+    }
+
+    EXPECT_ANY_THROW(client.barRequest().send().wait(io.waitScope));
+
+    auto snapshot = stats.snapshot();
+
+    auto& foo = findMethod(snapshot, typeId<test::TestInterface>(), 0);
+    EXPECT_EQ(3u, foo.callsSent);
+    EXPECT_EQ(3u, foo.callsReceived);
+    EXPECT_EQ(0u, foo.exceptionsSent);
+    EXPECT_EQ(0u, foo.exceptionsReceived);
+    EXPECT_EQ(3u, foo.clientLatency.count);
+    EXPECT_EQ(3u, foo.serverLatency.count);
+    EXPECT_LE(foo.serverLatency.percentile(1), foo.clientLatency.percentile(1));
+
+    auto& bar = findMethod(snapshot, typeId<test::TestInterface>(), 1);
+    EXPECT_EQ(1u, bar.callsSent);
+    EXPECT_EQ(1u, bar.callsReceived);
+    EXPECT_EQ(1u, bar.exceptionsSent);
+    EXPECT_EQ(1u, bar.exceptionsReceived);
+
+    ASSERT_EQ(2u, snapshot.connections.size());
+    for (auto& connection: snapshot.connections) {
+      EXPECT_LT(4u, connection.messagesSent);
+      EXPECT_LT(4u, connection.messagesReceived);
+      EXPECT_LT(connection.messagesSent, connection.wordsSent);
+      EXPECT_LT(connection.messagesReceived, connection.wordsReceived);
+      EXPECT_EQ(0u, connection.callsInFlight);
+      EXPECT_EQ(0u, connection.callWordsInFlight);
+    }
+    EXPECT_EQ(0u, snapshot.closedConnections.messagesSent);
+  }
+
+  // Closing the client's side folds its counters into the closed totals.
+  auto snapshot = stats.snapshot();
+  EXPECT_EQ(1u, snapshot.connections.size());
+  EXPECT_LT(4u, snapshot.closedConnections.messagesSent);
+  EXPECT_EQ(0u, snapshot.closedConnections.questions);
+}
+
+TEST(RpcStats, BogusMethodIds) {
+  auto io = kj::setupAsyncIo();
+  auto pipe = io.provider->newTwoWayPipe();
+  int callCount = 0;
+
+  RpcStats stats(4);
+
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[1], rpc::twoparty::Side::SERVER);
+  auto server = makeRpcServer(serverNetwork, kj::heap<TestInterfaceImpl>(callCount));
+  server.setStats(stats);
+
+  TwoPartyVatNetwork clientNetwork(*pipe.ends[0], rpc::twoparty::Side::CLIENT);
+  auto rpcClient = makeRpcClient(clientNetwork);
+  rpcClient.setStats(stats);
+
+  MallocMessageBuilder vatId(8);
+  vatId.initRoot<rpc::twoparty::VatId>().setSide(rpc::twoparty::Side::SERVER);
+  auto client = rpcClient.bootstrap(vatId.getRoot<rpc::twoparty::VatId>())
+      .castAs<test::TestInterface>();
+
+  {
+    auto request = client.fooRequest();
+    request.setI(123);
+    request.setJ(true);
+    request.send().wait(io.waitScope);
+  }
+
+  // A peer making up method IDs gets the first few entries, and the rest are lumped together.
+  for (uint i = 0; i < 1000; i++) {
+    auto request = client.typelessRequest(0x8000000000000000ull | i, i, nullptr);
+    EXPECT_ANY_THROW(request.send().wait(io.waitScope));
+  }
+
+  auto snapshot = stats.snapshot();
+  ASSERT_EQ(5u, snapshot.methods.size());
+
+  EXPECT_EQ(1u, findMethod(snapshot, typeId<test::TestInterface>(), 0).callsReceived);
+  for (uint i = 0; i < 3; i++) {
+    EXPECT_EQ(1u, findMethod(snapshot, 0x8000000000000000ull | i, i).callsReceived);
+  }
+
+  auto& other = snapshot.methods[4];
+  EXPECT_EQ(0u, other.interfaceId);
+  EXPECT_EQ(0u, other.methodId);
+  EXPECT_EQ(997u, other.callsSent);
+  EXPECT_EQ(997u, other.callsReceived);
+  EXPECT_EQ(997u, other.exceptionsSent);
+  EXPECT_EQ(997u, other.exceptionsReceived);
+}
+
+}  // namespace
+}  // namespace _ (private)
+}  // namespace capnp
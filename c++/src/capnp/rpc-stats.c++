@@ -0,0 +1,150 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#define CAPNP_PRIVATE
+#include "rpc-stats.h"
+#include "dense-hash-map.h"
+#include <kj/debug.h>
+
+namespace capnp {
+
+namespace _ {  // private
+
+namespace {
+
+struct MethodKey {
+  uint64_t interfaceId;
+  uint16_t methodId;
+
+  inline bool operator==(const MethodKey& other) const {
+    return interfaceId == other.interfaceId && methodId == other.methodId;
+  }
+};
+
+inline uint64_t hashKey(const MethodKey& key) {
+  return (key.interfaceId ^ key.methodId) * 0x9e3779b97f4a7c15ull;
+}
+
+}  // namespace
+}  // namespace _ (private)
+
+class RpcStats::MethodIndex: public _::DenseHashMap<_::MethodKey, _::RpcMethodStats*> {};
+
+namespace {
+
+RpcStats::Connection readConnection(const _::RpcConnectionStats& stats) {
+  RpcStats::Connection result;
+  result.id = stats.id;
+  result.messagesSent = stats.messagesSent.get();
+  result.messagesReceived = stats.messagesReceived.get();
+  result.wordsSent = stats.wordsSent.get();
+  result.wordsReceived = stats.wordsReceived.get();
+  result.questions = stats.questions.get();
+  result.exports = stats.exports.get();
+  result.callsInFlight = stats.callsInFlight.get();
+  result.callWordsInFlight = stats.callWordsInFlight.get();
+  return result;
+}
+
+}  // namespace
+
+RpcStats::RpcStats(uint maxMethods)
+    : methodIndex(kj::heap<MethodIndex>()), maxMethods(maxMethods) {}
+RpcStats::~RpcStats() noexcept(false) {}
+
+RpcStats::Snapshot RpcStats::snapshot() const {
+  auto lock = state.lockShared();
+
+  Snapshot result;
+  result.connections = KJ_MAP(connection, lock->connections) {
+    return readConnection(*connection);
+  };
+  result.closedConnections = lock->closedConnections;
+  result.methods = KJ_MAP(method, lock->methods) {
+    Method snapshot;
+    snapshot.interfaceId = method->interfaceId;
+    snapshot.methodId = method->methodId;
+    snapshot.callsSent = method->callsSent.get();
+    snapshot.callsReceived = method->callsReceived.get();
+    snapshot.exceptionsReceived = method->exceptionsReceived.get();
+    snapshot.exceptionsSent = method->exceptionsSent.get();
+    snapshot.clientLatency = method->clientLatency.read();
+    snapshot.serverLatency = method->serverLatency.read();
+    return snapshot;
+  };
+  return result;
+}
+
+_::RpcConnectionStats& RpcStats::addConnection() {
+  auto connection = kj::heap<_::RpcConnectionStats>();
+  connection->id = nextConnectionId++;
+  auto& result = *connection;
+  state.lockExclusive()->connections.add(kj::mv(connection));
+  return result;
+}
+
+void RpcStats::removeConnection(_::RpcConnectionStats& connection) {
+  auto lock = state.lockExclusive();
+
+  auto& closed = lock->closedConnections;
+  closed.messagesSent += connection.messagesSent.get();
+  closed.messagesReceived += connection.messagesReceived.get();
+  closed.wordsSent += connection.wordsSent.get();
+  closed.wordsReceived += connection.wordsReceived.get();
+
+  auto& connections = lock->connections;
+  for (size_t i = 0; i < connections.size(); i++) {
+    if (connections[i].get() == &connection) {
+      connections[i] = kj::mv(connections.back());
+      connections.removeLast();
+      return;
+    }
+  }
+  KJ_FAIL_ASSERT("connection not registered with this RpcStats");
+}
+
+_::RpcMethodStats& RpcStats::getMethod(uint64_t interfaceId, uint16_t methodId) {
+  _::MethodKey key = { interfaceId, methodId };
+  KJ_IF_MAYBE(existing, methodIndex->find(key)) {
+    return **existing;
+  }
+
+  bool isOther = methodIndex->size() >= maxMethods;
+  if (isOther && otherMethods != nullptr) {
+    return *otherMethods;
+  }
+
+  auto method = kj::heap<_::RpcMethodStats>();
+  auto& result = *method;
+  if (isOther) {
+    method->interfaceId = 0;
+    method->methodId = 0;
+    otherMethods = &result;
+  } else {
+    method->interfaceId = interfaceId;
+    method->methodId = methodId;
+    methodIndex->insert(key, &result);
+  }
+  state.lockExclusive()->methods.add(kj::mv(method));
+  return result;
+}
+
+}  // namespace capnp
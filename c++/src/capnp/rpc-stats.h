@@ -0,0 +1,175 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CAPNP_RPC_STATS_H_
+#define CAPNP_RPC_STATS_H_
+
+#if defined(__GNUC__) && !defined(CAPNP_HEADER_WARNINGS)
+#pragma GCC system_header
+#endif
+
+#include "common.h"
+#include <kj/async-stats.h>
+#include <kj/mutex.h>
+#include <kj/vector.h>
+
+namespace capnp {
+
+namespace _ {  // private
+
+struct RpcMethodStats {
+  // Live counters for one method.  Written only by the thread running the RpcSystem(s).
+
+  uint64_t interfaceId;
+  uint16_t methodId;
+
+  kj::StatsCounter callsSent;
+  kj::StatsCounter callsReceived;
+  kj::StatsCounter exceptionsReceived;
+  kj::StatsCounter exceptionsSent;
+  kj::HistogramRecorder clientLatency;
+  kj::HistogramRecorder serverLatency;
+  // In nanoseconds.
+};
+
+struct RpcConnectionStats {
+  // Live counters for one connection.  Written only by the thread running the RpcSystem(s).
+
+  uint64_t id;
+
+  kj::StatsCounter messagesSent;
+  kj::StatsCounter messagesReceived;
+  kj::StatsCounter wordsSent;
+  kj::StatsCounter wordsReceived;
+
+  kj::StatsCounter questions;
+  kj::StatsCounter exports;
+  kj::StatsCounter callsInFlight;
+  kj::StatsCounter callWordsInFlight;
+  // Gauges, refreshed whenever the connection sends or handles a message.
+};
+
+}  // namespace _ (private)
+
+class RpcStats {
+  // Call counts, latency histograms, and traffic counters for RpcSystems.  Collection is off
+  // unless an RpcStats is attached with `RpcSystem::setStats()`, and is cheap enough to leave on:
+  // the hot path is a hash lookup per call plus a handful of uncontended, non-atomic-RMW counter
+  // updates.
+  //
+  // An RpcStats may be attached to several RpcSystems as long as they all run on the same thread.
+  // `snapshot()` may be called from any thread at any time.  The RpcStats must outlive every
+  // RpcSystem it is attached to.
+
+public:
+  explicit RpcStats(uint maxMethods = 1024);
+  // At most `maxMethods` methods get entries of their own.  Calls to any further methods are
+  // counted together in one extra entry whose `interfaceId` and `methodId` are zero, so that a
+  // peer calling made-up method IDs can't make the table grow without bound.
+  ~RpcStats() noexcept(false);
+  KJ_DISALLOW_COPY(RpcStats);
+
+  typedef kj::Histogram Histogram;
+  // Latency histograms are in nanoseconds.  This used to be a struct of RpcStats' own, whose
+  // `sum` field was called `sumNanos`; code reading that field should now read `sum`.
+
+  struct Method {
+    uint64_t interfaceId;
+    uint16_t methodId;
+
+    uint64_t callsSent;
+    uint64_t callsReceived;
+    uint64_t exceptionsReceived;
+    // Calls sent which returned an exception.
+    uint64_t exceptionsSent;
+    // Calls received which returned an exception.
+
+    Histogram clientLatency;
+    // Time from sending a `Call` to receiving its `Return`.
+    Histogram serverLatency;
+    // Time from receiving a `Call` to sending its `Return`, or to cancellation.
+  };
+
+  struct Connection {
+    uint64_t id;
+    // Assigned in order of connection, starting at 1.
+
+    uint64_t messagesSent;
+    uint64_t messagesReceived;
+    uint64_t wordsSent;
+    uint64_t wordsReceived;
+    // Word counts are as reported by the VatNetwork, i.e. including framing.
+
+    uint64_t questions;
+    // Size of the question table: calls we made which have not yet been finished.
+    uint64_t exports;
+    // Size of the export table.
+    uint64_t callsInFlight;
+    uint64_t callWordsInFlight;
+    // Calls received which have not yet returned, and their total size, as counted against the
+    // flow limit (see `RpcSystem::setFlowLimit()`).
+  };
+
+  struct Snapshot {
+    kj::Array<Connection> connections;
+    // Connections which are currently open.
+
+    Connection closedConnections;
+    // Traffic counters summed over all connections which have closed.  Table sizes are zero.
+
+    kj::Array<Method> methods;
+    // Every method which has been called in either direction, in order of first use, up to
+    // `maxMethods` of them, followed by the entry for the rest, if any.
+  };
+
+  Snapshot snapshot() const;
+
+  // ---------------------------------------------------------------------------
+  // Used by the RPC implementation.  Only call these from the writer thread.
+
+  _::RpcConnectionStats& addConnection();
+  void removeConnection(_::RpcConnectionStats& connection);
+  _::RpcMethodStats& getMethod(uint64_t interfaceId, uint16_t methodId);
+
+private:
+  class MethodIndex;
+  kj::Own<MethodIndex> methodIndex;
+  // Writer-side index into `state.methods`.  Entries are never removed, so the pointers stay
+  // valid for the life of the RpcStats.
+
+  uint maxMethods;
+  _::RpcMethodStats* otherMethods = nullptr;
+  // Shared entry for methods beyond the first `maxMethods`.  Created on first use.
+
+  uint64_t nextConnectionId = 1;
+
+  struct State {
+    kj::Vector<kj::Own<_::RpcMethodStats>> methods;
+    kj::Vector<kj::Own<_::RpcConnectionStats>> connections;
+    Connection closedConnections = Connection();
+  };
+  kj::MutexGuarded<State> state;
+  // Held only to add or remove entries and to take snapshots, never while counting.
+};
+
+}  // namespace capnp
+
+#endif  // CAPNP_RPC_STATS_H_
@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 
 #include "rpc.h"
+#include "rpc-stats.h"
 #include "test-util.h"
 #include "schema.h"
 #include "serialize.h"
@@ -244,6 +245,10 @@ public:
         return message.getRoot<AnyPointer>();
       }
 
+      size_t sizeInWords() override {
+        return data.size();
+      }
+
       kj::Array<word> data;
       FlatArrayMessageReader message;
     };
@@ -259,6 +264,10 @@ public:
         return message.getRoot<AnyPointer>();
       }
 
+      size_t sizeInWords() override {
+        return computeSerializedSizeInWords(message);
+      }
+
       void send() override {
         if (connection.networkException != nullptr) {
           return;
@@ -578,6 +587,68 @@ TEST(Rpc, Release) {
   EXPECT_EQ(0, context.restorer.handleCount);
 }
 
+TEST(Rpc, ManyOutstandingCalls) {
+  // Keep enough questions, answers, imports and exports live at once that the tables have to go
+  // beyond their initial small-ID fast paths, and churn them so that IDs get recycled.
+  RpcStats stats;
+  TestContext context;
+  context.rpcClient.setStats(stats);
+
+  auto client = context.connect(test::TestSturdyRefObjectId::Tag::TEST_MORE_STUFF)
+      .castAs<test::TestMoreStuff>();
+
+  kj::Vector<test::TestHandle::Client> handles;
+
+  for (uint round = 0; round < 4; round++) {
+    kj::Vector<RemotePromise<test::TestMoreStuff::GetHandleResults>> promises;
+    for (uint i = 0; i < 100; i++) {
+      promises.add(client.getHandleRequest().send());
+    }
+    for (auto& promise: promises) {
+      handles.add(promise.wait(context.waitScope).getHandle());
+    }
+    promises = nullptr;
+
+    for (uint i = 0; i < 16; i++) kj::evalLater([]() {}).wait(context.waitScope);
+    EXPECT_EQ(handles.size(), context.restorer.handleCount);
+
+    // Drop every other handle, so that the freed IDs are scattered through the tables.
+    kj::Vector<test::TestHandle::Client> kept;
+    for (uint i = 0; i < handles.size(); i += 2) {
+      kept.add(kj::mv(handles[i]));
+    }
+    handles = kj::mv(kept);
+
+    for (uint i = 0; i < 16; i++) kj::evalLater([]() {}).wait(context.waitScope);
+    EXPECT_EQ(handles.size(), context.restorer.handleCount);
+  }
+
+  {
+    // Pass the same local capability many times at once; it should be exported only once.
+    int callCount = 0;
+    test::TestInterface::Client cap = kj::heap<TestInterfaceImpl>(callCount);
+    kj::Vector<RemotePromise<test::TestMoreStuff::CallFooResults>> promises;
+    for (uint i = 0; i < 50; i++) {
+      auto request = client.callFooRequest();
+      request.setCap(cap);
+      promises.add(request.send());
+    }
+
+    auto snapshot = stats.snapshot();
+    ASSERT_EQ(1u, snapshot.connections.size());
+    EXPECT_EQ(1u, snapshot.connections[0].exports);
+
+    for (auto& promise: promises) {
+      EXPECT_EQ("bar", promise.wait(context.waitScope).getS());
+    }
+    EXPECT_EQ(50, callCount);
+  }
+
+  handles = nullptr;
+  for (uint i = 0; i < 16; i++) kj::evalLater([]() {}).wait(context.waitScope);
+  EXPECT_EQ(0, context.restorer.handleCount);
+}
+
 TEST(Rpc, ReleaseOnCancel) {
   // At one time, there was a bug where if a Return contained capabilities, but the client had
   // canceled the request and already send a Finish (which presumably didn't reach the server before
@@ -68,12 +68,13 @@ private:
   int& handleCount;
 };
 
-kj::AsyncIoProvider::PipeThread runServer(kj::AsyncIoProvider& ioProvider,
-                                          int& callCount, int& handleCount) {
+kj::AsyncIoProvider::PipeThread runServer(
+    kj::AsyncIoProvider& ioProvider, int& callCount, int& handleCount,
+    TwoPartyVatNetwork::Encoding encoding = TwoPartyVatNetwork::Encoding::UNPACKED) {
   return ioProvider.newPipeThread(
-      [&callCount, &handleCount](
+      [&callCount, &handleCount, encoding](
        kj::AsyncIoProvider& ioProvider, kj::AsyncIoStream& stream, kj::WaitScope& waitScope) {
-    TwoPartyVatNetwork network(stream, rpc::twoparty::Side::SERVER);
+    TwoPartyVatNetwork network(stream, rpc::twoparty::Side::SERVER, ReaderOptions(), encoding);
     TestRestorer restorer(callCount, handleCount);
     auto server = makeRpcServer(network, restorer);
     network.onDisconnect().wait(waitScope);
@@ -142,6 +143,35 @@ TEST(TwoPartyNetwork, Basic) {
   EXPECT_TRUE(barFailed);
 }
 
+TEST(TwoPartyNetwork, Packed) {
+  auto ioContext = kj::setupAsyncIo();
+  int callCount = 0;
+  int handleCount = 0;
+
+  auto encoding = TwoPartyVatNetwork::Encoding::PACKED;
+  auto serverThread = runServer(*ioContext.provider, callCount, handleCount, encoding);
+  TwoPartyVatNetwork network(*serverThread.pipe, rpc::twoparty::Side::CLIENT,
+                             ReaderOptions(), encoding);
+  auto rpcClient = makeRpcClient(network);
+
+  auto client = getPersistentCap(rpcClient, rpc::twoparty::Side::SERVER,
+      test::TestSturdyRefObjectId::Tag::TEST_INTERFACE).castAs<test::TestInterface>();
+
+  auto request1 = client.fooRequest();
+  request1.setI(123);
+  request1.setJ(true);
+  auto promise1 = request1.send();
+
+  auto request2 = client.bazRequest();
+  initTestMessage(request2.initS());
+  auto promise2 = request2.send();
+
+  EXPECT_EQ("foo", promise1.wait(ioContext.waitScope).getX());
+  promise2.wait(ioContext.waitScope);
+
+  EXPECT_EQ(2, callCount);
+}
+
 TEST(TwoPartyNetwork, Pipelining) {
   auto ioContext = kj::setupAsyncIo();
   int callCount = 0;
@@ -308,6 +338,96 @@ TEST(TwoPartyNetwork, Abort) {
   EXPECT_TRUE(conn->receiveIncomingMessage().wait(ioContext.waitScope) == nullptr);
 }
 
+class WriteCountingStream final: public kj::AsyncIoStream {
+  // Forwards to another stream, counting write calls.
+
+public:
+  explicit WriteCountingStream(kj::AsyncIoStream& inner): inner(inner) {}
+
+  uint writeCount = 0;
+
+  kj::Promise<size_t> read(void* buffer, size_t minBytes, size_t maxBytes) override {
+    return inner.read(buffer, minBytes, maxBytes);
+  }
+  kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
+    return inner.tryRead(buffer, minBytes, maxBytes);
+  }
+  kj::Promise<void> write(const void* buffer, size_t size) override {
+    ++writeCount;
+    return inner.write(buffer, size);
+  }
+  kj::Promise<void> write(kj::ArrayPtr<const kj::ArrayPtr<const byte>> pieces) override {
+    ++writeCount;
+    return inner.write(pieces);
+  }
+  void shutdownWrite() override { inner.shutdownWrite(); }
+
+private:
+  kj::AsyncIoStream& inner;
+};
+
+TEST(TwoPartyNetwork, CoalescedWrites) {
+  // Messages sent during the same turn go out in a single write.
+
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+  WriteCountingStream countingStream(*pipe.ends[0]);
+
+  TwoPartyVatNetwork clientNetwork(countingStream, rpc::twoparty::Side::CLIENT);
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[1], rpc::twoparty::Side::SERVER);
+
+  MallocMessageBuilder refMessage(128);
+  auto hostId = refMessage.initRoot<rpc::twoparty::VatId>();
+  hostId.setSide(rpc::twoparty::Side::SERVER);
+  auto clientConn = KJ_ASSERT_NONNULL(clientNetwork.connect(hostId));
+  auto serverConn = serverNetwork.accept().wait(ioContext.waitScope);
+
+  for (uint i = 0; i < 3; i++) {
+    auto msg = clientConn->newOutgoingMessage(128);
+    msg->getBody().initAs<rpc::Message>().initAbort().setReason(kj::str("message ", i));
+    msg->send();
+  }
+  EXPECT_EQ(0u, countingStream.writeCount);
+
+  for (uint i = 0; i < 3; i++) {
+    auto incoming = KJ_ASSERT_NONNULL(
+        serverConn->receiveIncomingMessage().wait(ioContext.waitScope));
+    EXPECT_EQ(kj::str("message ", i),
+              incoming->getBody().getAs<rpc::Message>().getAbort().getReason());
+  }
+  EXPECT_EQ(1u, countingStream.writeCount);
+}
+
+TEST(TwoPartyNetwork, IncomingMessageSize) {
+  // sizeInWords() counts every segment and the segment table, even with an empty segment in the
+  // middle.
+
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[1], rpc::twoparty::Side::SERVER);
+  auto serverConn = serverNetwork.accept().wait(ioContext.waitScope);
+
+  MallocMessageBuilder builder;
+  builder.initRoot<rpc::Message>().initAbort().setReason("foo");
+  auto firstSegment = builder.getSegmentsForOutput()[0];
+  word padding[3];
+  memset(padding, 0, sizeof(padding));
+  kj::ArrayPtr<const word> segments[3] = {
+    firstSegment, kj::arrayPtr(padding, 0), kj::arrayPtr(padding, 3) };
+  writeMessage(*pipe.ends[0], segments).wait(ioContext.waitScope);
+
+  auto incoming = KJ_ASSERT_NONNULL(
+      serverConn->receiveIncomingMessage().wait(ioContext.waitScope));
+  EXPECT_EQ("foo", incoming->getBody().getAs<rpc::Message>().getAbort().getReason());
+  EXPECT_EQ(2 + firstSegment.size() + 3, incoming->sizeInWords());
+
+  // Copying the message out of the read buffer leaves it intact.
+  incoming->prepareToRetain();
+  EXPECT_EQ("foo", incoming->getBody().getAs<rpc::Message>().getAbort().getReason());
+  EXPECT_EQ(2 + firstSegment.size() + 3, incoming->sizeInWords());
+}
+
 TEST(TwoPartyNetwork, ConvenienceClasses) {
   auto ioContext = kj::setupAsyncIo();
 
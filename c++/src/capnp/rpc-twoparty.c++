@@ -26,9 +26,16 @@
 namespace capnp {
 
 TwoPartyVatNetwork::TwoPartyVatNetwork(kj::AsyncIoStream& stream, rpc::twoparty::Side side,
-                                       ReaderOptions receiveOptions)
+                                       ReaderOptions receiveOptions, Encoding encoding)
     : stream(stream), side(side), peerVatId(4),
-      receiveOptions(receiveOptions), previousWrite(kj::READY_NOW) {
+      receiveOptions(receiveOptions), encoding(encoding),
+      previousWrite(kj::READY_NOW) {
+  if (encoding == Encoding::PACKED) {
+    incomingMessages = kj::heap<PackedMessageStream>(stream, receiveOptions);
+  } else {
+    incomingMessages = kj::heap<BufferedMessageStream>(stream, receiveOptions);
+  }
+
   peerVatId.initRoot<rpc::twoparty::VatId>().setSide(
       side == rpc::twoparty::Side::CLIENT ? rpc::twoparty::Side::SERVER
                                           : rpc::twoparty::Side::CLIENT);
@@ -38,6 +45,8 @@ TwoPartyVatNetwork::TwoPartyVatNetwork(kj::AsyncIoStream& stream, rpc::twoparty:
   disconnectFulfiller.fulfiller = kj::mv(paf.fulfiller);
 }
 
+TwoPartyVatNetwork::~TwoPartyVatNetwork() noexcept(false) {}
+
 void TwoPartyVatNetwork::FulfillerDisposer::disposeImpl(void* pointer) const {
   if (--refcount == 0) {
     fulfiller->fulfill();
@@ -81,25 +90,90 @@ public:
     return message.getRoot<AnyPointer>();
   }
 
+  size_t sizeInWords() override {
+    return computeSerializedSizeInWords(message);
+  }
+
   void send() override {
-    network.previousWrite = KJ_ASSERT_NONNULL(network.previousWrite, "already shut down")
-        .then([&]() {
-      // Note that if the write fails, all further writes will be skipped due to the exception.
-      // We never actually handle this exception because we assume the read end will fail as well
-      // and it's cleaner to handle the failure there.
-      return writeMessage(network.stream, message);
-    }).attach(kj::addRef(*this))
-      // Note that it's important that the eagerlyEvaluate() come *after* the attach() because
-      // otherwise the message (and any capabilities in it) will not be released until a new
-      // message is written! (Kenton once spent all afternoon tracking this down...)
-      .eagerlyEvaluate(nullptr);
+    auto& previousWrite = KJ_ASSERT_NONNULL(network.previousWrite, "already shut down");
+    network.queuedMessages.add(kj::addRef(*this));
+
+    if (!network.flushScheduled) {
+      // Rather than writing right away, wait for the previous write to finish (or, if there is
+      // none, for the current event loop turn to end) so that any other messages sent in the
+      // meantime can go out in the same write.
+      network.flushScheduled = true;
+      auto& networkRef = network;
+      previousWrite = previousWrite.then([&networkRef]() {
+        return networkRef.flushQueue();
+      }).then([]() -> kj::Promise<void> {
+        return kj::READY_NOW;
+      }, [&networkRef](kj::Exception&& exception) -> kj::Promise<void> {
+        // A write failed, so nothing queued now will ever be written.  Drop the queue (releasing
+        // any capabilities held by the messages) and go back to scheduling a flush per send, so
+        // that later messages are dropped too rather than piling up.  The exception still
+        // propagates, so all further writes are skipped.  We never actually handle it because we
+        // assume the read end will fail as well and it's cleaner to handle the failure there.
+        networkRef.queuedMessages.clear();
+        networkRef.flushScheduled = false;
+        return kj::mv(exception);
+      }).eagerlyEvaluate(nullptr);
+    }
   }
 
+  MallocMessageBuilder& getMessage() { return message; }
+
 private:
   TwoPartyVatNetwork& network;
   MallocMessageBuilder message;
 };
 
+static constexpr size_t MAX_WRITE_BATCH_BYTES = 1 << 18;
+// Upper bound on the number of bytes we try to coalesce into one write.  A single message larger
+// than this is still written whole.
+
+kj::Promise<void> TwoPartyVatNetwork::flushQueue() {
+  auto queue = queuedMessages.releaseAsArray();
+
+  size_t count = 0;
+  size_t bytes = 0;
+  while (count < queue.size()) {
+    size_t size = computeSerializedSizeInWords(queue[count]->getMessage()) * sizeof(word);
+    if (count > 0 && bytes + size > MAX_WRITE_BATCH_BYTES) break;
+    bytes += size;
+    ++count;
+  }
+
+  auto batch = kj::heapArrayBuilder<kj::Own<OutgoingMessageImpl>>(count);
+  for (uint i = 0; i < count; i++) {
+    batch.add(kj::mv(queue[i]));
+  }
+  for (uint i = count; i < queue.size(); i++) {
+    queuedMessages.add(kj::mv(queue[i]));
+  }
+
+  auto segments = KJ_MAP(message, batch) {
+    return message->getMessage().getSegmentsForOutput();
+  };
+
+  // Note that it's important that the messages be attached to the write promise itself (which
+  // is eagerly evaluated, see send()), because otherwise the messages (and any capabilities in
+  // them) will not be released until a new message is written! (Kenton once spent all afternoon
+  // tracking this down...)
+  auto promise = encoding == Encoding::PACKED
+      ? writePackedMessages(stream, segments)
+      : writeMessages(stream, segments);
+  promise = promise.attach(kj::mv(batch), kj::mv(segments));
+
+  if (queuedMessages.empty()) {
+    flushScheduled = false;
+    return kj::mv(promise);
+  } else {
+    // Over budget; the rest go in the next write.  flushScheduled remains true.
+    return promise.then([this]() { return flushQueue(); });
+  }
+}
+
 class TwoPartyVatNetwork::IncomingMessageImpl final: public IncomingRpcMessage {
 public:
   IncomingMessageImpl(kj::Own<MessageReader> message): message(kj::mv(message)) {}
@@ -108,6 +182,17 @@ public:
     return message->getRoot<AnyPointer>();
   }
 
+  size_t sizeInWords() override {
+    return kj::downcast<MessageStream::Reader>(*message).sizeInWords();
+  }
+
+  void prepareToRetain() override {
+    auto& reader = kj::downcast<MessageStream::Reader>(*message);
+    if (reader.sharesBuffer()) {
+      message = reader.copy();
+    }
+  }
+
 private:
   kj::Own<MessageReader> message;
 };
@@ -122,7 +207,7 @@ kj::Own<OutgoingRpcMessage> TwoPartyVatNetwork::newOutgoingMessage(uint firstSeg
 
 kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> TwoPartyVatNetwork::receiveIncomingMessage() {
   return kj::evalLater([&]() {
-    return tryReadMessage(stream, receiveOptions)
+    return incomingMessages->tryReadMessage()
         .then([&](kj::Maybe<kj::Own<MessageReader>>&& message)
               -> kj::Maybe<kj::Own<IncomingRpcMessage>> {
       KJ_IF_MAYBE(m, message) {
@@ -36,9 +36,10 @@ static const ::capnp::_::AlignedData<26> b_9fd69ebc87b9719c = {
 ::capnp::word const* const bp_9fd69ebc87b9719c = b_9fd69ebc87b9719c.words;
 #if !CAPNP_LITE
 static const uint16_t m_9fd69ebc87b9719c[] = {1, 0};
+static const uint16_t h_9fd69ebc87b9719c[] = {65535, 65535, 0, 1};
 const ::capnp::_::RawSchema s_9fd69ebc87b9719c = {
   0x9fd69ebc87b9719c, b_9fd69ebc87b9719c.words, 26, nullptr, m_9fd69ebc87b9719c,
-  0, 2, nullptr, nullptr, nullptr, { &s_9fd69ebc87b9719c, nullptr, nullptr, 0, 0, nullptr }
+  h_9fd69ebc87b9719c, 0, 2, nullptr, nullptr, nullptr, { &s_9fd69ebc87b9719c, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 CAPNP_DEFINE_ENUM(Side_9fd69ebc87b9719c, 9fd69ebc87b9719c);
@@ -83,10 +84,11 @@ static const ::capnp::_::RawSchema* const d_d20b909fee733a8e[] = {
   &s_9fd69ebc87b9719c,
 };
 static const uint16_t m_d20b909fee733a8e[] = {0};
+static const uint16_t h_d20b909fee733a8e[] = {0, 65535};
 static const uint16_t i_d20b909fee733a8e[] = {0};
 const ::capnp::_::RawSchema s_d20b909fee733a8e = {
   0xd20b909fee733a8e, b_d20b909fee733a8e.words, 33, d_d20b909fee733a8e, m_d20b909fee733a8e,
-  1, 1, i_d20b909fee733a8e, nullptr, nullptr, { &s_d20b909fee733a8e, nullptr, nullptr, 0, 0, nullptr }
+  h_d20b909fee733a8e, 1, 1, i_d20b909fee733a8e, nullptr, nullptr, { &s_d20b909fee733a8e, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<34> b_b88d09a9c5f39817 = {
@@ -128,10 +130,11 @@ static const ::capnp::_::AlignedData<34> b_b88d09a9c5f39817 = {
 ::capnp::word const* const bp_b88d09a9c5f39817 = b_b88d09a9c5f39817.words;
 #if !CAPNP_LITE
 static const uint16_t m_b88d09a9c5f39817[] = {0};
+static const uint16_t h_b88d09a9c5f39817[] = {0, 65535};
 static const uint16_t i_b88d09a9c5f39817[] = {0};
 const ::capnp::_::RawSchema s_b88d09a9c5f39817 = {
   0xb88d09a9c5f39817, b_b88d09a9c5f39817.words, 34, nullptr, m_b88d09a9c5f39817,
-  0, 1, i_b88d09a9c5f39817, nullptr, nullptr, { &s_b88d09a9c5f39817, nullptr, nullptr, 0, 0, nullptr }
+  h_b88d09a9c5f39817, 0, 1, i_b88d09a9c5f39817, nullptr, nullptr, { &s_b88d09a9c5f39817, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<18> b_89f389b6fd4082c1 = {
@@ -158,7 +161,7 @@ static const ::capnp::_::AlignedData<18> b_89f389b6fd4082c1 = {
 #if !CAPNP_LITE
 const ::capnp::_::RawSchema s_89f389b6fd4082c1 = {
   0x89f389b6fd4082c1, b_89f389b6fd4082c1.words, 18, nullptr, nullptr,
-  0, 0, nullptr, nullptr, nullptr, { &s_89f389b6fd4082c1, nullptr, nullptr, 0, 0, nullptr }
+  nullptr, 0, 0, nullptr, nullptr, nullptr, { &s_89f389b6fd4082c1, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<19> b_b47f4979672cb59d = {
@@ -186,7 +189,7 @@ static const ::capnp::_::AlignedData<19> b_b47f4979672cb59d = {
 #if !CAPNP_LITE
 const ::capnp::_::RawSchema s_b47f4979672cb59d = {
   0xb47f4979672cb59d, b_b47f4979672cb59d.words, 19, nullptr, nullptr,
-  0, 0, nullptr, nullptr, nullptr, { &s_b47f4979672cb59d, nullptr, nullptr, 0, 0, nullptr }
+  nullptr, 0, 0, nullptr, nullptr, nullptr, { &s_b47f4979672cb59d, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<65> b_95b29059097fca83 = {
@@ -259,10 +262,11 @@ static const ::capnp::_::AlignedData<65> b_95b29059097fca83 = {
 ::capnp::word const* const bp_95b29059097fca83 = b_95b29059097fca83.words;
 #if !CAPNP_LITE
 static const uint16_t m_95b29059097fca83[] = {0, 1, 2};
+static const uint16_t h_95b29059097fca83[] = {65535, 65535, 65535, 1, 0, 2, 65535, 65535};
 static const uint16_t i_95b29059097fca83[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_95b29059097fca83 = {
   0x95b29059097fca83, b_95b29059097fca83.words, 65, nullptr, m_95b29059097fca83,
-  0, 3, i_95b29059097fca83, nullptr, nullptr, { &s_95b29059097fca83, nullptr, nullptr, 0, 0, nullptr }
+  h_95b29059097fca83, 0, 3, i_95b29059097fca83, nullptr, nullptr, { &s_95b29059097fca83, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<65> b_9d263a3630b7ebee = {
@@ -335,10 +339,11 @@ static const ::capnp::_::AlignedData<65> b_9d263a3630b7ebee = {
 ::capnp::word const* const bp_9d263a3630b7ebee = b_9d263a3630b7ebee.words;
 #if !CAPNP_LITE
 static const uint16_t m_9d263a3630b7ebee[] = {2, 0, 1};
+static const uint16_t h_9d263a3630b7ebee[] = {65535, 65535, 1, 2, 0, 65535, 65535, 65535};
 static const uint16_t i_9d263a3630b7ebee[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_9d263a3630b7ebee = {
   0x9d263a3630b7ebee, b_9d263a3630b7ebee.words, 65, nullptr, m_9d263a3630b7ebee,
-  0, 3, i_9d263a3630b7ebee, nullptr, nullptr, { &s_9d263a3630b7ebee, nullptr, nullptr, 0, 0, nullptr }
+  h_9d263a3630b7ebee, 0, 3, i_9d263a3630b7ebee, nullptr, nullptr, { &s_9d263a3630b7ebee, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 }  // namespace schemas
@@ -19,17 +19,17 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#define CAPNP_PRIVATE
 #include "rpc.h"
+#include "dense-hash-map.h"
 #include "message.h"
 #include <kj/debug.h>
 #include <kj/vector.h>
 #include <kj/async.h>
 #include <kj/one-of.h>
 #include <kj/function.h>
-#include <functional>  // std::greater
 #include <unordered_map>
 #include <map>
-#include <queue>
 #include <capnp/rpc.capnp.h>
 
 namespace capnp {
@@ -152,21 +152,28 @@ public:
     KJ_DREQUIRE(&entry == &slots[id]);
     T toRelease = kj::mv(slots[id]);
     slots[id] = T();
-    freeIds.push(id);
+    freeIds.add(id);
+    --count;
     return toRelease;
   }
 
   T& next(Id& id) {
+    // Freed IDs are reused most-recently-freed first, which is O(1) and keeps the IDs in use
+    // roughly as dense as the table itself.
+    ++count;
     if (freeIds.empty()) {
       id = slots.size();
       return slots.add();
     } else {
-      id = freeIds.top();
-      freeIds.pop();
+      id = freeIds.back();
+      freeIds.removeLast();
       return slots[id];
     }
   }
 
+  size_t size() const { return count; }
+  // Number of IDs handed out by next() and not yet erased.
+
   template <typename Func>
   void forEach(Func&& func) {
     for (Id i = 0; i < slots.size(); i++) {
@@ -178,19 +185,42 @@ public:
 
 private:
   kj::Vector<T> slots;
-  std::priority_queue<Id, std::vector<Id>, std::greater<Id>> freeIds;
+  kj::Vector<Id> freeIds;
+  size_t count = 0;
 };
 
 template <typename Id, typename T>
 class ImportTable {
   // Table mapping integers to T, where the integers are chosen remotely.
+  //
+  // Entries with IDs beyond the first few live in fixed-size chunks that are never moved, so
+  // references to entries stay valid while other entries are added and removed. An open-addressed
+  // index maps IDs to entries, and released entries are recycled through a free list, so a table
+  // in steady state does no allocation at all.
 
 public:
   T& operator[](Id id) {
     if (id < kj::size(low)) {
       return low[id];
     } else {
-      return high[id];
+      KJ_IF_MAYBE(entry, high.find(id)) {
+        return (*entry)->value;
+      }
+
+      HighEntry* entry = freeList;
+      if (entry == nullptr) {
+        chunks.add(kj::heapArray<HighEntry>(CHUNK_SIZE));
+        auto& chunk = chunks.back();
+        for (auto i: kj::indices(chunk)) {
+          chunk[i].nextFree = i + 1 < CHUNK_SIZE ? &chunk[i + 1] : nullptr;
+        }
+        entry = chunk.begin();
+      }
+      freeList = entry->nextFree;
+      entry->nextFree = nullptr;
+
+      high.insert(id, entry);
+      return entry->value;
     }
   }
 
@@ -198,11 +228,10 @@ public:
     if (id < kj::size(low)) {
       return low[id];
     } else {
-      auto iter = high.find(id);
-      if (iter == high.end()) {
-        return nullptr;
+      KJ_IF_MAYBE(entry, high.find(id)) {
+        return (*entry)->value;
       } else {
-        return iter->second;
+        return nullptr;
       }
     }
   }
@@ -215,9 +244,17 @@ public:
       low[id] = T();
       return toRelease;
     } else {
-      T toRelease = kj::mv(high[id]);
-      high.erase(id);
-      return toRelease;
+      KJ_IF_MAYBE(e, high.find(id)) {
+        HighEntry* entry = *e;
+        high.erase(id);
+        T toRelease = kj::mv(entry->value);
+        entry->value = T();
+        entry->nextFree = freeList;
+        freeList = entry;
+        return toRelease;
+      } else {
+        return T();
+      }
     }
   }
 
@@ -226,14 +263,23 @@ public:
     for (Id i: kj::indices(low)) {
       func(i, low[i]);
     }
-    for (auto& entry: high) {
-      func(entry.first, entry.second);
-    }
+    high.forEach([&](Id id, HighEntry* entry) {
+      func(id, entry->value);
+    });
   }
 
 private:
+  static constexpr uint CHUNK_SIZE = 64;
+
+  struct HighEntry {
+    T value;
+    HighEntry* nextFree = nullptr;
+  };
+
   T low[16];
-  std::unordered_map<Id, T> high;
+  DenseHashMap<Id, HighEntry*> high;
+  kj::Vector<kj::Array<HighEntry>> chunks;
+  HighEntry* freeList = nullptr;
 };
 
 // =======================================================================================
@@ -283,7 +329,7 @@ public:
       builder.setQuestionId(questionId);
       builder.getDeprecatedObjectId().set(objectId);
 
-      message->send();
+      sendMessage(*message);
     }
 
     auto pipeline = kj::refcounted<RpcPipeline>(*this, kj::mv(questionRef), kj::mv(paf.promise));
@@ -363,9 +409,11 @@ public:
       auto message = connection.get<Connected>()->newOutgoingMessage(
           messageSizeHint<void>() + exceptionSizeHint(exception));
       fromException(exception, message->getBody().getAs<rpc::Message>().initAbort());
-      message->send();
+      sendMessage(*message);
     });
 
+    stopStats();
+
     // Indicate disconnect.
     auto shutdownPromise = connection.get<Connected>()->shutdown()
         .attach(kj::mv(connection.get<Connected>()))
@@ -386,6 +434,17 @@ public:
     maybeUnblockFlow();
   }
 
+  void setStats(RpcStats& newStats) {
+    if (stats != nullptr || !connection.is<Connected>()) return;
+    stats = newStats;
+    connectionStats = &newStats.addConnection();
+    publishStats();
+  }
+
+  ~RpcConnectionState() noexcept(false) {
+    stopStats();
+  }
+
 private:
   class RpcClient;
   class ImportClient;
@@ -429,6 +488,10 @@ private:
     bool isTailCall = false;
     // Is this a tail call?  If so, we don't expect to receive results in the `Return`.
 
+    _::RpcMethodStats* methodStats = nullptr;
+    kj::TimePoint sendTime = kj::origin<kj::TimePoint>();
+    // If stats are enabled, the method called and when, to be recorded when `Return` arrives.
+
     inline bool operator==(decltype(nullptr)) const {
       return !isAwaitingReturn && selfRef == nullptr;
     }
@@ -529,7 +592,7 @@ private:
   // The Four Tables!
   // The order of the tables is important for correct destruction.
 
-  std::unordered_map<ClientHook*, ExportId> exportsByCap;
+  DenseHashMap<ClientHook*, ExportId> exportsByCap;
   // Maps already-exported ClientHook objects to their ID in the export table.
 
   ExportTable<EmbargoId, Embargo> embargoes;
@@ -543,6 +606,11 @@ private:
   // If non-null, we're currently blocking incoming messages waiting for callWordsInFlight to drop
   // below flowLimit. Fulfill this to un-block.
 
+  kj::Maybe<RpcStats&> stats;
+  _::RpcConnectionStats* connectionStats = nullptr;
+  size_t callsInFlight = 0;
+  // Set by setStats() and cleared on disconnect.  `callsInFlight` is only kept for the stats.
+
   kj::TaskSet tasks;
 
   // =====================================================================================
@@ -709,7 +777,7 @@ private:
           rpc::Release::Builder builder = message->getBody().initAs<rpc::Message>().initRelease();
           builder.setId(importId);
           builder.setReferenceCount(remoteRefcount);
-          message->send();
+          connectionState->sendMessage(*message);
         }
       });
     }
@@ -940,7 +1008,7 @@ private:
         replacement = newLocalPromiseClient(kj::mv(embargoPromise));
 
         // Send the `Disembargo`.
-        message->send();
+        connectionState->sendMessage(*message);
       }
 
       cap = kj::mv(replacement);
@@ -1013,18 +1081,17 @@ private:
     if (inner->getBrand() == this) {
       return kj::downcast<RpcClient>(*inner).writeDescriptor(descriptor);
     } else {
-      auto iter = exportsByCap.find(inner);
-      if (iter != exportsByCap.end()) {
+      KJ_IF_MAYBE(existingId, exportsByCap.find(inner)) {
         // We've already seen and exported this capability before.  Just up the refcount.
-        auto& exp = KJ_ASSERT_NONNULL(exports.find(iter->second));
+        auto& exp = KJ_ASSERT_NONNULL(exports.find(*existingId));
         ++exp.refcount;
-        descriptor.setSenderHosted(iter->second);
-        return iter->second;
+        descriptor.setSenderHosted(*existingId);
+        return *existingId;
       } else {
         // This is the first time we've seen this capability.
         ExportId exportId;
         auto& exp = exports.next(exportId);
-        exportsByCap[inner] = exportId;
+        exportsByCap.insert(inner, exportId);
         exp.refcount = 1;
         exp.clientHook = inner->addRef();
 
@@ -1119,7 +1186,7 @@ private:
       // export table is still live because when it is destroyed the asynchronous resolution task
       // (i.e. this code) is canceled.
       auto& exp = KJ_ASSERT_NONNULL(exports.find(exportId));
-      exportsByCap.erase(exp.clientHook);
+      exportsByCap.erase(exp.clientHook.get());
       exp.clientHook = kj::mv(resolution);
 
       if (exp.clientHook->getBrand() != this) {
@@ -1131,9 +1198,7 @@ private:
           // be able to just reuse the existing export table entry to represent the new promise --
           // unless it already has an entry.  Let's check.
 
-          auto insertResult = exportsByCap.insert(std::make_pair(exp.clientHook.get(), exportId));
-
-          if (insertResult.second) {
+          if (exportsByCap.insert(exp.clientHook.get(), exportId)) {
             // The new promise was not already in the table, therefore the existing export table
             // entry has now been repurposed to represent it.  There is no need to send a resolve
             // message at all.  We do, however, have to start resolving the next promise.
@@ -1148,7 +1213,7 @@ private:
       auto resolve = message->getBody().initAs<rpc::Message>().initResolve();
       resolve.setPromiseId(exportId);
       writeDescriptor(*exp.clientHook, resolve.initCap());
-      message->send();
+      sendMessage(*message);
 
       return kj::READY_NOW;
     }, [this,exportId](kj::Exception&& exception) {
@@ -1158,7 +1223,7 @@ private:
       auto resolve = message->getBody().initAs<rpc::Message>().initResolve();
       resolve.setPromiseId(exportId);
       fromException(exception, resolve.initException());
-      message->send();
+      sendMessage(*message);
     }).eagerlyEvaluate([this](kj::Exception&& exception) {
       // Put the exception on the TaskSet which will cause the connection to be terminated.
       tasks.add(kj::mv(exception));
@@ -1292,7 +1357,7 @@ private:
           // already received the return, then we've already built local proxies for the caps and
           // will send Release messages when those are destroyed.
           builder.setReleaseResultCaps(question.isAwaitingReturn);
-          message->send();
+          connectionState->sendMessage(*message);
         }
 
         // Check if the question has returned and, if so, remove it from the table.
@@ -1455,12 +1520,19 @@ private:
       question.paramExports = kj::mv(exports);
       question.isTailCall = isTailCall;
 
+      KJ_IF_MAYBE(s, connectionState->stats) {
+        auto& method = s->getMethod(callBuilder.getInterfaceId(), callBuilder.getMethodId());
+        method.callsSent.add(1);
+        question.methodStats = &method;
+        question.sendTime = kj::systemSteadyTime();
+      }
+
       // Finish and send.
       callBuilder.setQuestionId(questionId);
       if (isTailCall) {
         callBuilder.getSendResultsTo().setYourself();
       }
-      message->send();
+      connectionState->sendMessage(*message);
 
       // Make the result promise.
       SendInternalResult result;
@@ -1642,7 +1714,7 @@ private:
         }
       }
 
-      message->send();
+      connectionState.sendMessage(*message);
       if (capTable.size() == 0) {
         return nullptr;
       } else {
@@ -1697,6 +1769,13 @@ private:
           redirectResults(redirectResults),
           cancelFulfiller(kj::mv(cancelFulfiller)) {
       connectionState.callWordsInFlight += requestSize;
+      ++connectionState.callsInFlight;
+    }
+
+    void startStats(_::RpcMethodStats& method) {
+      method.callsReceived.add(1);
+      methodStats = &method;
+      startTime = kj::systemSteadyTime();
     }
 
     ~RpcCallContext() noexcept(false) {
@@ -1720,7 +1799,7 @@ private:
               builder.setCanceled();
             }
 
-            message->send();
+            connectionState->sendMessage(*message);
           }
 
           cleanupAnswerTable(nullptr, true);
@@ -1776,7 +1855,11 @@ private:
           builder.setReleaseParamCaps(false);
           fromException(exception, builder.initException());
 
-          message->send();
+          connectionState->sendMessage(*message);
+        }
+
+        if (methodStats != nullptr && connectionState->connectionStats != nullptr) {
+          methodStats->exceptionsSent.add(1);
         }
 
         // Do not allow releasing the pipeline because we want pipelined calls to propagate the
@@ -1859,7 +1942,7 @@ private:
               builder.setReleaseParamCaps(false);
               builder.setTakeFromOtherQuestion(tailInfo->questionId);
 
-              message->send();
+              connectionState->sendMessage(*message);
             }
 
             // There are no caps in our return message, but of course the tail results could have
@@ -1938,6 +2021,12 @@ private:
 
     kj::UnwindDetector unwindDetector;
 
+    // Stats -----------------------------------------------
+
+    _::RpcMethodStats* methodStats = nullptr;
+    kj::TimePoint startTime = kj::origin<kj::TimePoint>();
+    // Set by startStats() if stats are enabled.
+
     // -----------------------------------------------------
 
     bool isFirstResponder() {
@@ -1975,10 +2064,48 @@ private:
 
       // Also, this is the right time to stop counting the call against the flow limit.
       connectionState->callWordsInFlight -= requestSize;
+      --connectionState->callsInFlight;
       connectionState->maybeUnblockFlow();
+
+      if (connectionState->connectionStats != nullptr) {
+        // The `Return` has usually just been sent, before the counts above were decremented.
+        connectionState->publishStats();
+        if (methodStats != nullptr) {
+          methodStats->serverLatency.record((kj::systemSteadyTime() - startTime) / kj::NANOSECONDS);
+        }
+      }
     }
   };
 
+  // =====================================================================================
+  // Stats
+
+  void sendMessage(OutgoingRpcMessage& message) {
+    if (connectionStats != nullptr) {
+      connectionStats->messagesSent.add(1);
+      connectionStats->wordsSent.add(message.sizeInWords());
+      publishStats();
+    }
+    message.send();
+  }
+
+  void publishStats() {
+    // Refresh the gauges.  We do this on every message sent or handled rather than at each
+    // place the underlying values change, which nearly always happens alongside one or the other.
+    connectionStats->questions.set(questions.size());
+    connectionStats->exports.set(exports.size());
+    connectionStats->callsInFlight.set(callsInFlight);
+    connectionStats->callWordsInFlight.set(callWordsInFlight);
+  }
+
+  void stopStats() {
+    KJ_IF_MAYBE(s, stats) {
+      s->removeConnection(*connectionStats);
+      stats = nullptr;
+      connectionStats = nullptr;
+    }
+  }
+
   // =====================================================================================
   // Message handling
 
@@ -2007,7 +2134,14 @@ private:
     return connection.get<Connected>()->receiveIncomingMessage().then(
         [this](kj::Maybe<kj::Own<IncomingRpcMessage>>&& message) {
       KJ_IF_MAYBE(m, message) {
-        handleMessage(kj::mv(*m));
+        if (connectionStats == nullptr) {
+          handleMessage(kj::mv(*m));
+        } else {
+          connectionStats->messagesReceived.add(1);
+          connectionStats->wordsReceived.add(m->get()->sizeInWords());
+          handleMessage(kj::mv(*m));
+          if (connectionStats != nullptr) publishStats();
+        }
         return true;
       } else {
         disconnect(KJ_EXCEPTION(DISCONNECTED, "Peer disconnected."));
@@ -2025,6 +2159,12 @@ private:
   void handleMessage(kj::Own<IncomingRpcMessage> message) {
     auto reader = message->getBody().getAs<rpc::Message>();
 
+    if (reader.isCall() || (reader.isReturn() && reader.getReturn().isResults())) {
+      // The call context or response will keep `message` alive, possibly for a long time.
+      message->prepareToRetain();
+      reader = message->getBody().getAs<rpc::Message>();
+    }
+
     switch (reader.which()) {
       case rpc::Message::UNIMPLEMENTED:
         handleUnimplemented(reader.getUnimplemented());
@@ -2067,7 +2207,7 @@ private:
           auto message = connection.get<Connected>()->newOutgoingMessage(
               firstSegmentSize(reader.totalSize(), messageSizeHint<void>()));
           message->getBody().initAs<rpc::Message>().setUnimplemented(reader);
-          message->send();
+          sendMessage(*message);
         }
         break;
       }
@@ -2202,7 +2342,7 @@ private:
     answer.active = true;
     answer.pipeline = kj::Own<PipelineHook>(kj::refcounted<SingleCapPipeline>(kj::mv(capHook)));
 
-    response->send();
+    sendMessage(*response);
   }
 
   void handleCall(kj::Own<IncomingRpcMessage>&& message, const rpc::Call::Reader& call) {
@@ -2237,6 +2377,10 @@ private:
         *this, answerId, kj::mv(message), kj::mv(capTableArray), payload.getContent(),
         redirectResults, kj::mv(cancelPaf.fulfiller));
 
+    KJ_IF_MAYBE(s, stats) {
+      context->startStats(s->getMethod(call.getInterfaceId(), call.getMethodId()));
+    }
+
     // No more using `call` after this point, as it now belongs to the context.
 
     {
@@ -2380,6 +2524,14 @@ private:
       KJ_REQUIRE(question->isAwaitingReturn, "Duplicate Return.") { return; }
       question->isAwaitingReturn = false;
 
+      if (question->methodStats != nullptr && connectionStats != nullptr) {
+        question->methodStats->clientLatency.record(
+            (kj::systemSteadyTime() - question->sendTime) / kj::NANOSECONDS);
+        if (ret.isException()) {
+          question->methodStats->exceptionsReceived.add(1);
+        }
+      }
+
       if (ret.getReleaseParamCaps()) {
         exportsToRelease = kj::mv(question->paramExports);
       } else {
@@ -2549,7 +2701,7 @@ private:
 
       exp->refcount -= refcount;
       if (exp->refcount == 0) {
-        exportsByCap.erase(exp->clientHook);
+        exportsByCap.erase(exp->clientHook.get());
         exports.erase(id, *exp);
       }
     } else {
@@ -2625,7 +2777,7 @@ private:
 
           builder.getContext().setReceiverLoopback(embargoId);
 
-          message->send();
+          sendMessage(*message);
         })));
 
         break;
@@ -2714,6 +2866,14 @@ public:
     }
   }
 
+  void setStats(RpcStats& newStats) {
+    stats = newStats;
+
+    for (auto& conn: connections) {
+      conn.second->setStats(newStats);
+    }
+  }
+
 private:
   VatNetworkBase& network;
   kj::Maybe<Capability::Client> bootstrapInterface;
@@ -2721,6 +2881,7 @@ private:
   kj::Maybe<RealmGateway<>::Client> gateway;
   kj::Maybe<SturdyRefRestorerBase&> restorer;
   size_t flowLimit = kj::maxValue;
+  kj::Maybe<RpcStats&> stats;
   kj::TaskSet tasks;
 
   typedef std::unordered_map<VatNetworkBase::Connection*, kj::Own<RpcConnectionState>>
@@ -2742,6 +2903,9 @@ private:
       auto newState = kj::refcounted<RpcConnectionState>(
           bootstrapFactory, gateway, restorer, kj::mv(connection),
           kj::mv(onDisconnect.fulfiller), flowLimit);
+      KJ_IF_MAYBE(s, stats) {
+        newState->setStats(*s);
+      }
       RpcConnectionState& result = *newState;
       connections.insert(std::make_pair(connectionPtr, kj::mv(newState)));
       return result;
@@ -2808,5 +2972,9 @@ void RpcSystemBase::baseSetFlowLimit(size_t words) {
   return impl->setFlowLimit(words);
 }
 
+void RpcSystemBase::baseSetStats(RpcStats& stats) {
+  impl->setStats(stats);
+}
+
 }  // namespace _ (private)
 }  // namespace capnp
@@ -256,10 +256,11 @@ static const ::capnp::_::RawSchema* const d_91b79f1f808db032[] = {
   &s_fbe1980490e001af,
 };
 static const uint16_t m_91b79f1f808db032[] = {1, 11, 8, 2, 13, 4, 12, 9, 7, 10, 6, 5, 3, 0};
+static const uint16_t h_91b79f1f808db032[] = {65535, 9, 65535, 5, 7, 65535, 10, 65535, 65535, 2, 11, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 4, 65535, 65535, 65535, 65535, 65535, 65535, 1, 0, 8, 12, 13, 6, 3};
 static const uint16_t i_91b79f1f808db032[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
 const ::capnp::_::RawSchema s_91b79f1f808db032 = {
   0x91b79f1f808db032, b_91b79f1f808db032.words, 232, d_91b79f1f808db032, m_91b79f1f808db032,
-  12, 14, i_91b79f1f808db032, nullptr, nullptr, { &s_91b79f1f808db032, nullptr, nullptr, 0, 0, nullptr }
+  h_91b79f1f808db032, 12, 14, i_91b79f1f808db032, nullptr, nullptr, { &s_91b79f1f808db032, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<51> b_e94ccf8031176ec4 = {
@@ -318,10 +319,11 @@ static const ::capnp::_::AlignedData<51> b_e94ccf8031176ec4 = {
 ::capnp::word const* const bp_e94ccf8031176ec4 = b_e94ccf8031176ec4.words;
 #if !CAPNP_LITE
 static const uint16_t m_e94ccf8031176ec4[] = {1, 0};
+static const uint16_t h_e94ccf8031176ec4[] = {0, 65535, 1, 65535};
 static const uint16_t i_e94ccf8031176ec4[] = {0, 1};
 const ::capnp::_::RawSchema s_e94ccf8031176ec4 = {
   0xe94ccf8031176ec4, b_e94ccf8031176ec4.words, 51, nullptr, m_e94ccf8031176ec4,
-  0, 2, i_e94ccf8031176ec4, nullptr, nullptr, { &s_e94ccf8031176ec4, nullptr, nullptr, 0, 0, nullptr }
+  h_e94ccf8031176ec4, 0, 2, i_e94ccf8031176ec4, nullptr, nullptr, { &s_e94ccf8031176ec4, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<121> b_836a53ce789d4cd4 = {
@@ -455,10 +457,11 @@ static const ::capnp::_::RawSchema* const d_836a53ce789d4cd4[] = {
   &s_dae8b0f61aab5f99,
 };
 static const uint16_t m_836a53ce789d4cd4[] = {6, 2, 3, 4, 0, 5, 1};
+static const uint16_t h_836a53ce789d4cd4[] = {0, 65535, 65535, 4, 6, 65535, 65535, 65535, 1, 65535, 5, 65535, 65535, 2, 3, 65535};
 static const uint16_t i_836a53ce789d4cd4[] = {0, 1, 2, 3, 4, 5, 6};
 const ::capnp::_::RawSchema s_836a53ce789d4cd4 = {
   0x836a53ce789d4cd4, b_836a53ce789d4cd4.words, 121, d_836a53ce789d4cd4, m_836a53ce789d4cd4,
-  3, 7, i_836a53ce789d4cd4, nullptr, nullptr, { &s_836a53ce789d4cd4, nullptr, nullptr, 0, 0, nullptr }
+  h_836a53ce789d4cd4, 3, 7, i_836a53ce789d4cd4, nullptr, nullptr, { &s_836a53ce789d4cd4, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<65> b_dae8b0f61aab5f99 = {
@@ -534,10 +537,11 @@ static const ::capnp::_::RawSchema* const d_dae8b0f61aab5f99[] = {
   &s_836a53ce789d4cd4,
 };
 static const uint16_t m_dae8b0f61aab5f99[] = {0, 2, 1};
+static const uint16_t h_dae8b0f61aab5f99[] = {65535, 65535, 0, 2, 1, 65535, 65535, 65535};
 static const uint16_t i_dae8b0f61aab5f99[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_dae8b0f61aab5f99 = {
   0xdae8b0f61aab5f99, b_dae8b0f61aab5f99.words, 65, d_dae8b0f61aab5f99, m_dae8b0f61aab5f99,
-  1, 3, i_dae8b0f61aab5f99, nullptr, nullptr, { &s_dae8b0f61aab5f99, nullptr, nullptr, 0, 0, nullptr }
+  h_dae8b0f61aab5f99, 1, 3, i_dae8b0f61aab5f99, nullptr, nullptr, { &s_dae8b0f61aab5f99, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<148> b_9e19b28d3db3573a = {
@@ -697,10 +701,11 @@ static const ::capnp::_::RawSchema* const d_9e19b28d3db3573a[] = {
   &s_d625b7063acf691a,
 };
 static const uint16_t m_9e19b28d3db3573a[] = {7, 0, 4, 3, 1, 2, 5, 6};
+static const uint16_t h_9e19b28d3db3573a[] = {65535, 65535, 0, 65535, 65535, 2, 3, 5, 65535, 65535, 1, 4, 6, 65535, 7, 65535};
 static const uint16_t i_9e19b28d3db3573a[] = {2, 3, 4, 5, 6, 7, 0, 1};
 const ::capnp::_::RawSchema s_9e19b28d3db3573a = {
   0x9e19b28d3db3573a, b_9e19b28d3db3573a.words, 148, d_9e19b28d3db3573a, m_9e19b28d3db3573a,
-  2, 8, i_9e19b28d3db3573a, nullptr, nullptr, { &s_9e19b28d3db3573a, nullptr, nullptr, 0, 0, nullptr }
+  h_9e19b28d3db3573a, 2, 8, i_9e19b28d3db3573a, nullptr, nullptr, { &s_9e19b28d3db3573a, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<50> b_d37d2eb2c2f80e63 = {
@@ -758,10 +763,11 @@ static const ::capnp::_::AlignedData<50> b_d37d2eb2c2f80e63 = {
 ::capnp::word const* const bp_d37d2eb2c2f80e63 = b_d37d2eb2c2f80e63.words;
 #if !CAPNP_LITE
 static const uint16_t m_d37d2eb2c2f80e63[] = {0, 1};
+static const uint16_t h_d37d2eb2c2f80e63[] = {0, 65535, 1, 65535};
 static const uint16_t i_d37d2eb2c2f80e63[] = {0, 1};
 const ::capnp::_::RawSchema s_d37d2eb2c2f80e63 = {
   0xd37d2eb2c2f80e63, b_d37d2eb2c2f80e63.words, 50, nullptr, m_d37d2eb2c2f80e63,
-  0, 2, i_d37d2eb2c2f80e63, nullptr, nullptr, { &s_d37d2eb2c2f80e63, nullptr, nullptr, 0, 0, nullptr }
+  h_d37d2eb2c2f80e63, 0, 2, i_d37d2eb2c2f80e63, nullptr, nullptr, { &s_d37d2eb2c2f80e63, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<64> b_bbc29655fa89086e = {
@@ -837,10 +843,11 @@ static const ::capnp::_::RawSchema* const d_bbc29655fa89086e[] = {
   &s_d625b7063acf691a,
 };
 static const uint16_t m_bbc29655fa89086e[] = {1, 2, 0};
+static const uint16_t h_bbc29655fa89086e[] = {65535, 65535, 65535, 1, 65535, 65535, 2, 0};
 static const uint16_t i_bbc29655fa89086e[] = {1, 2, 0};
 const ::capnp::_::RawSchema s_bbc29655fa89086e = {
   0xbbc29655fa89086e, b_bbc29655fa89086e.words, 64, d_bbc29655fa89086e, m_bbc29655fa89086e,
-  2, 3, i_bbc29655fa89086e, nullptr, nullptr, { &s_bbc29655fa89086e, nullptr, nullptr, 0, 0, nullptr }
+  h_bbc29655fa89086e, 2, 3, i_bbc29655fa89086e, nullptr, nullptr, { &s_bbc29655fa89086e, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<48> b_ad1a6c0d7dd07497 = {
@@ -896,10 +903,11 @@ static const ::capnp::_::AlignedData<48> b_ad1a6c0d7dd07497 = {
 ::capnp::word const* const bp_ad1a6c0d7dd07497 = b_ad1a6c0d7dd07497.words;
 #if !CAPNP_LITE
 static const uint16_t m_ad1a6c0d7dd07497[] = {0, 1};
+static const uint16_t h_ad1a6c0d7dd07497[] = {0, 1, 65535, 65535};
 static const uint16_t i_ad1a6c0d7dd07497[] = {0, 1};
 const ::capnp::_::RawSchema s_ad1a6c0d7dd07497 = {
   0xad1a6c0d7dd07497, b_ad1a6c0d7dd07497.words, 48, nullptr, m_ad1a6c0d7dd07497,
-  0, 2, i_ad1a6c0d7dd07497, nullptr, nullptr, { &s_ad1a6c0d7dd07497, nullptr, nullptr, 0, 0, nullptr }
+  h_ad1a6c0d7dd07497, 0, 2, i_ad1a6c0d7dd07497, nullptr, nullptr, { &s_ad1a6c0d7dd07497, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<41> b_f964368b0fbd3711 = {
@@ -952,10 +960,11 @@ static const ::capnp::_::RawSchema* const d_f964368b0fbd3711[] = {
   &s_d562b4df655bdd4d,
 };
 static const uint16_t m_f964368b0fbd3711[] = {1, 0};
+static const uint16_t h_f964368b0fbd3711[] = {0, 1, 65535, 65535};
 static const uint16_t i_f964368b0fbd3711[] = {0, 1};
 const ::capnp::_::RawSchema s_f964368b0fbd3711 = {
   0xf964368b0fbd3711, b_f964368b0fbd3711.words, 41, d_f964368b0fbd3711, m_f964368b0fbd3711,
-  2, 2, i_f964368b0fbd3711, nullptr, nullptr, { &s_f964368b0fbd3711, nullptr, nullptr, 0, 0, nullptr }
+  h_f964368b0fbd3711, 2, 2, i_f964368b0fbd3711, nullptr, nullptr, { &s_f964368b0fbd3711, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<81> b_d562b4df655bdd4d = {
@@ -1047,10 +1056,11 @@ static const ::capnp::_::RawSchema* const d_d562b4df655bdd4d[] = {
   &s_f964368b0fbd3711,
 };
 static const uint16_t m_d562b4df655bdd4d[] = {2, 3, 1, 0};
+static const uint16_t h_d562b4df655bdd4d[] = {65535, 0, 2, 65535, 65535, 1, 3, 65535};
 static const uint16_t i_d562b4df655bdd4d[] = {0, 1, 2, 3};
 const ::capnp::_::RawSchema s_d562b4df655bdd4d = {
   0xd562b4df655bdd4d, b_d562b4df655bdd4d.words, 81, d_d562b4df655bdd4d, m_d562b4df655bdd4d,
-  1, 4, i_d562b4df655bdd4d, nullptr, nullptr, { &s_d562b4df655bdd4d, nullptr, nullptr, 0, 0, nullptr }
+  h_d562b4df655bdd4d, 1, 4, i_d562b4df655bdd4d, nullptr, nullptr, { &s_d562b4df655bdd4d, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<64> b_9c6a046bfbc1ac5a = {
@@ -1125,10 +1135,11 @@ static const ::capnp::_::RawSchema* const d_9c6a046bfbc1ac5a[] = {
   &s_95bc14545813fbc1,
 };
 static const uint16_t m_9c6a046bfbc1ac5a[] = {0, 2, 1};
+static const uint16_t h_9c6a046bfbc1ac5a[] = {0, 1, 2, 65535, 65535, 65535, 65535, 65535};
 static const uint16_t i_9c6a046bfbc1ac5a[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_9c6a046bfbc1ac5a = {
   0x9c6a046bfbc1ac5a, b_9c6a046bfbc1ac5a.words, 64, d_9c6a046bfbc1ac5a, m_9c6a046bfbc1ac5a,
-  1, 3, i_9c6a046bfbc1ac5a, nullptr, nullptr, { &s_9c6a046bfbc1ac5a, nullptr, nullptr, 0, 0, nullptr }
+  h_9c6a046bfbc1ac5a, 1, 3, i_9c6a046bfbc1ac5a, nullptr, nullptr, { &s_9c6a046bfbc1ac5a, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<64> b_d4c9b56290554016 = {
@@ -1200,10 +1211,11 @@ static const ::capnp::_::AlignedData<64> b_d4c9b56290554016 = {
 ::capnp::word const* const bp_d4c9b56290554016 = b_d4c9b56290554016.words;
 #if !CAPNP_LITE
 static const uint16_t m_d4c9b56290554016[] = {2, 1, 0};
+static const uint16_t h_d4c9b56290554016[] = {0, 1, 65535, 65535, 65535, 65535, 2, 65535};
 static const uint16_t i_d4c9b56290554016[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_d4c9b56290554016 = {
   0xd4c9b56290554016, b_d4c9b56290554016.words, 64, nullptr, m_d4c9b56290554016,
-  0, 3, i_d4c9b56290554016, nullptr, nullptr, { &s_d4c9b56290554016, nullptr, nullptr, 0, 0, nullptr }
+  h_d4c9b56290554016, 0, 3, i_d4c9b56290554016, nullptr, nullptr, { &s_d4c9b56290554016, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<63> b_fbe1980490e001af = {
@@ -1277,10 +1289,11 @@ static const ::capnp::_::RawSchema* const d_fbe1980490e001af[] = {
   &s_95bc14545813fbc1,
 };
 static const uint16_t m_fbe1980490e001af[] = {2, 0, 1};
+static const uint16_t h_fbe1980490e001af[] = {0, 1, 2, 65535, 65535, 65535, 65535, 65535};
 static const uint16_t i_fbe1980490e001af[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_fbe1980490e001af = {
   0xfbe1980490e001af, b_fbe1980490e001af.words, 63, d_fbe1980490e001af, m_fbe1980490e001af,
-  1, 3, i_fbe1980490e001af, nullptr, nullptr, { &s_fbe1980490e001af, nullptr, nullptr, 0, 0, nullptr }
+  h_fbe1980490e001af, 1, 3, i_fbe1980490e001af, nullptr, nullptr, { &s_fbe1980490e001af, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<50> b_95bc14545813fbc1 = {
@@ -1341,10 +1354,11 @@ static const ::capnp::_::RawSchema* const d_95bc14545813fbc1[] = {
   &s_d800b1d6cd6f1ca0,
 };
 static const uint16_t m_95bc14545813fbc1[] = {0, 1};
+static const uint16_t h_95bc14545813fbc1[] = {1, 65535, 65535, 0};
 static const uint16_t i_95bc14545813fbc1[] = {0, 1};
 const ::capnp::_::RawSchema s_95bc14545813fbc1 = {
   0x95bc14545813fbc1, b_95bc14545813fbc1.words, 50, d_95bc14545813fbc1, m_95bc14545813fbc1,
-  1, 2, i_95bc14545813fbc1, nullptr, nullptr, { &s_95bc14545813fbc1, nullptr, nullptr, 0, 0, nullptr }
+  h_95bc14545813fbc1, 1, 2, i_95bc14545813fbc1, nullptr, nullptr, { &s_95bc14545813fbc1, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<52> b_9a0e61223d96743b = {
@@ -1407,10 +1421,11 @@ static const ::capnp::_::RawSchema* const d_9a0e61223d96743b[] = {
   &s_8523ddc40b86b8b0,
 };
 static const uint16_t m_9a0e61223d96743b[] = {1, 0};
+static const uint16_t h_9a0e61223d96743b[] = {65535, 1, 0, 65535};
 static const uint16_t i_9a0e61223d96743b[] = {0, 1};
 const ::capnp::_::RawSchema s_9a0e61223d96743b = {
   0x9a0e61223d96743b, b_9a0e61223d96743b.words, 52, d_9a0e61223d96743b, m_9a0e61223d96743b,
-  1, 2, i_9a0e61223d96743b, nullptr, nullptr, { &s_9a0e61223d96743b, nullptr, nullptr, 0, 0, nullptr }
+  h_9a0e61223d96743b, 1, 2, i_9a0e61223d96743b, nullptr, nullptr, { &s_9a0e61223d96743b, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<114> b_8523ddc40b86b8b0 = {
@@ -1536,10 +1551,11 @@ static const ::capnp::_::RawSchema* const d_8523ddc40b86b8b0[] = {
   &s_d800b1d6cd6f1ca0,
 };
 static const uint16_t m_8523ddc40b86b8b0[] = {0, 4, 3, 1, 2, 5};
+static const uint16_t h_8523ddc40b86b8b0[] = {65535, 65535, 65535, 3, 65535, 5, 65535, 1, 65535, 65535, 4, 0, 65535, 2, 65535, 65535};
 static const uint16_t i_8523ddc40b86b8b0[] = {0, 1, 2, 3, 4, 5};
 const ::capnp::_::RawSchema s_8523ddc40b86b8b0 = {
   0x8523ddc40b86b8b0, b_8523ddc40b86b8b0.words, 114, d_8523ddc40b86b8b0, m_8523ddc40b86b8b0,
-  2, 6, i_8523ddc40b86b8b0, nullptr, nullptr, { &s_8523ddc40b86b8b0, nullptr, nullptr, 0, 0, nullptr }
+  h_8523ddc40b86b8b0, 2, 6, i_8523ddc40b86b8b0, nullptr, nullptr, { &s_8523ddc40b86b8b0, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<57> b_d800b1d6cd6f1ca0 = {
@@ -1607,10 +1623,11 @@ static const ::capnp::_::RawSchema* const d_d800b1d6cd6f1ca0[] = {
   &s_f316944415569081,
 };
 static const uint16_t m_d800b1d6cd6f1ca0[] = {0, 1};
+static const uint16_t h_d800b1d6cd6f1ca0[] = {0, 65535, 65535, 1};
 static const uint16_t i_d800b1d6cd6f1ca0[] = {0, 1};
 const ::capnp::_::RawSchema s_d800b1d6cd6f1ca0 = {
   0xd800b1d6cd6f1ca0, b_d800b1d6cd6f1ca0.words, 57, d_d800b1d6cd6f1ca0, m_d800b1d6cd6f1ca0,
-  1, 2, i_d800b1d6cd6f1ca0, nullptr, nullptr, { &s_d800b1d6cd6f1ca0, nullptr, nullptr, 0, 0, nullptr }
+  h_d800b1d6cd6f1ca0, 1, 2, i_d800b1d6cd6f1ca0, nullptr, nullptr, { &s_d800b1d6cd6f1ca0, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<50> b_f316944415569081 = {
@@ -1668,10 +1685,11 @@ static const ::capnp::_::AlignedData<50> b_f316944415569081 = {
 ::capnp::word const* const bp_f316944415569081 = b_f316944415569081.words;
 #if !CAPNP_LITE
 static const uint16_t m_f316944415569081[] = {1, 0};
+static const uint16_t h_f316944415569081[] = {1, 0, 65535, 65535};
 static const uint16_t i_f316944415569081[] = {0, 1};
 const ::capnp::_::RawSchema s_f316944415569081 = {
   0xf316944415569081, b_f316944415569081.words, 50, nullptr, m_f316944415569081,
-  0, 2, i_f316944415569081, nullptr, nullptr, { &s_f316944415569081, nullptr, nullptr, 0, 0, nullptr }
+  h_f316944415569081, 0, 2, i_f316944415569081, nullptr, nullptr, { &s_f316944415569081, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<49> b_d37007fde1f0027d = {
@@ -1728,10 +1746,11 @@ static const ::capnp::_::AlignedData<49> b_d37007fde1f0027d = {
 ::capnp::word const* const bp_d37007fde1f0027d = b_d37007fde1f0027d.words;
 #if !CAPNP_LITE
 static const uint16_t m_d37007fde1f0027d[] = {0, 1};
+static const uint16_t h_d37007fde1f0027d[] = {0, 1, 65535, 65535};
 static const uint16_t i_d37007fde1f0027d[] = {0, 1};
 const ::capnp::_::RawSchema s_d37007fde1f0027d = {
   0xd37007fde1f0027d, b_d37007fde1f0027d.words, 49, nullptr, m_d37007fde1f0027d,
-  0, 2, i_d37007fde1f0027d, nullptr, nullptr, { &s_d37007fde1f0027d, nullptr, nullptr, 0, 0, nullptr }
+  h_d37007fde1f0027d, 0, 2, i_d37007fde1f0027d, nullptr, nullptr, { &s_d37007fde1f0027d, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<85> b_d625b7063acf691a = {
@@ -1827,10 +1846,11 @@ static const ::capnp::_::RawSchema* const d_d625b7063acf691a[] = {
   &s_b28c96e23f4cbd58,
 };
 static const uint16_t m_d625b7063acf691a[] = {2, 1, 0, 3};
+static const uint16_t h_d625b7063acf691a[] = {65535, 0, 1, 65535, 65535, 2, 3, 65535};
 static const uint16_t i_d625b7063acf691a[] = {0, 1, 2, 3};
 const ::capnp::_::RawSchema s_d625b7063acf691a = {
   0xd625b7063acf691a, b_d625b7063acf691a.words, 85, d_d625b7063acf691a, m_d625b7063acf691a,
-  1, 4, i_d625b7063acf691a, nullptr, nullptr, { &s_d625b7063acf691a, nullptr, nullptr, 0, 0, nullptr }
+  h_d625b7063acf691a, 1, 4, i_d625b7063acf691a, nullptr, nullptr, { &s_d625b7063acf691a, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<37> b_b28c96e23f4cbd58 = {
@@ -1875,9 +1895,10 @@ static const ::capnp::_::AlignedData<37> b_b28c96e23f4cbd58 = {
 ::capnp::word const* const bp_b28c96e23f4cbd58 = b_b28c96e23f4cbd58.words;
 #if !CAPNP_LITE
 static const uint16_t m_b28c96e23f4cbd58[] = {2, 0, 1, 3};
+static const uint16_t h_b28c96e23f4cbd58[] = {65535, 65535, 2, 3, 0, 65535, 1, 65535};
 const ::capnp::_::RawSchema s_b28c96e23f4cbd58 = {
   0xb28c96e23f4cbd58, b_b28c96e23f4cbd58.words, 37, nullptr, m_b28c96e23f4cbd58,
-  0, 4, nullptr, nullptr, nullptr, { &s_b28c96e23f4cbd58, nullptr, nullptr, 0, 0, nullptr }
+  h_b28c96e23f4cbd58, 0, 4, nullptr, nullptr, nullptr, { &s_b28c96e23f4cbd58, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 CAPNP_DEFINE_ENUM(Type_b28c96e23f4cbd58, b28c96e23f4cbd58);
@@ -142,6 +142,11 @@ public:
   // order to prevent a grain from inundating the system with in-flight calls. In practice, the
   // main time this happens is when a grain is pushing a large file download and doesn't implement
   // proper cooperative flow control.
+
+  void setStats(RpcStats& stats);
+  // Starts collecting call counts, latencies, and traffic counters into `stats`, which must
+  // outlive this RpcSystem. Connections that are already open are included from now on. See
+  // rpc-stats.h.
 };
 
 template <typename VatId, typename ProvisionId, typename RecipientId,
@@ -277,6 +282,10 @@ public:
   virtual void send() = 0;
   // Send the message, or at least put it in a queue to be sent later.  Note that the builder
   // returned by `getBody()` remains valid at least until the `OutgoingRpcMessage` is destroyed.
+
+  virtual size_t sizeInWords() { return 0; }
+  // Get the total size of the message, in words, as it will be transmitted, for statistics.
+  // Called just before `send()`.  The default reports nothing.
 };
 
 class IncomingRpcMessage {
@@ -286,6 +295,17 @@ public:
   virtual AnyPointer::Reader getBody() = 0;
   // Get the message body, to be interpreted by the caller.  (The standard RPC implementation
   // interprets it as a Message as defined in rpc.capnp.)
+
+  virtual size_t sizeInWords() { return 0; }
+  // Get the total size of the message, in words, as it was received, for statistics.  The default
+  // reports nothing.
+
+  virtual void prepareToRetain() {}
+  // Called before the RPC system holds on to the message past handling it: a call's params are
+  // kept until the call returns, and results until the caller drops them.  A VatNetwork which
+  // reads messages in place from a buffer shared with other messages should copy the message out
+  // here, so that it doesn't pin memory which the flow limit (see `RpcSystem::setFlowLimit()`)
+  // doesn't account for.  Readers previously obtained from `getBody()` may be invalidated.
 };
 
 template <typename VatId, typename ProvisionId, typename RecipientId,
@@ -473,6 +493,11 @@ inline void RpcSystem<VatId>::setFlowLimit(size_t words) {
   baseSetFlowLimit(words);
 }
 
+template <typename VatId>
+inline void RpcSystem<VatId>::setStats(RpcStats& stats) {
+  baseSetStats(stats);
+}
+
 template <typename VatId, typename ProvisionId, typename RecipientId,
           typename ThirdPartyCapId, typename JoinResult>
 RpcSystem<VatId> makeRpcServer(
@@ -54,6 +54,29 @@ TEST(SchemaLoader, Load) {
   EXPECT_EQ(0u, struct16Schema.getProto().getStruct().getFields().size());
 }
 
+TEST(SchemaLoader, NameLookup) {
+  SchemaLoader loader;
+
+  StructSchema structSchema =
+      loader.load(Schema::from<TestAllTypes>().getProto()).asStruct();
+  for (auto field: structSchema.getFields()) {
+    EXPECT_EQ(field.getIndex(), structSchema.getFieldByName(field.getProto().getName()).getIndex());
+  }
+  EXPECT_TRUE(structSchema.findFieldByName("noSuchField") == nullptr);
+
+  EnumSchema enumSchema = loader.load(Schema::from<TestEnum>().getProto()).asEnum();
+  for (auto enumerant: enumSchema.getEnumerants()) {
+    EXPECT_EQ(enumerant.getIndex(),
+              enumSchema.getEnumerantByName(enumerant.getProto().getName()).getIndex());
+  }
+  EXPECT_TRUE(enumSchema.findEnumerantByName("noSuchEnumerant") == nullptr);
+
+  // A struct with no members has no hash table at all.
+  StructSchema emptySchema =
+      loader.load(Schema::from<test::TestEmptyStruct>().getProto()).asStruct();
+  EXPECT_TRUE(emptySchema.findFieldByName("foo") == nullptr);
+}
+
 TEST(SchemaLoader, LoadLateUnion) {
   SchemaLoader loader;
 
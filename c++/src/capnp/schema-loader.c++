@@ -298,6 +298,22 @@ public:
     return result.begin();
   }
 
+  const uint16_t* makeMemberHashTable() {
+    if (members.empty()) return nullptr;
+
+    kj::ArrayPtr<uint16_t> result =
+        loader.arena.allocateArray<uint16_t>(_::memberNameHashTableSize(members.size()));
+    for (auto& slot: result) slot = _::EMPTY_MEMBER_SLOT;
+
+    uint mask = result.size() - 1;
+    for (auto& member: members) {
+      uint slot = _::hashMemberName(member.first) & mask;
+      while (result[slot] != _::EMPTY_MEMBER_SLOT) slot = (slot + 1) & mask;
+      result[slot] = member.second;
+    }
+    return result.begin();
+  }
+
   const uint16_t* makeMembersByDiscriminantArray() {
     return membersByDiscriminant.begin();
   }
@@ -1295,6 +1311,7 @@ _::RawSchema* SchemaLoader::Impl::load(const schema::Node::Reader& reader, bool
     slot->encodedSize = validated.size();
     slot->dependencies = validator.makeDependencyArray(&slot->dependencyCount);
     slot->membersByName = validator.makeMemberInfoArray(&slot->memberCount);
+    slot->membersByNameHash = validator.makeMemberHashTable();
     slot->membersByDiscriminant = validator.makeMembersByDiscriminantArray();
 
     // Even though this schema isn't itself branded, it may have dependencies that are. So, we
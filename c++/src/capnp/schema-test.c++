@@ -101,6 +101,28 @@ TEST(Schema, FieldLookupOutOfOrder) {
   EXPECT_EQ(5, schema.getFieldByName("waldo").getProto().getOrdinal().getExplicit());
 }
 
+TEST(Schema, NameLookupFindsEveryMember) {
+  auto structSchema = Schema::from<TestAllTypes>();
+  for (auto field: structSchema.getFields()) {
+    EXPECT_EQ(field.getIndex(), structSchema.getFieldByName(field.getProto().getName()).getIndex());
+    EXPECT_TRUE(structSchema.findFieldByName(kj::str(field.getProto().getName(), "x")) == nullptr);
+  }
+
+  auto enumSchema = Schema::from<TestEnum>();
+  for (auto enumerant: enumSchema.getEnumerants()) {
+    EXPECT_EQ(enumerant.getIndex(),
+              enumSchema.getEnumerantByName(enumerant.getProto().getName()).getIndex());
+  }
+  EXPECT_TRUE(enumSchema.findEnumerantByName("") == nullptr);
+
+  auto interfaceSchema = Schema::from<test::TestMoreStuff>();
+  for (auto method: interfaceSchema.getMethods()) {
+    EXPECT_EQ(method.getIndex(),
+              interfaceSchema.getMethodByName(method.getProto().getName()).getIndex());
+  }
+  EXPECT_TRUE(interfaceSchema.findMethodByName("Hold") == nullptr);
+}
+
 TEST(Schema, Unions) {
   auto schema = Schema::from<TestUnion>().asStruct();
 
@@ -83,7 +83,7 @@ static const AlignedData<13> NULL_SCHEMA_BYTES = {{
 }};
 const RawSchema NULL_SCHEMA = {
   0x0000000000000000, NULL_SCHEMA_BYTES.words, 13,
-  nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
+  nullptr, nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
   { &NULL_SCHEMA, nullptr, nullptr, 0, 0, nullptr }
 };
 
@@ -105,7 +105,7 @@ static const AlignedData<14> NULL_STRUCT_SCHEMA_BYTES = {{
 }};
 const RawSchema NULL_STRUCT_SCHEMA = {
   0x0000000000000001, NULL_STRUCT_SCHEMA_BYTES.words, 14,
-  nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
+  nullptr, nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
   { &NULL_STRUCT_SCHEMA, nullptr, nullptr, 0, 0, nullptr }
 };
 
@@ -127,7 +127,7 @@ static const AlignedData<14> NULL_ENUM_SCHEMA_BYTES = {{
 }};
 const RawSchema NULL_ENUM_SCHEMA = {
   0x0000000000000002, NULL_ENUM_SCHEMA_BYTES.words, 14,
-  nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
+  nullptr, nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
   { &NULL_ENUM_SCHEMA, nullptr, nullptr, 0, 0, nullptr }
 };
 
@@ -149,7 +149,7 @@ static const AlignedData<14> NULL_INTERFACE_SCHEMA_BYTES = {{
 }};
 const RawSchema NULL_INTERFACE_SCHEMA = {
   0x0000000000000003, NULL_INTERFACE_SCHEMA_BYTES.words, 14,
-  nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
+  nullptr, nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
   { &NULL_INTERFACE_SCHEMA, nullptr, nullptr, 0, 0, nullptr }
 };
 
@@ -177,7 +177,7 @@ static const AlignedData<20> NULL_CONST_SCHEMA_BYTES = {{
 }};
 const RawSchema NULL_CONST_SCHEMA = {
   0x0000000000000004, NULL_CONST_SCHEMA_BYTES.words, 20,
-  nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
+  nullptr, nullptr, nullptr, 0, 0, nullptr, nullptr, nullptr,
   { &NULL_CONST_SCHEMA, nullptr, nullptr, 0, 0, nullptr }
 };
 
@@ -433,6 +433,20 @@ namespace {
 template <typename List>
 auto findSchemaMemberByName(const _::RawSchema* raw, kj::StringPtr name, List&& list)
     -> kj::Maybe<decltype(list[0])> {
+  if (raw->membersByNameHash != nullptr) {
+    uint mask = _::memberNameHashTableSize(raw->memberCount) - 1;
+    for (uint slot = _::hashMemberName(name) & mask;; slot = (slot + 1) & mask) {
+      uint16_t memberIndex = raw->membersByNameHash[slot];
+      if (memberIndex == _::EMPTY_MEMBER_SLOT) {
+        return nullptr;
+      }
+      auto candidate = list[memberIndex];
+      if (candidate.getProto().getName() == name) {
+        return candidate;
+      }
+    }
+  }
+
   uint lower = 0;
   uint upper = raw->memberCount;
 
@@ -241,10 +241,11 @@ static const ::capnp::_::RawSchema* const d_e682ab4cf923a417[] = {
   &s_f1c8950dab257542,
 };
 static const uint16_t m_e682ab4cf923a417[] = {11, 5, 10, 1, 2, 8, 6, 0, 9, 13, 4, 12, 3, 7};
+static const uint16_t h_e682ab4cf923a417[] = {0, 5, 7, 6, 8, 65535, 3, 65535, 11, 65535, 13, 65535, 65535, 65535, 2, 4, 9, 65535, 65535, 65535, 10, 65535, 1, 65535, 65535, 12, 65535, 65535, 65535, 65535, 65535, 65535};
 static const uint16_t i_e682ab4cf923a417[] = {6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 12, 13};
 const ::capnp::_::RawSchema s_e682ab4cf923a417 = {
   0xe682ab4cf923a417, b_e682ab4cf923a417.words, 221, d_e682ab4cf923a417, m_e682ab4cf923a417,
-  8, 14, i_e682ab4cf923a417, nullptr, nullptr, { &s_e682ab4cf923a417, nullptr, nullptr, 0, 0, nullptr }
+  h_e682ab4cf923a417, 8, 14, i_e682ab4cf923a417, nullptr, nullptr, { &s_e682ab4cf923a417, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<34> b_b9521bccf10fa3b1 = {
@@ -286,10 +287,11 @@ static const ::capnp::_::AlignedData<34> b_b9521bccf10fa3b1 = {
 ::capnp::word const* const bp_b9521bccf10fa3b1 = b_b9521bccf10fa3b1.words;
 #if !CAPNP_LITE
 static const uint16_t m_b9521bccf10fa3b1[] = {0};
+static const uint16_t h_b9521bccf10fa3b1[] = {0, 65535};
 static const uint16_t i_b9521bccf10fa3b1[] = {0};
 const ::capnp::_::RawSchema s_b9521bccf10fa3b1 = {
   0xb9521bccf10fa3b1, b_b9521bccf10fa3b1.words, 34, nullptr, m_b9521bccf10fa3b1,
-  0, 1, i_b9521bccf10fa3b1, nullptr, nullptr, { &s_b9521bccf10fa3b1, nullptr, nullptr, 0, 0, nullptr }
+  h_b9521bccf10fa3b1, 0, 1, i_b9521bccf10fa3b1, nullptr, nullptr, { &s_b9521bccf10fa3b1, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<49> b_debf55bbfa0fc242 = {
@@ -346,10 +348,11 @@ static const ::capnp::_::AlignedData<49> b_debf55bbfa0fc242 = {
 ::capnp::word const* const bp_debf55bbfa0fc242 = b_debf55bbfa0fc242.words;
 #if !CAPNP_LITE
 static const uint16_t m_debf55bbfa0fc242[] = {1, 0};
+static const uint16_t h_debf55bbfa0fc242[] = {1, 65535, 0, 65535};
 static const uint16_t i_debf55bbfa0fc242[] = {0, 1};
 const ::capnp::_::RawSchema s_debf55bbfa0fc242 = {
   0xdebf55bbfa0fc242, b_debf55bbfa0fc242.words, 49, nullptr, m_debf55bbfa0fc242,
-  0, 2, i_debf55bbfa0fc242, nullptr, nullptr, { &s_debf55bbfa0fc242, nullptr, nullptr, 0, 0, nullptr }
+  h_debf55bbfa0fc242, 0, 2, i_debf55bbfa0fc242, nullptr, nullptr, { &s_debf55bbfa0fc242, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<134> b_9ea0b19b37fb4435 = {
@@ -496,10 +499,11 @@ static const ::capnp::_::RawSchema* const d_9ea0b19b37fb4435[] = {
   &s_e682ab4cf923a417,
 };
 static const uint16_t m_9ea0b19b37fb4435[] = {0, 4, 5, 6, 3, 1, 2};
+static const uint16_t h_9ea0b19b37fb4435[] = {6, 1, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 2, 0, 3, 4, 5};
 static const uint16_t i_9ea0b19b37fb4435[] = {0, 1, 2, 3, 4, 5, 6};
 const ::capnp::_::RawSchema s_9ea0b19b37fb4435 = {
   0x9ea0b19b37fb4435, b_9ea0b19b37fb4435.words, 134, d_9ea0b19b37fb4435, m_9ea0b19b37fb4435,
-  3, 7, i_9ea0b19b37fb4435, nullptr, nullptr, { &s_9ea0b19b37fb4435, nullptr, nullptr, 0, 0, nullptr }
+  h_9ea0b19b37fb4435, 3, 7, i_9ea0b19b37fb4435, nullptr, nullptr, { &s_9ea0b19b37fb4435, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<37> b_b54ab3364333f598 = {
@@ -548,10 +552,11 @@ static const ::capnp::_::RawSchema* const d_b54ab3364333f598[] = {
   &s_e682ab4cf923a417,
 };
 static const uint16_t m_b54ab3364333f598[] = {0};
+static const uint16_t h_b54ab3364333f598[] = {65535, 0};
 static const uint16_t i_b54ab3364333f598[] = {0};
 const ::capnp::_::RawSchema s_b54ab3364333f598 = {
   0xb54ab3364333f598, b_b54ab3364333f598.words, 37, d_b54ab3364333f598, m_b54ab3364333f598,
-  2, 1, i_b54ab3364333f598, nullptr, nullptr, { &s_b54ab3364333f598, nullptr, nullptr, 0, 0, nullptr }
+  h_b54ab3364333f598, 2, 1, i_b54ab3364333f598, nullptr, nullptr, { &s_b54ab3364333f598, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<57> b_e82753cff0c2218f = {
@@ -621,10 +626,11 @@ static const ::capnp::_::RawSchema* const d_e82753cff0c2218f[] = {
   &s_e682ab4cf923a417,
 };
 static const uint16_t m_e82753cff0c2218f[] = {0, 1};
+static const uint16_t h_e82753cff0c2218f[] = {1, 0, 65535, 65535};
 static const uint16_t i_e82753cff0c2218f[] = {0, 1};
 const ::capnp::_::RawSchema s_e82753cff0c2218f = {
   0xe82753cff0c2218f, b_e82753cff0c2218f.words, 57, d_e82753cff0c2218f, m_e82753cff0c2218f,
-  3, 2, i_e82753cff0c2218f, nullptr, nullptr, { &s_e82753cff0c2218f, nullptr, nullptr, 0, 0, nullptr }
+  h_e82753cff0c2218f, 3, 2, i_e82753cff0c2218f, nullptr, nullptr, { &s_e82753cff0c2218f, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<47> b_b18aa5ac7a0d9420 = {
@@ -684,10 +690,11 @@ static const ::capnp::_::RawSchema* const d_b18aa5ac7a0d9420[] = {
   &s_e682ab4cf923a417,
 };
 static const uint16_t m_b18aa5ac7a0d9420[] = {0, 1};
+static const uint16_t h_b18aa5ac7a0d9420[] = {65535, 0, 1, 65535};
 static const uint16_t i_b18aa5ac7a0d9420[] = {0, 1};
 const ::capnp::_::RawSchema s_b18aa5ac7a0d9420 = {
   0xb18aa5ac7a0d9420, b_b18aa5ac7a0d9420.words, 47, d_b18aa5ac7a0d9420, m_b18aa5ac7a0d9420,
-  3, 2, i_b18aa5ac7a0d9420, nullptr, nullptr, { &s_b18aa5ac7a0d9420, nullptr, nullptr, 0, 0, nullptr }
+  h_b18aa5ac7a0d9420, 3, 2, i_b18aa5ac7a0d9420, nullptr, nullptr, { &s_b18aa5ac7a0d9420, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<228> b_ec1619d4400a0290 = {
@@ -927,10 +934,11 @@ static const ::capnp::_::RawSchema* const d_ec1619d4400a0290[] = {
   &s_e682ab4cf923a417,
 };
 static const uint16_t m_ec1619d4400a0290[] = {12, 2, 3, 4, 6, 1, 8, 9, 10, 11, 5, 7, 0};
+static const uint16_t h_ec1619d4400a0290[] = {65535, 65535, 65535, 65535, 5, 10, 65535, 1, 65535, 65535, 65535, 6, 3, 0, 9, 65535, 2, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 7, 8, 65535, 65535, 4, 12, 11, 65535};
 static const uint16_t i_ec1619d4400a0290[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
 const ::capnp::_::RawSchema s_ec1619d4400a0290 = {
   0xec1619d4400a0290, b_ec1619d4400a0290.words, 228, d_ec1619d4400a0290, m_ec1619d4400a0290,
-  2, 13, i_ec1619d4400a0290, nullptr, nullptr, { &s_ec1619d4400a0290, nullptr, nullptr, 0, 0, nullptr }
+  h_ec1619d4400a0290, 2, 13, i_ec1619d4400a0290, nullptr, nullptr, { &s_ec1619d4400a0290, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<114> b_9aad50a41f4af45f = {
@@ -1058,10 +1066,11 @@ static const ::capnp::_::RawSchema* const d_9aad50a41f4af45f[] = {
   &s_f1c8950dab257542,
 };
 static const uint16_t m_9aad50a41f4af45f[] = {2, 1, 3, 5, 0, 6, 4};
+static const uint16_t h_9aad50a41f4af45f[] = {65535, 2, 4, 6, 65535, 65535, 0, 65535, 65535, 65535, 65535, 65535, 1, 3, 5, 65535};
 static const uint16_t i_9aad50a41f4af45f[] = {4, 5, 0, 1, 2, 3, 6};
 const ::capnp::_::RawSchema s_9aad50a41f4af45f = {
   0x9aad50a41f4af45f, b_9aad50a41f4af45f.words, 114, d_9aad50a41f4af45f, m_9aad50a41f4af45f,
-  4, 7, i_9aad50a41f4af45f, nullptr, nullptr, { &s_9aad50a41f4af45f, nullptr, nullptr, 0, 0, nullptr }
+  h_9aad50a41f4af45f, 4, 7, i_9aad50a41f4af45f, nullptr, nullptr, { &s_9aad50a41f4af45f, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<25> b_97b14cbe7cfec712 = {
@@ -1095,7 +1104,7 @@ static const ::capnp::_::AlignedData<25> b_97b14cbe7cfec712 = {
 #if !CAPNP_LITE
 const ::capnp::_::RawSchema s_97b14cbe7cfec712 = {
   0x97b14cbe7cfec712, b_97b14cbe7cfec712.words, 25, nullptr, nullptr,
-  0, 0, nullptr, nullptr, nullptr, { &s_97b14cbe7cfec712, nullptr, nullptr, 0, 0, nullptr }
+  nullptr, 0, 0, nullptr, nullptr, nullptr, { &s_97b14cbe7cfec712, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<80> b_c42305476bb4746f = {
@@ -1188,10 +1197,11 @@ static const ::capnp::_::RawSchema* const d_c42305476bb4746f[] = {
   &s_d07378ede1f9cc60,
 };
 static const uint16_t m_c42305476bb4746f[] = {2, 3, 0, 1};
+static const uint16_t h_c42305476bb4746f[] = {3, 65535, 0, 65535, 65535, 1, 65535, 2};
 static const uint16_t i_c42305476bb4746f[] = {0, 1, 2, 3};
 const ::capnp::_::RawSchema s_c42305476bb4746f = {
   0xc42305476bb4746f, b_c42305476bb4746f.words, 80, d_c42305476bb4746f, m_c42305476bb4746f,
-  3, 4, i_c42305476bb4746f, nullptr, nullptr, { &s_c42305476bb4746f, nullptr, nullptr, 0, 0, nullptr }
+  h_c42305476bb4746f, 3, 4, i_c42305476bb4746f, nullptr, nullptr, { &s_c42305476bb4746f, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<32> b_cafccddb68db1d11 = {
@@ -1234,10 +1244,11 @@ static const ::capnp::_::RawSchema* const d_cafccddb68db1d11[] = {
   &s_9aad50a41f4af45f,
 };
 static const uint16_t m_cafccddb68db1d11[] = {0};
+static const uint16_t h_cafccddb68db1d11[] = {0, 65535};
 static const uint16_t i_cafccddb68db1d11[] = {0};
 const ::capnp::_::RawSchema s_cafccddb68db1d11 = {
   0xcafccddb68db1d11, b_cafccddb68db1d11.words, 32, d_cafccddb68db1d11, m_cafccddb68db1d11,
-  1, 1, i_cafccddb68db1d11, nullptr, nullptr, { &s_cafccddb68db1d11, nullptr, nullptr, 0, 0, nullptr }
+  h_cafccddb68db1d11, 1, 1, i_cafccddb68db1d11, nullptr, nullptr, { &s_cafccddb68db1d11, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<50> b_bb90d5c287870be6 = {
@@ -1298,10 +1309,11 @@ static const ::capnp::_::RawSchema* const d_bb90d5c287870be6[] = {
   &s_9aad50a41f4af45f,
 };
 static const uint16_t m_bb90d5c287870be6[] = {1, 0};
+static const uint16_t h_bb90d5c287870be6[] = {65535, 1, 0, 65535};
 static const uint16_t i_bb90d5c287870be6[] = {0, 1};
 const ::capnp::_::RawSchema s_bb90d5c287870be6 = {
   0xbb90d5c287870be6, b_bb90d5c287870be6.words, 50, d_bb90d5c287870be6, m_bb90d5c287870be6,
-  1, 2, i_bb90d5c287870be6, nullptr, nullptr, { &s_bb90d5c287870be6, nullptr, nullptr, 0, 0, nullptr }
+  h_bb90d5c287870be6, 1, 2, i_bb90d5c287870be6, nullptr, nullptr, { &s_bb90d5c287870be6, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<69> b_978a7cebdc549a4d = {
@@ -1381,10 +1393,11 @@ static const ::capnp::_::RawSchema* const d_978a7cebdc549a4d[] = {
   &s_f1c8950dab257542,
 };
 static const uint16_t m_978a7cebdc549a4d[] = {2, 1, 0};
+static const uint16_t h_978a7cebdc549a4d[] = {65535, 2, 65535, 65535, 1, 65535, 0, 65535};
 static const uint16_t i_978a7cebdc549a4d[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_978a7cebdc549a4d = {
   0x978a7cebdc549a4d, b_978a7cebdc549a4d.words, 69, d_978a7cebdc549a4d, m_978a7cebdc549a4d,
-  1, 3, i_978a7cebdc549a4d, nullptr, nullptr, { &s_978a7cebdc549a4d, nullptr, nullptr, 0, 0, nullptr }
+  h_978a7cebdc549a4d, 1, 3, i_978a7cebdc549a4d, nullptr, nullptr, { &s_978a7cebdc549a4d, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<48> b_a9962a9ed0a4d7f8 = {
@@ -1443,10 +1456,11 @@ static const ::capnp::_::RawSchema* const d_a9962a9ed0a4d7f8[] = {
   &s_903455f06065422b,
 };
 static const uint16_t m_a9962a9ed0a4d7f8[] = {1, 0};
+static const uint16_t h_a9962a9ed0a4d7f8[] = {0, 65535, 1, 65535};
 static const uint16_t i_a9962a9ed0a4d7f8[] = {0, 1};
 const ::capnp::_::RawSchema s_a9962a9ed0a4d7f8 = {
   0xa9962a9ed0a4d7f8, b_a9962a9ed0a4d7f8.words, 48, d_a9962a9ed0a4d7f8, m_a9962a9ed0a4d7f8,
-  1, 2, i_a9962a9ed0a4d7f8, nullptr, nullptr, { &s_a9962a9ed0a4d7f8, nullptr, nullptr, 0, 0, nullptr }
+  h_a9962a9ed0a4d7f8, 1, 2, i_a9962a9ed0a4d7f8, nullptr, nullptr, { &s_a9962a9ed0a4d7f8, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<155> b_9500cce23b334d80 = {
@@ -1614,10 +1628,11 @@ static const ::capnp::_::RawSchema* const d_9500cce23b334d80[] = {
   &s_f1c8950dab257542,
 };
 static const uint16_t m_9500cce23b334d80[] = {4, 1, 7, 0, 5, 2, 6, 3};
+static const uint16_t h_9500cce23b334d80[] = {5, 4, 65535, 65535, 65535, 65535, 0, 7, 65535, 6, 65535, 65535, 1, 3, 65535, 2};
 static const uint16_t i_9500cce23b334d80[] = {0, 1, 2, 3, 4, 5, 6, 7};
 const ::capnp::_::RawSchema s_9500cce23b334d80 = {
   0x9500cce23b334d80, b_9500cce23b334d80.words, 155, d_9500cce23b334d80, m_9500cce23b334d80,
-  3, 8, i_9500cce23b334d80, nullptr, nullptr, { &s_9500cce23b334d80, nullptr, nullptr, 0, 0, nullptr }
+  h_9500cce23b334d80, 3, 8, i_9500cce23b334d80, nullptr, nullptr, { &s_9500cce23b334d80, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<269> b_d07378ede1f9cc60 = {
@@ -1901,10 +1916,11 @@ static const ::capnp::_::RawSchema* const d_d07378ede1f9cc60[] = {
   &s_ed8bca69f7fb0cbf,
 };
 static const uint16_t m_d07378ede1f9cc60[] = {18, 1, 13, 15, 10, 11, 3, 4, 5, 2, 17, 14, 16, 12, 7, 8, 9, 6, 0};
+static const uint16_t h_d07378ede1f9cc60[] = {15, 14, 65535, 65535, 65535, 65535, 65535, 11, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 10, 3, 2, 9, 18, 65535, 65535, 65535, 65535, 65535, 65535, 6, 65535, 65535, 65535, 0, 16, 65535, 65535, 65535, 5, 13, 65535, 65535, 65535, 65535, 65535, 65535, 8, 65535, 65535, 65535, 17, 65535, 7, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 1, 12, 4};
 static const uint16_t i_d07378ede1f9cc60[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18};
 const ::capnp::_::RawSchema s_d07378ede1f9cc60 = {
   0xd07378ede1f9cc60, b_d07378ede1f9cc60.words, 269, d_d07378ede1f9cc60, m_d07378ede1f9cc60,
-  5, 19, i_d07378ede1f9cc60, nullptr, nullptr, { &s_d07378ede1f9cc60, nullptr, nullptr, 0, 0, nullptr }
+  h_d07378ede1f9cc60, 5, 19, i_d07378ede1f9cc60, nullptr, nullptr, { &s_d07378ede1f9cc60, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<33> b_87e739250a60ea97 = {
@@ -1948,10 +1964,11 @@ static const ::capnp::_::RawSchema* const d_87e739250a60ea97[] = {
   &s_d07378ede1f9cc60,
 };
 static const uint16_t m_87e739250a60ea97[] = {0};
+static const uint16_t h_87e739250a60ea97[] = {65535, 0};
 static const uint16_t i_87e739250a60ea97[] = {0};
 const ::capnp::_::RawSchema s_87e739250a60ea97 = {
   0x87e739250a60ea97, b_87e739250a60ea97.words, 33, d_87e739250a60ea97, m_87e739250a60ea97,
-  1, 1, i_87e739250a60ea97, nullptr, nullptr, { &s_87e739250a60ea97, nullptr, nullptr, 0, 0, nullptr }
+  h_87e739250a60ea97, 1, 1, i_87e739250a60ea97, nullptr, nullptr, { &s_87e739250a60ea97, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<47> b_9e0e78711a7f87a9 = {
@@ -2010,10 +2027,11 @@ static const ::capnp::_::RawSchema* const d_9e0e78711a7f87a9[] = {
   &s_d07378ede1f9cc60,
 };
 static const uint16_t m_9e0e78711a7f87a9[] = {1, 0};
+static const uint16_t h_9e0e78711a7f87a9[] = {0, 65535, 1, 65535};
 static const uint16_t i_9e0e78711a7f87a9[] = {0, 1};
 const ::capnp::_::RawSchema s_9e0e78711a7f87a9 = {
   0x9e0e78711a7f87a9, b_9e0e78711a7f87a9.words, 47, d_9e0e78711a7f87a9, m_9e0e78711a7f87a9,
-  2, 2, i_9e0e78711a7f87a9, nullptr, nullptr, { &s_9e0e78711a7f87a9, nullptr, nullptr, 0, 0, nullptr }
+  h_9e0e78711a7f87a9, 2, 2, i_9e0e78711a7f87a9, nullptr, nullptr, { &s_9e0e78711a7f87a9, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<47> b_ac3a6f60ef4cc6d3 = {
@@ -2072,10 +2090,11 @@ static const ::capnp::_::RawSchema* const d_ac3a6f60ef4cc6d3[] = {
   &s_d07378ede1f9cc60,
 };
 static const uint16_t m_ac3a6f60ef4cc6d3[] = {1, 0};
+static const uint16_t h_ac3a6f60ef4cc6d3[] = {0, 65535, 1, 65535};
 static const uint16_t i_ac3a6f60ef4cc6d3[] = {0, 1};
 const ::capnp::_::RawSchema s_ac3a6f60ef4cc6d3 = {
   0xac3a6f60ef4cc6d3, b_ac3a6f60ef4cc6d3.words, 47, d_ac3a6f60ef4cc6d3, m_ac3a6f60ef4cc6d3,
-  2, 2, i_ac3a6f60ef4cc6d3, nullptr, nullptr, { &s_ac3a6f60ef4cc6d3, nullptr, nullptr, 0, 0, nullptr }
+  h_ac3a6f60ef4cc6d3, 2, 2, i_ac3a6f60ef4cc6d3, nullptr, nullptr, { &s_ac3a6f60ef4cc6d3, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<48> b_ed8bca69f7fb0cbf = {
@@ -2135,10 +2154,11 @@ static const ::capnp::_::RawSchema* const d_ed8bca69f7fb0cbf[] = {
   &s_d07378ede1f9cc60,
 };
 static const uint16_t m_ed8bca69f7fb0cbf[] = {1, 0};
+static const uint16_t h_ed8bca69f7fb0cbf[] = {0, 65535, 1, 65535};
 static const uint16_t i_ed8bca69f7fb0cbf[] = {0, 1};
 const ::capnp::_::RawSchema s_ed8bca69f7fb0cbf = {
   0xed8bca69f7fb0cbf, b_ed8bca69f7fb0cbf.words, 48, d_ed8bca69f7fb0cbf, m_ed8bca69f7fb0cbf,
-  2, 2, i_ed8bca69f7fb0cbf, nullptr, nullptr, { &s_ed8bca69f7fb0cbf, nullptr, nullptr, 0, 0, nullptr }
+  h_ed8bca69f7fb0cbf, 2, 2, i_ed8bca69f7fb0cbf, nullptr, nullptr, { &s_ed8bca69f7fb0cbf, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<46> b_c2573fe8a23e49f1 = {
@@ -2198,10 +2218,11 @@ static const ::capnp::_::RawSchema* const d_c2573fe8a23e49f1[] = {
   &s_d07378ede1f9cc60,
 };
 static const uint16_t m_c2573fe8a23e49f1[] = {2, 1, 0};
+static const uint16_t h_c2573fe8a23e49f1[] = {1, 65535, 2, 65535, 65535, 65535, 0, 65535};
 static const uint16_t i_c2573fe8a23e49f1[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_c2573fe8a23e49f1 = {
   0xc2573fe8a23e49f1, b_c2573fe8a23e49f1.words, 46, d_c2573fe8a23e49f1, m_c2573fe8a23e49f1,
-  4, 3, i_c2573fe8a23e49f1, nullptr, nullptr, { &s_c2573fe8a23e49f1, nullptr, nullptr, 0, 0, nullptr }
+  h_c2573fe8a23e49f1, 4, 3, i_c2573fe8a23e49f1, nullptr, nullptr, { &s_c2573fe8a23e49f1, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<81> b_8e3b5f79fe593656 = {
@@ -2293,10 +2314,11 @@ static const ::capnp::_::RawSchema* const d_8e3b5f79fe593656[] = {
   &s_c2573fe8a23e49f1,
 };
 static const uint16_t m_8e3b5f79fe593656[] = {0, 3, 2, 1};
+static const uint16_t h_8e3b5f79fe593656[] = {1, 2, 65535, 0, 65535, 65535, 65535, 3};
 static const uint16_t i_8e3b5f79fe593656[] = {0, 1, 2, 3};
 const ::capnp::_::RawSchema s_8e3b5f79fe593656 = {
   0x8e3b5f79fe593656, b_8e3b5f79fe593656.words, 81, d_8e3b5f79fe593656, m_8e3b5f79fe593656,
-  1, 4, i_8e3b5f79fe593656, nullptr, nullptr, { &s_8e3b5f79fe593656, nullptr, nullptr, 0, 0, nullptr }
+  h_8e3b5f79fe593656, 1, 4, i_8e3b5f79fe593656, nullptr, nullptr, { &s_8e3b5f79fe593656, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<50> b_9dd1f724f4614a85 = {
@@ -2357,10 +2379,11 @@ static const ::capnp::_::RawSchema* const d_9dd1f724f4614a85[] = {
   &s_c2573fe8a23e49f1,
 };
 static const uint16_t m_9dd1f724f4614a85[] = {1, 0};
+static const uint16_t h_9dd1f724f4614a85[] = {1, 65535, 0, 65535};
 static const uint16_t i_9dd1f724f4614a85[] = {0, 1};
 const ::capnp::_::RawSchema s_9dd1f724f4614a85 = {
   0x9dd1f724f4614a85, b_9dd1f724f4614a85.words, 50, d_9dd1f724f4614a85, m_9dd1f724f4614a85,
-  1, 2, i_9dd1f724f4614a85, nullptr, nullptr, { &s_9dd1f724f4614a85, nullptr, nullptr, 0, 0, nullptr }
+  h_9dd1f724f4614a85, 1, 2, i_9dd1f724f4614a85, nullptr, nullptr, { &s_9dd1f724f4614a85, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<37> b_baefc9120c56e274 = {
@@ -2408,10 +2431,11 @@ static const ::capnp::_::RawSchema* const d_baefc9120c56e274[] = {
   &s_c2573fe8a23e49f1,
 };
 static const uint16_t m_baefc9120c56e274[] = {0};
+static const uint16_t h_baefc9120c56e274[] = {0, 65535};
 static const uint16_t i_baefc9120c56e274[] = {0};
 const ::capnp::_::RawSchema s_baefc9120c56e274 = {
   0xbaefc9120c56e274, b_baefc9120c56e274.words, 37, d_baefc9120c56e274, m_baefc9120c56e274,
-  1, 1, i_baefc9120c56e274, nullptr, nullptr, { &s_baefc9120c56e274, nullptr, nullptr, 0, 0, nullptr }
+  h_baefc9120c56e274, 1, 1, i_baefc9120c56e274, nullptr, nullptr, { &s_baefc9120c56e274, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<43> b_903455f06065422b = {
@@ -2465,10 +2489,11 @@ static const ::capnp::_::RawSchema* const d_903455f06065422b[] = {
   &s_abd73485a9636bc9,
 };
 static const uint16_t m_903455f06065422b[] = {0};
+static const uint16_t h_903455f06065422b[] = {0, 65535};
 static const uint16_t i_903455f06065422b[] = {0};
 const ::capnp::_::RawSchema s_903455f06065422b = {
   0x903455f06065422b, b_903455f06065422b.words, 43, d_903455f06065422b, m_903455f06065422b,
-  1, 1, i_903455f06065422b, nullptr, nullptr, { &s_903455f06065422b, nullptr, nullptr, 0, 0, nullptr }
+  h_903455f06065422b, 1, 1, i_903455f06065422b, nullptr, nullptr, { &s_903455f06065422b, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<67> b_abd73485a9636bc9 = {
@@ -2546,10 +2571,11 @@ static const ::capnp::_::RawSchema* const d_abd73485a9636bc9[] = {
   &s_c863cd16969ee7fc,
 };
 static const uint16_t m_abd73485a9636bc9[] = {1, 2, 0};
+static const uint16_t h_abd73485a9636bc9[] = {2, 65535, 65535, 65535, 65535, 65535, 0, 1};
 static const uint16_t i_abd73485a9636bc9[] = {1, 2, 0};
 const ::capnp::_::RawSchema s_abd73485a9636bc9 = {
   0xabd73485a9636bc9, b_abd73485a9636bc9.words, 67, d_abd73485a9636bc9, m_abd73485a9636bc9,
-  1, 3, i_abd73485a9636bc9, nullptr, nullptr, { &s_abd73485a9636bc9, nullptr, nullptr, 0, 0, nullptr }
+  h_abd73485a9636bc9, 1, 3, i_abd73485a9636bc9, nullptr, nullptr, { &s_abd73485a9636bc9, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<49> b_c863cd16969ee7fc = {
@@ -2609,10 +2635,11 @@ static const ::capnp::_::RawSchema* const d_c863cd16969ee7fc[] = {
   &s_d07378ede1f9cc60,
 };
 static const uint16_t m_c863cd16969ee7fc[] = {1, 0};
+static const uint16_t h_c863cd16969ee7fc[] = {65535, 1, 0, 65535};
 static const uint16_t i_c863cd16969ee7fc[] = {0, 1};
 const ::capnp::_::RawSchema s_c863cd16969ee7fc = {
   0xc863cd16969ee7fc, b_c863cd16969ee7fc.words, 49, d_c863cd16969ee7fc, m_c863cd16969ee7fc,
-  1, 2, i_c863cd16969ee7fc, nullptr, nullptr, { &s_c863cd16969ee7fc, nullptr, nullptr, 0, 0, nullptr }
+  h_c863cd16969ee7fc, 1, 2, i_c863cd16969ee7fc, nullptr, nullptr, { &s_c863cd16969ee7fc, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<305> b_ce23dcd2d7b00c9b = {
@@ -2925,10 +2952,11 @@ static const ::capnp::_::AlignedData<305> b_ce23dcd2d7b00c9b = {
 ::capnp::word const* const bp_ce23dcd2d7b00c9b = b_ce23dcd2d7b00c9b.words;
 #if !CAPNP_LITE
 static const uint16_t m_ce23dcd2d7b00c9b[] = {18, 1, 13, 15, 10, 11, 3, 4, 5, 2, 17, 14, 16, 12, 7, 8, 9, 6, 0};
+static const uint16_t h_ce23dcd2d7b00c9b[] = {15, 14, 65535, 65535, 65535, 65535, 65535, 11, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 10, 3, 2, 9, 18, 65535, 65535, 65535, 65535, 65535, 65535, 6, 65535, 65535, 65535, 0, 16, 65535, 65535, 65535, 5, 13, 65535, 65535, 65535, 65535, 65535, 65535, 8, 65535, 65535, 65535, 17, 65535, 7, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 1, 12, 4};
 static const uint16_t i_ce23dcd2d7b00c9b[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18};
 const ::capnp::_::RawSchema s_ce23dcd2d7b00c9b = {
   0xce23dcd2d7b00c9b, b_ce23dcd2d7b00c9b.words, 305, nullptr, m_ce23dcd2d7b00c9b,
-  0, 19, i_ce23dcd2d7b00c9b, nullptr, nullptr, { &s_ce23dcd2d7b00c9b, nullptr, nullptr, 0, 0, nullptr }
+  h_ce23dcd2d7b00c9b, 0, 19, i_ce23dcd2d7b00c9b, nullptr, nullptr, { &s_ce23dcd2d7b00c9b, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<63> b_f1c8950dab257542 = {
@@ -3003,10 +3031,11 @@ static const ::capnp::_::RawSchema* const d_f1c8950dab257542[] = {
   &s_ce23dcd2d7b00c9b,
 };
 static const uint16_t m_f1c8950dab257542[] = {2, 0, 1};
+static const uint16_t h_f1c8950dab257542[] = {0, 65535, 1, 65535, 65535, 65535, 2, 65535};
 static const uint16_t i_f1c8950dab257542[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_f1c8950dab257542 = {
   0xf1c8950dab257542, b_f1c8950dab257542.words, 63, d_f1c8950dab257542, m_f1c8950dab257542,
-  2, 3, i_f1c8950dab257542, nullptr, nullptr, { &s_f1c8950dab257542, nullptr, nullptr, 0, 0, nullptr }
+  h_f1c8950dab257542, 2, 3, i_f1c8950dab257542, nullptr, nullptr, { &s_f1c8950dab257542, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<54> b_d1958f7dba521926 = {
@@ -3068,9 +3097,10 @@ static const ::capnp::_::AlignedData<54> b_d1958f7dba521926 = {
 ::capnp::word const* const bp_d1958f7dba521926 = b_d1958f7dba521926.words;
 #if !CAPNP_LITE
 static const uint16_t m_d1958f7dba521926[] = {1, 2, 5, 0, 4, 7, 6, 3};
+static const uint16_t h_d1958f7dba521926[] = {1, 3, 65535, 65535, 4, 65535, 65535, 7, 65535, 65535, 6, 5, 65535, 65535, 0, 2};
 const ::capnp::_::RawSchema s_d1958f7dba521926 = {
   0xd1958f7dba521926, b_d1958f7dba521926.words, 54, nullptr, m_d1958f7dba521926,
-  0, 8, nullptr, nullptr, nullptr, { &s_d1958f7dba521926, nullptr, nullptr, 0, 0, nullptr }
+  h_d1958f7dba521926, 0, 8, nullptr, nullptr, nullptr, { &s_d1958f7dba521926, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 CAPNP_DEFINE_ENUM(ElementSize_d1958f7dba521926, d1958f7dba521926);
@@ -3145,10 +3175,11 @@ static const ::capnp::_::RawSchema* const d_bfc546f6210ad7ce[] = {
   &s_e682ab4cf923a417,
 };
 static const uint16_t m_bfc546f6210ad7ce[] = {0, 1};
+static const uint16_t h_bfc546f6210ad7ce[] = {65535, 65535, 0, 1};
 static const uint16_t i_bfc546f6210ad7ce[] = {0, 1};
 const ::capnp::_::RawSchema s_bfc546f6210ad7ce = {
   0xbfc546f6210ad7ce, b_bfc546f6210ad7ce.words, 62, d_bfc546f6210ad7ce, m_bfc546f6210ad7ce,
-  2, 2, i_bfc546f6210ad7ce, nullptr, nullptr, { &s_bfc546f6210ad7ce, nullptr, nullptr, 0, 0, nullptr }
+  h_bfc546f6210ad7ce, 2, 2, i_bfc546f6210ad7ce, nullptr, nullptr, { &s_bfc546f6210ad7ce, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<74> b_cfea0eb02e810062 = {
@@ -3233,10 +3264,11 @@ static const ::capnp::_::RawSchema* const d_cfea0eb02e810062[] = {
   &s_ae504193122357e5,
 };
 static const uint16_t m_cfea0eb02e810062[] = {1, 0, 2};
+static const uint16_t h_cfea0eb02e810062[] = {0, 1, 65535, 65535, 65535, 2, 65535, 65535};
 static const uint16_t i_cfea0eb02e810062[] = {0, 1, 2};
 const ::capnp::_::RawSchema s_cfea0eb02e810062 = {
   0xcfea0eb02e810062, b_cfea0eb02e810062.words, 74, d_cfea0eb02e810062, m_cfea0eb02e810062,
-  1, 3, i_cfea0eb02e810062, nullptr, nullptr, { &s_cfea0eb02e810062, nullptr, nullptr, 0, 0, nullptr }
+  h_cfea0eb02e810062, 1, 3, i_cfea0eb02e810062, nullptr, nullptr, { &s_cfea0eb02e810062, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 static const ::capnp::_::AlignedData<52> b_ae504193122357e5 = {
@@ -3296,10 +3328,11 @@ static const ::capnp::_::AlignedData<52> b_ae504193122357e5 = {
 ::capnp::word const* const bp_ae504193122357e5 = b_ae504193122357e5.words;
 #if !CAPNP_LITE
 static const uint16_t m_ae504193122357e5[] = {0, 1};
+static const uint16_t h_ae504193122357e5[] = {0, 65535, 1, 65535};
 static const uint16_t i_ae504193122357e5[] = {0, 1};
 const ::capnp::_::RawSchema s_ae504193122357e5 = {
   0xae504193122357e5, b_ae504193122357e5.words, 52, nullptr, m_ae504193122357e5,
-  0, 2, i_ae504193122357e5, nullptr, nullptr, { &s_ae504193122357e5, nullptr, nullptr, 0, 0, nullptr }
+  h_ae504193122357e5, 0, 2, i_ae504193122357e5, nullptr, nullptr, { &s_ae504193122357e5, nullptr, nullptr, 0, 0, nullptr }
 };
 #endif  // !CAPNP_LITE
 }  // namespace schemas
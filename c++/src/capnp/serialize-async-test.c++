@@ -21,6 +21,7 @@
 
 #include "serialize-async.h"
 #include "serialize.h"
+#include "serialize-packed.h"
 #include <kj/debug.h>
 #include <kj/thread.h>
 #include <stdlib.h>
@@ -177,6 +178,201 @@ TEST(SerializeAsyncTest, ParseAsyncEvenSegmentCount) {
   checkTestMessage(received->getRoot<TestAllTypes>());
 }
 
+TEST(SerializeAsyncTest, ParseAsyncSegmentBufferPool) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto input = ioContext.lowLevelProvider->wrapInputFd(fds[0]);
+  kj::FdOutputStream rawOutput(fds[1]);
+  FragmentingOutputStream output(rawOutput);
+
+  TestMessageBuilder message(7);
+  initTestMessage(message.getRoot<TestAllTypes>());
+
+  kj::Thread thread([&]() {
+    writeMessage(output, message);
+    writeMessage(output, message);
+  });
+
+  SegmentBufferPool pool;
+
+  for (uint i = 0; i < 2; i++) {
+    auto received = readMessage(*input, pool).wait(ioContext.waitScope);
+    checkTestMessage(received->getRoot<TestAllTypes>());
+  }
+}
+
+TEST(SerializeAsyncTest, BufferedStream) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto input = ioContext.lowLevelProvider->wrapInputFd(fds[0]);
+  kj::FdOutputStream output(fds[1]);
+
+  TestMessageBuilder message1(1);
+  TestMessageBuilder message2(7);
+  TestMessageBuilder message3(10);
+  initTestMessage(message1.getRoot<TestAllTypes>());
+  initTestMessage(message2.getRoot<TestAllTypes>());
+  initTestMessage(message3.getRoot<TestAllTypes>());
+
+  kj::Thread thread([&]() {
+    for (uint i = 0; i < 10; i++) {
+      writeMessage(output, message1);
+      writeMessage(output, message2);
+      writeMessage(output, message3);
+    }
+    KJ_SYSCALL(shutdown(fds[1], SHUT_WR));
+  });
+
+  // Use the smallest buffer, so that messages straddle it and some don't fit at all, and keep
+  // every message alive so that the stream can never reuse a buffer.
+  EXPECT_LT(128u, computeSerializedSizeInWords(message1));
+  EXPECT_LT(256u, computeSerializedSizeInWords(message3));
+  BufferedMessageStream stream(*input, ReaderOptions(), 0);
+  kj::Vector<kj::Own<MessageReader>> received;
+  for (;;) {
+    KJ_IF_MAYBE(message, stream.tryReadMessage().wait(ioContext.waitScope)) {
+      received.add(kj::mv(*message));
+    } else {
+      break;
+    }
+  }
+
+  ASSERT_EQ(30u, received.size());
+  for (auto& message: received) {
+    checkTestMessage(message->getRoot<TestAllTypes>());
+  }
+}
+
+TEST(SerializeAsyncTest, BufferedStreamCopy) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto input = ioContext.lowLevelProvider->wrapInputFd(fds[0]);
+  kj::FdOutputStream output(fds[1]);
+
+  MallocMessageBuilder message;
+  message.initRoot<TestAllTypes>().setUInt32Field(123);
+  size_t messageWords = computeSerializedSizeInWords(message);
+
+  kj::Thread thread([&]() {
+    writeMessage(output, message);
+    writeMessage(output, message);
+    KJ_SYSCALL(shutdown(fds[1], SHUT_WR));
+  });
+
+  BufferedMessageStream stream(*input);
+  for (uint i = 0; i < 2; i++) {
+    auto received = stream.readMessage().wait(ioContext.waitScope);
+    auto& reader = kj::downcast<MessageStream::Reader>(*received);
+    EXPECT_EQ(messageWords, reader.sizeInWords());
+    EXPECT_TRUE(reader.sharesBuffer());
+
+    auto copy = reader.copy();
+    received = nullptr;
+    EXPECT_FALSE(copy->sharesBuffer());
+    EXPECT_EQ(messageWords, copy->sizeInWords());
+    EXPECT_EQ(123u, copy->getRoot<TestAllTypes>().getUInt32Field());
+  }
+}
+
+TEST(SerializeAsyncTest, BufferedStreamFragmented) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto input = ioContext.lowLevelProvider->wrapInputFd(fds[0]);
+  kj::FdOutputStream rawOutput(fds[1]);
+  FragmentingOutputStream output(rawOutput);
+
+  TestMessageBuilder message1(1);
+  TestMessageBuilder message2(7);
+  initTestMessage(message1.getRoot<TestAllTypes>());
+  initTestMessage(message2.getRoot<TestAllTypes>());
+
+  kj::Thread thread([&]() {
+    writeMessage(output, message1);
+    writeMessage(output, message2);
+  });
+
+  BufferedMessageStream stream(*input);
+  for (uint i = 0; i < 2; i++) {
+    auto received = stream.readMessage().wait(ioContext.waitScope);
+    checkTestMessage(received->getRoot<TestAllTypes>());
+  }
+}
+
+TEST(SerializeAsyncTest, BufferedStreamPrematureEof) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto input = ioContext.lowLevelProvider->wrapInputFd(fds[0]);
+  kj::FdOutputStream output(fds[1]);
+
+  TestMessageBuilder message(1);
+  initTestMessage(message.getRoot<TestAllTypes>());
+  auto words = messageToFlatArray(message);
+
+  kj::Thread thread([&]() {
+    output.write(words.begin(), words.asBytes().size() / 2);
+    KJ_SYSCALL(shutdown(fds[1], SHUT_WR));
+  });
+
+  BufferedMessageStream stream(*input);
+  EXPECT_ANY_THROW(stream.tryReadMessage().wait(ioContext.waitScope));
+}
+
+TEST(SerializeAsyncTest, PackedStream) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto input = ioContext.lowLevelProvider->wrapInputFd(fds[0]);
+  kj::FdOutputStream rawOutput(fds[1]);
+  FragmentingOutputStream output(rawOutput);
+
+  TestMessageBuilder message1(1);
+  TestMessageBuilder message2(7);
+  initTestMessage(message1.getRoot<TestAllTypes>());
+  initTestMessage(message2.getRoot<TestAllTypes>());
+
+  // Include some incompressible data so that the input has long uncompressed runs as well as
+  // runs of zeros.
+  auto data = message2.getRoot<TestAllTypes>().initDataField(1000);
+  for (auto& b: data) b = rand() | 1;
+
+  kj::Thread thread([&]() {
+    for (uint i = 0; i < 3; i++) {
+      writePackedMessage(output, message1);
+      writePackedMessage(output, message2);
+    }
+    KJ_SYSCALL(shutdown(fds[1], SHUT_WR));
+  });
+
+  // Use the smallest buffer, so that tag groups and runs straddle reads.
+  PackedMessageStream stream(*input, ReaderOptions(), 0);
+  for (uint i = 0; i < 3; i++) {
+    auto received1 = stream.readMessage().wait(ioContext.waitScope);
+    checkTestMessage(received1->getRoot<TestAllTypes>());
+    auto received2 = stream.readMessage().wait(ioContext.waitScope);
+    EXPECT_TRUE(received2->getRoot<TestAllTypes>().getDataField() == data);
+  }
+  EXPECT_TRUE(stream.tryReadMessage().wait(ioContext.waitScope) == nullptr);
+}
+
+TEST(SerializeAsyncTest, PackedStreamPrematureEof) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto input = ioContext.lowLevelProvider->wrapInputFd(fds[0]);
+  kj::FdOutputStream output(fds[1]);
+
+  TestMessageBuilder message(1);
+  initTestMessage(message.getRoot<TestAllTypes>());
+  kj::VectorOutputStream packed;
+  writePackedMessage(packed, message);
+
+  kj::Thread thread([&]() {
+    output.write(packed.getArray().begin(), packed.getArray().size() / 2);
+    KJ_SYSCALL(shutdown(fds[1], SHUT_WR));
+  });
+
+  PackedMessageStream stream(*input);
+  EXPECT_ANY_THROW(stream.tryReadMessage().wait(ioContext.waitScope));
+}
+
 TEST(SerializeAsyncTest, WriteAsync) {
   PipeWithSmallBuffer fds;
   auto ioContext = kj::setupAsyncIo();
@@ -249,6 +445,55 @@ TEST(SerializeAsyncTest, WriteAsyncEvenSegmentCount) {
   writeMessage(*output, message).wait(ioContext.waitScope);
 }
 
+TEST(SerializeAsyncTest, WriteMessages) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto output = ioContext.lowLevelProvider->wrapOutputFd(fds[1]);
+
+  TestMessageBuilder message1(1);
+  TestMessageBuilder message2(7);
+  TestMessageBuilder message3(10);
+  initTestMessage(message1.getRoot<TestAllTypes>());
+  initTestMessage(message2.getRoot<TestAllTypes>());
+  initTestMessage(message3.getRoot<TestAllTypes>());
+
+  kj::Thread thread([&]() {
+    for (uint i = 0; i < 3; i++) {
+      StreamFdMessageReader reader(fds[0]);
+      checkTestMessage(reader.getRoot<TestAllTypes>());
+    }
+  });
+
+  MessageBuilder* builders[3] = { &message1, &message2, &message3 };
+  writeMessages(*output, builders).wait(ioContext.waitScope);
+}
+
+TEST(SerializeAsyncTest, WritePackedMessages) {
+  PipeWithSmallBuffer fds;
+  auto ioContext = kj::setupAsyncIo();
+  auto output = ioContext.lowLevelProvider->wrapOutputFd(fds[1]);
+
+  TestMessageBuilder message1(1);
+  TestMessageBuilder message2(7);
+  initTestMessage(message1.getRoot<TestAllTypes>());
+  initTestMessage(message2.getRoot<TestAllTypes>());
+
+  kj::Thread thread([&]() {
+    kj::FdInputStream rawInput(fds[0]);
+    kj::BufferedInputStreamWrapper input(rawInput);
+    for (uint i = 0; i < 3; i++) {
+      PackedMessageReader reader(input);
+      checkTestMessage(reader.getRoot<TestAllTypes>());
+    }
+  });
+
+  writePackedMessage(*output, message1).wait(ioContext.waitScope);
+  kj::ArrayPtr<const kj::ArrayPtr<const word>> messages[2] = {
+    message1.getSegmentsForOutput(), message2.getSegmentsForOutput()
+  };
+  writePackedMessages(*output, messages).wait(ioContext.waitScope);
+}
+
 }  // namespace
 }  // namespace _ (private)
 }  // namespace capnp
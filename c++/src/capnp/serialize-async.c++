@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 
 #include "serialize-async.h"
+#include "serialize-packed.h"
 #include <kj/debug.h>
 
 namespace capnp {
@@ -28,7 +29,9 @@ namespace {
 
 class AsyncMessageReader: public MessageReader {
 public:
-  inline AsyncMessageReader(ReaderOptions options): MessageReader(options) {
+  inline AsyncMessageReader(ReaderOptions options,
+                            kj::Maybe<SegmentBufferAllocator&> segmentAllocator = nullptr)
+      : MessageReader(options), segmentAllocator(segmentAllocator) {
     memset(firstWord, 0, sizeof(firstWord));
   }
   ~AsyncMessageReader() noexcept(false) {}
@@ -54,6 +57,10 @@ private:
   kj::Array<word> ownedSpace;
   // Only if scratchSpace wasn't big enough.
 
+  kj::Maybe<SegmentBufferAllocator&> segmentAllocator;
+  kj::Array<kj::Array<word>> ownedSegments;
+  // Only when reading each segment into its own buffer.
+
   inline uint segmentCount() { return firstWord[0].get() + 1; }
   inline uint segment0Size() { return firstWord[1].get(); }
 
@@ -61,6 +68,7 @@ private:
       kj::AsyncInputStream& inputStream, kj::ArrayPtr<word> scratchSpace);
   kj::Promise<void> readSegments(
       kj::AsyncInputStream& inputStream, kj::ArrayPtr<word> scratchSpace);
+  kj::Promise<void> readOwnedSegments(kj::AsyncInputStream& inputStream, uint first);
 };
 
 kj::Promise<bool> AsyncMessageReader::read(kj::AsyncInputStream& inputStream,
@@ -122,9 +130,22 @@ kj::Promise<void> AsyncMessageReader::readSegments(kj::AsyncInputStream& inputSt
     return kj::READY_NOW;  // exception will be propagated
   }
 
+  KJ_IF_MAYBE(allocator, segmentAllocator) {
+    // Read each segment into its own buffer.
+    ownedSegments = kj::heapArray<kj::Array<word>>(segmentCount());
+    segmentStarts = kj::heapArray<const word*>(segmentCount());
+    for (uint i = 0; i < segmentCount(); i++) {
+      uint size = i == 0 ? segment0Size() : moreSizes[i - 1].get();
+      ownedSegments[i] = allocator->allocateSegment(i, size);
+      KJ_ASSERT(ownedSegments[i].size() == size, "SegmentBufferAllocator returned wrong size");
+      segmentStarts[i] = ownedSegments[i].begin();
+    }
+    return readOwnedSegments(inputStream, 0);
+  }
+
   if (scratchSpace.size() < totalWords) {
     // TODO(perf):  Consider allocating each segment as a separate chunk to reduce memory
-    //   fragmentation.
+    //   fragmentation.  (Callers who care can pass a SegmentBufferAllocator.)
     ownedSpace = kj::heapArray<word>(totalWords);
     scratchSpace = ownedSpace;
   }
@@ -145,6 +166,20 @@ kj::Promise<void> AsyncMessageReader::readSegments(kj::AsyncInputStream& inputSt
   return inputStream.read(scratchSpace.begin(), totalWords * sizeof(word));
 }
 
+kj::Promise<void> AsyncMessageReader::readOwnedSegments(kj::AsyncInputStream& inputStream,
+                                                        uint first) {
+  // Read segments `first` and up, skipping empty ones.
+  for (uint i = first; i < ownedSegments.size(); i++) {
+    if (ownedSegments[i].size() > 0) {
+      return inputStream.read(ownedSegments[i].begin(), ownedSegments[i].size() * sizeof(word))
+          .then([this,&inputStream,i]() {
+        return readOwnedSegments(inputStream, i + 1);
+      });
+    }
+  }
+  return kj::READY_NOW;
+}
+
 
 }  // namespace
 
@@ -172,6 +207,420 @@ kj::Promise<kj::Maybe<kj::Own<MessageReader>>> tryReadMessage(
   }));
 }
 
+kj::Promise<kj::Own<MessageReader>> readMessage(
+    kj::AsyncInputStream& input, SegmentBufferAllocator& segmentAllocator,
+    ReaderOptions options) {
+  auto reader = kj::heap<AsyncMessageReader>(options, segmentAllocator);
+  auto promise = reader->read(input, nullptr);
+  return promise.then(kj::mvCapture(reader, [](kj::Own<MessageReader>&& reader, bool success) {
+    KJ_REQUIRE(success, "Premature EOF.") { break; }
+    return kj::mv(reader);
+  }));
+}
+
+kj::Promise<kj::Maybe<kj::Own<MessageReader>>> tryReadMessage(
+    kj::AsyncInputStream& input, SegmentBufferAllocator& segmentAllocator,
+    ReaderOptions options) {
+  auto reader = kj::heap<AsyncMessageReader>(options, segmentAllocator);
+  auto promise = reader->read(input, nullptr);
+  return promise.then(kj::mvCapture(reader,
+        [](kj::Own<MessageReader>&& reader, bool success) -> kj::Maybe<kj::Own<MessageReader>> {
+    if (success) {
+      return kj::mv(reader);
+    } else {
+      return nullptr;
+    }
+  }));
+}
+
+// =======================================================================================
+
+class MessageStream::Buffer: public kj::Refcounted {
+public:
+  explicit Buffer(size_t sizeInWords): words(kj::heapArray<word>(sizeInWords)) {}
+
+  inline byte* bytes() { return reinterpret_cast<byte*>(words.begin()); }
+  inline size_t size() { return words.size() * sizeof(word); }
+
+  kj::Array<word> words;
+};
+
+MessageStream::Reader::Reader(ReaderOptions options, kj::Own<Buffer>&& buffer, const word* start)
+    : MessageReader(options), buffer(kj::mv(buffer)) {
+  auto table = reinterpret_cast<const _::WireValue<uint32_t>*>(start);
+  uint segmentCount = table[0].get() + 1;
+  const word* pos = start + (segmentCount + 2) / 2;
+
+  segment0 = kj::arrayPtr(pos, table[1].get());
+  pos += segment0.size();
+
+  if (segmentCount > 1) {
+    moreSegments = kj::heapArray<kj::ArrayPtr<const word>>(segmentCount - 1);
+    for (uint i = 1; i < segmentCount; i++) {
+      moreSegments[i - 1] = kj::arrayPtr(pos, table[i + 1].get());
+      pos += moreSegments[i - 1].size();
+    }
+  }
+
+  words = kj::arrayPtr(start, pos);
+}
+
+MessageStream::Reader::~Reader() noexcept(false) {}
+
+bool MessageStream::Reader::sharesBuffer() const {
+  return words.size() < buffer->words.size();
+}
+
+kj::Own<MessageStream::Reader> MessageStream::Reader::copy() {
+  auto space = kj::refcounted<Buffer>(words.size());
+  memcpy(space->bytes(), words.begin(), words.asBytes().size());
+  const word* start = space->words.begin();
+  return kj::heap<Reader>(getOptions(), kj::mv(space), start);
+}
+
+kj::ArrayPtr<const word> MessageStream::Reader::getSegment(uint id) {
+  if (id == 0) {
+    return segment0;
+  } else if (id <= moreSegments.size()) {
+    return moreSegments[id - 1];
+  } else {
+    return nullptr;
+  }
+}
+
+MessageStream::~MessageStream() noexcept(false) {}
+
+kj::Promise<kj::Own<MessageReader>> MessageStream::readMessage() {
+  return tryReadMessage().then([](kj::Maybe<kj::Own<MessageReader>>&& message) {
+    KJ_IF_MAYBE(m, message) {
+      return kj::mv(*m);
+    } else {
+      KJ_FAIL_REQUIRE("Premature EOF.") { break; }
+      return kj::Own<MessageReader>();
+    }
+  });
+}
+
+BufferedMessageStream::BufferedMessageStream(
+    kj::AsyncInputStream& input, ReaderOptions options, uint bufferSizeInWords)
+    : input(input), options(options), bufferSizeInWords(kj::max(bufferSizeInWords, 256u)),
+      buffer(kj::refcounted<Buffer>(this->bufferSizeInWords)) {}
+
+BufferedMessageStream::~BufferedMessageStream() noexcept(false) {}
+
+kj::Promise<kj::Maybe<kj::Own<MessageReader>>> BufferedMessageStream::tryReadMessage() {
+  typedef kj::Maybe<kj::Own<MessageReader>> Result;
+
+  size_t available = endPos - readPos;
+  if (available < sizeof(word)) {
+    return fillAndRetry(sizeof(word) - available);
+  }
+
+  auto table = reinterpret_cast<const _::WireValue<uint32_t>*>(buffer->bytes() + readPos);
+
+  // Reject messages with too many segments for security reasons.
+  KJ_REQUIRE(table[0].get() < 511, "Message has too many segments.") {
+    return Result(nullptr);  // exception will be propagated
+  }
+  uint segmentCount = table[0].get() + 1;
+
+  size_t tableBytes = (segmentCount + 2) / 2 * sizeof(word);
+  if (available < tableBytes) {
+    return fillAndRetry(tableBytes - available);
+  }
+
+  size_t totalWords = 0;
+  for (uint i = 0; i < segmentCount; i++) {
+    totalWords += table[i + 1].get();
+  }
+
+  // Don't accept a message which the receiver couldn't possibly traverse without hitting the
+  // traversal limit.  Without this check, a malicious client could transmit a very large segment
+  // size to make the receiver allocate excessive space and possibly crash.
+  KJ_REQUIRE(totalWords <= options.traversalLimitInWords,
+             "Message is too large.  To increase the limit on the receiving end, see "
+             "capnp::ReaderOptions.") {
+    return Result(nullptr);  // exception will be propagated
+  }
+
+  size_t messageBytes = tableBytes + totalWords * sizeof(word);
+  if (available >= messageBytes) {
+    // The common case: the whole message is already here.
+    auto start = reinterpret_cast<const word*>(table);
+    readPos += messageBytes;
+    return Result(kj::heap<Reader>(options, kj::addRef(*buffer), start));
+  } else if (messageBytes > buffer->size()) {
+    return readLargeMessage(messageBytes / sizeof(word))
+        .then([](kj::Own<MessageReader>&& message) -> Result { return kj::mv(message); });
+  } else {
+    return fillAndRetry(messageBytes - available);
+  }
+}
+
+kj::Promise<kj::Maybe<kj::Own<MessageReader>>> BufferedMessageStream::fillAndRetry(
+    size_t minBytes) {
+  return fill(minBytes).then([this](bool success) -> kj::Promise<kj::Maybe<kj::Own<MessageReader>>> {
+    if (success) {
+      return tryReadMessage();
+    }
+
+    // EOF is only OK between messages.
+    KJ_REQUIRE(readPos == endPos, "Premature EOF.") { break; }
+    return kj::Maybe<kj::Own<MessageReader>>(nullptr);
+  });
+}
+
+kj::Promise<bool> BufferedMessageStream::fill(size_t minBytes) {
+  size_t capacity = buffer->size();
+  size_t remaining = endPos - readPos;
+
+  // Outstanding messages only refer to data before `readPos`, so we can always append to the
+  // buffer, but we can only move data to the front of it if nothing else is using it.  When the
+  // space left at the end gets small, start over at the front, in a new buffer if need be, so
+  // that reads stay large.
+  if (capacity - endPos < kj::max(minBytes, capacity / 8)) {
+    if (buffer->isShared()) {
+      auto newBuffer = kj::refcounted<Buffer>(bufferSizeInWords);
+      memcpy(newBuffer->bytes(), buffer->bytes() + readPos, remaining);
+      buffer = kj::mv(newBuffer);
+    } else {
+      memmove(buffer->bytes(), buffer->bytes() + readPos, remaining);
+    }
+    readPos = 0;
+    endPos = remaining;
+  }
+
+  KJ_ASSERT(capacity - endPos >= minBytes);
+  return input.tryRead(buffer->bytes() + endPos, minBytes, capacity - endPos)
+      .then([this,minBytes](size_t n) {
+    endPos += n;
+    return n >= minBytes;
+  });
+}
+
+kj::Promise<kj::Own<MessageReader>> BufferedMessageStream::readLargeMessage(size_t messageWords) {
+  // Read a message that doesn't fit in the buffer into its own space, starting with whatever
+  // part of it we already have.
+  auto space = kj::refcounted<Buffer>(messageWords);
+  size_t available = endPos - readPos;
+  memcpy(space->bytes(), buffer->bytes() + readPos, available);
+  readPos = endPos;
+
+  auto promise = input.read(space->bytes() + available, space->size() - available);
+  return promise.then(kj::mvCapture(space, [this](kj::Own<Buffer>&& space) {
+    const word* start = space->words.begin();
+    return kj::Own<MessageReader>(kj::heap<Reader>(options, kj::mv(space), start));
+  }));
+}
+
+// =======================================================================================
+
+PackedMessageStream::PackedMessageStream(
+    kj::AsyncInputStream& input, ReaderOptions options, uint bufferSizeInBytes)
+    : input(input), options(options),
+      // The buffer must at least hold a complete tag group, which is at most 10 bytes.
+      buffer(kj::heapArray<byte>(kj::max(bufferSizeInBytes, 64u))) {}
+
+PackedMessageStream::~PackedMessageStream() noexcept(false) {}
+
+byte* PackedMessageStream::unpackBuffered(byte* out, byte* outEnd) {
+  // `out` and `outEnd` are always word-aligned relative to the start of the message, and every
+  // run is a whole number of words, so each tag group's word fits entirely.
+
+  const byte* in = buffer.begin() + readPos;
+  const byte* inEnd = buffer.begin() + endPos;
+
+  // Keep the run state in locals, since otherwise every byte stored through `out` (which may
+  // alias anything) would force it to be reloaded.
+  size_t zeroBytes = zeroBytesLeft;
+  size_t rawBytes = rawBytesLeft;
+
+  for (;;) {
+    if (zeroBytes > 0) {
+      size_t n = kj::min(zeroBytes, size_t(outEnd - out));
+      memset(out, 0, n);
+      out += n;
+      zeroBytes -= n;
+    } else if (rawBytes > 0) {
+      size_t n = kj::min(rawBytes, kj::min(size_t(outEnd - out), size_t(inEnd - in)));
+      memcpy(out, in, n);
+      out += n;
+      in += n;
+      rawBytes -= n;
+      if (rawBytes > 0) break;
+    }
+
+    if (out == outEnd || in == inEnd) break;
+
+    uint8_t tag = *in;
+    if (inEnd - in >= 10) {
+      // The whole tag group is certainly here, so we can decode without bounds checks.
+      ++in;
+
+#define HANDLE_BYTE(n) \
+      { \
+         bool isNonzero = (tag & (1u << n)) != 0; \
+         *out++ = *in & (-(int8_t)isNonzero); \
+         in += isNonzero; \
+      }
+
+      HANDLE_BYTE(0);
+      HANDLE_BYTE(1);
+      HANDLE_BYTE(2);
+      HANDLE_BYTE(3);
+      HANDLE_BYTE(4);
+      HANDLE_BYTE(5);
+      HANDLE_BYTE(6);
+      HANDLE_BYTE(7);
+#undef HANDLE_BYTE
+    } else {
+      size_t groupSize = 1 + kj::popCount(tag) + (tag == 0 || tag == 0xff);
+      if (size_t(inEnd - in) < groupSize) {
+        // Incomplete tag group; wait for the rest.
+        break;
+      }
+      ++in;
+
+      for (uint i = 0; i < 8; i++) {
+        *out++ = (tag & (1u << i)) ? *in++ : 0;
+      }
+    }
+
+    if (tag == 0) {
+      zeroBytes = *in++ * sizeof(word);
+    } else if (tag == 0xff) {
+      rawBytes = *in++ * sizeof(word);
+    }
+  }
+
+  zeroBytesLeft = zeroBytes;
+  rawBytesLeft = rawBytes;
+  readPos = in - buffer.begin();
+  return out;
+}
+
+kj::Promise<bool> PackedMessageStream::unpack(kj::ArrayPtr<byte> dst, bool atMessageStart) {
+  byte* pos = unpackBuffered(dst.begin(), dst.end());
+  if (pos == dst.end()) {
+    return true;
+  }
+
+  // Everything in the buffer has been decoded except possibly the first few bytes of a tag group.
+  // Move those to the front and read more.
+  size_t leftover = endPos - readPos;
+  memmove(buffer.begin(), buffer.begin() + readPos, leftover);
+  readPos = 0;
+  endPos = leftover;
+
+  bool nothingConsumed = atMessageStart && pos == dst.begin() && leftover == 0;
+  byte* end = dst.end();
+  return input.tryRead(buffer.begin() + endPos, 1, buffer.size() - endPos)
+      .then([this,pos,end,nothingConsumed](size_t n) -> kj::Promise<bool> {
+    if (n == 0) {
+      if (nothingConsumed) {
+        return false;
+      }
+      KJ_FAIL_REQUIRE("Premature EOF.") { return false; }
+    }
+    endPos += n;
+    return unpack(kj::arrayPtr(pos, end), false);
+  });
+}
+
+kj::Promise<kj::Maybe<kj::Own<MessageReader>>> PackedMessageStream::tryReadMessage() {
+  // Each step below first decodes whatever is already buffered, and only goes through the event
+  // loop if that wasn't enough.  Usually the whole message is in the buffer.
+
+  auto bytes = kj::arrayPtr(&firstWord, 1).asBytes();
+  byte* pos = unpackBuffered(bytes.begin(), bytes.end());
+  if (pos == bytes.end()) {
+    return readSegmentTable();
+  }
+
+  return unpack(kj::arrayPtr(pos, bytes.end()), pos == bytes.begin())
+      .then([this](bool success) -> kj::Promise<kj::Maybe<kj::Own<MessageReader>>> {
+    if (success) {
+      return readSegmentTable();
+    } else {
+      return kj::Maybe<kj::Own<MessageReader>>(nullptr);
+    }
+  });
+}
+
+kj::Promise<kj::Maybe<kj::Own<MessageReader>>> PackedMessageStream::readSegmentTable() {
+  typedef kj::Maybe<kj::Own<MessageReader>> Result;
+
+  auto firstHalf = reinterpret_cast<const _::WireValue<uint32_t>*>(&firstWord);
+
+  // Reject messages with too many segments for security reasons.
+  KJ_REQUIRE(firstHalf[0].get() < 511, "Message has too many segments.") {
+    return Result(nullptr);  // exception will be propagated
+  }
+  uint segmentCount = firstHalf[0].get() + 1;
+
+  auto table = kj::heapArray<word>((segmentCount + 2) / 2);
+  memcpy(table.asBytes().begin(), &firstWord, sizeof(word));
+
+  auto bytes = table.slice(1, table.size()).asBytes();
+  byte* pos = unpackBuffered(bytes.begin(), bytes.end());
+  if (pos == bytes.end()) {
+    return readBody(kj::mv(table));
+  }
+
+  return unpack(kj::arrayPtr(pos, bytes.end()), false)
+      .then(kj::mvCapture(table, [this](kj::Array<word>&& table, bool) {
+    return readBody(kj::mv(table));
+  }));
+}
+
+kj::Promise<kj::Maybe<kj::Own<MessageReader>>> PackedMessageStream::readBody(
+    kj::Array<word> table) {
+  typedef kj::Maybe<kj::Own<MessageReader>> Result;
+
+  auto sizes = reinterpret_cast<const _::WireValue<uint32_t>*>(table.begin());
+  uint segmentCount = sizes[0].get() + 1;
+  size_t totalWords = 0;
+  for (uint i = 0; i < segmentCount; i++) {
+    totalWords += sizes[i + 1].get();
+  }
+
+  // Don't accept a message which the receiver couldn't possibly traverse without hitting the
+  // traversal limit.  Without this check, a malicious client could transmit a very large segment
+  // size to make the receiver allocate excessive space and possibly crash.
+  KJ_REQUIRE(totalWords <= options.traversalLimitInWords,
+             "Message is too large.  To increase the limit on the receiving end, see "
+             "capnp::ReaderOptions.") {
+    return Result(nullptr);  // exception will be propagated
+  }
+
+  // The message is unpacked directly into its final space, right after a copy of the table.
+  auto space = kj::refcounted<Buffer>(table.size() + totalWords);
+  memcpy(space->bytes(), table.begin(), table.asBytes().size());
+
+  auto bytes = space->words.slice(table.size(), space->words.size()).asBytes();
+  byte* pos = unpackBuffered(bytes.begin(), bytes.end());
+  if (pos == bytes.end()) {
+    return finishMessage(kj::mv(space));
+  }
+
+  return unpack(kj::arrayPtr(pos, bytes.end()), false)
+      .then(kj::mvCapture(space, [this](kj::Own<Buffer>&& space, bool) {
+    return finishMessage(kj::mv(space));
+  }));
+}
+
+kj::Maybe<kj::Own<MessageReader>> PackedMessageStream::finishMessage(kj::Own<Buffer> space) {
+  KJ_REQUIRE(zeroBytesLeft == 0 && rawBytesLeft == 0,
+             "Packed input did not end cleanly on a message boundary.") {
+    zeroBytesLeft = 0;
+    rawBytesLeft = 0;
+    break;
+  }
+
+  const word* start = space->words.begin();
+  return kj::Own<MessageReader>(kj::heap<Reader>(options, kj::mv(space), start));
+}
+
 // =======================================================================================
 
 namespace {
@@ -217,4 +666,87 @@ kj::Promise<void> writeMessage(kj::AsyncOutputStream& output,
   return promise.then(kj::mvCapture(arrays, [](WriteArrays&&) {}));
 }
 
+kj::Promise<void> writeMessages(
+    kj::AsyncOutputStream& output,
+    kj::ArrayPtr<const kj::ArrayPtr<const kj::ArrayPtr<const word>>> messages) {
+  KJ_REQUIRE(messages.size() > 0, "Tried to serialize zero messages.");
+
+  size_t tableSize = 0;
+  size_t pieceCount = 0;
+  for (auto& segments: messages) {
+    KJ_REQUIRE(segments.size() > 0, "Tried to serialize uninitialized message.");
+    tableSize += (segments.size() + 2) & ~size_t(1);
+    pieceCount += segments.size() + 1;
+  }
+
+  // All of the segment tables share one array.
+  WriteArrays arrays;
+  arrays.table = kj::heapArray<_::WireValue<uint32_t>>(tableSize);
+  auto pieces = kj::heapArrayBuilder<kj::ArrayPtr<const byte>>(pieceCount);
+
+  auto table = arrays.table.begin();
+  for (auto& segments: messages) {
+    auto start = table;
+    (table++)->set(segments.size() - 1);
+    for (auto& segment: segments) {
+      (table++)->set(segment.size());
+    }
+    if (segments.size() % 2 == 0) {
+      // Set padding byte.
+      (table++)->set(0);
+    }
+
+    pieces.add(kj::arrayPtr(start, table).asBytes());
+    for (auto& segment: segments) {
+      pieces.add(segment.asBytes());
+    }
+  }
+  KJ_ASSERT(table == arrays.table.end());
+
+  arrays.pieces = pieces.finish();
+  auto promise = output.write(arrays.pieces);
+
+  // Make sure the arrays aren't freed until the write completes.
+  return promise.then(kj::mvCapture(arrays, [](WriteArrays&&) {}));
+}
+
+kj::Promise<void> writeMessages(kj::AsyncOutputStream& output,
+                                kj::ArrayPtr<MessageBuilder*> builders) {
+  auto messages = KJ_MAP(builder, builders) {
+    return builder->getSegmentsForOutput();
+  };
+  return writeMessages(output, messages);
+}
+
+kj::Promise<void> writePackedMessage(kj::AsyncOutputStream& output,
+                                     kj::ArrayPtr<const kj::ArrayPtr<const word>> segments) {
+  return writePackedMessages(output, kj::arrayPtr(&segments, 1));
+}
+
+kj::Promise<void> writePackedMessages(
+    kj::AsyncOutputStream& output,
+    kj::ArrayPtr<const kj::ArrayPtr<const kj::ArrayPtr<const word>>> messages) {
+  KJ_REQUIRE(messages.size() > 0, "Tried to serialize zero messages.");
+
+  // Packing can grow data. A word with no zero bytes costs two extra bytes (its tag and the
+  // length of the uncompressed run it starts), and words join the run until one has at least two
+  // zero bytes, which packs to seven bytes or fewer. So the worst case is one extra byte per two
+  // words, i.e. 1/16, plus a few bytes wherever a run is cut short by the end of a write (the
+  // segment table and each segment are written separately). Size the buffer for that, so that it
+  // is never reallocated.
+  size_t bound = 0;
+  for (auto& segments: messages) {
+    size_t words = computeSerializedSizeInWords(segments);
+    bound += words * sizeof(word) + words / 2 + 3 * (segments.size() + 1);
+  }
+  auto packed = kj::heap<kj::VectorOutputStream>(bound);
+
+  for (auto& segments: messages) {
+    writePackedMessage(*packed, segments);
+  }
+
+  auto promise = output.write(packed->getArray().begin(), packed->getArray().size());
+  return promise.attach(kj::mv(packed));
+}
+
 }  // namespace capnp
@@ -28,6 +28,7 @@
 
 #include <kj/async-io.h>
 #include "message.h"
+#include "serialize.h"
 
 namespace capnp {
 
@@ -45,6 +46,161 @@ kj::Promise<kj::Maybe<kj::Own<MessageReader>>> tryReadMessage(
     kj::ArrayPtr<word> scratchSpace = nullptr);
 // Like `readMessage` but returns null on EOF.
 
+kj::Promise<kj::Own<MessageReader>> readMessage(
+    kj::AsyncInputStream& input, SegmentBufferAllocator& segmentAllocator,
+    ReaderOptions options = ReaderOptions());
+kj::Promise<kj::Maybe<kj::Own<MessageReader>>> tryReadMessage(
+    kj::AsyncInputStream& input, SegmentBufferAllocator& segmentAllocator,
+    ReaderOptions options = ReaderOptions());
+// Like the above, but reads each segment directly into its own buffer obtained from
+// `segmentAllocator` (see serialize.h) rather than into one contiguous array.
+//
+// `segmentAllocator` must remain valid until the returned promise resolves (or is canceled).
+
+class MessageStream {
+  // A source of a sequence of messages, such as BufferedMessageStream or PackedMessageStream.
+
+public:
+  virtual ~MessageStream() noexcept(false);
+
+  virtual kj::Promise<kj::Maybe<kj::Own<MessageReader>>> tryReadMessage() = 0;
+  // Reads the next message, or returns null on EOF at a message boundary.  Only one read may be in
+  // progress at a time.
+
+  kj::Promise<kj::Own<MessageReader>> readMessage();
+  // Like tryReadMessage() but throws on EOF.
+
+  class Reader;
+  // Every MessageReader returned by the MessageStreams in this file is a Reader, so callers which
+  // know where a message came from can kj::downcast to get at its framing.
+
+protected:
+  class Buffer;
+  // A refcounted word array which messages are read into.
+};
+
+class MessageStream::Reader final: public MessageReader {
+  // A message read in place from a Buffer.
+
+public:
+  Reader(ReaderOptions options, kj::Own<Buffer>&& buffer, const word* start);
+  // `start` points to the segment table of a complete, already-validated message in `buffer`.
+  ~Reader() noexcept(false);
+
+  kj::ArrayPtr<const word> getSegment(uint id) override;
+
+  inline size_t sizeInWords() const { return words.size(); }
+  // Size of the message as it was framed on the stream, i.e. including the segment table.
+
+  bool sharesBuffer() const;
+  // True if the message was read into a buffer along with other data, in which case holding on to
+  // it keeps the whole buffer alive.
+
+  kj::Own<Reader> copy();
+  // Copies the message into space of its own.  Readers previously obtained from this Reader still
+  // point into the original buffer.
+
+private:
+  kj::Own<Buffer> buffer;
+  kj::ArrayPtr<const word> words;
+  kj::ArrayPtr<const word> segment0;
+  kj::Array<kj::ArrayPtr<const word>> moreSegments;
+};
+
+class BufferedMessageStream final: public MessageStream {
+  // Reads a sequence of messages from an AsyncInputStream through a buffer, so that a single read
+  // from the stream typically yields many messages.  In contrast, readMessage() reads each message
+  // with two or three separate reads.
+  //
+  // Messages that arrive entirely within the buffer are returned without copying: each such
+  // MessageReader holds a reference to the buffer, and the buffer is only reused once all of them
+  // have been destroyed.  So, holding on to any one message pins its whole buffer; callers who
+  // keep messages around for a long time should copy them first (see `Reader::copy()`).  Messages
+  // bigger than the buffer are read into their own space.
+  //
+  // The stream must remain valid until all returned promises resolve (or are canceled).  Only one
+  // read may be in progress at a time.
+
+public:
+  explicit BufferedMessageStream(kj::AsyncInputStream& input,
+                                 ReaderOptions options = ReaderOptions(),
+                                 uint bufferSizeInWords = 8192);
+  // The buffer is at least 256 words, so that it can hold the largest segment table.
+  KJ_DISALLOW_COPY(BufferedMessageStream);
+  ~BufferedMessageStream() noexcept(false);
+
+  kj::Promise<kj::Maybe<kj::Own<MessageReader>>> tryReadMessage() override;
+
+private:
+  kj::AsyncInputStream& input;
+  ReaderOptions options;
+  uint bufferSizeInWords;
+
+  kj::Own<Buffer> buffer;
+  size_t readPos = 0;
+  // Byte offset of the start of the next message within `buffer`.  Always a word boundary.
+  size_t endPos = 0;
+  // Byte offset of the end of the data read so far.
+
+  kj::Promise<bool> fill(size_t minBytes);
+  // Reads at least `minBytes` more into the buffer, making room if necessary.  Returns false on
+  // EOF.
+
+  kj::Promise<kj::Maybe<kj::Own<MessageReader>>> fillAndRetry(size_t minBytes);
+  kj::Promise<kj::Own<MessageReader>> readLargeMessage(size_t messageWords);
+};
+
+class PackedMessageStream final: public MessageStream {
+  // Reads a sequence of packed messages (see serialize-packed.h) from an AsyncInputStream.
+  //
+  // Input is read in large chunks and unpacked incrementally as it arrives, directly into each
+  // message's own space; a read which ends in the middle of a tag group or a run simply leaves
+  // the decoder's state to be picked up when more bytes come in.  Nothing ever blocks waiting for
+  // a full message.
+  //
+  // The stream must remain valid until all returned promises resolve (or are canceled).  Only one
+  // read may be in progress at a time.
+
+public:
+  explicit PackedMessageStream(kj::AsyncInputStream& input,
+                               ReaderOptions options = ReaderOptions(),
+                               uint bufferSizeInBytes = 65536);
+  KJ_DISALLOW_COPY(PackedMessageStream);
+  ~PackedMessageStream() noexcept(false);
+
+  kj::Promise<kj::Maybe<kj::Own<MessageReader>>> tryReadMessage() override;
+
+private:
+  kj::AsyncInputStream& input;
+  ReaderOptions options;
+
+  kj::Array<byte> buffer;
+  size_t readPos = 0;
+  size_t endPos = 0;
+  // Packed bytes in `buffer` which have been read but not yet decoded.
+
+  size_t zeroBytesLeft = 0;
+  size_t rawBytesLeft = 0;
+  // Remainder of a run of zero words (tag 0x00) or of uncompressed words (tag 0xff) which has
+  // been started but not yet fully output.  At most one of these is non-zero.
+
+  word firstWord;
+  // Start of the segment table of the message being read.
+
+  byte* unpackBuffered(byte* out, byte* outEnd);
+  // Decodes as much of the buffered input into [out, outEnd) as possible, returning the new
+  // output position.  Tag groups are only decoded once they are entirely in the buffer.
+
+  kj::Promise<bool> unpack(kj::ArrayPtr<byte> dst, bool atMessageStart);
+  // Fills `dst` with unpacked bytes, reading more input as needed.  Returns false if EOF occurs
+  // before any input at all was consumed and `atMessageStart` is true; throws on any other EOF.
+
+  kj::Promise<kj::Maybe<kj::Own<MessageReader>>> readSegmentTable();
+  kj::Promise<kj::Maybe<kj::Own<MessageReader>>> readBody(kj::Array<word> table);
+  kj::Maybe<kj::Own<MessageReader>> finishMessage(kj::Own<Buffer> space);
+  // The steps of tryReadMessage(), after the first word and after the whole segment table.
+};
+
 kj::Promise<void> writeMessage(kj::AsyncOutputStream& output,
                                kj::ArrayPtr<const kj::ArrayPtr<const word>> segments)
     KJ_WARN_UNUSED_RESULT;
@@ -52,6 +208,29 @@ kj::Promise<void> writeMessage(kj::AsyncOutputStream& output, MessageBuilder& bu
     KJ_WARN_UNUSED_RESULT;
 // Write asynchronously.  The parameters must remain valid until the returned promise resolves.
 
+kj::Promise<void> writeMessages(
+    kj::AsyncOutputStream& output,
+    kj::ArrayPtr<const kj::ArrayPtr<const kj::ArrayPtr<const word>>> messages)
+    KJ_WARN_UNUSED_RESULT;
+kj::Promise<void> writeMessages(kj::AsyncOutputStream& output,
+                                kj::ArrayPtr<MessageBuilder*> builders)
+    KJ_WARN_UNUSED_RESULT;
+// Like writeMessage(), but writes several messages back-to-back using a single gather write, which
+// on most streams means a single writev() call rather than one per message.
+
+kj::Promise<void> writePackedMessage(kj::AsyncOutputStream& output,
+                                     kj::ArrayPtr<const kj::ArrayPtr<const word>> segments)
+    KJ_WARN_UNUSED_RESULT;
+kj::Promise<void> writePackedMessage(kj::AsyncOutputStream& output, MessageBuilder& builder)
+    KJ_WARN_UNUSED_RESULT;
+kj::Promise<void> writePackedMessages(
+    kj::AsyncOutputStream& output,
+    kj::ArrayPtr<const kj::ArrayPtr<const kj::ArrayPtr<const word>>> messages)
+    KJ_WARN_UNUSED_RESULT;
+// Packed versions of writeMessage() and writeMessages(), to be read with PackedMessageStream (or
+// any of the synchronous packed readers).  The messages are packed into a temporary buffer up
+// front, so the parameters need not outlive the call, and are then written with a single write.
+
 // =======================================================================================
 // inline implementation details
 
@@ -59,6 +238,11 @@ inline kj::Promise<void> writeMessage(kj::AsyncOutputStream& output, MessageBuil
   return writeMessage(output, builder.getSegmentsForOutput());
 }
 
+inline kj::Promise<void> writePackedMessage(kj::AsyncOutputStream& output,
+                                            MessageBuilder& builder) {
+  return writePackedMessage(output, builder.getSegmentsForOutput());
+}
+
 }  // namespace capnp
 
 #endif  // CAPNP_SERIALIZE_ASYNC_H_
@@ -0,0 +1,322 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if !_WIN32
+
+#include "serialize-log.h"
+#include <kj/debug.h>
+#include <kj/compat/gtest.h>
+#include <kj/miniposix.h>
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "test-util.h"
+
+namespace capnp {
+namespace _ {  // private
+namespace {
+
+kj::AutoCloseFd makeTempFile() {
+  char filename[] = "/tmp/capnproto-serialize-log-test-XXXXXX";
+  kj::AutoCloseFd fd(mkstemp(filename));
+  KJ_ASSERT(fd.get() >= 0);
+  KJ_SYSCALL(unlink(filename));
+  return fd;
+}
+
+off_t fileSize(int fd) {
+  struct stat stats;
+  KJ_SYSCALL(fstat(fd, &stats));
+  return stats.st_size;
+}
+
+void appendMessages(MessageLogWriter& writer, uint begin, uint end) {
+  for (uint i = begin; i < end; i++) {
+    // Vary the segment count so that messages have different sizes and segment tables.
+    MallocMessageBuilder builder(i % 3 == 0 ? SUGGESTED_FIRST_SEGMENT_WORDS : i % 3,
+                                 AllocationStrategy::FIXED_SIZE);
+    auto root = builder.initRoot<TestAllTypes>();
+    root.setUInt32Field(i);
+    root.setTextField(kj::str("message ", i));
+    EXPECT_EQ(i, writer.append(builder));
+  }
+}
+
+void checkMessages(const MessageLogReader& reader, uint count) {
+  ASSERT_EQ(count, reader.size());
+  for (uint i = 0; i < count; i++) {
+    auto message = reader.getMessage(i);
+    auto root = message->getRoot<TestAllTypes>();
+    EXPECT_EQ(i, root.getUInt32Field());
+    EXPECT_EQ(kj::str("message ", i), root.getTextField());
+  }
+}
+
+TEST(SerializeLog, WriteAndRead) {
+  auto log = makeTempFile();
+  auto index = makeTempFile();
+
+  {
+    MessageLogWriter writer(log, index);
+    writer.setBatchSize(4);
+    appendMessages(writer, 0, 10);
+    EXPECT_EQ(10u, writer.size());
+  }
+
+  EXPECT_EQ(10 * sizeof(uint64_t), fileSize(index));
+
+  {
+    MessageLogReader reader(log);
+    checkMessages(reader, 10);
+  }
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 10);
+  }
+
+  // Reopening appends.
+  {
+    MessageLogWriter writer(log, index);
+    EXPECT_EQ(10u, writer.size());
+    appendMessages(writer, 10, 15);
+  }
+
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 15);
+
+    uint count = 0;
+    reader.forEach([&](size_t i, MessageReader& message) {
+      EXPECT_EQ(count++, i);
+      EXPECT_EQ(i, message.getRoot<TestAllTypes>().getUInt32Field());
+    });
+    EXPECT_EQ(15u, count);
+
+    KJ_EXPECT_THROW_MESSAGE("out of range", reader.getMessage(15));
+  }
+}
+
+TEST(SerializeLog, Empty) {
+  auto log = makeTempFile();
+  auto index = makeTempFile();
+
+  MessageLogReader reader(log);
+  EXPECT_EQ(0u, reader.size());
+  MessageLogReader indexedReader(log, index);
+  EXPECT_EQ(0u, indexedReader.size());
+  reader.forEachParallel(4, [](size_t, MessageReader&) { ADD_FAILURE(); });
+}
+
+TEST(SerializeLog, TornTail) {
+  auto log = makeTempFile();
+  auto index = makeTempFile();
+
+  {
+    MessageLogWriter writer(log, index);
+    appendMessages(writer, 0, 5);
+  }
+  off_t goodSize = fileSize(log);
+
+  // Simulate a crash in the middle of writing a message: only part of it made it to the log, and
+  // none of it to the index.
+  {
+    MallocMessageBuilder builder;
+    initTestMessage(builder.initRoot<TestAllTypes>());
+    auto words = messageToFlatArray(builder);
+    auto bytes = words.asBytes();
+    KJ_SYSCALL(pwrite(log, bytes.begin(), bytes.size() / 2 + 3, goodSize));
+  }
+
+  {
+    MessageLogReader reader(log);
+    checkMessages(reader, 5);
+  }
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 5);
+  }
+
+  // The writer truncates the torn message away before appending.
+  {
+    MessageLogWriter writer(log, index);
+    EXPECT_EQ(goodSize, fileSize(log));
+    appendMessages(writer, 5, 7);
+  }
+
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 7);
+  }
+}
+
+TEST(SerializeLog, CorruptSegmentTable) {
+  // A damaged segment table in the middle of the log can make a message appear to run past the
+  // end of the log, like a torn one. Since complete messages follow it, it must not be mistaken
+  // for one and truncated away along with them.
+  auto log = makeTempFile();
+
+  {
+    MessageLogWriter writer(log);
+    appendMessages(writer, 0, 8);
+  }
+  off_t goodSize = fileSize(log);
+
+  {
+    MessageLogReader reader(log);
+    uint64_t offset = reader.getMessageWords(3).begin() - reader.getMessageWords(0).begin();
+    WireValue<uint32_t> bogusSize;
+    bogusSize.set(1u << 30);
+    KJ_SYSCALL(pwrite(log, &bogusSize, sizeof(bogusSize), offset * sizeof(word) + 4));
+  }
+
+  EXPECT_ANY_THROW(MessageLogReader reader(log));
+  EXPECT_ANY_THROW(MessageLogWriter writer(log));
+  EXPECT_EQ(goodSize, fileSize(log));
+}
+
+TEST(SerializeLog, StaleOrCorruptIndex) {
+  auto log = makeTempFile();
+  auto index = makeTempFile();
+
+  {
+    MessageLogWriter writer(log, index);
+    appendMessages(writer, 0, 3);
+  }
+
+  // Append more messages without updating the index; they are found by scanning.
+  {
+    MessageLogWriter writer(log);
+    appendMessages(writer, 3, 8);
+  }
+  EXPECT_EQ(3 * sizeof(uint64_t), fileSize(index));
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 8);
+  }
+
+  // An index entry pointing past the end of the log is discarded along with what follows it.
+  {
+    WireValue<uint64_t> bogus;
+    bogus.set(1u << 30);
+    KJ_SYSCALL(pwrite(index, &bogus, sizeof(bogus), sizeof(bogus)));
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 8);
+  }
+
+  // Regenerate the index.
+  {
+    MessageLogReader reader(log);
+    reader.writeIndex(index);
+  }
+  EXPECT_EQ(8 * sizeof(uint64_t), fileSize(index));
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 8);
+  }
+}
+
+TEST(SerializeLog, MismatchedIndex) {
+  // An index that does not match the log, e.g. one left over from some other log, can point into
+  // the middle of a message. Parsing from there can make the rest of the log look like an
+  // incomplete message, which the writer must not truncate away.
+  auto log = makeTempFile();
+  auto index = makeTempFile();
+
+  {
+    MessageLogWriter writer(log);
+    appendMessages(writer, 0, 8);
+  }
+  off_t goodSize = fileSize(log);
+
+  {
+    // Point the index at the text of the last message, whose first word, read as a segment
+    // table, claims more segments than the log has words.
+    MessageLogReader reader(log);
+    auto base = reader.getMessageWords(0).begin();
+    auto last = reader.getMessageWords(7);
+    uint64_t textOffset = 0;
+    for (auto& w: last) {
+      if (memcmp(&w, "message ", sizeof(word)) == 0) {
+        textOffset = &w - base;
+      }
+    }
+    ASSERT_NE(0u, textOffset);
+
+    WireValue<uint64_t> entries[2];
+    entries[0].set(0);
+    entries[1].set(textOffset);
+    KJ_SYSCALL(pwrite(index, entries, sizeof(entries), 0));
+  }
+
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 8);
+  }
+
+  {
+    MessageLogWriter writer(log, index);
+    EXPECT_EQ(goodSize, fileSize(log));
+    appendMessages(writer, 8, 10);
+  }
+
+  {
+    MessageLogReader reader(log, index);
+    checkMessages(reader, 10);
+  }
+}
+
+TEST(SerializeLog, ForEachParallel) {
+  auto log = makeTempFile();
+
+  {
+    MessageLogWriter writer(log);
+    writer.setBatchSize(16);
+    appendMessages(writer, 0, 100);
+  }
+
+  MessageLogReader reader(log);
+  ASSERT_EQ(100u, reader.size());
+
+  for (uint threadCount: {1, 3, 4, 200}) {
+    std::atomic<uint> count(0);
+    std::atomic<uint64_t> sum(0);
+    reader.forEachParallel(threadCount, [&](size_t i, MessageReader& message) {
+      auto value = message.getRoot<TestAllTypes>().getUInt32Field();
+      KJ_ASSERT(value == i);
+      count += 1;
+      sum += value;
+    });
+    EXPECT_EQ(100u, count.load());
+    EXPECT_EQ(99u * 100 / 2, sum.load());
+  }
+
+  KJ_EXPECT_THROW_MESSAGE("failed in callback",
+      reader.forEachParallel(4, [](size_t i, MessageReader&) {
+    if (i == 30) KJ_FAIL_ASSERT("failed in callback");
+  }));
+}
+
+}  // namespace
+}  // namespace _ (private)
+}  // namespace capnp
+
+#endif  // !_WIN32
@@ -0,0 +1,350 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if !_WIN32
+// Message logs need mmap() and pread(), so they are not available on Windows.
+
+#include "serialize-log.h"
+#include "endian.h"
+#include <kj/debug.h>
+#include <kj/thread.h>
+#include <kj/miniposix.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+namespace capnp {
+
+namespace {
+
+class MmapDisposer: public kj::ArrayDisposer {
+protected:
+  void disposeImpl(void* firstElement, size_t elementSize, size_t elementCount,
+                   size_t capacity, void (*destroyElement)(void*)) const {
+    munmap(firstElement, elementSize * elementCount);
+  }
+};
+
+constexpr MmapDisposer mmapDisposer = MmapDisposer();
+
+typedef _::WireValue<uint64_t> IndexEntry;
+
+void syncData(int fd) {
+#if __APPLE__
+  // macOS has no fdatasync().
+  KJ_SYSCALL(fsync(fd));
+#else
+  KJ_SYSCALL(fdatasync(fd));
+#endif
+}
+
+}  // namespace
+
+MessageLogReader::MessageLogReader(int fd, ReaderOptions options)
+    : options(options) {
+  mapFile(fd);
+  offsets.add(0);
+  scanFrom(0);
+  checkTail();
+}
+
+MessageLogReader::MessageLogReader(int fd, int indexFd, ReaderOptions options)
+    : options(options) {
+  mapFile(fd);
+  loadIndex(indexFd);
+  bool usedIndex = offsets.size() > 1;
+  scanFrom(offsets.back());
+
+  if (usedIndex && offsets.back() != mapping.size()) {
+    // Something at the end doesn't parse. That is normally a message torn by a crash, but an index
+    // that doesn't match the log (e.g. one left over from a different log) can also make us start
+    // parsing mid-message, and MessageLogWriter truncates whatever we report as incomplete. So
+    // don't trust the index here; the full scan only costs extra after a crash.
+    offsets.clear();
+    offsets.add(0);
+    scanFrom(0);
+  }
+
+  checkTail();
+}
+
+MessageLogReader::~MessageLogReader() noexcept(false) {}
+
+void MessageLogReader::mapFile(int fd) {
+  struct stat stats;
+  KJ_SYSCALL(fstat(fd, &stats));
+
+  // Ignore a trailing partial word; it can only be part of an incomplete message.
+  size_t words = stats.st_size / sizeof(word);
+  if (words == 0) return;
+
+  void* ptr = mmap(nullptr, words * sizeof(word), PROT_READ, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED) {
+    KJ_FAIL_SYSCALL("mmap", errno);
+  }
+  mapping = kj::Array<const word>(reinterpret_cast<const word*>(ptr), words, mmapDisposer);
+}
+
+void MessageLogReader::loadIndex(int indexFd) {
+  struct stat stats;
+  KJ_SYSCALL(fstat(indexFd, &stats));
+
+  auto entries = kj::heapArray<IndexEntry>(stats.st_size / sizeof(IndexEntry));
+  auto bytes = entries.asPtr().asBytes();
+  size_t pos = 0;
+  while (pos < bytes.size()) {
+    ssize_t n;
+    KJ_SYSCALL(n = pread(indexFd, bytes.begin() + pos, bytes.size() - pos, pos));
+    if (n == 0) break;  // Truncated concurrently; use what we got.
+    pos += n;
+  }
+  entries = kj::heapArray<IndexEntry>(entries.slice(0, pos / sizeof(IndexEntry)));
+
+  offsets = kj::Vector<uint64_t>(entries.size() + 1);
+  offsets.add(0);
+  if (entries.size() == 0 || entries[0].get() != 0) return;
+
+  for (size_t i = 1; i < entries.size(); i++) {
+    uint64_t offset = entries[i].get();
+    if (offset <= offsets.back() || offset > mapping.size()) break;
+    offsets.add(offset);
+  }
+
+  // The index records where messages start, so `offsets` now ends with the start of the last
+  // indexed message, whose completeness is checked by scanFrom() along with anything after it.
+}
+
+void MessageLogReader::scanFrom(uint64_t offset) {
+  // `offset` is where the next message begins and is already recorded as the end of the previous
+  // one.
+
+  while (offset < mapping.size()) {
+    auto rest = mapping.slice(offset, mapping.size());
+    size_t messageSize = expectedSizeInWordsFromPrefix(rest);
+    if (messageSize > rest.size()) {
+      // Incomplete message at the end of the log.
+      break;
+    }
+    offset += messageSize;
+    offsets.add(offset);
+  }
+}
+
+bool MessageLogReader::messagesReachEnd(uint64_t offset) const {
+  // Returns true if the log from `offset` to its end is a sequence of complete messages.
+
+  while (offset < mapping.size()) {
+    auto rest = mapping.slice(offset, mapping.size());
+    auto table = reinterpret_cast<const _::WireValue<uint32_t>*>(rest.begin());
+    if (table[0].get() == 0 && table[1].get() == 0) {
+      // A zero word reads as a message with one empty segment. Such messages don't occur in
+      // practice (the root pointer alone needs a word), while a region of the file that was
+      // allocated but never written reads as zeros.
+      return false;
+    }
+    size_t messageSize = expectedSizeInWordsFromPrefix(rest);
+    if (messageSize > rest.size()) {
+      return false;
+    }
+    offset += messageSize;
+  }
+  return true;
+}
+
+void MessageLogReader::checkTail() const {
+  // The scan stopped at a message that runs past the end of the log. That is normally one torn by
+  // a crash, which is ignored (and which MessageLogWriter truncates away). But a segment table
+  // damaged in the middle of the log looks the same, and truncating there would destroy every
+  // message after it. Since logs are only appended to, a torn message can only be followed by
+  // more of its own partial content, so if complete messages run from anywhere after it to the
+  // end of the log, the log is corrupt.
+
+  uint64_t badOffset = offsets.back();
+  for (uint64_t offset = badOffset + 1; offset < mapping.size(); offset++) {
+    if (messagesReachEnd(offset)) {
+      KJ_FAIL_REQUIRE("message log is corrupt: a message's segment table runs past the end of "
+                      "the log, but complete messages follow it",
+                      badOffset * sizeof(word), offset * sizeof(word));
+    }
+  }
+}
+
+kj::ArrayPtr<const word> MessageLogReader::getMessageWords(size_t index) const {
+  KJ_REQUIRE(index < size(), "message index out of range", index, size());
+  return mapping.slice(offsets[index], offsets[index + 1]);
+}
+
+kj::Own<MessageReader> MessageLogReader::getMessage(size_t index) const {
+  return kj::heap<FlatArrayMessageReader>(getMessageWords(index), options);
+}
+
+void MessageLogReader::forEach(
+    kj::Function<void(size_t index, MessageReader& message)> func) const {
+  for (size_t i = 0; i < size(); i++) {
+    FlatArrayMessageReader reader(getMessageWords(i), options);
+    func(i, reader);
+  }
+}
+
+void MessageLogReader::forEachParallel(
+    uint threadCount, kj::ConstFunction<void(size_t index, MessageReader& message)> func) const {
+  KJ_REQUIRE(threadCount > 0);
+  threadCount = kj::min(threadCount, kj::max(size(), size_t(1)));
+
+  // Split by message count. Splitting by bytes would balance better when message sizes vary
+  // widely, but logs typically hold messages of similar size.
+  //
+  // Each range catches its own exception, so that kj::Thread's destructor never throws; we
+  // rethrow the first one after every thread has been joined.
+  auto exceptions = kj::heapArray<kj::Maybe<kj::Exception>>(threadCount);
+  auto runRange = [this,&func,&exceptions](uint rangeIndex, size_t begin, size_t end) {
+    exceptions[rangeIndex] = kj::runCatchingExceptions([&]() {
+      for (size_t i = begin; i < end; i++) {
+        FlatArrayMessageReader reader(getMessageWords(i), options);
+        func(i, reader);
+      }
+    });
+  };
+
+  {
+    auto threads = kj::heapArrayBuilder<kj::Own<kj::Thread>>(threadCount - 1);
+    size_t perThread = size() / threadCount;
+    size_t extra = size() % threadCount;
+    size_t begin = 0;
+    for (uint i = 0; i < threadCount; i++) {
+      size_t end = begin + perThread + (i < extra);
+      if (i + 1 < threadCount) {
+        threads.add(kj::heap<kj::Thread>([&runRange,i,begin,end]() { runRange(i, begin, end); }));
+      } else {
+        // The last range runs on this thread.
+        runRange(i, begin, end);
+      }
+      begin = end;
+    }
+    KJ_ASSERT(begin == size());
+  }  // Joins the threads.
+
+  for (auto& exception: exceptions) {
+    KJ_IF_MAYBE(e, exception) {
+      kj::throwFatalException(kj::mv(*e));
+    }
+  }
+}
+
+void MessageLogReader::writeIndex(int indexFd) const {
+  auto entries = kj::heapArray<IndexEntry>(size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    entries[i].set(offsets[i]);
+  }
+
+  KJ_SYSCALL(ftruncate(indexFd, 0));
+  auto bytes = entries.asPtr().asBytes();
+  size_t pos = 0;
+  while (pos < bytes.size()) {
+    ssize_t n;
+    KJ_SYSCALL(n = pwrite(indexFd, bytes.begin() + pos, bytes.size() - pos, pos));
+    pos += n;
+  }
+}
+
+// =======================================================================================
+
+MessageLogWriter::MessageLogWriter(int fd)
+    : output(fd), bufferedOutput(output), fd(fd) {
+  MessageLogReader existing(fd);
+  init(existing);
+}
+
+MessageLogWriter::MessageLogWriter(int fd, int indexFd)
+    : output(fd), bufferedOutput(output), fd(fd), indexFd(indexFd) {
+  MessageLogReader existing(fd, indexFd);
+  existing.writeIndex(indexFd);
+  syncData(indexFd);
+  init(existing);
+}
+
+void MessageLogWriter::init(MessageLogReader& existing) {
+  messageCount = existing.size();
+  endOffset = existing.offsets.back();
+
+  // Drop any incomplete message left at the end by a crash, so that new messages start at a
+  // message boundary.
+  KJ_SYSCALL(ftruncate(fd, endOffset * sizeof(word)));
+  KJ_SYSCALL(lseek(fd, endOffset * sizeof(word), SEEK_SET));
+}
+
+MessageLogWriter::~MessageLogWriter() noexcept(false) {
+  unwindDetector.catchExceptionsIfUnwinding([&]() {
+    flush();
+  });
+}
+
+void MessageLogWriter::setBatchSize(uint size) {
+  KJ_REQUIRE(size > 0, "batch size must be positive");
+  batchSize = size;
+}
+
+size_t MessageLogWriter::append(kj::ArrayPtr<const kj::ArrayPtr<const word>> segments) {
+  writeMessage(bufferedOutput, segments);
+
+  if (indexFd != nullptr) {
+    pendingIndexEntries.add(endOffset);
+  }
+  endOffset += computeSerializedSizeInWords(segments);
+
+  size_t result = messageCount++;
+  if (++pendingCount >= batchSize) {
+    flush();
+  }
+  return result;
+}
+
+void MessageLogWriter::flush() {
+  if (pendingCount == 0) return;
+
+  bufferedOutput.flush();
+  syncData(fd);
+
+  KJ_IF_MAYBE(i, indexFd) {
+    auto entries = kj::heapArray<IndexEntry>(pendingIndexEntries.size());
+    for (size_t j = 0; j < entries.size(); j++) {
+      entries[j].set(pendingIndexEntries[j]);
+    }
+
+    struct stat stats;
+    KJ_SYSCALL(fstat(*i, &stats));
+    auto bytes = entries.asPtr().asBytes();
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+      ssize_t n;
+      KJ_SYSCALL(n = pwrite(*i, bytes.begin() + pos, bytes.size() - pos, stats.st_size + pos));
+      pos += n;
+    }
+    syncData(*i);
+    pendingIndexEntries.clear();
+  }
+
+  pendingCount = 0;
+}
+
+}  // namespace capnp
+
+#endif  // !_WIN32
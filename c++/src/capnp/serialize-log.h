@@ -0,0 +1,181 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// This file implements message logs: files consisting of many messages, each in the standard
+// serialization format (see serialize.h), simply concatenated. This is exactly what you get by
+// calling writeMessageToFd() repeatedly on the same file, so existing files of that form can be
+// read as logs.
+//
+// A log may optionally have a sidecar index file, which records where each message starts so that
+// opening the log does not require scanning it. The index is a flat array of 64-bit little-endian
+// offsets, in words, from the start of the log. It is only an optimization: it can always be
+// regenerated from the log, and the log remains valid without it.
+//
+// Message logs are not available on Windows.
+
+#ifndef CAPNP_SERIALIZE_LOG_H_
+#define CAPNP_SERIALIZE_LOG_H_
+
+#if defined(__GNUC__) && !defined(CAPNP_HEADER_WARNINGS)
+#pragma GCC system_header
+#endif
+
+#include "serialize.h"
+#include <kj/function.h>
+#include <kj/vector.h>
+
+namespace capnp {
+
+class MessageLogReader {
+  // Maps a message log into memory and provides random access to its messages. Messages are read
+  // in place: getMessage() and friends do not copy message data.
+  //
+  // If the log ends with an incomplete message, e.g. because the writer crashed in the middle of
+  // appending it, the incomplete message is ignored. The same applies to messages appended after
+  // the reader was constructed; construct a new reader to see them. However, if a message claims
+  // to run past the end of the log but complete messages follow it, its segment table must have
+  // been damaged, and the constructor throws rather than ignore the rest of the log.
+
+public:
+  explicit MessageLogReader(int fd, ReaderOptions options = ReaderOptions());
+  // Maps the log open as `fd` and builds an index of its messages by walking their segment tables.
+  // The fd may be closed once the constructor returns.
+
+  MessageLogReader(int fd, int indexFd, ReaderOptions options = ReaderOptions());
+  // Like the above, but loads the index from the sidecar file open as `indexFd` rather than
+  // walking the whole log. Messages that the index does not cover yet, e.g. because the log was
+  // appended to without updating the index, are found by walking from the last indexed message.
+  // Index entries that are inconsistent with the log (not increasing, or past its end) are
+  // discarded along with everything after them.
+  //
+  // Message boundaries taken from the index are not otherwise checked when the log is opened; if
+  // the index is corrupt, reading the affected messages throws, like reading any malformed
+  // message does.
+
+  KJ_DISALLOW_COPY(MessageLogReader);
+  ~MessageLogReader() noexcept(false);
+
+  inline size_t size() const { return offsets.size() - 1; }
+  // Number of messages in the log.
+
+  kj::ArrayPtr<const word> getMessageWords(size_t index) const;
+  // Returns the serialized form of the given message, pointing into the mapping. Pass it to a
+  // FlatArrayMessageReader to read the message without any allocation.
+
+  kj::Own<MessageReader> getMessage(size_t index) const;
+  // Returns a reader for the given message.
+
+  void forEach(kj::Function<void(size_t index, MessageReader& message)> func) const;
+  // Calls `func` on every message, in order.
+
+  void forEachParallel(uint threadCount,
+                       kj::ConstFunction<void(size_t index, MessageReader& message)> func) const;
+  // Calls `func` on every message, using `threadCount` threads (the calling thread included) that
+  // each handle one contiguous range of messages. `func` must be safe to call from several threads
+  // at once. If `func` throws, the exception is rethrown here once all threads have finished.
+
+  void writeIndex(int indexFd) const;
+  // Writes this log's index to `indexFd`, replacing its contents.
+
+private:
+  kj::Array<const word> mapping;
+  kj::Vector<uint64_t> offsets;
+  // Word offset at which each message begins, followed by the offset where the last one ends.
+
+  ReaderOptions options;
+
+  void mapFile(int fd);
+  void loadIndex(int indexFd);
+  void scanFrom(uint64_t offset);
+  bool messagesReachEnd(uint64_t offset) const;
+  void checkTail() const;
+
+  friend class MessageLogWriter;
+};
+
+class MessageLogWriter {
+  // Appends messages to a message log, and optionally keeps its sidecar index up-to-date.
+  //
+  // Appended messages are buffered and written out in batches: every `batchSize` messages (see
+  // setBatchSize()), and whenever flush() is called. Writing out a batch also fdatasync()s (on
+  // macOS, fsync()s) the log and then the index, so that a batch is durable once it has been
+  // written; a crash can lose at most the batch in progress. Since the index is synced after the
+  // log, it never refers to messages that are not in the log, but it may miss the latest ones,
+  // which readers find by walking the log.
+  //
+  // Only one writer may be appending to a log at a time. Not thread-safe.
+
+public:
+  explicit MessageLogWriter(int fd);
+  MessageLogWriter(int fd, int indexFd);
+  // Opens the log open as `fd` (and its index, if given) for appending. The fd(s) must be open for
+  // reading and writing, and must remain open for as long as the writer is in use. If the log ends
+  // with an incomplete message left behind by a crash, it is truncated away first; if the log is
+  // corrupt (see MessageLogReader), this throws and leaves the log untouched. If an index is
+  // given, it is rewritten to match the log.
+
+  KJ_DISALLOW_COPY(MessageLogWriter);
+  ~MessageLogWriter() noexcept(false);
+  // Flushes, unless unwinding due to an exception.
+
+  size_t append(MessageBuilder& builder);
+  size_t append(kj::ArrayPtr<const kj::ArrayPtr<const word>> segments);
+  // Appends a message and returns its index in the log.
+
+  void flush();
+  // Writes out and syncs all messages appended so far.
+
+  void setBatchSize(uint size);
+  // Sets the number of messages after which append() writes out a batch. Defaults to 64. Smaller
+  // batches lose less on a crash but sync more often.
+
+  inline size_t size() const { return messageCount; }
+  // Number of messages in the log, including ones that have not been written out yet.
+
+private:
+  kj::FdOutputStream output;
+  kj::BufferedOutputStreamWrapper bufferedOutput;
+  int fd;
+  kj::Maybe<int> indexFd;
+  uint batchSize = 64;
+
+  size_t messageCount = 0;
+  uint64_t endOffset = 0;
+  // Word offset of the end of the log, including buffered messages.
+
+  kj::Vector<uint64_t> pendingIndexEntries;
+  uint pendingCount = 0;
+
+  kj::UnwindDetector unwindDetector;
+
+  void init(MessageLogReader& existing);
+};
+
+// =======================================================================================
+// inline implementation details
+
+inline size_t MessageLogWriter::append(MessageBuilder& builder) {
+  return append(builder.getSegmentsForOutput());
+}
+
+}  // namespace capnp
+
+#endif  // CAPNP_SERIALIZE_LOG_H_
@@ -21,6 +21,7 @@
 
 #include "serialize-packed.h"
 #include <kj/debug.h>
+#include <kj/vector.h>
 #include <kj/compat/gtest.h>
 #include <string>
 #include <stdlib.h>
@@ -577,6 +578,105 @@ TEST(Packed, RoundTripHugeStringEvenSegmentCountLazy) {
 
 // TODO(test):  Test error cases.
 
+// =======================================================================================
+
+TEST(Packed, SplitMessages) {
+  TestPipe pipe;
+  kj::Vector<size_t> sizes;
+
+  auto write = [&](MessageBuilder& builder) {
+    size_t before = pipe.getArray().size();
+    writePackedMessage(pipe, builder);
+    sizes.add(pipe.getArray().size() - before);
+  };
+
+  // Small fixed-size segments give messages of many segments.
+  for (uint segmentWords: {1u, 2u, 5u, SUGGESTED_FIRST_SEGMENT_WORDS}) {
+    {
+      MallocMessageBuilder builder(segmentWords, AllocationStrategy::FIXED_SIZE);
+      initTestMessage(builder.initRoot<TestAllTypes>());
+      write(builder);
+    }
+    {
+      MallocMessageBuilder builder(segmentWords, AllocationStrategy::FIXED_SIZE);
+      builder.initRoot<TestAllTypes>().initStructList(segmentWords % 7);
+      write(builder);
+    }
+    {
+      MallocMessageBuilder builder(segmentWords, AllocationStrategy::FIXED_SIZE);
+      builder.initRoot<TestAllTypes>().setTextField(std::string(5000, 'x') + "foo");
+      write(builder);
+    }
+  }
+
+  auto messages = splitPackedMessages(pipe.getArray());
+  ASSERT_EQ(sizes.size(), messages.size());
+  const byte* expectedBegin = pipe.getArray().begin();
+  for (uint i = 0; i < messages.size(); i++) {
+    EXPECT_EQ(expectedBegin, messages[i].begin());
+    EXPECT_EQ(sizes[i], messages[i].size());
+    expectedBegin = messages[i].end();
+  }
+
+  EXPECT_EQ(0u, splitPackedMessages(nullptr).size());
+
+  // Missing the last byte.
+  KJ_EXPECT_THROW_MESSAGE("Premature end of packed input",
+      splitPackedMessages(pipe.getArray().slice(0, pipe.getArray().size() - 1)));
+}
+
+TEST(Packed, SplitMessagesRunCrossingSegmentTable) {
+  // Two segments of sizes 1 and 0, whose only data word is zero. The zero run that encodes the
+  // second table word also covers the data word. A one-segment message of size 0 follows.
+  byte packed[] = { 0x11, 1, 1, 0, 1,   0, 0 };
+
+  auto messages = splitPackedMessages(kj::arrayPtr(packed, sizeof(packed)));
+  ASSERT_EQ(2u, messages.size());
+  EXPECT_EQ(5u, messages[0].size());
+  EXPECT_EQ(2u, messages[1].size());
+
+  // A run extending into the next message is invalid.
+  byte overrun[] = { 0x11, 1, 1, 0, 2 };
+  KJ_EXPECT_THROW_MESSAGE("past the end of the message",
+      splitPackedMessages(kj::arrayPtr(overrun, sizeof(overrun))));
+}
+
+TEST(Packed, ReadMessagesParallel) {
+  TestPipe pipe;
+  for (uint i = 0; i < 100; i++) {
+    MallocMessageBuilder builder(i % 4 + 1, AllocationStrategy::FIXED_SIZE);
+    auto root = builder.initRoot<TestAllTypes>();
+    root.setUInt32Field(i);
+    root.setTextField(std::string(i * 50, 'x'));
+    writePackedMessage(pipe, builder);
+  }
+
+  for (uint threadCount: {1, 3, 8}) {
+    auto seen = kj::heapArray<bool>(100);
+    for (auto& b: seen) b = false;
+
+    readPackedMessagesParallel(pipe.getArray(), threadCount, [&](size_t i, MessageReader& message) {
+      auto root = message.getRoot<TestAllTypes>();
+      KJ_ASSERT(root.getUInt32Field() == i);
+      KJ_ASSERT(root.getTextField().size() == i * 50);
+      seen[i] = true;
+    });
+
+    for (uint i = 0; i < 100; i++) {
+      KJ_EXPECT(seen[i], i);
+    }
+  }
+
+  KJ_EXPECT_THROW_MESSAGE("failed in callback",
+      readPackedMessagesParallel(pipe.getArray(), 4, [](size_t i, MessageReader&) {
+    if (i == 50) KJ_FAIL_ASSERT("failed in callback");
+  }));
+
+  KJ_EXPECT_THROW_MESSAGE("Premature end of packed input",
+      readPackedMessagesParallel(pipe.getArray().slice(0, pipe.getArray().size() - 1), 4,
+                                 [](size_t, MessageReader&) {}));
+}
+
 }  // namespace
 }  // namespace _ (private)
 }  // namespace capnp
@@ -21,17 +21,208 @@
 
 #include "serialize-packed.h"
 #include <kj/debug.h>
+#include <kj/mutex.h>
+#include <kj/thread.h>
+#include <kj/vector.h>
 #include "layout.h"
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// The SSSE3 kernels are compiled with a function-level target attribute and picked at runtime,
+// so they're used on CPUs that have SSSE3 even when the library is built for baseline x86.
+#define CAPNP_PACKED_SSSE3 1
+#include <tmmintrin.h>
+#else
+#define CAPNP_PACKED_SSSE3 0
+#endif
+
 namespace capnp {
 
 namespace _ {  // private
 
+// =======================================================================================
+// Word-at-a-time kernels
+//
+// The packed format works one word at a time: each word becomes a tag byte, whose bit N is set
+// if byte N of the word is non-zero, followed by the non-zero bytes. The helpers below compute a
+// whole tag at once and move a word's non-zero bytes in a single shuffle, rather than handling
+// the word's eight bytes one by one. SSE2 is part of the x86-64 baseline, so it is used whenever
+// the compiler targets it. The SSSE3 shuffles are not, so the stream loops are templates over a
+// "kernel" that moves one word's bytes, instantiated once with a portable kernel and once, inside
+// a function built for SSSE3, with the shuffle kernel; which one runs is decided by asking the CPU.
+
+namespace {
+
+inline uint8_t computeTag(const uint8_t* in) {
+  // Returns the tag for the 8-byte word at `in`.
+
+#if defined(__SSE2__)
+  __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+  uint zeroMask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+  return ~zeroMask;
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t x;
+  memcpy(&x, in, sizeof(x));
+  // Set the high bit of each byte iff the byte is non-zero, without carries between bytes...
+  uint64_t nonzero = (((x & 0x7f7f7f7f7f7f7f7full) + 0x7f7f7f7f7f7f7f7full) | x)
+                   & 0x8080808080808080ull;
+  // ...then gather the eight high bits into the top byte.
+  return ((nonzero >> 7) * 0x0102040810204080ull) >> 56;
+#else
+  uint8_t tag = 0;
+  for (uint i = 0; i < 8; i++) {
+    tag |= (in[i] != 0) << i;
+  }
+  return tag;
+#endif
+}
+
+inline bool hasMultipleZeros(uint8_t tag) {
+  // Returns true if the word with the given tag has at least two zero bytes.
+  uint8_t zeros = ~tag;
+  return (zeros & (zeros - 1)) != 0;
+}
+
+struct ScalarKernel {
+  // Moves the bytes of one word a byte at a time.
+
+  inline void expand(uint8_t tag, const uint8_t* __restrict__& in,
+                     uint8_t* __restrict__& out) const {
+    // Writes the word whose tag is `tag` and whose non-zero bytes start at `in`.
+
+#define HANDLE_BYTE(n) \
+    { \
+       bool isNonzero = (tag & (1u << n)) != 0; \
+       *out++ = *in & (-(int8_t)isNonzero); \
+       in += isNonzero; \
+    }
+
+    HANDLE_BYTE(0);
+    HANDLE_BYTE(1);
+    HANDLE_BYTE(2);
+    HANDLE_BYTE(3);
+    HANDLE_BYTE(4);
+    HANDLE_BYTE(5);
+    HANDLE_BYTE(6);
+    HANDLE_BYTE(7);
+#undef HANDLE_BYTE
+  }
+
+  inline void compact(uint8_t tag, const uint8_t* __restrict__& in,
+                      uint8_t* __restrict__& out) const {
+    // Writes the non-zero bytes of the word at `in`, whose tag is `tag`.
+
+#define HANDLE_BYTE(n) \
+    *out = *in; \
+    out += (tag >> n) & 1; /* out only advances if the byte was non-zero */ \
+    ++in
+
+    HANDLE_BYTE(0);
+    HANDLE_BYTE(1);
+    HANDLE_BYTE(2);
+    HANDLE_BYTE(3);
+    HANDLE_BYTE(4);
+    HANDLE_BYTE(5);
+    HANDLE_BYTE(6);
+    HANDLE_BYTE(7);
+#undef HANDLE_BYTE
+  }
+};
+
+#if CAPNP_PACKED_SSSE3
+
+struct ShuffleTables {
+  // For each possible tag, the byte shuffles that expand packed bytes into a word and compact a
+  // word into packed bytes. An index with the high bit set makes PSHUFB produce zero.
+
+  uint8_t expand[256][16];
+  uint8_t compact[256][16];
+  uint8_t popCount[256];
+
+  ShuffleTables() {
+    for (uint tag = 0; tag < 256; tag++) {
+      memset(expand[tag], 0x80, sizeof(expand[tag]));
+      memset(compact[tag], 0x80, sizeof(compact[tag]));
+
+      uint count = 0;
+      for (uint i = 0; i < 8; i++) {
+        if (tag & (1u << i)) {
+          expand[tag][i] = count;
+          compact[tag][count] = i;
+          ++count;
+        }
+      }
+      popCount[tag] = count;
+    }
+  }
+};
+
+inline const ShuffleTables& getShuffleTables() {
+  static const ShuffleTables tables;
+  return tables;
+}
+
+struct Ssse3Kernel {
+  // Moves the bytes of one word with a single shuffle.  Each call loads and stores a whole word,
+  // so the caller must have 8 bytes of input and output to spare.  Only call these from code built
+  // for SSSE3.
+
+  const ShuffleTables& tables = getShuffleTables();
+
+  __attribute__((target("ssse3")))
+  inline void expand(uint8_t tag, const uint8_t* __restrict__& in,
+                     uint8_t* __restrict__& out) const {
+    __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+    __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.expand[tag]));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(packed, shuffle));
+    out += 8;
+    in += tables.popCount[tag];
+  }
+
+  __attribute__((target("ssse3")))
+  inline void compact(uint8_t tag, const uint8_t* __restrict__& in,
+                      uint8_t* __restrict__& out) const {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+    __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.compact[tag]));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(bytes, shuffle));
+    out += tables.popCount[tag];
+    in += 8;
+  }
+};
+
+bool hasSsse3() {
+#if defined(__SSSE3__)
+  return true;
+#else
+  static const bool result = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3") != 0;
+  }();
+  return result;
+#endif
+}
+
+#endif  // CAPNP_PACKED_SSSE3
+
+}  // namespace
+
 PackedInputStream::PackedInputStream(kj::BufferedInputStream& inner): inner(inner) {}
 PackedInputStream::~PackedInputStream() noexcept(false) {}
 
-size_t PackedInputStream::tryRead(void* dst, size_t minBytes, size_t maxBytes) {
+namespace {
+
+template <typename Kernel>
+KJ_ALWAYS_INLINE(size_t tryReadPacked(
+    kj::BufferedInputStream& inner, void* dst, size_t minBytes, size_t maxBytes));
+
+template <typename Kernel>
+size_t tryReadPacked(kj::BufferedInputStream& inner, void* dst, size_t minBytes, size_t maxBytes) {
+  // The body of PackedInputStream::tryRead().
+
   if (maxBytes == 0) {
     return 0;
   }
@@ -49,6 +240,8 @@ size_t PackedInputStream::tryRead(void* dst, size_t minBytes, size_t maxBytes) {
   }
   const uint8_t* __restrict__ in = reinterpret_cast<const uint8_t*>(buffer.begin());
 
+  const Kernel kernel;
+
 #define REFRESH_BUFFER() \
   inner.skip(buffer.size()); \
   buffer = inner.getReadBuffer(); \
@@ -100,22 +293,8 @@ size_t PackedInputStream::tryRead(void* dst, size_t minBytes, size_t maxBytes) {
     } else {
       tag = *in++;
 
-#define HANDLE_BYTE(n) \
-      { \
-         bool isNonzero = (tag & (1u << n)) != 0; \
-         *out++ = *in & (-(int8_t)isNonzero); \
-         in += isNonzero; \
-      }
-
-      HANDLE_BYTE(0);
-      HANDLE_BYTE(1);
-      HANDLE_BYTE(2);
-      HANDLE_BYTE(3);
-      HANDLE_BYTE(4);
-      HANDLE_BYTE(5);
-      HANDLE_BYTE(6);
-      HANDLE_BYTE(7);
-#undef HANDLE_BYTE
+      // At least 9 bytes of input remain and the output has room for a whole word.
+      kernel.expand(tag, in, out);
     }
 
     if (tag == 0) {
@@ -180,6 +359,25 @@ size_t PackedInputStream::tryRead(void* dst, size_t minBytes, size_t maxBytes) {
 #undef REFRESH_BUFFER
 }
 
+#if CAPNP_PACKED_SSSE3
+__attribute__((target("ssse3")))
+size_t tryReadPackedSsse3(
+    kj::BufferedInputStream& inner, void* dst, size_t minBytes, size_t maxBytes) {
+  return tryReadPacked<Ssse3Kernel>(inner, dst, minBytes, maxBytes);
+}
+#endif
+
+}  // namespace
+
+size_t PackedInputStream::tryRead(void* dst, size_t minBytes, size_t maxBytes) {
+#if CAPNP_PACKED_SSSE3
+  if (hasSsse3()) {
+    return tryReadPackedSsse3(inner, dst, minBytes, maxBytes);
+  }
+#endif
+  return tryReadPacked<ScalarKernel>(inner, dst, minBytes, maxBytes);
+}
+
 void PackedInputStream::skip(size_t bytes) {
   // We can't just read into buffers because buffers must end on block boundaries.
 
@@ -302,7 +500,15 @@ PackedOutputStream::PackedOutputStream(kj::BufferedOutputStream& inner)
     : inner(inner) {}
 PackedOutputStream::~PackedOutputStream() noexcept(false) {}
 
-void PackedOutputStream::write(const void* src, size_t size) {
+namespace {
+
+template <typename Kernel>
+KJ_ALWAYS_INLINE(void writePacked(kj::BufferedOutputStream& inner, const void* src, size_t size));
+
+template <typename Kernel>
+void writePacked(kj::BufferedOutputStream& inner, const void* src, size_t size) {
+  // The body of PackedOutputStream::write().
+
   kj::ArrayPtr<byte> buffer = inner.getWriteBuffer();
   byte slowBuffer[20];
 
@@ -311,6 +517,8 @@ void PackedOutputStream::write(const void* src, size_t size) {
   const uint8_t* __restrict__ in = reinterpret_cast<const uint8_t*>(src);
   const uint8_t* const inEnd = reinterpret_cast<const uint8_t*>(src) + size;
 
+  const Kernel kernel;
+
   while (in < inEnd) {
     if (reinterpret_cast<uint8_t*>(buffer.end()) - out < 10) {
       // Oops, we're out of space.  We need at least 10 bytes for the fast path, since we don't
@@ -325,27 +533,11 @@ void PackedOutputStream::write(const void* src, size_t size) {
       out = reinterpret_cast<uint8_t*>(buffer.begin());
     }
 
-    uint8_t* tagPos = out++;
+    uint8_t tag = computeTag(in);
+    *out++ = tag;
 
-#define HANDLE_BYTE(n) \
-    uint8_t bit##n = *in != 0; \
-    *out = *in; \
-    out += bit##n; /* out only advances if the byte was non-zero */ \
-    ++in
-
-    HANDLE_BYTE(0);
-    HANDLE_BYTE(1);
-    HANDLE_BYTE(2);
-    HANDLE_BYTE(3);
-    HANDLE_BYTE(4);
-    HANDLE_BYTE(5);
-    HANDLE_BYTE(6);
-    HANDLE_BYTE(7);
-#undef HANDLE_BYTE
-
-    uint8_t tag = (bit0 << 0) | (bit1 << 1) | (bit2 << 2) | (bit3 << 3)
-                | (bit4 << 4) | (bit5 << 5) | (bit6 << 6) | (bit7 << 7);
-    *tagPos = tag;
+    // We have room for at least 9 more bytes.
+    kernel.compact(tag, in, out);
 
     if (tag == 0) {
       // An all-zero word is followed by a count of consecutive zero words (not including the
@@ -386,22 +578,9 @@ void PackedOutputStream::write(const void* src, size_t size) {
         limit = in + 255 * sizeof(word);
       }
 
-      while (in < limit) {
-        // Check eight input bytes for zeros.
-        uint c = *in++ == 0;
-        c += *in++ == 0;
-        c += *in++ == 0;
-        c += *in++ == 0;
-        c += *in++ == 0;
-        c += *in++ == 0;
-        c += *in++ == 0;
-        c += *in++ == 0;
-
-        if (c >= 2) {
-          // Un-read the word with multiple zeros, since we'll want to compress that one.
-          in -= 8;
-          break;
-        }
+      while (in < limit && !hasMultipleZeros(computeTag(in))) {
+        // Stop before the first word with multiple zeros, since we'll want to compress that one.
+        in += 8;
       }
 
       // Write the count.
@@ -427,6 +606,25 @@ void PackedOutputStream::write(const void* src, size_t size) {
   inner.write(buffer.begin(), reinterpret_cast<byte*>(out) - buffer.begin());
 }
 
+#if CAPNP_PACKED_SSSE3
+__attribute__((target("ssse3")))
+void writePackedSsse3(kj::BufferedOutputStream& inner, const void* src, size_t size) {
+  writePacked<Ssse3Kernel>(inner, src, size);
+}
+#endif
+
+}  // namespace
+
+void PackedOutputStream::write(const void* src, size_t size) {
+#if CAPNP_PACKED_SSSE3
+  if (hasSsse3()) {
+    writePackedSsse3(inner, src, size);
+    return;
+  }
+#endif
+  writePacked<ScalarKernel>(inner, src, size);
+}
+
 }  // namespace _ (private)
 
 // =======================================================================================
@@ -504,4 +702,235 @@ size_t computeUnpackedSizeInWords(kj::ArrayPtr<const byte> packedBytes) {
   return total;
 }
 
+namespace {
+
+const byte* findPackedMessageEnd(const byte* ptr, const byte* end, size_t& unpackedWords) {
+  // Walks over the packed message starting at `ptr`, returning a pointer just past its end and
+  // setting `unpackedWords` to its unpacked size, including the segment table. Words are only
+  // reconstructed while we are still inside the segment table; after that we just skip tags.
+
+  size_t wordIndex = 0;
+  size_t tableWords = 1;    // Becomes the real table size once word 0 has been decoded.
+  size_t totalWords = 1;
+  uint segmentCount = 0;
+
+  auto tableWord = [&](const byte* w) {
+    auto sizes = reinterpret_cast<const _::WireValue<uint32_t>*>(w);
+    if (wordIndex == 0) {
+      segmentCount = sizes[0].get() + 1;
+      KJ_REQUIRE(segmentCount > 0 && segmentCount < 512, "Message has too many segments.");
+      tableWords = segmentCount / 2 + 1;
+      totalWords = tableWords + sizes[1].get();
+    } else {
+      // Word i of the table holds the sizes of segments 2i-1 and 2i; the latter may be padding.
+      for (uint i = 0; i < 2; i++) {
+        uint segment = wordIndex * 2 - 1 + i;
+        if (segment < segmentCount) {
+          totalWords += sizes[i].get();
+        }
+      }
+    }
+  };
+
+  // Segment table.
+  while (wordIndex < tableWords) {
+    KJ_REQUIRE(ptr < end, "Premature end of packed input.");
+    uint tag = *ptr++;
+    KJ_REQUIRE(end - ptr >= kj::popCount(tag), "Premature end of packed input.");
+
+    alignas(word) byte w[sizeof(word)] = {};
+    for (uint i = 0; i < 8; i++) {
+      if (tag & (1u << i)) {
+        w[i] = *ptr++;
+      }
+    }
+    tableWord(w);
+    ++wordIndex;
+
+    if (tag == 0 || tag == 0xff) {
+      KJ_REQUIRE(ptr < end, "Premature end of packed input.");
+      size_t run = *ptr++;
+
+      // The run may continue past the end of the table.
+      while (run > 0 && wordIndex < tableWords) {
+        if (tag == 0) {
+          memset(w, 0, sizeof(w));
+        } else {
+          KJ_REQUIRE(end - ptr >= sizeof(word), "Premature end of packed input.");
+          memcpy(w, ptr, sizeof(word));
+          ptr += sizeof(word);
+        }
+        tableWord(w);
+        ++wordIndex;
+        --run;
+      }
+
+      if (tag == 0xff) {
+        KJ_REQUIRE(end - ptr >= run * sizeof(word), "Premature end of packed input.");
+        ptr += run * sizeof(word);
+      }
+      wordIndex += run;
+    }
+  }
+
+  // Segment contents. A tag and its data take at most 10 bytes, so while at least that much input
+  // remains we only need to bounds-check literal runs.
+  while (wordIndex < totalWords) {
+    if (end - ptr < 10) {
+      KJ_REQUIRE(ptr < end, "Premature end of packed input.");
+      uint tag = *ptr;
+      KJ_REQUIRE(end - ptr > kj::popCount(tag) + (tag == 0 || tag == 0xff),
+                 "Premature end of packed input.");
+    }
+
+    uint tag = *ptr++;
+    ptr += kj::popCount(tag);
+    ++wordIndex;
+
+    if (tag == 0) {
+      wordIndex += *ptr++;
+    } else if (tag == 0xff) {
+      size_t run = *ptr++;
+      KJ_REQUIRE(end - ptr >= run * sizeof(word), "Premature end of packed input.");
+      ptr += run * sizeof(word);
+      wordIndex += run;
+    }
+  }
+
+  KJ_REQUIRE(wordIndex == totalWords, "Packed run extends past the end of the message.");
+
+  unpackedWords = totalWords;
+  return ptr;
+}
+
+}  // namespace
+
+kj::Array<kj::ArrayPtr<const byte>> splitPackedMessages(kj::ArrayPtr<const byte> packedBytes) {
+  kj::Vector<kj::ArrayPtr<const byte>> result;
+  const byte* ptr = packedBytes.begin();
+  while (ptr < packedBytes.end()) {
+    size_t unpackedWords;
+    const byte* messageEnd = findPackedMessageEnd(ptr, packedBytes.end(), unpackedWords);
+    result.add(kj::arrayPtr(ptr, messageEnd));
+    ptr = messageEnd;
+  }
+  return result.releaseAsArray();
+}
+
+void readPackedMessagesParallel(kj::ArrayPtr<const byte> packedBytes, uint threadCount,
+                                kj::ConstFunction<void(size_t index, MessageReader& message)> func,
+                                ReaderOptions options) {
+  KJ_REQUIRE(threadCount > 0);
+
+  // The calling thread finds message boundaries and publishes batches of consecutive messages,
+  // which the other threads unpack as soon as they are published. Finding boundaries is several
+  // times cheaper than unpacking, so it rarely holds the other threads up. Once it is done, the
+  // calling thread helps unpack.
+  //
+  // A batch is closed once it holds at least BATCH_BYTES, so there can be no more than
+  // packedBytes.size() / BATCH_BYTES + 1 of them.
+  static constexpr size_t BATCH_BYTES = 16384;
+
+  struct Batch {
+    kj::ArrayPtr<const byte> bytes;
+    size_t firstIndex;
+    size_t count;
+    size_t maxUnpackedWords;
+  };
+
+  auto batches = kj::heapArray<Batch>(packedBytes.size() / BATCH_BYTES + 1);
+
+  struct Progress {
+    size_t publishedCount = 0;
+    // Batches before this index have been filled in and may be unpacked.
+    size_t nextBatch = 0;
+    bool scanDone = false;
+    bool failed = false;
+  };
+  kj::MutexGuarded<Progress> progress;
+
+  // Each thread catches its own exception, so that kj::Thread's destructor never throws; we
+  // rethrow the first one after every thread has been joined.
+  auto exceptions = kj::heapArray<kj::Maybe<kj::Exception>>(threadCount);
+
+  auto work = [&](uint threadIndex) {
+    exceptions[threadIndex] = kj::runCatchingExceptions([&]() {
+      kj::Array<word> scratch;
+      for (;;) {
+        // Sleep until there is a batch to claim, or nothing more to do.
+        kj::Maybe<size_t> claimed = progress.when([](const Progress& p) {
+          return p.failed || p.nextBatch < p.publishedCount || p.scanDone;
+        }, [](Progress& p) -> kj::Maybe<size_t> {
+          if (p.failed || p.nextBatch == p.publishedCount) return nullptr;
+          return p.nextBatch++;
+        });
+
+        KJ_IF_MAYBE(index, claimed) {
+          auto& batch = batches[*index];
+          if (scratch.size() < batch.maxUnpackedWords) {
+            scratch = kj::heapArray<word>(kj::max(batch.maxUnpackedWords, scratch.size() * 2));
+          }
+
+          kj::ArrayInputStream input(batch.bytes);
+          for (size_t i = 0; i < batch.count; i++) {
+            PackedMessageReader reader(input, options, scratch);
+            func(batch.firstIndex + i, reader);
+          }
+        } else {
+          return;
+        }
+      }
+    });
+    if (exceptions[threadIndex] != nullptr) {
+      progress.lockExclusive()->failed = true;
+    }
+  };
+
+  {
+    auto threads = kj::heapArrayBuilder<kj::Own<kj::Thread>>(threadCount - 1);
+    for (uint i = 0; i + 1 < threadCount; i++) {
+      threads.add(kj::heap<kj::Thread>([&work,i]() { work(i); }));
+    }
+
+    exceptions[threadCount - 1] = kj::runCatchingExceptions([&]() {
+      const byte* ptr = packedBytes.begin();
+      size_t messageCount = 0;
+      while (ptr < packedBytes.end()) {
+        Batch batch { kj::arrayPtr(ptr, ptr), messageCount, 0, 0 };
+        while (ptr < packedBytes.end() && ptr - batch.bytes.begin() < BATCH_BYTES) {
+          size_t unpackedWords;
+          ptr = findPackedMessageEnd(ptr, packedBytes.end(), unpackedWords);
+          batch.maxUnpackedWords = kj::max(batch.maxUnpackedWords, unpackedWords);
+          ++batch.count;
+        }
+        batch.bytes = kj::arrayPtr(batch.bytes.begin(), ptr);
+        messageCount += batch.count;
+
+        auto lock = progress.lockExclusive();
+        if (lock->failed) break;
+        KJ_ASSERT(lock->publishedCount < batches.size());
+        batches[lock->publishedCount++] = batch;
+      }
+    });
+
+    {
+      auto lock = progress.lockExclusive();
+      lock->scanDone = true;
+      if (exceptions[threadCount - 1] != nullptr) {
+        lock->failed = true;
+      }
+    }
+
+    if (exceptions[threadCount - 1] == nullptr) {
+      work(threadCount - 1);
+    }
+  }  // Joins the threads.
+
+  for (auto& exception: exceptions) {
+    KJ_IF_MAYBE(e, exception) {
+      kj::throwFatalException(kj::mv(*e));
+    }
+  }
+}
+
 }  // namespace capnp
@@ -27,6 +27,7 @@
 #endif
 
 #include "serialize.h"
+#include <kj/function.h>
 
 namespace capnp {
 
@@ -110,6 +111,24 @@ size_t computeUnpackedSizeInWords(kj::ArrayPtr<const byte> packedBytes);
 // Computes the number of words to which the given packed bytes will unpack. Not intended for use
 // in performance-sensitive situations.
 
+kj::Array<kj::ArrayPtr<const byte>> splitPackedMessages(kj::ArrayPtr<const byte> packedBytes);
+// Splits a buffer containing a sequence of packed messages, e.g. as written by repeated calls to
+// writePackedMessage(), into the individual messages. Only each message's segment table is
+// unpacked; segment contents are skipped over, so this is much cheaper than unpacking. Throws if
+// the buffer ends in the middle of a message.
+
+void readPackedMessagesParallel(kj::ArrayPtr<const byte> packedBytes, uint threadCount,
+                                kj::ConstFunction<void(size_t index, MessageReader& message)> func,
+                                ReaderOptions options = ReaderOptions());
+// Unpacks each message in a buffer containing a sequence of packed messages and calls `func` on
+// it, using `threadCount` threads (the calling thread included). The calling thread finds message
+// boundaries as splitPackedMessages() does and hands out batches of messages, which the other
+// threads start unpacking right away, each into a buffer of its own that is reused from message to
+// message. `func` must be safe to call from several threads at once, and may be called in any
+// order. If `func` throws, or the input turns out to be malformed, no further batches are started
+// and the exception is rethrown once all threads have finished; messages preceding the error may
+// already have been passed to `func`.
+
 // =======================================================================================
 // inline stuff
 
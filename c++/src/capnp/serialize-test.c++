@@ -23,7 +23,10 @@
 #include <kj/debug.h>
 #include <kj/compat/gtest.h>
 #include <kj/miniposix.h>
+#include <kj/thread.h>
+#include <kj/vector.h>
 #include <string>
+#include <algorithm>
 #include <stdlib.h>
 #include <fcntl.h>
 #include "test-util.h"
@@ -217,6 +220,30 @@ private:
   bool lazy;
 };
 
+TEST(Serialize, FlatArrayManySegmentsConcurrentReaders) {
+  // Segments other than the first are initialized lazily the first time they are traversed, so
+  // multiple threads sharing one reader race to initialize them. Use enough segments that the
+  // arena's segment table has to grow several times while other threads are reading it.
+  TestMessageBuilder builder(40);
+  initTestMessage(builder.initRoot<TestAllTypes>());
+
+  kj::Array<word> serialized = messageToFlatArray(builder);
+  FlatArrayMessageReader reader(serialized.asPtr());
+
+  {
+    kj::Vector<kj::Own<kj::Thread>> threads;
+    for (uint i = 0; i < 4; i++) {
+      threads.add(kj::heap<kj::Thread>([&]() {
+        for (uint j = 0; j < 20; j++) {
+          checkTestMessage(reader.getRoot<TestAllTypes>());
+        }
+      }));
+    }
+  }
+
+  checkTestMessage(reader.getRoot<TestAllTypes>());
+}
+
 TEST(Serialize, InputStream) {
   TestMessageBuilder builder(1);
   initTestMessage(builder.initRoot<TestAllTypes>());
@@ -302,6 +329,91 @@ TEST(Serialize, InputStreamEvenSegmentCountLazy) {
   checkTestMessage(reader.getRoot<TestAllTypes>());
 }
 
+class CountingSegmentAllocator: public SegmentBufferAllocator {
+public:
+  uint count = 0;
+
+  kj::Array<word> allocateSegment(uint id, uint sizeInWords) override {
+    EXPECT_EQ(count, id);
+    ++count;
+    return kj::heapArray<word>(sizeInWords);
+  }
+};
+
+TEST(Serialize, InputStreamSegmentAllocator) {
+  for (uint segmentCount: {1, 7, 10}) {
+    TestMessageBuilder builder(segmentCount);
+    initTestMessage(builder.initRoot<TestAllTypes>());
+
+    kj::Array<word> serialized = messageToFlatArray(builder);
+
+    for (bool lazy: {false, true}) {
+      TestInputStream stream(serialized.asPtr(), lazy);
+      CountingSegmentAllocator allocator;
+      InputStreamMessageReader reader(stream, allocator);
+
+      EXPECT_EQ(builder.getSegmentsForOutput().size(), allocator.count);
+      checkTestMessage(reader.getRoot<TestAllTypes>());
+    }
+  }
+}
+
+TEST(Serialize, InputStreamSegmentBufferPool) {
+  TestMessageBuilder builder(7);
+  initTestMessage(builder.initRoot<TestAllTypes>());
+
+  kj::Array<word> serialized = messageToFlatArray(builder);
+
+  SegmentBufferPool pool;
+  kj::Vector<const word*> firstBuffers;
+
+  {
+    TestInputStream stream(serialized.asPtr(), false);
+    InputStreamMessageReader reader(stream, pool);
+    checkTestMessage(reader.getRoot<TestAllTypes>());
+
+    for (uint i = 0; i < builder.getSegmentsForOutput().size(); i++) {
+      firstBuffers.add(reader.getSegment(i).begin());
+    }
+  }
+
+  {
+    // Reading the same message again reuses the same buffers (possibly in a different order).
+    TestInputStream stream(serialized.asPtr(), false);
+    InputStreamMessageReader reader(stream, pool);
+    checkTestMessage(reader.getRoot<TestAllTypes>());
+
+    for (uint i = 0; i < builder.getSegmentsForOutput().size(); i++) {
+      const word* buffer = reader.getSegment(i).begin();
+      EXPECT_TRUE(std::find(firstBuffers.begin(), firstBuffers.end(), buffer) !=
+                  firstBuffers.end());
+    }
+  }
+
+  {
+    // A pool with no room to cache anything still works.
+    SegmentBufferPool tinyPool(0);
+    TestInputStream stream(serialized.asPtr(), false);
+    InputStreamMessageReader reader(stream, tinyPool);
+    checkTestMessage(reader.getRoot<TestAllTypes>());
+  }
+}
+
+TEST(Serialize, SegmentArrayOwned) {
+  TestMessageBuilder builder(7);
+  initTestMessage(builder.initRoot<TestAllTypes>());
+
+  auto segments = builder.getSegmentsForOutput();
+  auto copies = KJ_MAP(segment, segments) -> kj::Array<const word> {
+    auto copy = kj::heapArray<word>(segment.size());
+    memcpy(copy.begin(), segment.begin(), segment.size() * sizeof(word));
+    return kj::mv(copy);
+  };
+
+  SegmentArrayMessageReader reader(kj::mv(copies));
+  checkTestMessage(reader.getRoot<TestAllTypes>());
+}
+
 TEST(Serialize, InputStreamToBuilder) {
   TestMessageBuilder builder(1);
   initTestMessage(builder.initRoot<TestAllTypes>());
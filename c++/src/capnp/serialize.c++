@@ -161,9 +161,74 @@ size_t computeSerializedSizeInWords(kj::ArrayPtr<const kj::ArrayPtr<const word>>
 
 // =======================================================================================
 
+namespace {
+
+uint sizeClass(size_t words) {
+  // Returns the smallest i such that 2^i >= words.
+  return words <= 1 ? 0 : 64 - kj::countLeadingZeros(words - 1);
+}
+
+}  // namespace
+
+SegmentBufferAllocator::~SegmentBufferAllocator() noexcept(false) {}
+
+SegmentBufferPool::SegmentBufferPool(size_t maxCachedWords): maxCachedWords(maxCachedWords) {}
+
+SegmentBufferPool::~SegmentBufferPool() noexcept(false) {
+  for (auto& freeList: freeLists) {
+    for (void* buffer: freeList) {
+      operator delete(buffer);
+    }
+  }
+}
+
+kj::Array<word> SegmentBufferPool::allocateSegment(uint id, uint sizeInWords) {
+  if (sizeInWords == 0) {
+    return nullptr;
+  }
+
+  uint i = sizeClass(sizeInWords);
+  void* buffer;
+  if (freeLists[i].empty()) {
+    buffer = operator new(sizeof(word) << i);
+  } else {
+    buffer = freeLists[i].back();
+    freeLists[i].removeLast();
+    cachedWords -= size_t(1) << i;
+  }
+
+  return kj::Array<word>(reinterpret_cast<word*>(buffer), sizeInWords, *this);
+}
+
+void SegmentBufferPool::disposeImpl(void* firstElement, size_t elementSize, size_t elementCount,
+                                    size_t capacity, void (*destroyElement)(void*)) const {
+  uint i = sizeClass(elementCount);
+  size_t words = size_t(1) << i;
+  if (cachedWords + words <= maxCachedWords) {
+    freeLists[i].add(firstElement);
+    cachedWords += words;
+  } else {
+    operator delete(firstElement);
+  }
+}
+
+// -------------------------------------------------------------------
+
 InputStreamMessageReader::InputStreamMessageReader(
     kj::InputStream& inputStream, ReaderOptions options, kj::ArrayPtr<word> scratchSpace)
     : MessageReader(options), inputStream(inputStream), readPos(nullptr) {
+  init(scratchSpace, nullptr);
+}
+
+InputStreamMessageReader::InputStreamMessageReader(
+    kj::InputStream& inputStream, SegmentBufferAllocator& segmentAllocator, ReaderOptions options)
+    : MessageReader(options), inputStream(inputStream), readPos(nullptr) {
+  init(nullptr, segmentAllocator);
+}
+
+void InputStreamMessageReader::init(kj::ArrayPtr<word> scratchSpace,
+                                    kj::Maybe<SegmentBufferAllocator&> segmentAllocator) {
+  auto& options = getOptions();
   _::WireValue<uint32_t> firstWord[2];
 
   inputStream.read(firstWord, sizeof(firstWord));
@@ -201,9 +266,30 @@ InputStreamMessageReader::InputStreamMessageReader(
     break;
   }
 
+  KJ_IF_MAYBE(allocator, segmentAllocator) {
+    // Read each segment into its own buffer.
+    ownedSegments = kj::heapArray<kj::Array<word>>(segmentCount);
+    for (uint i = 0; i < segmentCount; i++) {
+      uint size = i == 0 ? segment0Size : moreSizes[i - 1].get();
+      auto buffer = allocator->allocateSegment(i, size);
+      KJ_ASSERT(buffer.size() == size, "SegmentBufferAllocator returned wrong size");
+      inputStream.read(buffer.begin(), size * sizeof(word));
+      ownedSegments[i] = kj::mv(buffer);
+    }
+
+    segment0 = ownedSegments[0];
+    if (segmentCount > 1) {
+      moreSegments = kj::heapArray<kj::ArrayPtr<const word>>(segmentCount - 1);
+      for (uint i = 1; i < segmentCount; i++) {
+        moreSegments[i - 1] = ownedSegments[i];
+      }
+    }
+    return;
+  }
+
   if (scratchSpace.size() < totalWords) {
     // TODO(perf):  Consider allocating each segment as a separate chunk to reduce memory
-    //   fragmentation.
+    //   fragmentation.  (Callers who care can pass a SegmentBufferAllocator.)
     ownedSpace = kj::heapArray<word>(totalWords);
     scratchSpace = ownedSpace;
   }
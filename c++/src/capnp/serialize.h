@@ -47,6 +47,7 @@
 
 #include "message.h"
 #include <kj/io.h>
+#include <kj/vector.h>
 
 namespace capnp {
 
@@ -124,6 +125,49 @@ size_t expectedSizeInWordsFromPrefix(kj::ArrayPtr<const word> messagePrefix);
 
 // =======================================================================================
 
+class SegmentBufferAllocator {
+  // Supplies the memory into which a stream-based message reader reads each segment, as an
+  // alternative to reading the whole message into one contiguous scratch array. Each segment gets
+  // its own buffer, so huge messages never need one giant allocation, and the buffers can come
+  // from a pool or be memory the application already manages.
+
+public:
+  virtual ~SegmentBufferAllocator() noexcept(false);
+
+  virtual kj::Array<word> allocateSegment(uint id, uint sizeInWords) = 0;
+  // Returns an array of exactly `sizeInWords` words to hold segment number `id`. Its content need
+  // not be initialized. The reader owns the array until the reader is destroyed; an allocator that
+  // wants its buffers back can give the arrays a custom kj::ArrayDisposer.
+};
+
+class SegmentBufferPool final: public SegmentBufferAllocator, private kj::ArrayDisposer {
+  // A SegmentBufferAllocator which recycles buffers. Sizes are rounded up to a power of two, and
+  // buffers released by destroyed readers are kept on a free list for their size, so that reading
+  // a stream of similarly-sized messages does no allocation in steady state.
+  //
+  // The pool is not thread-safe, and it must outlive every reader whose buffers it allocated.
+
+public:
+  explicit SegmentBufferPool(size_t maxCachedWords = 1u << 20);
+  // At most `maxCachedWords` words worth of released buffers are kept for reuse; beyond that,
+  // released buffers are freed.
+
+  KJ_DISALLOW_COPY(SegmentBufferPool);
+  ~SegmentBufferPool() noexcept(false);
+
+  kj::Array<word> allocateSegment(uint id, uint sizeInWords) override;
+
+private:
+  mutable kj::Vector<void*> freeLists[33];
+  // freeLists[i] holds released buffers of 2^i words.
+
+  mutable size_t cachedWords = 0;
+  size_t maxCachedWords;
+
+  void disposeImpl(void* firstElement, size_t elementSize, size_t elementCount,
+                   size_t capacity, void (*destroyElement)(void*)) const override;
+};
+
 class InputStreamMessageReader: public MessageReader {
   // A MessageReader that reads from an abstract kj::InputStream. See also StreamFdMessageReader
   // for a subclass specific to file descriptors.
@@ -132,6 +176,12 @@ public:
   InputStreamMessageReader(kj::InputStream& inputStream,
                            ReaderOptions options = ReaderOptions(),
                            kj::ArrayPtr<word> scratchSpace = nullptr);
+  InputStreamMessageReader(kj::InputStream& inputStream,
+                           SegmentBufferAllocator& segmentAllocator,
+                           ReaderOptions options = ReaderOptions());
+  // Reads each segment directly into its own buffer obtained from `segmentAllocator`, rather than
+  // into a single contiguous array. All segments are read before the constructor returns.
+
   ~InputStreamMessageReader() noexcept(false);
 
   // implements MessageReader ----------------------------------------
@@ -148,7 +198,12 @@ private:
   kj::Array<word> ownedSpace;
   // Only if scratchSpace wasn't big enough.
 
+  kj::Array<kj::Array<word>> ownedSegments;
+  // Only when reading with a SegmentBufferAllocator.
+
   kj::UnwindDetector unwindDetector;
+
+  void init(kj::ArrayPtr<word> scratchSpace, kj::Maybe<SegmentBufferAllocator&> segmentAllocator);
 };
 
 void readMessageCopy(kj::InputStream& input, MessageBuilder& target,
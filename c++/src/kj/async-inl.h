@@ -38,6 +38,43 @@
 namespace kj {
 namespace _ {  // private
 
+template <typename T>
+class PromiseNodeDisposer final: public Disposer {
+public:
+  void disposeImpl(void* pointer) const override {
+    reinterpret_cast<T*>(pointer)->~T();
+    freePromiseNodeSpace(pointer, sizeof(T));
+  }
+
+  static const PromiseNodeDisposer instance;
+};
+
+template <typename T>
+const PromiseNodeDisposer<T> PromiseNodeDisposer<T>::instance = PromiseNodeDisposer<T>();
+
+template <typename T, typename... Params>
+Own<T> allocPromiseNode(Params&&... params) {
+  // Like heap<T>(), but for promise nodes and other objects that come and go with every turn of
+  // the event loop.  Small objects are recycled through free lists owned by the thread's
+  // EventLoop, so that steady-state promise chaining doesn't touch the global allocator.  The
+  // object may be destroyed on any thread.
+
+  static_assert(alignof(T) <= alignof(::max_align_t),
+                "promise node space is only aligned like the global allocator's");
+
+  struct Space {
+    // Frees the space if the constructor throws.  (Cheaper than KJ_ON_SCOPE_FAILURE.)
+    T* ptr;
+    ~Space() { if (ptr != nullptr) freePromiseNodeSpace(ptr, sizeof(T)); }
+  };
+
+  Space space = { reinterpret_cast<T*>(allocPromiseNodeSpace(sizeof(T))) };
+  ctor(*space.ptr, kj::fwd<Params>(params)...);
+  T* result = space.ptr;
+  space.ptr = nullptr;
+  return Own<T>(result, PromiseNodeDisposer<T>::instance);
+}
+
 template <typename T>
 class ExceptionOr;
 
@@ -153,6 +190,11 @@ public:
   // If this node wraps some other PromiseNode, get the wrapped node.  Used for debug tracing.
   // Default implementation returns nullptr.
 
+  virtual bool isReady();
+  // Returns true if the node is known to be ready already, in which case get() may be called
+  // without waiting on onReady().  Used by co_await to avoid suspending.  The default
+  // implementation returns false, which is always safe.
+
 protected:
   class OnReadyEvent {
     // Helper class for implementing onReady().
@@ -165,6 +207,9 @@ protected:
     // Arms the event if init() has already been called and makes future calls to init() return
     // true.
 
+    bool isReady() const;
+    // Returns true if arm() was already called.
+
   private:
     Event* event = nullptr;
   };
@@ -178,6 +223,7 @@ public:
   ~ImmediatePromiseNodeBase() noexcept(false);
 
   void onReady(Event& event) noexcept override;
+  bool isReady() override;
 };
 
 template <typename T>
@@ -476,7 +522,7 @@ public:
   ForkHub(Own<PromiseNode>&& inner): ForkHubBase(kj::mv(inner), result) {}
 
   Promise<_::UnfixVoid<T>> addBranch() {
-    return Promise<_::UnfixVoid<T>>(false, kj::heap<ForkBranch<T>>(addRef(*this)));
+    return Promise<_::UnfixVoid<T>>(false, allocPromiseNode<ForkBranch<T>>(addRef(*this)));
   }
 
 private:
@@ -503,6 +549,7 @@ public:
   void setSelfPointer(Own<PromiseNode>* selfPtr) noexcept override;
   void get(ExceptionOrValue& output) noexcept override;
   PromiseNode* getInnerForTrace() override;
+  bool isReady() override;
 
 private:
   enum State {
@@ -524,7 +571,7 @@ private:
 
 template <typename T>
 Own<PromiseNode> maybeChain(Own<PromiseNode>&& node, Promise<T>*) {
-  return heap<ChainPromiseNode>(kj::mv(node));
+  return allocPromiseNode<ChainPromiseNode>(kj::mv(node));
 }
 
 template <typename T>
@@ -682,7 +729,7 @@ template <typename T>
 Own<PromiseNode> spark(Own<PromiseNode>&& node) {
   // Forces evaluation of the given node to begin as soon as possible, even if no one is waiting
   // on it.
-  return heap<EagerPromiseNode<T>>(kj::mv(node));
+  return allocPromiseNode<EagerPromiseNode<T>>(kj::mv(node));
 }
 
 // -------------------------------------------------------------------
@@ -690,6 +737,7 @@ Own<PromiseNode> spark(Own<PromiseNode>&& node) {
 class AdapterPromiseNodeBase: public PromiseNode {
 public:
   void onReady(Event& event) noexcept override;
+  bool isReady() override;
 
 protected:
   inline void setReady() {
@@ -747,11 +795,11 @@ private:
 
 template <typename T>
 Promise<T>::Promise(_::FixVoid<T> value)
-    : PromiseBase(heap<_::ImmediatePromiseNode<_::FixVoid<T>>>(kj::mv(value))) {}
+    : PromiseBase(_::allocPromiseNode<_::ImmediatePromiseNode<_::FixVoid<T>>>(kj::mv(value))) {}
 
 template <typename T>
 Promise<T>::Promise(kj::Exception&& exception)
-    : PromiseBase(heap<_::ImmediateBrokenPromiseNode>(kj::mv(exception))) {}
+    : PromiseBase(_::allocPromiseNode<_::ImmediateBrokenPromiseNode>(kj::mv(exception))) {}
 
 template <typename T>
 template <typename Func, typename ErrorFunc>
@@ -759,7 +807,7 @@ PromiseForResult<Func, T> Promise<T>::then(Func&& func, ErrorFunc&& errorHandler
   typedef _::FixVoid<_::ReturnType<Func, T>> ResultT;
 
   Own<_::PromiseNode> intermediate =
-      heap<_::TransformPromiseNode<ResultT, _::FixVoid<T>, Func, ErrorFunc>>(
+      _::allocPromiseNode<_::TransformPromiseNode<ResultT, _::FixVoid<T>, Func, ErrorFunc>>(
           kj::mv(node), kj::fwd<Func>(func), kj::fwd<ErrorFunc>(errorHandler));
   return PromiseForResult<Func, T>(false,
       _::maybeChain(kj::mv(intermediate), implicitCast<ResultT*>(nullptr)));
@@ -835,13 +883,14 @@ Promise<T> ForkedPromise<T>::addBranch() {
 
 template <typename T>
 Promise<T> Promise<T>::exclusiveJoin(Promise<T>&& other) {
-  return Promise(false, heap<_::ExclusiveJoinPromiseNode>(kj::mv(node), kj::mv(other.node)));
+  return Promise(false, _::allocPromiseNode<_::ExclusiveJoinPromiseNode>(
+      kj::mv(node), kj::mv(other.node)));
 }
 
 template <typename T>
 template <typename... Attachments>
 Promise<T> Promise<T>::attach(Attachments&&... attachments) {
-  return Promise(false, kj::heap<_::AttachmentPromiseNode<Tuple<Attachments...>>>(
+  return Promise(false, _::allocPromiseNode<_::AttachmentPromiseNode<Tuple<Attachments...>>>(
       kj::mv(node), kj::tuple(kj::fwd<Attachments>(attachments)...)));
 }
 
@@ -894,7 +943,7 @@ void Promise<void>::detach(ErrorFunc&& errorHandler) {
 
 template <typename T>
 Promise<Array<T>> joinPromises(Array<Promise<T>>&& promises) {
-  return Promise<Array<T>>(false, kj::heap<_::ArrayJoinPromiseNode<T>>(
+  return Promise<Array<T>>(false, _::allocPromiseNode<_::ArrayJoinPromiseNode<T>>(
       KJ_MAP(p, promises) { return kj::mv(p.node); },
       heapArray<_::ExceptionOr<T>>(promises.size())));
 }
@@ -922,7 +971,8 @@ public:
   KJ_DISALLOW_COPY(WeakFulfiller);
 
   static kj::Own<WeakFulfiller> make() {
-    WeakFulfiller* ptr = new WeakFulfiller;
+    WeakFulfiller* ptr = new (PlacementNew(), allocPromiseNodeSpace(sizeof(WeakFulfiller)))
+        WeakFulfiller;
     return Own<WeakFulfiller>(ptr, *ptr);
   }
 
@@ -949,7 +999,7 @@ public:
   void detach(PromiseFulfiller<T>& from) {
     if (inner == nullptr) {
       // Already disposed.
-      delete this;
+      destroy();
     } else {
       KJ_IREQUIRE(inner == &from);
       inner = nullptr;
@@ -961,12 +1011,18 @@ private:
 
   WeakFulfiller(): inner(nullptr) {}
 
+  void destroy() const {
+    WeakFulfiller* self = const_cast<WeakFulfiller*>(this);
+    self->~WeakFulfiller();
+    freePromiseNodeSpace(self, sizeof(WeakFulfiller));
+  }
+
   void disposeImpl(void* pointer) const override {
     // TODO(perf): Factor some of this out so it isn't regenerated for every fulfiller type?
 
     if (inner == nullptr) {
       // Already detached.
-      delete this;
+      destroy();
     } else {
       if (inner->isWaiting()) {
         inner->reject(kj::Exception(kj::Exception::Type::FAILED, __FILE__, __LINE__,
@@ -1020,7 +1076,7 @@ bool PromiseFulfiller<void>::rejectIfThrows(Func&& func) {
 
 template <typename T, typename Adapter, typename... Params>
 Promise<T> newAdaptedPromise(Params&&... adapterConstructorParams) {
-  return Promise<T>(false, heap<_::AdapterPromiseNode<_::FixVoid<T>, Adapter>>(
+  return Promise<T>(false, _::allocPromiseNode<_::AdapterPromiseNode<_::FixVoid<T>, Adapter>>(
       kj::fwd<Params>(adapterConstructorParams)...));
 }
 
@@ -1028,14 +1084,302 @@ template <typename T>
 PromiseFulfillerPair<T> newPromiseAndFulfiller() {
   auto wrapper = _::WeakFulfiller<T>::make();
 
-  Own<_::PromiseNode> intermediate(
-      heap<_::AdapterPromiseNode<_::FixVoid<T>, _::PromiseAndFulfillerAdapter<T>>>(*wrapper));
+  Own<_::PromiseNode> intermediate(_::allocPromiseNode<
+      _::AdapterPromiseNode<_::FixVoid<T>, _::PromiseAndFulfillerAdapter<T>>>(*wrapper));
   Promise<_::JoinPromises<T>> promise(false,
       _::maybeChain(kj::mv(intermediate), implicitCast<T*>(nullptr)));
 
   return PromiseFulfillerPair<T> { kj::mv(promise), kj::mv(wrapper) };
 }
 
+// =======================================================================================
+// Cross-thread execution
+
+namespace _ {  // private
+
+class XThreadEvent: public PromiseNode, private Disposer {
+  // Work queued by Executor::executeAsync().  The object first travels through the target
+  // Executor's queue to be executed on the target thread, then back through the calling thread's
+  // Executor to deliver the result.  It is also the PromiseNode of the promise returned to the
+  // caller; dropping that promise invokes our Disposer.  Since both threads hold references, the
+  // refcount is atomic.
+
+public:
+  XThreadEvent(ExceptionOrValue& result, Own<const Executor> replyTo);
+
+  Own<PromiseNode> send(const Executor& target);
+  // Queues the event on `target` and returns the calling thread's end.
+
+  void onReady(Event& event) noexcept override;
+
+protected:
+  virtual ~XThreadEvent() noexcept(false);
+
+  virtual Promise<void> execute() = 0;
+  // Called on the target thread.  Returns a promise which resolves (never rejects) once the
+  // result has been stored.
+
+private:
+  ExceptionOrValue& result;
+  Own<const Executor> replyTo;
+
+  XThreadEvent* next = nullptr;
+  // Link in an Executor's queue.
+
+  uint refcount = 2;
+  // One reference for the calling thread's PromiseNode, one for the event itself while it is
+  // queued or executing.
+
+  bool canceled = false;
+  // Set when the calling thread drops the promise.  Read by the target thread.
+
+  bool replying = false;
+  // False while on the way to the target thread, true once on the way back.
+
+  bool nodeAlive = true;
+  // Whether the calling thread still holds the promise.  Only accessed by the calling thread.
+
+  OnReadyEvent onReadyEvent;
+
+  class ReplyGuard;
+
+  void run(EventLoop& loop);
+  void reply();
+  void deliver();
+  void release();
+  void disposeImpl(void* pointer) const override;
+
+  friend class kj::Executor;
+};
+
+template <typename T>
+class XThreadResultSetter {
+public:
+  explicit XThreadResultSetter(ExceptionOr<FixVoid<T>>& result): result(result) {}
+
+  template <typename... Params>
+  void operator()(Params&&... params) {
+    result.value = FixVoid<T>(kj::fwd<Params>(params)...);
+  }
+
+private:
+  ExceptionOr<FixVoid<T>>& result;
+};
+
+template <typename T, typename Func>
+class XThreadEventImpl final: public XThreadEvent {
+public:
+  XThreadEventImpl(Func&& func, Own<const Executor> replyTo)
+      : XThreadEvent(result, kj::mv(replyTo)), func(kj::mv(func)) {}
+
+  void get(ExceptionOrValue& output) noexcept override {
+    output.as<FixVoid<T>>() = kj::mv(result);
+  }
+
+protected:
+  Promise<void> execute() override {
+    return evalLater(kj::mv(func)).then(XThreadResultSetter<T>(result), [this](Exception&& e) {
+      result.addException(kj::mv(e));
+    });
+  }
+
+private:
+  ExceptionOr<FixVoid<T>> result;
+  Func func;
+};
+
+}  // namespace _ (private)
+
+template <typename Func>
+PromiseForResult<Func, void> Executor::executeAsync(Func&& func) const {
+  typedef _::JoinPromises<_::ReturnType<Func, void>> T;
+  auto replyTo = getCurrentThreadExecutor().addRef();
+  auto event = new _::XThreadEventImpl<T, Decay<Func>>(
+      Decay<Func>(kj::fwd<Func>(func)), kj::mv(replyTo));
+  return PromiseForResult<Func, void>(false, event->send(*this));
+}
+
+#if KJ_HAS_COROUTINE
+// =======================================================================================
+// Coroutines
+
+namespace _ {  // private
+
+class CoroutineBase: public PromiseNode, public Event, private Disposer {
+  // The promise_type of a coroutine returning Promise<T>, and thus part of the coroutine frame.
+  // It is also the PromiseNode of the Promise the coroutine returns (destroying that promise
+  // destroys the frame), and the Event that resumes the coroutine when an awaited promise is
+  // ready.
+
+public:
+  explicit CoroutineBase(std::coroutine_handle<> handle): handle(handle) {}
+
+  static void* operator new(size_t size) { return allocPromiseNodeSpace(size); }
+  static void operator delete(void* space, size_t size) { freePromiseNodeSpace(space, size); }
+  // The frame is allocated like any other promise node.
+
+  std::suspend_never initial_suspend() { return {}; }
+  // Run synchronously up to the first co_await that isn't ready.
+
+  class FinalAwaiter {
+  public:
+    explicit FinalAwaiter(CoroutineBase& coroutine): coroutine(coroutine) {}
+
+    bool await_ready() noexcept { return false; }
+    void await_suspend(std::coroutine_handle<>) noexcept { coroutine.onReadyEvent.arm(); }
+    void await_resume() noexcept {}
+
+  private:
+    CoroutineBase& coroutine;
+  };
+
+  FinalAwaiter final_suspend() noexcept { return FinalAwaiter(*this); }
+  // Stay suspended at the end, so that the frame lives until the promise is dropped.
+
+  void unhandled_exception() {
+    KJ_IF_MAYBE(exception, kj::runCatchingExceptions([]() { throw; })) {
+      getResultRef().addException(kj::mv(*exception));
+    }
+  }
+
+  void onReady(Event& event) noexcept override { onReadyEvent.init(event); }
+  bool isReady() override { return onReadyEvent.isReady(); }
+  PromiseNode* getInnerForTrace() override {
+    KJ_IF_MAYBE(node, awaiting) {
+      return node->get();
+    } else {
+      return nullptr;
+    }
+  }
+
+protected:
+  Own<PromiseNode> selfOwn() { return Own<PromiseNode>(this, *this); }
+
+  virtual ExceptionOrValue& getResultRef() = 0;
+
+private:
+  std::coroutine_handle<> handle;
+  OnReadyEvent onReadyEvent;
+
+  Maybe<Own<PromiseNode>&> awaiting;
+  // The node of the promise we're suspended on, if any.
+
+  Maybe<Own<Event>> fire() override {
+    // The awaited promise is ready.
+    awaiting = nullptr;
+    handle.resume();
+    return nullptr;
+  }
+
+  void disposeImpl(void* pointer) const override {
+    handle.destroy();
+  }
+
+  template <typename>
+  friend class PromiseAwaiter;
+};
+
+template <typename T>
+class CoroutineReturn: public CoroutineBase {
+public:
+  using CoroutineBase::CoroutineBase;
+
+  void return_value(T&& value) { result.value = kj::mv(value); }
+  void return_value(const T& value) { result.value = value; }
+
+protected:
+  ExceptionOr<T> result;
+};
+
+template <>
+class CoroutineReturn<Void>: public CoroutineBase {
+public:
+  using CoroutineBase::CoroutineBase;
+
+  void return_void() { result.value = Void(); }
+
+protected:
+  ExceptionOr<Void> result;
+};
+
+template <typename T>
+class Coroutine final: public CoroutineReturn<FixVoid<T>> {
+public:
+  Coroutine(): CoroutineReturn<FixVoid<T>>(std::coroutine_handle<Coroutine>::from_promise(*this)) {}
+
+  Promise<T> get_return_object() {
+    return Promise<T>(false, this->selfOwn());
+  }
+
+  template <typename U>
+  PromiseAwaiter<U> await_transform(Promise<U>&& promise) {
+    return PromiseAwaiter<U>(*this, kj::mv(promise.node));
+  }
+  template <typename U>
+  PromiseAwaiter<U> await_transform(Promise<U>& promise) {
+    return PromiseAwaiter<U>(*this, kj::mv(promise.node));
+  }
+
+  void get(ExceptionOrValue& output) noexcept override {
+    output.as<FixVoid<T>>() = kj::mv(this->result);
+  }
+
+private:
+  ExceptionOrValue& getResultRef() override { return this->result; }
+};
+
+template <typename T>
+class PromiseAwaiter {
+  // The result of co_await on a Promise<T>.
+
+public:
+  PromiseAwaiter(CoroutineBase& coroutine, Own<PromiseNode>&& node)
+      : coroutine(coroutine), node(kj::mv(node)) {}
+  KJ_DISALLOW_COPY(PromiseAwaiter);
+
+  bool await_ready() { return node->isReady(); }
+  // If the promise is already resolved, carry on without suspending.
+
+  void await_suspend(std::coroutine_handle<>) {
+    node->setSelfPointer(&node);
+    node->onReady(coroutine);
+    coroutine.awaiting = node;
+  }
+
+  T await_resume() {
+    // Like Promise<T>::wait().
+    ExceptionOr<FixVoid<T>> result;
+    node->get(result);
+    node = nullptr;
+
+    KJ_IF_MAYBE(value, result.value) {
+      KJ_IF_MAYBE(exception, result.exception) {
+        throwRecoverableException(kj::mv(*exception));
+      }
+      return returnMaybeVoid(kj::mv(*value));
+    } else KJ_IF_MAYBE(exception, result.exception) {
+      throwFatalException(kj::mv(*exception));
+    } else {
+      // Result contained neither a value nor an exception?
+      KJ_UNREACHABLE;
+    }
+  }
+
+private:
+  CoroutineBase& coroutine;
+  Own<PromiseNode> node;
+};
+
+}  // namespace _ (private)
+#endif  // KJ_HAS_COROUTINE
+
 }  // namespace kj
 
+#if KJ_HAS_COROUTINE
+template <typename T, typename... Params>
+struct std::coroutine_traits<kj::Promise<T>, Params...> {
+  using promise_type = kj::_::Coroutine<T>;
+};
+#endif
+
 #endif  // KJ_ASYNC_INL_H_
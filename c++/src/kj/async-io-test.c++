@@ -164,6 +164,50 @@ TEST(AsyncIo, TwoWayPipe) {
   EXPECT_EQ("bar", result2);
 }
 
+TEST(AsyncIo, IoUring) {
+  auto ioContext = setupAsyncIo(EventPortBackend::IO_URING);
+  if (!ioContext.unixEventPort.isUsingIoUring()) {
+    KJ_LOG(WARNING, "io_uring not available; skipping test");
+    return;
+  }
+  auto& network = ioContext.provider->getNetwork();
+
+  // Connect over TCP, which also exercises waitConnected().
+  auto listener = network.parseAddress("localhost").wait(ioContext.waitScope)->listen();
+  auto clientPromise = network.parseAddress("localhost", listener->getPort())
+      .then([](Own<NetworkAddress>&& addr) { return addr->connect(); });
+  auto server = listener->accept().wait(ioContext.waitScope);
+  auto client = clientPromise.wait(ioContext.waitScope);
+
+  // Send much more than fits in the socket buffers, so that writes complete partially.
+  auto data = heapArray<byte>(4 << 20);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = i * 7;
+  }
+  ArrayPtr<const byte> pieces[3] = {
+    data.slice(0, 1000), data.slice(1000, 1 << 20), data.slice(1 << 20, data.size())
+  };
+  auto writePromise = client->write(pieces);
+
+  auto received = heapArray<byte>(data.size());
+  server->read(received.begin(), received.size()).wait(ioContext.waitScope);
+  writePromise.wait(ioContext.waitScope);
+  EXPECT_TRUE(data.asPtr() == received.asPtr());
+
+  // A canceled read doesn't consume data.
+  char buffer[4];
+  {
+    auto canceled = server->tryRead(buffer, 3, 4);
+    ioContext.unixEventPort.poll();
+  }
+  client->write("foo", 3).wait(ioContext.waitScope);
+  EXPECT_EQ(3u, server->tryRead(buffer, 3, 4).wait(ioContext.waitScope));
+  EXPECT_EQ("foo", heapString(buffer, 3));
+
+  client->shutdownWrite();
+  EXPECT_EQ(0u, server->tryRead(buffer, 1, 4).wait(ioContext.waitScope));
+}
+
 TEST(AsyncIo, PipeThread) {
   auto ioContext = setupAsyncIo();
 
@@ -42,6 +42,14 @@
 #include <poll.h>
 #include <limits.h>
 
+#if defined(SO_REUSEPORT_LB)
+// FreeBSD 12+: plain SO_REUSEPORT only lets the last socket bound receive connections.
+#define KJ_SHARED_LISTEN_OPTION SO_REUSEPORT_LB
+#elif __linux__ && defined(SO_REUSEPORT)
+// Linux 3.9+ balances connections across all sockets bound with SO_REUSEPORT.
+#define KJ_SHARED_LISTEN_OPTION SO_REUSEPORT
+#endif
+
 namespace kj {
 
 namespace {
@@ -112,7 +120,11 @@ class AsyncStreamFd: public OwnedFileDescriptor, public AsyncIoStream {
 public:
   AsyncStreamFd(UnixEventPort& eventPort, int fd, uint flags)
       : OwnedFileDescriptor(fd, flags),
-        observer(eventPort, fd, UnixEventPort::FdObserver::OBSERVE_READ_WRITE) {}
+        eventPort(eventPort),
+        useRing(eventPort.isUsingIoUring()),
+        // With io_uring the kernel waits for readiness on our behalf, so readiness events would
+        // just be spurious wakeups.
+        observer(eventPort, fd, useRing ? 0 : UnixEventPort::FdObserver::OBSERVE_READ_WRITE) {}
   virtual ~AsyncStreamFd() noexcept(false) {}
 
   Promise<size_t> read(void* buffer, size_t minBytes, size_t maxBytes) override {
@@ -131,6 +143,10 @@ public:
   }
 
   Promise<void> write(const void* buffer, size_t size) override {
+    if (useRing) {
+      return writeRing(arrayPtr(reinterpret_cast<const byte*>(buffer), size), nullptr);
+    }
+
     ssize_t writeResult;
     KJ_NONBLOCKING_SYSCALL(writeResult = ::write(fd, buffer, size)) {
       // Error.
@@ -165,7 +181,9 @@ public:
 
   Promise<void> write(ArrayPtr<const ArrayPtr<const byte>> pieces) override {
     if (pieces.size() == 0) {
-      return writeInternal(nullptr, nullptr);
+      return useRing ? writeRing(nullptr, nullptr) : writeInternal(nullptr, nullptr);
+    } else if (useRing) {
+      return writeRing(pieces[0], pieces.slice(1, pieces.size()));
     } else {
       return writeInternal(pieces[0], pieces.slice(1, pieces.size()));
     }
@@ -208,6 +226,10 @@ public:
   Promise<void> waitConnected() {
     // Wait until initial connection has completed. This actually just waits until it is writable.
 
+    if (useRing) {
+      return eventPort.submitPoll(fd, POLLOUT);
+    }
+
     // Can't just go directly to writeObserver.whenBecomesWritable() because of edge triggering. We
     // need to explicitly check if the socket is already connected.
 
@@ -229,6 +251,8 @@ public:
   }
 
 private:
+  UnixEventPort& eventPort;
+  bool useRing;
   UnixEventPort::FdObserver observer;
 
   Promise<size_t> tryReadInternal(void* buffer, size_t minBytes, size_t maxBytes,
@@ -237,6 +261,10 @@ private:
     // maxBytes, and buffer have already been adjusted to account for them, but this count must
     // be included in the final return value.
 
+    if (useRing) {
+      return tryReadRing(buffer, minBytes, maxBytes, alreadyRead);
+    }
+
     ssize_t n;
     KJ_NONBLOCKING_SYSCALL(n = ::read(fd, buffer, maxBytes)) {
       // Error.
@@ -297,6 +325,52 @@ private:
     }
   }
 
+  Promise<size_t> tryReadRing(void* buffer, size_t minBytes, size_t maxBytes,
+                              size_t alreadyRead) {
+    // Like tryReadInternal(), but the read is queued on the io_uring, which waits for data itself.
+
+    return eventPort.submitRead(fd, buffer, maxBytes)
+        .then([=](size_t n) -> Promise<size_t> {
+      if (n == 0) {
+        // EOF -OR- maxBytes == 0.
+        return alreadyRead;
+      } else if (n >= minBytes) {
+        return alreadyRead + n;
+      } else {
+        return tryReadRing(reinterpret_cast<byte*>(buffer) + n,
+                           minBytes - n, maxBytes - n, alreadyRead + n);
+      }
+    });
+  }
+
+  Promise<void> writeRing(ArrayPtr<const byte> firstPiece,
+                          ArrayPtr<const ArrayPtr<const byte>> morePieces) {
+    // Like writeInternal(), but the write is queued on the io_uring, which waits for buffer
+    // space itself.
+
+    KJ_STACK_ARRAY(ArrayPtr<const byte>, pieces, 1 + morePieces.size(), 16, 128);
+    pieces[0] = firstPiece;
+    for (uint i = 0; i < morePieces.size(); i++) {
+      pieces[i + 1] = morePieces[i];
+    }
+
+    return eventPort.submitWrite(fd, pieces).then([=](size_t n) mutable -> Promise<void> {
+      // Discard all data that was written, then issue a new write for what's left (if any).
+      for (;;) {
+        if (n < firstPiece.size()) {
+          return writeRing(firstPiece.slice(n, firstPiece.size()), morePieces);
+        } else if (morePieces.size() == 0) {
+          KJ_DASSERT(n == firstPiece.size(), n);
+          return READY_NOW;
+        } else {
+          n -= firstPiece.size();
+          firstPiece = morePieces[0];
+          morePieces = morePieces.slice(1, morePieces.size());
+        }
+      }
+    });
+  }
+
   Promise<void> writeInternal(ArrayPtr<const byte> firstPiece,
                               ArrayPtr<const ArrayPtr<const byte>> morePieces) {
     const size_t iovmax = kj::miniposix::iovMax(1 + morePieces.size());
@@ -911,8 +985,8 @@ private:
 
 class LowLevelAsyncIoProviderImpl final: public LowLevelAsyncIoProvider {
 public:
-  LowLevelAsyncIoProviderImpl()
-      : eventLoop(eventPort), timer(eventPort), waitScope(eventLoop) {}
+  explicit LowLevelAsyncIoProviderImpl(EventPortBackend backend = EventPortBackend::DEFAULT)
+      : eventPort(backend), eventLoop(eventPort), timer(eventPort), waitScope(eventLoop) {}
 
   inline WaitScope& getWaitScope() { return waitScope; }
 
@@ -969,6 +1043,18 @@ public:
   }
 
   Own<ConnectionReceiver> listen() override {
+    return listenImpl(false);
+  }
+
+  Own<ConnectionReceiver> listenShared() override {
+#ifdef KJ_SHARED_LISTEN_OPTION
+    return listenImpl(true);
+#else
+    KJ_UNIMPLEMENTED("Load-balanced shared listening sockets are not supported on this platform.");
+#endif
+  }
+
+  Own<ConnectionReceiver> listenImpl(bool reusePort) {
     if (addrs.size() > 1) {
       KJ_LOG(WARNING, "Bind address resolved to multiple addresses.  Only the first address will "
           "be used.  If this is incorrect, specify the address numerically.  This may be fixed "
@@ -985,6 +1071,12 @@ public:
       int optval = 1;
       KJ_SYSCALL(setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)));
 
+#ifdef KJ_SHARED_LISTEN_OPTION
+      if (reusePort) {
+        KJ_SYSCALL(setsockopt(fd, SOL_SOCKET, KJ_SHARED_LISTEN_OPTION, &optval, sizeof(optval)));
+      }
+#endif
+
       addrs[0].bind(fd);
 
       // TODO(someday):  Let queue size be specified explicitly in string addresses.
@@ -1378,6 +1470,9 @@ void DatagramPort::getsockopt(int level, int option, void* value, uint* length)
 void DatagramPort::setsockopt(int level, int option, const void* value, uint length) {
   KJ_UNIMPLEMENTED("Not a socket.");
 }
+Own<ConnectionReceiver> NetworkAddress::listenShared() {
+  KJ_UNIMPLEMENTED("Shared listening not implemented.");
+}
 Own<DatagramPort> NetworkAddress::bindDatagramPort() {
   KJ_UNIMPLEMENTED("Datagram sockets not implemented.");
 }
@@ -1390,7 +1485,11 @@ Own<AsyncIoProvider> newAsyncIoProvider(LowLevelAsyncIoProvider& lowLevel) {
 }
 
 AsyncIoContext setupAsyncIo() {
-  auto lowLevel = heap<LowLevelAsyncIoProviderImpl>();
+  return setupAsyncIo(EventPortBackend::DEFAULT);
+}
+
+AsyncIoContext setupAsyncIo(EventPortBackend backend) {
+  auto lowLevel = heap<LowLevelAsyncIoProviderImpl>(backend);
   auto ioProvider = kj::heap<AsyncIoProviderImpl>(*lowLevel);
   auto& waitScope = lowLevel->getWaitScope();
   auto& eventPort = lowLevel->getEventPort();
@@ -36,6 +36,7 @@ struct sockaddr;
 namespace kj {
 
 class UnixEventPort;
+enum class EventPortBackend;
 class NetworkAddress;
 
 // =======================================================================================
@@ -238,6 +239,13 @@ public:
   //
   // The address must be local.
 
+  virtual Own<ConnectionReceiver> listenShared();
+  // Like listen(), but allows several listeners -- typically one per thread, each with its own
+  // event loop -- to listen on the same address at once, with the operating system spreading
+  // incoming connections among them.  This uses SO_REUSEPORT on Linux and SO_REUSEPORT_LB on
+  // FreeBSD.  Elsewhere (including macOS and the other BSDs, whose SO_REUSEPORT does not balance
+  // connections) it throws UNIMPLEMENTED.
+
   virtual Own<DatagramPort> bindDatagramPort();
   // Open this address as a datagram (e.g. UDP) port.
   //
@@ -473,6 +481,11 @@ AsyncIoContext setupAsyncIo();
 //   note that this means that server processes which daemonize themselves at startup must wait
 //   until after daemonization to create an AsyncIoContext.
 
+AsyncIoContext setupAsyncIo(EventPortBackend backend);
+// Like setupAsyncIo(), but selects the kernel event interface. See EventPortBackend in
+// async-unix.h; in particular, EventPortBackend::IO_URING falls back to the default if io_uring is
+// unavailable.
+
 // =======================================================================================
 // inline implementation details
 
@@ -31,6 +31,17 @@
 
 #include "exception.h"
 
+#if __cplusplus > 201703L && defined(__cpp_impl_coroutine) && \
+    (defined(__clang__) || !defined(__GNUC__) || __GNUC__ >= 13)
+// Compiling as C++20 with coroutine support, so Promise<T> can be a coroutine return type.  See
+// "Coroutines" in async.h.  (GCC 12 and earlier hit an internal compiler error on any coroutine
+// whose return type has a potentially-throwing destructor, as Promise<T> does.)
+#include <coroutine>
+#define KJ_HAS_COROUTINE 1
+#else
+#define KJ_HAS_COROUTINE 0
+#endif
+
 namespace kj {
 
 class EventLoop;
@@ -164,6 +175,23 @@ class TaskSetImpl;
 
 class Event;
 
+class XThreadEvent;
+
+#if KJ_HAS_COROUTINE
+template <typename T>
+class Coroutine;
+template <typename T>
+class PromiseAwaiter;
+#endif
+
+void* allocPromiseNodeSpace(size_t size);
+void freePromiseNodeSpace(void* space, size_t size);
+// Space for promise nodes and events; see allocPromiseNode() in async-inl.h.
+
+size_t promiseNodeHeapAllocations();
+// Number of times allocPromiseNodeSpace() has had to call the global allocator while the current
+// thread's EventLoop was current, for tests which check that steady-state code doesn't.
+
 class PromiseBase {
 public:
   kj::String trace();
@@ -180,6 +208,10 @@ private:
   template <typename>
   friend class kj::Promise;
   friend class TaskSetImpl;
+#if KJ_HAS_COROUTINE
+  template <typename>
+  friend class Coroutine;
+#endif
   template <typename U>
   friend Promise<Array<U>> kj::joinPromises(Array<Promise<U>>&& promises);
   friend Promise<void> kj::joinPromises(Array<Promise<void>>&& promises);
@@ -0,0 +1,182 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "async-stats.h"
+#include "debug.h"
+#include "test.h"
+#include <unistd.h>
+
+namespace kj {
+namespace {
+
+KJ_TEST("HistogramRecorder buckets") {
+  KJ_EXPECT(HistogramRecorder::bucketFor(0) == 0);
+  KJ_EXPECT(HistogramRecorder::bucketFor(7) == 7);
+  KJ_EXPECT(HistogramRecorder::bucketFor(8) == 8);
+  KJ_EXPECT(HistogramRecorder::bucketFor(kj::maxValue) == HistogramRecorder::BUCKET_COUNT - 1);
+
+  // Eight buckets per power of two: bucket 32 covers [64, 72) and bucket 40 covers [128, 144).
+  KJ_EXPECT(Histogram::bucketLowerBound(7) == 7);
+  KJ_EXPECT(Histogram::bucketLowerBound(32) == 64);
+  KJ_EXPECT(Histogram::bucketLowerBound(33) == 72);
+  KJ_EXPECT(Histogram::bucketLowerBound(40) == 128);
+  KJ_EXPECT(Histogram::bucketLowerBound(41) == 144);
+
+  for (uint64_t value = 0; value < (uint64_t(1) << 40); value = value * 9 / 8 + 1) {
+    uint bucket = HistogramRecorder::bucketFor(value);
+    uint64_t lower = Histogram::bucketLowerBound(bucket);
+    uint64_t upper = Histogram::bucketLowerBound(bucket + 1);
+    KJ_EXPECT(lower <= value && value < upper, value, lower, upper);
+    KJ_EXPECT((upper - lower) * 8 <= kj::max(lower, uint64_t(8)), value, lower, upper);
+  }
+}
+
+KJ_TEST("Histogram percentiles") {
+  Histogram histogram;
+  histogram.buckets = heapArray<uint64_t>(HistogramRecorder::BUCKET_COUNT);
+  for (auto& bucket: histogram.buckets) bucket = 0;
+
+  KJ_EXPECT(histogram.percentile(0.5) == 0);
+
+  histogram.buckets[32] = 99;
+  histogram.buckets[40] = 1;
+  histogram.count = 100;
+
+  KJ_EXPECT(histogram.percentile(0.5) == 71);
+  KJ_EXPECT(histogram.percentile(0.99) == 71);
+  KJ_EXPECT(histogram.percentile(1) == 143);
+}
+
+KJ_TEST("HistogramRecorder") {
+  HistogramRecorder recorder;
+  for (uint64_t value = 1; value <= 1000; value++) {
+    recorder.record(value * 1000);
+  }
+
+  auto histogram = recorder.read();
+  KJ_EXPECT(histogram.buckets.size() == HistogramRecorder::BUCKET_COUNT);
+  KJ_EXPECT(histogram.count == 1000);
+  KJ_EXPECT(histogram.sum == 500500000);
+
+  uint64_t median = histogram.percentile(0.5);
+  KJ_EXPECT(500000 <= median && median <= 500000 * 9 / 8, median);
+
+  uint64_t p99 = histogram.percentile(0.99);
+  KJ_EXPECT(990000 <= p99 && p99 <= 990000 * 9 / 8, p99);
+
+  uint64_t max = histogram.percentile(1);
+  KJ_EXPECT(1000000 <= max && max <= 1000000 * 9 / 8, max);
+}
+
+KJ_TEST("systemSteadyTime") {
+  TimePoint start = systemSteadyTime();
+  usleep(10000);
+  Duration elapsed = systemSteadyTime() - start;
+  KJ_EXPECT(elapsed >= 10 * MILLISECONDS, elapsed / NANOSECONDS);
+}
+
+KJ_TEST("EventLoopStats counts turns and wakeups") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  EventLoopStats stats;
+  loop.setStats(stats);
+
+  uint count = 0;
+  auto promise = evalLater([&]() { ++count; })
+      .then([&]() { ++count; })
+      .eagerlyEvaluate(nullptr);
+  loop.run();
+  KJ_EXPECT(count == 2);
+
+  auto snapshot = stats.snapshot();
+  KJ_EXPECT(snapshot.turnNanos.count >= 1);
+  KJ_EXPECT(snapshot.turnsPerWakeup.count == 1);
+  KJ_EXPECT(snapshot.turnsPerWakeup.sum == snapshot.turnNanos.count);
+  KJ_EXPECT(snapshot.longestTurnNanos <= snapshot.turnNanos.sum);
+  KJ_EXPECT(snapshot.stalls == 0);
+  uint64_t turns = snapshot.turnNanos.count;
+
+  // Running an empty queue is not a wakeup.
+  loop.run();
+  KJ_EXPECT(stats.snapshot().turnsPerWakeup.count == 1);
+
+  promise = evalLater([&]() { ++count; }).eagerlyEvaluate(nullptr);
+  loop.run();
+  KJ_EXPECT(count == 3);
+  snapshot = stats.snapshot();
+  KJ_EXPECT(snapshot.turnsPerWakeup.count == 2);
+  KJ_EXPECT(snapshot.turnNanos.count > turns);
+  turns = snapshot.turnNanos.count;
+
+  loop.setStats(nullptr);
+  promise = evalLater([&]() { ++count; }).eagerlyEvaluate(nullptr);
+  loop.run();
+  KJ_EXPECT(count == 4);
+  snapshot = stats.snapshot();
+  KJ_EXPECT(snapshot.turnsPerWakeup.count == 2);
+  KJ_EXPECT(snapshot.turnNanos.count == turns);
+}
+
+class LogCapture: public ExceptionCallback {
+public:
+  void logMessage(LogSeverity severity, const char* file, int line, int contextDepth,
+                  String&& text) override {
+    if (severity == LogSeverity::WARNING) {
+      warnings.add(kj::mv(text));
+    } else {
+      ExceptionCallback::logMessage(severity, file, line, contextDepth, kj::mv(text));
+    }
+  }
+
+  Vector<String> warnings;
+};
+
+KJ_TEST("EventLoopStats logs stalls") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  EventLoopStats stats(10 * MILLISECONDS);
+  KJ_EXPECT(stats.getStallThreshold() == 10 * MILLISECONDS);
+  loop.setStats(stats);
+
+  LogCapture logs;
+  auto promise = evalLater([]() {})
+      .then([]() { usleep(50000); })
+      .eagerlyEvaluate(nullptr);
+  loop.run();
+
+  auto snapshot = stats.snapshot();
+  KJ_EXPECT(snapshot.stalls == 1);
+  KJ_EXPECT(snapshot.longestTurnNanos >= 50000000, snapshot.longestTurnNanos);
+  KJ_EXPECT(snapshot.turnNanos.percentile(1) >= 50000000);
+
+  KJ_ASSERT(logs.warnings.size() == 1);
+  auto& warning = logs.warnings[0];
+  KJ_EXPECT(_::hasSubstring(warning, "event loop stalled"), warning);
+#if !KJ_NO_RTTI
+  // The trace names the offending callback.
+  KJ_EXPECT(_::hasSubstring(warning, "TransformPromiseNode"), warning);
+#endif
+}
+
+}  // namespace
+}  // namespace kj
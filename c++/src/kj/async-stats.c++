@@ -0,0 +1,109 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "async-stats.h"
+#include "debug.h"
+
+namespace kj {
+
+constexpr uint HistogramRecorder::BUCKET_COUNT;
+
+uint64_t Histogram::percentile(double fraction) const {
+  if (count == 0) return 0;
+
+  // The rank of the value we're looking for, counting from 1.
+  uint64_t rank = kj::max(uint64_t(fraction * count + 0.5), uint64_t(1));
+
+  uint64_t seen = 0;
+  for (uint i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return bucketLowerBound(i + 1) - 1;
+    }
+  }
+  return bucketLowerBound(buckets.size()) - 1;
+}
+
+uint64_t Histogram::bucketLowerBound(uint bucket) {
+  constexpr uint SUB_BUCKET_BITS = HistogramRecorder::SUB_BUCKET_BITS;
+  if (bucket < (1u << SUB_BUCKET_BITS)) return bucket;
+  uint shift = (bucket >> SUB_BUCKET_BITS) - 1;
+  uint subBucket = bucket & ((1u << SUB_BUCKET_BITS) - 1);
+  return uint64_t((1u << SUB_BUCKET_BITS) + subBucket) << shift;
+}
+
+Histogram HistogramRecorder::read() const {
+  Histogram result;
+  result.buckets = heapArray<uint64_t>(BUCKET_COUNT);
+  for (uint i = 0; i < BUCKET_COUNT; i++) {
+    result.buckets[i] = buckets[i].get();
+    result.count += result.buckets[i];
+  }
+  result.sum = sum.get();
+  return result;
+}
+
+// =======================================================================================
+
+EventLoopStats::EventLoopStats(Duration stallThreshold)
+    : stallThresholdNanos(stallThreshold / NANOSECONDS) {
+  KJ_REQUIRE(stallThreshold > 0 * NANOSECONDS, "stall threshold must be positive");
+}
+
+EventLoopStats::~EventLoopStats() noexcept(false) {}
+
+EventLoopStats::Snapshot EventLoopStats::snapshot() const {
+  Snapshot result;
+  result.turnNanos = turns.read();
+  result.turnsPerWakeup = wakeups.read();
+  result.stalls = stalls.get();
+  result.longestTurnNanos = longestTurnNanos.get();
+  return result;
+}
+
+Duration EventLoopStats::getStallThreshold() const {
+  return stallThresholdNanos * NANOSECONDS;
+}
+
+bool EventLoopStats::recordTurn(uint64_t nanos) {
+  turns.record(nanos);
+  ++turnsThisWakeup;
+
+  if (nanos > longestTurnNanos.get()) {
+    longestTurnNanos.set(nanos);
+  }
+
+  if (nanos >= stallThresholdNanos) {
+    stalls.add(1);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+void EventLoopStats::endWakeup() {
+  if (turnsThisWakeup > 0) {
+    wakeups.record(turnsThisWakeup);
+    turnsThisWakeup = 0;
+  }
+}
+
+}  // namespace kj
@@ -0,0 +1,163 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef KJ_ASYNC_STATS_H_
+#define KJ_ASYNC_STATS_H_
+
+#if defined(__GNUC__) && !KJ_HEADER_WARNINGS
+#pragma GCC system_header
+#endif
+
+#include "async.h"
+#include "time.h"
+
+namespace kj {
+
+class StatsCounter {
+  // A 64-bit value written by one thread and read by any thread.  Updates are a relaxed load
+  // followed by a relaxed store rather than an atomic read-modify-write, so they cost about the
+  // same as a plain increment; this is only correct because there is a single writer.
+
+public:
+  inline uint64_t get() const { return __atomic_load_n(&value, __ATOMIC_RELAXED); }
+  inline void set(uint64_t n) { __atomic_store_n(&value, n, __ATOMIC_RELAXED); }
+  inline void add(uint64_t n) { set(get() + n); }
+
+private:
+  uint64_t value = 0;
+};
+
+struct Histogram {
+  // A snapshot of a `HistogramRecorder`.
+
+  Array<uint64_t> buckets;
+  // Count of values recorded in each bucket.  Bucket `i` covers the range from
+  // `bucketLowerBound(i)` up to, but not including, `bucketLowerBound(i + 1)`.
+
+  uint64_t count = 0;
+  uint64_t sum = 0;
+
+  uint64_t percentile(double fraction) const;
+  // Returns an upper bound on the value below which `fraction` (between 0 and 1) of recorded
+  // values fall.  The bound is within 1/8 of the true value.  Returns 0 if nothing was
+  // recorded.
+
+  static uint64_t bucketLowerBound(uint bucket);
+};
+
+class HistogramRecorder {
+  // Histogram of unsigned values, such as durations in nanoseconds.  Like HdrHistogram, each
+  // power of two is split into 2^SUB_BUCKET_BITS linear buckets, so a bucket is never wider than
+  // 1/8 of its lower bound, and recording is a couple of shifts and one counter update.  Like
+  // StatsCounter, it may have only one writer, but `read()` may be called from any thread.
+
+public:
+  static constexpr uint SUB_BUCKET_BITS = 3;
+  static constexpr uint MAX_BITS = 40;
+  // Values of 2^40 or more (in nanoseconds, about 18 minutes) are all recorded in the last
+  // bucket.
+
+  static constexpr uint BUCKET_COUNT = (MAX_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+  static inline uint bucketFor(uint64_t value) {
+    if (value < (1u << SUB_BUCKET_BITS)) return value;
+    if (value >> MAX_BITS) return BUCKET_COUNT - 1;
+    uint exponent = 63 - countLeadingZeros(value);
+    uint shift = exponent - SUB_BUCKET_BITS;
+    return ((shift + 1) << SUB_BUCKET_BITS) + ((value >> shift) & ((1u << SUB_BUCKET_BITS) - 1));
+  }
+
+  inline void record(uint64_t value) {
+    buckets[bucketFor(value)].add(1);
+    sum.add(value);
+  }
+
+  Histogram read() const;
+
+private:
+  StatsCounter buckets[BUCKET_COUNT];
+  StatsCounter sum;
+};
+
+class EventLoopStats {
+  // Turn timings for an `EventLoop`, for finding callbacks that hog the loop.  A single slow
+  // callback delays every other event on the loop, and otherwise tends to show up only as
+  // timeouts somewhere else.  Collection is off unless an EventLoopStats is attached with
+  // `EventLoop::setStats()`.  While off, the loop pays one null check per event; while on, each
+  // event costs two reads of the monotonic clock, a walk down the event's promise chain (so that
+  // a stall can be traced), and a few counter updates.
+  //
+  // Each event the loop fires is one "turn".  Every turn is timed and recorded in a histogram.
+  // A turn which runs for at least the stall threshold is also counted and logged as a warning,
+  // together with a trace of the event that ran (as in `Promise::trace()`), so that the
+  // offending callback can be identified.
+  //
+  // The loop also counts "wakeups".  A wakeup begins when the loop finds work after having run
+  // out of it, and ends the next time the loop finds its queue empty.  The number of turns in
+  // each wakeup is recorded in a second histogram.
+  //
+  // An EventLoopStats may be attached to only one EventLoop at a time, and must stay alive for as
+  // long as it is attached.  `snapshot()` may be called from any thread at any time.
+
+public:
+  explicit EventLoopStats(Duration stallThreshold = 100 * MILLISECONDS);
+  ~EventLoopStats() noexcept(false);
+  KJ_DISALLOW_COPY(EventLoopStats);
+
+  struct Snapshot {
+    Histogram turnNanos;
+    // Duration of each turn, in nanoseconds.  `turnNanos.count` is the number of turns.
+
+    Histogram turnsPerWakeup;
+    // Number of turns run in each completed wakeup.  `turnsPerWakeup.count` is the number of
+    // wakeups.
+
+    uint64_t stalls;
+    // Turns which ran for at least the stall threshold.
+
+    uint64_t longestTurnNanos;
+  };
+
+  Snapshot snapshot() const;
+
+  Duration getStallThreshold() const;
+
+private:
+  uint64_t stallThresholdNanos;
+
+  HistogramRecorder turns;
+  HistogramRecorder wakeups;
+  StatsCounter stalls;
+  StatsCounter longestTurnNanos;
+
+  uint64_t turnsThisWakeup = 0;
+  // Only touched by the loop's thread.
+
+  bool recordTurn(uint64_t nanos);
+  // Returns true if the turn stalled the loop, in which case the loop logs it.
+  void endWakeup();
+
+  friend class EventLoop;
+};
+
+}  // namespace kj
+
+#endif  // KJ_ASYNC_STATS_H_
@@ -607,6 +607,45 @@ TEST(Async, TaskSet) {
   EXPECT_EQ(1u, errorHandler.exceptionCount);
 }
 
+TEST(Async, TaskSetManyTasks) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ErrorHandlerImpl errorHandler;
+
+  {
+    TaskSet tasks(errorHandler);
+
+    // Complete tasks in an order unrelated to the order they were added, so that removals come
+    // from all over the list.
+    constexpr uint COUNT = 1000;
+    auto fulfillers = heapArrayBuilder<Own<PromiseFulfiller<void>>>(COUNT);
+    for (uint i = 0; i < COUNT; i++) {
+      auto paf = newPromiseAndFulfiller<void>();
+      tasks.add(kj::mv(paf.promise));
+      fulfillers.add(kj::mv(paf.fulfiller));
+    }
+    for (uint i = 0; i < COUNT; i++) {
+      auto& fulfiller = fulfillers[i * 7 % COUNT];
+      if (i % 10 == 0) {
+        fulfiller->reject(KJ_EXCEPTION(FAILED, "example TaskSet failure"));
+      } else {
+        fulfiller->fulfill();
+      }
+    }
+
+    evalLater([]() {}).wait(waitScope);
+    EXPECT_EQ(COUNT / 10, errorHandler.exceptionCount);
+  }
+
+  {
+    // Destroying a set with lots of pending tasks doesn't recurse through the list.
+    TaskSet tasks(errorHandler);
+    for (uint i = 0; i < 200000; i++) {
+      tasks.add(kj::NEVER_DONE);
+    }
+  }
+}
+
 class DestructorDetector {
 public:
   DestructorDetector(bool& setTrue): setTrue(setTrue) {}
@@ -735,5 +774,169 @@ TEST(Async, SetRunnable) {
   }
 }
 
+TEST(Async, PromiseNodeAllocation) {
+  // Once the EventLoop's free lists are warmed up, chaining promises shouldn't call the global
+  // allocator for nodes at all.
+
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  auto run = [&]() {
+    auto paf = newPromiseAndFulfiller<int>();
+    auto promise = evalLater([]() { return 1; })
+        .then([](int i) { return evalLater([i]() { return i + 1; }); })
+        .attach(123)
+        .exclusiveJoin(kj::mv(paf.promise))
+        .then([](int i) { return i * 2; })
+        .eagerlyEvaluate(nullptr);
+    return promise.wait(waitScope);
+  };
+
+  EXPECT_EQ(4, run());
+
+  const uint iterations = 10000;
+  size_t before = _::promiseNodeHeapAllocations();
+  for (uint i = 0; i < iterations; i++) {
+    run();
+  }
+  size_t allocations = _::promiseNodeHeapAllocations() - before;
+
+  KJ_LOG(INFO, "heap allocations for promise chains", iterations, allocations);
+  EXPECT_EQ(0u, allocations);
+}
+
+TEST(Async, PromiseNodeCacheLimit) {
+  // The free lists hold a bounded number of bytes, so space for more nodes than that, freed all at
+  // once, mostly goes back to the heap.
+
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  const uint count = 10000;
+  auto makePromises = [&]() {
+    Vector<Promise<void>> promises(count);
+    for (uint i = 0; i < count; i++) {
+      promises.add(evalLater([]() {}));
+    }
+  };
+
+  size_t before = _::promiseNodeHeapAllocations();
+  makePromises();
+  size_t cold = _::promiseNodeHeapAllocations() - before;
+
+  before = _::promiseNodeHeapAllocations();
+  makePromises();
+  size_t warm = _::promiseNodeHeapAllocations() - before;
+
+  EXPECT_GT(warm, 0u);
+  EXPECT_LT(warm, cold);
+}
+
+#if KJ_HAS_COROUTINE
+
+Promise<int> coroutineSum(Promise<int> a, Promise<int> b) {
+  int x = co_await a;
+  int y = co_await kj::mv(b);
+  co_return x + y;
+}
+
+Promise<void> coroutineCount(uint n, uint& counter) {
+  for (uint i = 0; i < n; i++) {
+    counter += co_await evalLater([]() { return 1; });
+  }
+}
+
+TEST(Async, Coroutine) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  EXPECT_EQ(5, coroutineSum(evalLater([]() { return 2; }), 3).wait(waitScope));
+
+  uint counter = 0;
+  auto promise = coroutineCount(10, counter);
+  EXPECT_EQ(0u, counter);
+  promise.wait(waitScope);
+  EXPECT_EQ(10u, counter);
+}
+
+Promise<void> coroutineAdd(Promise<int> a, Promise<int> b, int& result) {
+  result = co_await a + co_await b;
+}
+
+TEST(Async, CoroutineReady) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  // Awaiting a promise that's already resolved doesn't suspend, so this coroutine finishes
+  // without the event loop running.
+  auto paf = newPromiseAndFulfiller<int>();
+  paf.fulfiller->fulfill(2);
+  int result = 0;
+  auto promise = coroutineAdd(kj::mv(paf.promise), 3, result);
+  EXPECT_EQ(5, result);
+  promise.wait(waitScope);
+
+  result = 0;
+  promise = coroutineAdd(evalLater([]() { return 2; }), 3, result);
+  EXPECT_EQ(0, result);
+  promise.wait(waitScope);
+  EXPECT_EQ(5, result);
+}
+
+TEST(Async, CoroutineException) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  // An exception from an awaited promise is thrown into the coroutine, and one escaping the
+  // coroutine rejects its promise.
+  auto promise = coroutineSum(Promise<int>(KJ_EXCEPTION(FAILED, "foo")), 3);
+  KJ_EXPECT_THROW_MESSAGE("foo", promise.wait(waitScope));
+
+  auto catcher = [](Promise<int> inner) -> Promise<int> {
+    try {
+      co_return co_await inner;
+    } catch (const Exception& e) {
+      co_return 123;
+    }
+  };
+  EXPECT_EQ(123, catcher(Promise<int>(KJ_EXCEPTION(FAILED, "foo"))).wait(waitScope));
+}
+
+TEST(Async, CoroutineCancel) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  // Dropping the coroutine's promise destroys it while suspended, which cancels what it awaits.
+  bool destroyed = false;
+  auto paf = newPromiseAndFulfiller<int>();
+  {
+    auto promise = coroutineSum(paf.promise.attach(kj::defer([&]() { destroyed = true; })), 1);
+    evalLater([]() {}).wait(waitScope);
+    EXPECT_FALSE(destroyed);
+  }
+  EXPECT_TRUE(destroyed);
+  EXPECT_FALSE(paf.fulfiller->isWaiting());
+}
+
+TEST(Async, CoroutineAllocation) {
+  // A coroutine allocates just its frame, from the same free lists as promise nodes, so once
+  // those are warm a coroutine with many steps doesn't touch the global allocator.
+
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  uint counter = 0;
+  coroutineCount(10, counter).wait(waitScope);
+
+  size_t before = _::promiseNodeHeapAllocations();
+  for (uint i = 0; i < 1000; i++) {
+    coroutineCount(10, counter).wait(waitScope);
+  }
+  EXPECT_EQ(before, _::promiseNodeHeapAllocations());
+  EXPECT_EQ(10010u, counter);
+}
+
+#endif  // KJ_HAS_COROUTINE
+
 }  // namespace
 }  // namespace kj
@@ -23,12 +23,14 @@
 #include "thread.h"
 #include "debug.h"
 #include "io.h"
+#include "mutex.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <kj/compat/gtest.h>
 #include <pthread.h>
 #include <algorithm>
@@ -553,6 +555,75 @@ TEST(AsyncUnixTest, SteadyTimers) {
   }
 }
 
+TEST(AsyncUnixTest, ManyTimers) {
+  // Timers spread over several wheel slots and levels, some canceled, fire in time order and
+  // never early.
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  auto start = port.steadyTime();
+  kj::Vector<TimePoint> fired;
+  kj::Vector<Promise<void>> promises;
+  uint expectedCount = 0;
+
+  for (uint i = 0; i < 600; i++) {
+    // Delays from -5ms to ~150ms in uneven steps, so that many share a tick and some land past
+    // the first 64-tick block.
+    TimePoint time = start + (int(i * 7919 % 1550) - 50) * 100 * MICROSECONDS;
+    auto promise = port.atSteadyTime(time).then([&port,&fired,time]() {
+      KJ_EXPECT(time <= port.steadyTime());
+      fired.add(time);
+    }).eagerlyEvaluate([](Exception&& e) { ADD_FAILURE() << str(e).cStr(); });
+    if (i % 3 == 0) {
+      // Leave this one canceled.
+    } else {
+      promises.add(kj::mv(promise));
+      ++expectedCount;
+    }
+  }
+
+  // Timers far in the future are only cascaded, not fired.
+  auto farFuture = port.atSteadyTime(start + 1000 * SECONDS);
+  auto farFuture2 = port.atSteadyTime(start + 10 * SECONDS);
+
+  port.atSteadyTime(start + 200 * MILLISECONDS).wait(waitScope);
+
+  ASSERT_EQ(expectedCount, fired.size());
+  for (uint i = 1; i < fired.size(); i++) {
+    KJ_EXPECT(fired[i - 1] <= fired[i], i);
+  }
+}
+
+TEST(AsyncUnixTest, FarFutureTimers) {
+  // Timers at the far end of what a TimePoint can represent land in the top wheel level rather
+  // than past it, and don't disturb nearer timers.
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  auto start = port.steadyTime();
+  auto latest = origin<TimePoint>() + int64_t(kj::maxValue) * NANOSECONDS;
+
+  bool farFired = false;
+  auto farFuture = port.atSteadyTime(latest).then([&]() { farFired = true; })
+      .eagerlyEvaluate(nullptr);
+  auto farFuture2 = port.atSteadyTime(start + 200 * 365 * DAYS).then([&]() { farFired = true; })
+      .eagerlyEvaluate(nullptr);
+  auto farFuture3 = port.atSteadyTime(latest - 1 * MILLISECONDS).then([&]() { farFired = true; })
+      .eagerlyEvaluate(nullptr);
+
+  port.atSteadyTime(start + 10 * MILLISECONDS).wait(waitScope);
+  EXPECT_FALSE(farFired);
+
+  // Canceling them works too.
+  farFuture2 = nullptr;
+  port.atSteadyTime(start + 20 * MILLISECONDS).wait(waitScope);
+  EXPECT_FALSE(farFired);
+}
+
 TEST(AsyncUnixTest, Wake) {
   captureSignals();
   UnixEventPort port;
@@ -582,4 +653,207 @@ TEST(AsyncUnixTest, Wake) {
   EXPECT_TRUE(port.wait());
 }
 
+TEST(AsyncUnixTest, IoUringBackend) {
+  captureSignals();
+  UnixEventPort port(EventPortBackend::IO_URING);
+  if (!port.isUsingIoUring()) {
+    KJ_LOG(WARNING, "io_uring not available; skipping test");
+    return;
+  }
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  // Signals, wakeups, and timers still work when the epoll FD is itself polled via the ring.
+  EXPECT_FALSE(port.poll());
+  port.wake();
+  EXPECT_TRUE(port.poll());
+  EXPECT_FALSE(port.poll());
+
+  kill(getpid(), SIGURG);
+  EXPECT_EQ(SIGURG, port.onSignal(SIGURG).wait(waitScope).si_signo);
+
+  auto start = port.steadyTime();
+  port.atSteadyTime(start + 10 * MILLISECONDS).wait(waitScope);
+  KJ_EXPECT(start + 10 * MILLISECONDS <= port.steadyTime());
+
+  int pipefds[2];
+  KJ_SYSCALL(pipe2(pipefds, O_CLOEXEC | O_NONBLOCK));
+  kj::AutoCloseFd infd(pipefds[0]), outfd(pipefds[1]);
+
+  // A read is only satisfied once data arrives.
+  char buffer[16];
+  bool done = false;
+  auto promise = port.submitRead(infd, buffer, sizeof(buffer)).then([&](size_t n) {
+    done = true;
+    return n;
+  });
+  port.poll();
+  loop.run();
+  EXPECT_FALSE(done);
+  KJ_SYSCALL(write(outfd, "foo", 3));
+  EXPECT_EQ(3u, promise.wait(waitScope));
+  EXPECT_EQ("foo", heapString(buffer, 3));
+
+  // Destroying a pending read cancels it, so that later data goes to the next read.
+  {
+    char otherBuffer[16];
+    auto canceled = port.submitRead(infd, otherBuffer, sizeof(otherBuffer));
+    port.poll();
+  }
+  KJ_SYSCALL(write(outfd, "bar", 3));
+  EXPECT_EQ(3u, port.submitRead(infd, buffer, sizeof(buffer)).wait(waitScope));
+  EXPECT_EQ("bar", heapString(buffer, 3));
+
+  // Writes report how much was written, and polls resolve when ready.
+  ArrayPtr<const byte> pieces[2] = { StringPtr("ba").asBytes(), StringPtr("z").asBytes() };
+  EXPECT_EQ(3u, port.submitWrite(outfd, pieces).wait(waitScope));
+  port.submitPoll(infd, POLLIN).wait(waitScope);
+  EXPECT_EQ(3u, port.submitRead(infd, buffer, sizeof(buffer)).wait(waitScope));
+  EXPECT_EQ("baz", heapString(buffer, 3));
+
+  // Closing the write end gives EOF.
+  outfd = nullptr;
+  EXPECT_EQ(0u, port.submitRead(infd, buffer, sizeof(buffer)).wait(waitScope));
+}
+
+TEST(AsyncUnixTest, Executor) {
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  MutexGuarded<Maybe<Own<const Executor>>> workerExecutor;
+  Own<PromiseFulfiller<void>> stopWorker;
+  pthread_t workerThread;
+
+  Thread thread([&]() {
+    UnixEventPort port;
+    EventLoop loop(port);
+    WaitScope waitScope(loop);
+
+    auto paf = newPromiseAndFulfiller<void>();
+    stopWorker = kj::mv(paf.fulfiller);
+    workerThread = pthread_self();
+    *workerExecutor.lockExclusive() = loop.getExecutor().addRef();
+
+    paf.promise.wait(waitScope);
+  });
+
+  Own<const Executor> executor;
+  for (;;) {
+    KJ_IF_MAYBE(e, *workerExecutor.lockExclusive()) {
+      executor = kj::mv(*e);
+      break;
+    }
+    delay();
+  }
+
+  // A plain value.
+  pthread_t ranOn = pthread_self();
+  EXPECT_EQ(123, executor->executeAsync([&]() {
+    ranOn = pthread_self();
+    return 123;
+  }).wait(waitScope));
+  EXPECT_TRUE(pthread_equal(ranOn, workerThread));
+
+  // A promise, which is waited on by the worker.
+  EXPECT_EQ("foo", executor->executeAsync([]() {
+    return evalLater([]() { return kj::str("foo"); });
+  }).wait(waitScope));
+
+  // An exception.
+  EXPECT_ANY_THROW(executor->executeAsync([]() -> int {
+    KJ_FAIL_ASSERT("bar");
+  }).wait(waitScope));
+
+  // Lots of calls at once complete in order.
+  {
+    uint counter = 0;
+    auto promises = heapArrayBuilder<Promise<uint>>(1000);
+    for (uint i = 0; i < 1000; i++) {
+      promises.add(executor->executeAsync([&counter]() { return counter++; }));
+    }
+    auto results = joinPromises(promises.finish()).wait(waitScope);
+    for (uint i = 0; i < results.size(); i++) {
+      EXPECT_EQ(i, results[i]);
+    }
+  }
+
+  // A dropped promise doesn't wedge anything.
+  {
+    auto dropped = executor->executeAsync([]() {});
+  }
+
+  // Work queued on our own loop runs too.
+  EXPECT_EQ(5, loop.getExecutor().executeAsync([]() { return 5; }).wait(waitScope));
+
+  executor->executeAsync([&]() { stopWorker->fulfill(); }).wait(waitScope);
+}
+
+TEST(AsyncUnixTest, ExecutorManyThreads) {
+  // Several threads hammer one loop's Executor at once.
+
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  const uint THREADS = 4;
+  const uint CALLS = 500;
+
+  auto& executor = loop.getExecutor();
+  uint counter = 0;
+  uint finished = 0;
+
+  auto threads = heapArrayBuilder<Own<Thread>>(THREADS);
+  for (uint t = 0; t < THREADS; t++) {
+    threads.add(heap<Thread>([&]() {
+      UnixEventPort port;
+      EventLoop loop(port);
+      WaitScope waitScope(loop);
+
+      auto promises = heapArrayBuilder<Promise<uint>>(CALLS);
+      for (uint i = 0; i < CALLS; i++) {
+        promises.add(executor.executeAsync([&]() { return ++counter; }));
+      }
+      auto results = joinPromises(promises.finish()).wait(waitScope);
+
+      // Each thread's calls ran in the order it made them.
+      for (uint i = 1; i < results.size(); i++) {
+        EXPECT_LT(results[i - 1], results[i]);
+      }
+
+      __atomic_add_fetch(&finished, 1, __ATOMIC_RELEASE);
+    }));
+  }
+
+  // Keep our loop running until every thread has received all of its replies.
+  while (__atomic_load_n(&finished, __ATOMIC_ACQUIRE) < THREADS) {
+    port.atSteadyTime(port.steadyTime() + 1 * MILLISECONDS).wait(waitScope);
+  }
+  EXPECT_EQ(THREADS * CALLS, counter);
+}
+
+TEST(AsyncUnixTest, ExecutorLoopDestroyed) {
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  Own<const Executor> executor;
+  {
+    UnixEventPort port2;
+    EventLoop loop2(port2);
+    executor = loop2.getExecutor().addRef();
+  }
+
+  auto promise = executor->executeAsync([]() { return 1; });
+  auto exception = KJ_ASSERT_NONNULL(promise.then([](int) {
+    return Maybe<Exception>(nullptr);
+  }, [](Exception&& e) {
+    return Maybe<Exception>(kj::mv(e));
+  }).wait(waitScope));
+  EXPECT_EQ(Exception::Type::DISCONNECTED, exception.getType());
+}
+
 }  // namespace kj
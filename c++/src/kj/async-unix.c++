@@ -22,11 +22,12 @@
 #include "async-unix.h"
 #include "debug.h"
 #include "threadlocal.h"
+#include "miniposix.h"
 #include <setjmp.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <limits>
-#include <set>
+#include <algorithm>
 #include <chrono>
 #include <pthread.h>
 
@@ -35,6 +36,24 @@
 #include <sys/epoll.h>
 #include <sys/signalfd.h>
 #include <sys/eventfd.h>
+#if !defined(KJ_USE_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_FEAT_EXT_ARG)
+// io_uring support is compiled in wherever the kernel headers are new enough (Linux 5.11) to have
+// everything the backend uses, IORING_FEAT_EXT_ARG being the newest of it.  Whether it is
+// actually used is decided at runtime; see EventPortBackend.
+#define KJ_USE_IO_URING 1
+#endif
+#endif
+#endif
+#if KJ_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <poll.h>
+#endif
 #else
 #include <poll.h>
 #endif
@@ -45,41 +64,213 @@ namespace kj {
 // Timer code common to multiple implementations
 
 struct UnixEventPort::TimerSet {
-  struct TimerBefore {
-    bool operator()(TimerPromiseAdapter* lhs, TimerPromiseAdapter* rhs);
+  // Hierarchical timing wheel. Adding and removing a timer is O(1) and allocation-free, since
+  // timers are linked directly into their slot's list.
+  //
+  // Time is divided into ticks of TICK. Wheel level L has SLOTS slots, each spanning
+  // SLOTS^L ticks. A timer lives at the level of the highest base-SLOTS digit in which its tick
+  // differs from `currentTick`, in the slot given by that digit. So level 0 holds timers due
+  // within the current run of SLOTS ticks, level 1 those due within the current run of SLOTS^2
+  // ticks, and so on. When `currentTick` enters a new higher-level slot, that slot's timers
+  // are redistributed ("cascaded") to lower levels. Each timer cascades at most LEVELS times.
+
+  static constexpr uint LEVEL_BITS = 6;
+  static constexpr uint SLOTS = 1u << LEVEL_BITS;
+  static constexpr uint LEVELS = 8;
+  // 48 bits of ticks.  A TimePoint is an int64 count of nanoseconds, which is less than 2^44
+  // milliseconds (about 290 years), so any time at all, even `maxValue`, fits in the wheel.
+
+  static constexpr Duration TICK = 1 * MILLISECONDS;
+  // Timers due within the same tick are fired in order of their exact time, so the tick only
+  // affects bookkeeping, not precision.
+
+  static_assert((uint64_t(kj::maxValue) >> 1) / (1 * MILLISECONDS / NANOSECONDS)
+                >> (LEVELS * LEVEL_BITS) == 0,
+                "timer wheel doesn't cover every TimePoint");
+
+  struct Slot {
+    TimerPromiseAdapter* head = nullptr;
+    TimerPromiseAdapter** tail = &head;
   };
-  using Timers = std::multiset<TimerPromiseAdapter*, TimerBefore>;
-  Timers timers;
+
+  Slot slots[LEVELS][SLOTS];
+  uint64_t occupied[LEVELS] = {};
+  // Bit i of occupied[L] is set iff slots[L][i] is non-empty.
+
+  uint64_t currentTick;
+  // No timer is due before this tick. Only moves forward, in advance().
+
+  Vector<TimerPromiseAdapter*> scratch;
+  // Timers being fired by advance(). Kept to reuse its capacity.
+
+  explicit TimerSet(TimePoint now): currentTick(toTick(now)) {}
+
+  static uint64_t toTick(TimePoint time) {
+    int64_t ticks = (time - origin<TimePoint>()) / TICK;
+    return ticks < 0 ? 0 : ticks;
+  }
+
+  void add(TimerPromiseAdapter& timer);
+  void remove(TimerPromiseAdapter& timer);
+
+  bool findNext(uint64_t& tick, uint& level);
+  // Finds the earliest non-empty slot. For level 0, `tick` is the slot's tick; for higher levels
+  // it's the first tick the slot covers (which is when it must be cascaded). Returns false if
+  // there are no timers.
+
+  Maybe<TimePoint> nextTime();
+  // Returns a time no later than that of the earliest timer, and no earlier than the next tick
+  // unless that timer is in the current tick.
+
+  void advance(TimePoint now);
+  // Fires all timers due at or before `now`.
 };
 
+constexpr Duration UnixEventPort::TimerSet::TICK;
+
 class UnixEventPort::TimerPromiseAdapter {
 public:
   TimerPromiseAdapter(PromiseFulfiller<void>& fulfiller, UnixEventPort& port, TimePoint time)
       : time(time), fulfiller(fulfiller), port(port) {
-    pos = port.timers->timers.insert(this);
+    port.timers->add(*this);
   }
 
   ~TimerPromiseAdapter() {
-    if (pos != port.timers->timers.end()) {
-      port.timers->timers.erase(pos);
+    if (slot != nullptr) {
+      port.timers->remove(*this);
     }
   }
 
-  void fulfill() {
-    fulfiller.fulfill();
-    port.timers->timers.erase(pos);
-    pos = port.timers->timers.end();
-  }
-
   const TimePoint time;
   PromiseFulfiller<void>& fulfiller;
   UnixEventPort& port;
-  TimerSet::Timers::const_iterator pos;
+
+  TimerSet::Slot* slot = nullptr;
+  TimerPromiseAdapter* next = nullptr;
+  TimerPromiseAdapter** prev = nullptr;
+  // Position in the wheel, maintained by TimerSet. `slot` is null once the timer has fired.
 };
 
-bool UnixEventPort::TimerSet::TimerBefore::operator()(
-    TimerPromiseAdapter* lhs, TimerPromiseAdapter* rhs) {
-  return lhs->time < rhs->time;
+void UnixEventPort::TimerSet::add(TimerPromiseAdapter& timer) {
+  // Timers that are already due go in the current tick.
+  uint64_t tick = kj::max(toTick(timer.time), currentTick);
+
+  uint64_t diff = tick ^ currentTick;
+  uint level = diff == 0 ? 0 : (63 - countLeadingZeros(diff)) / LEVEL_BITS;
+  KJ_DASSERT(level < LEVELS);
+  uint index = (tick >> (level * LEVEL_BITS)) & (SLOTS - 1);
+
+  Slot& slot = slots[level][index];
+  timer.slot = &slot;
+  timer.next = nullptr;
+  timer.prev = slot.tail;
+  *slot.tail = &timer;
+  slot.tail = &timer.next;
+  occupied[level] |= uint64_t(1) << index;
+}
+
+void UnixEventPort::TimerSet::remove(TimerPromiseAdapter& timer) {
+  Slot& slot = *timer.slot;
+  *timer.prev = timer.next;
+  if (timer.next == nullptr) {
+    slot.tail = timer.prev;
+  } else {
+    timer.next->prev = timer.prev;
+  }
+  timer.slot = nullptr;
+
+  if (slot.head == nullptr) {
+    uint position = &slot - &slots[0][0];
+    occupied[position / SLOTS] &= ~(uint64_t(1) << (position % SLOTS));
+  }
+}
+
+bool UnixEventPort::TimerSet::findNext(uint64_t& tick, uint& level) {
+  // Occupied slots at level 0 are at or after the current digit; at higher levels they are
+  // strictly after it (the current one would have been cascaded), so the first occupied slot
+  // found scanning upward from level 0 is the earliest.
+  for (uint l = 0; l < LEVELS; l++) {
+    uint shift = l * LEVEL_BITS;
+    uint digit = (currentTick >> shift) & (SLOTS - 1);
+    uint first = l == 0 ? digit : digit + 1;
+    if (first >= SLOTS) continue;
+
+    uint64_t mask = occupied[l] & (~uint64_t(0) << first);
+    if (mask != 0) {
+      uint64_t blockStart = (currentTick >> (shift + LEVEL_BITS)) << (shift + LEVEL_BITS);
+      tick = blockStart | (uint64_t(countTrailingZeros(mask)) << shift);
+      level = l;
+      return true;
+    }
+  }
+  return false;
+}
+
+Maybe<TimePoint> UnixEventPort::TimerSet::nextTime() {
+  uint64_t tick;
+  uint level;
+  if (!findNext(tick, level)) {
+    return nullptr;
+  } else if (level == 0) {
+    // Need the exact time, or we'd spin when the earliest timer is later in the current tick.
+    TimerPromiseAdapter* timer = slots[0][tick & (SLOTS - 1)].head;
+    TimePoint result = timer->time;
+    for (timer = timer->next; timer != nullptr; timer = timer->next) {
+      result = kj::min(result, timer->time);
+    }
+    return result;
+  } else {
+    return origin<TimePoint>() + tick * TICK;
+  }
+}
+
+void UnixEventPort::TimerSet::advance(TimePoint now) {
+  uint64_t nowTick = toTick(now);
+
+  uint64_t tick;
+  uint level;
+  while (findNext(tick, level) && tick <= nowTick) {
+    currentTick = tick;
+    Slot& slot = slots[level][(tick >> (level * LEVEL_BITS)) & (SLOTS - 1)];
+
+    if (level > 0) {
+      // Cascade: every timer in the slot now belongs at a lower level.
+      TimerPromiseAdapter* timer = slot.head;
+      slot.head = nullptr;
+      slot.tail = &slot.head;
+      occupied[level] &= ~(uint64_t(1) << ((tick >> (level * LEVEL_BITS)) & (SLOTS - 1)));
+      while (timer != nullptr) {
+        TimerPromiseAdapter* next = timer->next;
+        add(*timer);
+        timer = next;
+      }
+      continue;
+    }
+
+    // Level 0: everything in the slot is due this tick. If that's the current tick, some may
+    // not be due quite yet.
+    scratch.clear();
+    for (TimerPromiseAdapter* timer = slot.head; timer != nullptr;) {
+      TimerPromiseAdapter* next = timer->next;
+      if (timer->time <= now) {
+        remove(*timer);
+        scratch.add(timer);
+      }
+      timer = next;
+    }
+
+    std::stable_sort(scratch.begin(), scratch.end(),
+        [](TimerPromiseAdapter* a, TimerPromiseAdapter* b) { return a->time < b->time; });
+    for (auto timer: scratch) {
+      timer->fulfiller.fulfill();
+    }
+
+    if (tick == nowTick) break;
+  }
+
+  // Nothing else is due until after `nowTick`. Moving up to it doesn't skip over any slot that
+  // needs cascading, since findNext() would have returned it.
+  currentTick = kj::max(currentTick, nowTick);
 }
 
 Promise<void> UnixEventPort::atSteadyTime(TimePoint time) {
@@ -93,13 +284,7 @@ TimePoint UnixEventPort::currentSteadyTime() {
 
 void UnixEventPort::processTimers() {
   frozenSteadyTime = currentSteadyTime();
-  for (;;) {
-    auto front = timers->timers.begin();
-    if (front == timers->timers.end() || (*front)->time > frozenSteadyTime) {
-      break;
-    }
-    (*front)->fulfill();
-  }
+  timers->advance(frozenSteadyTime);
 }
 
 // =======================================================================================
@@ -243,11 +428,412 @@ void UnixEventPort::gotSignal(const siginfo_t& siginfo) {
 }
 
 #if KJ_USE_EPOLL
+#if KJ_USE_IO_URING
+// =======================================================================================
+// io_uring implementation
+//
+// We talk to the kernel directly rather than through liburing, which would be an extra
+// dependency for the sake of a few hundred lines. See io_uring(7) for the ring protocol.
+
+namespace {
+
+static constexpr uint64_t RING_EPOLL_TAG = 1;
+static constexpr uint64_t RING_CANCEL_TAG = 2;
+// user_data values for completions that don't belong to an IoUringOpAdapter. Adapters' operations
+// use the address of their IoUring::Op, which is never this small.
+
+static constexpr auto RING_CANCEL_TIMEOUT = 1 * SECONDS;
+// How long an IoUringOpAdapter's destructor waits for a canceled operation to complete before
+// abandoning it.
+
+static constexpr unsigned RING_REQUIRED_FEATURES =
+    IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS | IORING_FEAT_EXT_ARG;
+// Everything here is in Linux 5.11. Requiring it keeps the code free of fallback paths.
+
+static inline uint32_t ringPollEvents(short events) {
+  uint32_t result = static_cast<unsigned short>(events);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  // The kernel stores poll32_events halfword-swapped on big-endian machines.
+  result = (result << 16) | (result >> 16);
+#endif
+  return result;
+}
+
+}  // namespace
+
+class UnixEventPort::IoUring {
+public:
+  static Maybe<Own<IoUring>> tryCreate() {
+    // Returns null if io_uring isn't usable here.
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = CQ_ENTRIES;
+
+    int fd = syscall(__NR_io_uring_setup, SQ_ENTRIES, &params);
+    if (fd < 0) {
+      // ENOSYS on old kernels, EPERM where disabled by sysctl or seccomp.
+      return nullptr;
+    }
+    AutoCloseFd ringFd(fd);
+
+    if ((params.features & RING_REQUIRED_FEATURES) != RING_REQUIRED_FEATURES) {
+      return nullptr;
+    }
+
+    size_t ringSize = kj::max(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+                              params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void* ring = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED) {
+      KJ_FAIL_SYSCALL("mmap(io_uring)", errno) { return nullptr; }
+    }
+    size_t sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      munmap(ring, ringSize);
+      KJ_FAIL_SYSCALL("mmap(io_uring)", errno) { return nullptr; }
+    }
+
+    return heap<IoUring>(kj::mv(ringFd), params, ring, ringSize,
+                         reinterpret_cast<io_uring_sqe*>(sqes), sqesSize);
+  }
+
+  IoUring(AutoCloseFd fd, const struct io_uring_params& params,
+          void* ring, size_t ringSize, io_uring_sqe* sqes, size_t sqesSize)
+      : fd(kj::mv(fd)), ring(ring), ringSize(ringSize), sqes(sqes), sqesSize(sqesSize),
+        sqHead(offset<uint32_t>(params.sq_off.head)),
+        sqTail(offset<uint32_t>(params.sq_off.tail)),
+        sqMask(*offset<uint32_t>(params.sq_off.ring_mask)),
+        sqEntries(params.sq_entries),
+        cqHead(offset<uint32_t>(params.cq_off.head)),
+        cqTail(offset<uint32_t>(params.cq_off.tail)),
+        cqMask(*offset<uint32_t>(params.cq_off.ring_mask)),
+        cqes(offset<io_uring_cqe>(params.cq_off.cqes)),
+        localSqTail(*sqTail) {
+    // We always fill the SQ in order, so the indirection array can be the identity.
+    uint32_t* array = offset<uint32_t>(params.sq_off.array);
+    for (uint32_t i = 0; i < sqEntries; i++) {
+      array[i] = i;
+    }
+  }
+
+  ~IoUring() noexcept(false) {
+    // Closing the ring FD cancels anything still in flight. (Normally nothing is, since every
+    // adapter cancels its own operation.)
+    munmap(sqes, sqesSize);
+    munmap(ring, ringSize);
+  }
+
+  KJ_DISALLOW_COPY(IoUring);
+
+  struct Op {
+    // What the user_data of an IoUringOpAdapter's submissions points at. Ops belong to the ring
+    // rather than to the adapter so that an adapter whose canceled operation is taking too long
+    // can be destroyed anyway: it detaches from its Op, and reap() recycles the Op once the
+    // operation's completion finally arrives.
+
+    IoUringOpAdapter* adapter = nullptr;
+    // Null if the adapter has gone away.
+
+    Array<struct iovec> iov;
+    // For IORING_OP_WRITEV, which may still be reading this if the adapter has gone away.
+
+    Op* nextFree = nullptr;
+  };
+
+  Op& allocOp(IoUringOpAdapter& adapter) {
+    // Ops live in fixed-size chunks that are never moved and are recycled through a free list,
+    // so there is no allocation per operation in steady state.
+
+    Op* op = freeOps;
+    if (op == nullptr) {
+      opChunks.add(heapArray<Op>(OP_CHUNK_SIZE));
+      auto& chunk = opChunks.back();
+      for (auto i: indices(chunk)) {
+        chunk[i].nextFree = i + 1 < OP_CHUNK_SIZE ? &chunk[i + 1] : nullptr;
+      }
+      op = chunk.begin();
+    }
+    freeOps = op->nextFree;
+    op->nextFree = nullptr;
+    op->adapter = &adapter;
+    return *op;
+  }
+
+  void freeOp(Op& op) {
+    op.adapter = nullptr;
+    op.iov = nullptr;
+    op.nextFree = freeOps;
+    freeOps = &op;
+  }
+
+  io_uring_sqe& getSqe(uint64_t userData) {
+    // Returns a zeroed submission entry, which is submitted by the next call to enter().
+
+    if (localSqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == sqEntries) {
+      // Queue is full. Submit what we have without waiting for anything.
+      enter(0);
+    }
+
+    io_uring_sqe& sqe = sqes[localSqTail & sqMask];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.user_data = userData;
+    __atomic_store_n(sqTail, ++localSqTail, __ATOMIC_RELEASE);
+    return sqe;
+  }
+
+  void enter(int timeout) {
+    // Submits all queued entries, then waits up to `timeout` milliseconds (-1 = forever, 0 = not
+    // at all) for at least one completion. Completions must then be picked up with reap().
+
+    uint32_t toSubmit = localSqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (timeout > 0) {
+      ts.tv_sec = timeout / 1000;
+      ts.tv_nsec = (timeout % 1000) * 1000000;
+      arg.ts = reinterpret_cast<uintptr_t>(&ts);
+    }
+
+    int result = syscall(__NR_io_uring_enter, fd.get(), toSubmit, timeout == 0 ? 0 : 1,
+                         IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (result < 0) {
+      int error = errno;
+      switch (error) {
+        case ETIME:   // Timed out.
+        case EINTR:   // Interrupted by a signal. The event loop will call us again.
+        case EBUSY:   // CQ overflowed; reap() and try again.
+        case EAGAIN:  // Kernel out of memory for requests; reap() and try again.
+          break;
+        default:
+          KJ_FAIL_SYSCALL("io_uring_enter()", error);
+      }
+    }
+  }
+
+  bool hasCompletions() {
+    return *cqHead != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+  }
+
+  void reap();
+  // Dispatches all available completions.
+
+  bool epollArmed = false;
+  // Whether a poll on the epoll FD is currently queued or in flight.
+
+  bool epollReady = false;
+  // Whether the epoll FD has been reported readable but not yet drained.
+
+private:
+  static constexpr uint OP_CHUNK_SIZE = 64;
+
+  static constexpr uint32_t SQ_ENTRIES = 256;
+  static constexpr uint32_t CQ_ENTRIES = 4096;
+  // Completions can outnumber submissions: one read per connection may be in flight at a time,
+  // but they are only submitted in batches. The kernel buffers CQ overflow anyway (NODROP).
+
+  AutoCloseFd fd;
+  void* ring;
+  size_t ringSize;
+  io_uring_sqe* sqes;
+  size_t sqesSize;
+
+  uint32_t* sqHead;
+  uint32_t* sqTail;
+  uint32_t sqMask;
+  uint32_t sqEntries;
+  uint32_t* cqHead;
+  uint32_t* cqTail;
+  uint32_t cqMask;
+  io_uring_cqe* cqes;
+
+  uint32_t localSqTail;
+
+  Vector<Array<Op>> opChunks;
+  Op* freeOps = nullptr;
+
+  template <typename T>
+  T* offset(uint32_t bytes) {
+    return reinterpret_cast<T*>(reinterpret_cast<byte*>(ring) + bytes);
+  }
+};
+
+class UnixEventPort::IoUringOpAdapter {
+  // A single read, write, or poll on the ring. If the promise is destroyed early, the destructor
+  // cancels the operation and waits, for at most RING_CANCEL_TIMEOUT, for it to finish.
+
+public:
+  IoUringOpAdapter(PromiseFulfiller<size_t>& fulfiller, IoUring& ring,
+                   int fd, void* buffer, size_t maxBytes)
+      : fulfiller(fulfiller), ring(ring), op(ring.allocOp(*this)), fd(fd),
+        opcode(IORING_OP_READ), pollEvents(POLLIN), buffer(buffer),
+        // The kernel takes a 32-bit length. Reading less than requested is always allowed.
+        size(kj::min(maxBytes, size_t(1) << 30)) {
+    submit();
+  }
+
+  IoUringOpAdapter(PromiseFulfiller<size_t>& fulfiller, IoUring& ring,
+                   int fd, ArrayPtr<const ArrayPtr<const byte>> pieces)
+      : fulfiller(fulfiller), ring(ring), op(ring.allocOp(*this)), fd(fd),
+        opcode(IORING_OP_WRITEV), pollEvents(POLLOUT) {
+    // If there are more than IOV_MAX pieces, this is a short write; the caller loops.
+    auto& iov = op.iov;
+    iov = heapArray<struct iovec>(kj::min(pieces.size(), kj::miniposix::iovMax(pieces.size())));
+    for (uint i = 0; i < iov.size(); i++) {
+      // writev() interface is not const-correct.  :(
+      iov[i].iov_base = const_cast<byte*>(pieces[i].begin());
+      iov[i].iov_len = pieces[i].size();
+    }
+    submit();
+  }
+
+  IoUringOpAdapter(PromiseFulfiller<size_t>& fulfiller, IoUring& ring, int fd, short events)
+      : fulfiller(fulfiller), ring(ring), op(ring.allocOp(*this)), fd(fd),
+        opcode(IORING_OP_POLL_ADD), pollEvents(events) {
+    submit();
+  }
+
+  ~IoUringOpAdapter() noexcept(false) {
+    if (inFlight) {
+      canceling = true;
+      io_uring_sqe& sqe = ring.getSqe(RING_CANCEL_TAG);
+      sqe.opcode = IORING_OP_ASYNC_CANCEL;
+      sqe.fd = -1;
+      sqe.addr = reinterpret_cast<uintptr_t>(&op);
+
+      // The operation's completion (successful or not) is what tells us that the kernel is done
+      // with our buffer. Our FDs are non-blocking, so a pending operation can only be waiting on
+      // an internal poll, which the cancellation aborts immediately; the timeout is so that a
+      // misbehaving kernel can't hang the event loop.
+      TimePoint deadline = systemSteadyTime() + RING_CANCEL_TIMEOUT;
+      while (inFlight) {
+        Duration remaining = deadline - systemSteadyTime();
+        if (remaining <= 0 * SECONDS) {
+          KJ_LOG(ERROR, "io_uring operation did not finish canceling; abandoning it", fd);
+          op.adapter = nullptr;
+          return;
+        }
+        ring.enter(ring.hasCompletions() ? 0 :
+                   kj::max((remaining + MILLISECONDS - unit<Duration>()) / MILLISECONDS, 1));
+        ring.reap();
+      }
+    }
+    ring.freeOp(op);
+  }
+
+  void complete(int result) {
+    inFlight = false;
+    if (canceling) return;
+
+    if (result == -EAGAIN && opcode != IORING_OP_POLL_ADD) {
+      // Older kernels honor O_NONBLOCK rather than waiting for the FD to become ready. Wait
+      // ourselves, then try again.
+      submitPollThenRetry();
+    } else if (result == -EINTR) {
+      submit();
+    } else if (polling) {
+      // The FD is ready (or in an error state, which the retried operation will report).
+      polling = false;
+      submit();
+    } else if (result < 0) {
+      fulfiller.rejectIfThrows([&]() {
+        KJ_FAIL_SYSCALL(opcode == IORING_OP_READ ? "read()" :
+                        opcode == IORING_OP_WRITEV ? "writev()" : "poll()", -result, fd);
+      });
+    } else {
+      fulfiller.fulfill(implicitCast<size_t>(result));
+    }
+  }
+
+private:
+  PromiseFulfiller<size_t>& fulfiller;
+  IoUring& ring;
+  IoUring::Op& op;
+  int fd;
+  uint8_t opcode;
+  short pollEvents;
+
+  void* buffer = nullptr;
+  size_t size = 0;
+
+  bool inFlight = false;
+  bool polling = false;
+  bool canceling = false;
+
+  void submit() {
+    io_uring_sqe& sqe = ring.getSqe(reinterpret_cast<uintptr_t>(&op));
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    switch (opcode) {
+      case IORING_OP_READ:
+        sqe.addr = reinterpret_cast<uintptr_t>(buffer);
+        sqe.len = size;
+        sqe.off = -1;  // Current position (irrelevant for sockets and pipes).
+        break;
+      case IORING_OP_WRITEV:
+        sqe.addr = reinterpret_cast<uintptr_t>(op.iov.begin());
+        sqe.len = op.iov.size();
+        sqe.off = -1;
+        break;
+      case IORING_OP_POLL_ADD:
+        sqe.poll32_events = ringPollEvents(pollEvents);
+        break;
+    }
+    inFlight = true;
+  }
+
+  void submitPollThenRetry() {
+    io_uring_sqe& sqe = ring.getSqe(reinterpret_cast<uintptr_t>(&op));
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd;
+    sqe.poll32_events = ringPollEvents(pollEvents);
+    inFlight = true;
+    polling = true;
+  }
+};
+
+void UnixEventPort::IoUring::reap() {
+  uint32_t head = *cqHead;
+  while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+    io_uring_cqe cqe = cqes[head & cqMask];
+
+    // Release the slot before dispatching, since dispatching may re-enter the ring.
+    __atomic_store_n(cqHead, ++head, __ATOMIC_RELEASE);
+
+    if (cqe.user_data == RING_EPOLL_TAG) {
+      epollArmed = false;
+      epollReady = true;
+    } else if (cqe.user_data == RING_CANCEL_TAG) {
+      // Outcome of an IORING_OP_ASYNC_CANCEL. Whatever it was, the canceled operation delivers
+      // its own completion.
+    } else {
+      Op& op = *reinterpret_cast<Op*>(cqe.user_data);
+      if (op.adapter == nullptr) {
+        // The adapter gave up waiting for this canceled operation.
+        freeOp(op);
+      } else {
+        op.adapter->complete(cqe.res);
+      }
+    }
+  }
+}
+
+#else  // KJ_USE_IO_URING
+
+class UnixEventPort::IoUring {};
+
+#endif  // KJ_USE_IO_URING, else
+
 // =======================================================================================
 // epoll FdObserver implementation
 
-UnixEventPort::UnixEventPort()
-    : timers(kj::heap<TimerSet>()),
+UnixEventPort::UnixEventPort(EventPortBackend backend)
+    : timers(kj::heap<TimerSet>(currentSteadyTime())),
       frozenSteadyTime(currentSteadyTime()),
       epollFd(-1),
       signalFd(-1),
@@ -273,6 +859,14 @@ UnixEventPort::UnixEventPort()
   KJ_SYSCALL(epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event));
   event.data.u64 = 1;
   KJ_SYSCALL(epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &event));
+
+  if (backend == EventPortBackend::IO_URING) {
+#if KJ_USE_IO_URING
+    KJ_IF_MAYBE(ring, IoUring::tryCreate()) {
+      ioUring = kj::mv(*ring);
+    }
+#endif
+  }
 }
 
 UnixEventPort::~UnixEventPort() noexcept(false) {}
@@ -358,16 +952,15 @@ Promise<void> UnixEventPort::FdObserver::whenUrgentDataAvailable() {
 }
 
 bool UnixEventPort::wait() {
-  // epoll_wait()'s timeout is an `int` count of milliseconds, so truncate to that.
-  // Also, make sure that we aren't within a millisecond of overflowing a `Duration` since that
-  // will break the math below.
+  // epoll_wait()'s (and io_uring_enter()'s) timeout is an `int` count of milliseconds, so
+  // truncate to that. Also, make sure that we aren't within a millisecond of overflowing a
+  // `Duration` since that will break the math below.
   constexpr Duration MAX_TIMEOUT =
       min(int(maxValue) * MILLISECONDS, Duration(maxValue) - MILLISECONDS);
 
   int epollTimeout = -1;
-  auto timer = timers->timers.begin();
-  if (timer != timers->timers.end()) {
-    Duration timeout = (*timer)->time - currentSteadyTime();
+  KJ_IF_MAYBE(nextTime, timers->nextTime()) {
+    Duration timeout = *nextTime - currentSteadyTime();
     if (timeout < 0 * SECONDS) {
       epollTimeout = 0;
     } else if (timeout < MAX_TIMEOUT) {
@@ -378,10 +971,16 @@ bool UnixEventPort::wait() {
     }
   }
 
+  if (ioUring.get() != nullptr) {
+    return doIoUringWait(epollTimeout);
+  }
   return doEpollWait(epollTimeout);
 }
 
 bool UnixEventPort::poll() {
+  if (ioUring.get() != nullptr) {
+    return doIoUringWait(0);
+  }
   return doEpollWait(0);
 }
 
@@ -500,7 +1099,7 @@ static siginfo_t toRegularSiginfo(const struct signalfd_siginfo& siginfo) {
   return result;
 }
 
-bool UnixEventPort::doEpollWait(int timeout) {
+void UnixEventPort::updateSignalFdMask() {
   sigset_t newMask;
   sigemptyset(&newMask);
 
@@ -518,6 +1117,10 @@ bool UnixEventPort::doEpollWait(int timeout) {
     signalFdSigset = newMask;
     KJ_SYSCALL(signalfd(signalFd, &signalFdSigset, SFD_NONBLOCK | SFD_CLOEXEC));
   }
+}
+
+bool UnixEventPort::doEpollWait(int timeout) {
+  updateSignalFdMask();
 
   struct epoll_event events[16];
   int n;
@@ -557,6 +1160,83 @@ bool UnixEventPort::doEpollWait(int timeout) {
   return woken;
 }
 
+#if KJ_USE_IO_URING
+// =======================================================================================
+// io_uring event waiting
+
+bool UnixEventPort::doIoUringWait(int timeout) {
+  IoUring& ring = *ioUring;
+
+  // Signals and cross-thread wakeups arrive through the epoll FD, so that's always being polled.
+  updateSignalFdMask();
+  if (!ring.epollArmed) {
+    io_uring_sqe& sqe = ring.getSqe(RING_EPOLL_TAG);
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = epollFd;
+    sqe.poll32_events = ringPollEvents(POLLIN);
+    ring.epollArmed = true;
+  }
+
+  if (ring.epollReady || ring.hasCompletions()) {
+    // Something already happened (perhaps noticed while canceling an operation); don't block.
+    timeout = 0;
+  }
+
+  ring.enter(timeout);
+  ring.reap();
+
+  if (ring.epollReady) {
+    ring.epollReady = false;
+    return doEpollWait(0);  // Also processes timers.
+  } else {
+    processTimers();
+    return false;
+  }
+}
+
+bool UnixEventPort::isUsingIoUring() const {
+  return ioUring.get() != nullptr;
+}
+
+Promise<size_t> UnixEventPort::submitRead(int fd, void* buffer, size_t maxBytes) {
+  KJ_REQUIRE(ioUring.get() != nullptr, "this UnixEventPort is not using io_uring");
+  return newAdaptedPromise<size_t, IoUringOpAdapter>(*ioUring, fd, buffer, maxBytes);
+}
+
+Promise<size_t> UnixEventPort::submitWrite(int fd, ArrayPtr<const ArrayPtr<const byte>> pieces) {
+  KJ_REQUIRE(ioUring.get() != nullptr, "this UnixEventPort is not using io_uring");
+  return newAdaptedPromise<size_t, IoUringOpAdapter>(*ioUring, fd, pieces);
+}
+
+Promise<void> UnixEventPort::submitPoll(int fd, short events) {
+  KJ_REQUIRE(ioUring.get() != nullptr, "this UnixEventPort is not using io_uring");
+  return newAdaptedPromise<size_t, IoUringOpAdapter>(*ioUring, fd, events).then([](size_t) {});
+}
+
+#else  // KJ_USE_IO_URING
+
+bool UnixEventPort::doIoUringWait(int timeout) {
+  KJ_UNREACHABLE;
+}
+
+bool UnixEventPort::isUsingIoUring() const {
+  return false;
+}
+
+Promise<size_t> UnixEventPort::submitRead(int fd, void* buffer, size_t maxBytes) {
+  KJ_UNIMPLEMENTED("this UnixEventPort is not using io_uring");
+}
+
+Promise<size_t> UnixEventPort::submitWrite(int fd, ArrayPtr<const ArrayPtr<const byte>> pieces) {
+  KJ_UNIMPLEMENTED("this UnixEventPort is not using io_uring");
+}
+
+Promise<void> UnixEventPort::submitPoll(int fd, short events) {
+  KJ_UNIMPLEMENTED("this UnixEventPort is not using io_uring");
+}
+
+#endif  // KJ_USE_IO_URING, else
+
 #else  // KJ_USE_EPOLL
 // =======================================================================================
 // Traditional poll() FdObserver implementation.
@@ -565,8 +1245,8 @@ bool UnixEventPort::doEpollWait(int timeout) {
 #define POLLRDHUP 0
 #endif
 
-UnixEventPort::UnixEventPort()
-    : timers(kj::heap<TimerSet>()),
+UnixEventPort::UnixEventPort(EventPortBackend backend)
+    : timers(kj::heap<TimerSet>(currentSteadyTime())),
       frozenSteadyTime(currentSteadyTime()) {
   static_assert(sizeof(threadId) >= sizeof(pthread_t),
                 "pthread_t is larger than a long long on your platform.  Please port.");
@@ -577,6 +1257,22 @@ UnixEventPort::UnixEventPort()
 
 UnixEventPort::~UnixEventPort() noexcept(false) {}
 
+bool UnixEventPort::isUsingIoUring() const {
+  return false;
+}
+
+Promise<size_t> UnixEventPort::submitRead(int fd, void* buffer, size_t maxBytes) {
+  KJ_UNIMPLEMENTED("io_uring is only available on Linux");
+}
+
+Promise<size_t> UnixEventPort::submitWrite(int fd, ArrayPtr<const ArrayPtr<const byte>> pieces) {
+  KJ_UNIMPLEMENTED("io_uring is only available on Linux");
+}
+
+Promise<void> UnixEventPort::submitPoll(int fd, short events) {
+  KJ_UNIMPLEMENTED("io_uring is only available on Linux");
+}
+
 UnixEventPort::FdObserver::FdObserver(UnixEventPort& eventPort, int fd, uint flags)
     : eventPort(eventPort), fd(fd), flags(flags), next(nullptr), prev(nullptr) {}
 
@@ -776,9 +1472,8 @@ bool UnixEventPort::wait() {
       min(int(maxValue) * MILLISECONDS, Duration(maxValue) - MILLISECONDS);
 
   int pollTimeout = -1;
-  auto timer = timers->timers.begin();
-  if (timer != timers->timers.end()) {
-    Duration timeout = (*timer)->time - currentSteadyTime();
+  KJ_IF_MAYBE(nextTime, timers->nextTime()) {
+    Duration timeout = *nextTime - currentSteadyTime();
     if (timeout < 0 * SECONDS) {
       pollTimeout = 0;
     } else if (timeout < MAX_TIMEOUT) {
@@ -39,6 +39,20 @@
 
 namespace kj {
 
+enum class EventPortBackend {
+  // Selects the kernel interface a `UnixEventPort` uses to wait for I/O.
+
+  DEFAULT,
+  // epoll on Linux, poll() elsewhere.
+
+  IO_URING
+  // Linux io_uring (kernel 5.11 or newer). Stream reads and writes are queued on the ring and
+  // submitted together in a single system call each time the event loop waits, instead of
+  // waiting for readiness and then issuing a separate read() or write(). If io_uring is not
+  // available (old kernel, not compiled in, or disabled by seccomp policy), the port silently
+  // falls back to DEFAULT; check `UnixEventPort::isUsingIoUring()` to find out.
+};
+
 class UnixEventPort: public EventPort {
   // An EventPort implementation which can wait for events on file descriptors as well as signals.
   // This API only makes sense on Unix.
@@ -59,7 +73,7 @@ class UnixEventPort: public EventPort {
   //   until after daemonization to create a UnixEventPort.
 
 public:
-  UnixEventPort();
+  explicit UnixEventPort(EventPortBackend backend = EventPortBackend::DEFAULT);
   ~UnixEventPort() noexcept(false);
 
   class FdObserver;
@@ -96,6 +110,26 @@ public:
   TimePoint steadyTime() { return frozenSteadyTime; }
   Promise<void> atSteadyTime(TimePoint time);
 
+  bool isUsingIoUring() const;
+  // Returns true if this port was created with EventPortBackend::IO_URING and io_uring turned out
+  // to be available. The methods below may only be called if so.
+
+  Promise<size_t> submitRead(int fd, void* buffer, size_t maxBytes);
+  // Queues a read() of up to `maxBytes` on the ring. Resolves to the number of bytes read, which
+  // is zero at EOF. The buffer must remain valid until the promise resolves or is destroyed;
+  // destroying the promise cancels the read, waiting for the kernel to let go of the buffer.
+  //
+  // Unlike with FdObserver, there's no need to try the read first: if no data is available the
+  // kernel waits for some to arrive.
+
+  Promise<size_t> submitWrite(int fd, ArrayPtr<const ArrayPtr<const byte>> pieces);
+  // Queues a writev() of `pieces` on the ring. Resolves to the number of bytes written, which may
+  // be less than the total. The bytes (but not the `pieces` array itself) must remain valid until
+  // the promise resolves or is destroyed.
+
+  Promise<void> submitPoll(int fd, short events);
+  // Resolves once poll() would report any of `events` (e.g. POLLOUT) on `fd`. Level-triggered.
+
   // implements EventPort ------------------------------------------------------
   bool wait() override;
   bool poll() override;
@@ -127,7 +161,15 @@ private:
   // Signal mask as currently set on the signalFd. Tracked so we can detect whether or not it
   // needs updating.
 
+  class IoUring;
+  class IoUringOpAdapter;
+  Own<IoUring> ioUring;
+  // Non-null if using io_uring. In that case the epoll FD is still used for FdObservers, signals,
+  // and wakeups, but it is itself polled through the ring.
+
+  void updateSignalFdMask();
   bool doEpollWait(int timeout);
+  bool doIoUringWait(int timeout);
 
 #else
   class PollContext;
@@ -20,11 +20,11 @@
 // THE SOFTWARE.
 
 #include "async.h"
+#include "async-stats.h"
 #include "debug.h"
 #include "vector.h"
 #include "threadlocal.h"
 #include <exception>
-#include <map>
 
 #if KJ_USE_FUTEX
 #include <unistd.h>
@@ -54,6 +54,58 @@ EventLoop& currentEventLoop() {
   return *loop;
 }
 
+}  // namespace
+
+namespace _ {  // private
+
+void* allocPromiseNodeSpace(size_t size) {
+  uint sizeClass = (size - 1) / EventLoop::NODE_SIZE_QUANTUM;
+  EventLoop* loop = threadLocalEventLoop;
+
+  if (sizeClass >= EventLoop::NODE_SIZE_CLASSES) {
+    if (loop != nullptr) ++loop->nodeHeapAllocations;
+    return operator new(size);
+  }
+
+  size_t classSize = (sizeClass + 1) * EventLoop::NODE_SIZE_QUANTUM;
+  if (loop != nullptr) {
+    EventLoop::FreeNode* node = loop->freeNodes[sizeClass];
+    if (node != nullptr) {
+      loop->freeNodes[sizeClass] = node->next;
+      loop->freeNodeBytes -= classSize;
+      return node;
+    }
+    ++loop->nodeHeapAllocations;
+  }
+
+  // Always allocate the whole size class, since the space may later be reused for any object of
+  // the class, possibly by a different loop.
+  return operator new(classSize);
+}
+
+void freePromiseNodeSpace(void* space, size_t size) {
+  uint sizeClass = (size - 1) / EventLoop::NODE_SIZE_QUANTUM;
+  size_t classSize = (sizeClass + 1) * EventLoop::NODE_SIZE_QUANTUM;
+  EventLoop* loop = threadLocalEventLoop;
+  if (loop != nullptr && sizeClass < EventLoop::NODE_SIZE_CLASSES &&
+      loop->freeNodeBytes + classSize <= EventLoop::MAX_FREE_NODE_BYTES) {
+    auto node = reinterpret_cast<EventLoop::FreeNode*>(space);
+    node->next = loop->freeNodes[sizeClass];
+    loop->freeNodes[sizeClass] = node;
+    loop->freeNodeBytes += classSize;
+  } else {
+    operator delete(space);
+  }
+}
+
+size_t promiseNodeHeapAllocations() {
+  return currentEventLoop().nodeHeapAllocations;
+}
+
+}  // namespace _ (private)
+
+namespace {
+
 class BoolEvent: public _::Event {
 public:
   bool fired = false;
@@ -94,12 +146,15 @@ public:
     : errorHandler(errorHandler) {}
 
   ~TaskSetImpl() noexcept(false) {
-    // std::map doesn't like it when elements' destructors throw, so carefully disassemble it.
-    if (!tasks.empty()) {
-      Vector<Own<Task>> deleteMe(tasks.size());
-      for (auto& entry: tasks) {
-        deleteMe.add(kj::mv(entry.second));
+    // Destroy tasks one at a time rather than letting each task's `next` destroy the rest, which
+    // could overflow the stack for a large set.
+    while (tasks != nullptr) {
+      Own<Task> task = kj::mv(KJ_ASSERT_NONNULL(tasks));
+      tasks = kj::mv(task->next);
+      KJ_IF_MAYBE(head, tasks) {
+        head->get()->prev = &tasks;
       }
+      task->prev = nullptr;
     }
   }
 
@@ -111,6 +166,11 @@ public:
       node->onReady(*this);
     }
 
+    Maybe<Own<Task>> next;
+    Maybe<Own<Task>>* prev = nullptr;
+    // Links in the TaskSetImpl's list of tasks. The list owns the tasks: `*prev` is the owning
+    // pointer to this task.
+
   protected:
     Maybe<Own<Event>> fire() override {
       // Get the result.
@@ -129,11 +189,15 @@ public:
         taskSet.errorHandler.taskFailed(kj::mv(*e));
       }
 
-      // Remove from the task map.
-      auto iter = taskSet.tasks.find(this);
-      KJ_ASSERT(iter != taskSet.tasks.end());
-      Own<Event> self = kj::mv(iter->second);
-      taskSet.tasks.erase(iter);
+      // Remove from the task list.
+      KJ_ASSERT(prev != nullptr);
+      Own<Event> self = kj::mv(KJ_ASSERT_NONNULL(*prev));
+      KJ_ASSERT(self.get() == this);
+      KJ_IF_MAYBE(n, next) {
+        n->get()->prev = prev;
+      }
+      *prev = kj::mv(next);
+      prev = nullptr;
       return mv(self);
     }
 
@@ -147,15 +211,25 @@ public:
   };
 
   void add(Promise<void>&& promise) {
-    auto task = heap<Task>(*this, kj::mv(promise.node));
-    Task* ptr = task;
-    tasks.insert(std::make_pair(ptr, kj::mv(task)));
+    auto task = allocPromiseNode<Task>(*this, kj::mv(promise.node));
+    KJ_IF_MAYBE(head, tasks) {
+      head->get()->prev = &task->next;
+      task->next = kj::mv(tasks);
+    }
+    task->prev = &tasks;
+    tasks = kj::mv(task);
   }
 
   kj::String trace() {
     kj::Vector<kj::String> traces;
-    for (auto& entry: tasks) {
-      traces.add(entry.second->trace());
+    Maybe<Own<Task>>* ptr = &tasks;
+    for (;;) {
+      KJ_IF_MAYBE(task, *ptr) {
+        traces.add(task->get()->trace());
+        ptr = &task->get()->next;
+      } else {
+        break;
+      }
     }
     return kj::strArray(traces, "\n============================================\n");
   }
@@ -163,8 +237,9 @@ public:
 private:
   TaskSet::ErrorHandler& errorHandler;
 
-  // TODO(perf):  Use a linked list instead.
-  std::map<Task*, Own<Task>> tasks;
+  Maybe<Own<Task>> tasks;
+  // Head of a doubly-linked list of tasks, most recently added first. Adding and removing a task
+  // doesn't allocate beyond the task itself.
 };
 
 class LoggingErrorHandler: public TaskSet::ErrorHandler {
@@ -209,11 +284,11 @@ void EventPort::wake() const {
 }
 
 EventLoop::EventLoop()
-    : port(_::NullEventPort::instance),
+    : port(_::NullEventPort::instance), executor(new Executor(*this)),
       daemons(kj::heap<_::TaskSetImpl>(_::LoggingErrorHandler::instance)) {}
 
 EventLoop::EventLoop(EventPort& port)
-    : port(port),
+    : port(port), executor(new Executor(*this)),
       daemons(kj::heap<_::TaskSetImpl>(_::LoggingErrorHandler::instance)) {}
 
 EventLoop::~EventLoop() noexcept(false) {
@@ -221,6 +296,11 @@ EventLoop::~EventLoop() noexcept(false) {
   // some more.
   daemons = nullptr;
 
+  // Refuse further cross-thread work and fail whatever is still queued.  The Executor object
+  // itself lives on for as long as other threads hold references to it.
+  executor->shutdown();
+  executor->disposeImpl(executor);
+
   // The application _should_ destroy everything using the EventLoop before destroying the
   // EventLoop itself, so if there are events on the loop, this indicates a memory leak.
   KJ_REQUIRE(head == nullptr, "EventLoop destroyed with events still in the queue.  Memory leak?",
@@ -241,12 +321,22 @@ EventLoop::~EventLoop() noexcept(false) {
     threadLocalEventLoop = nullptr;
     break;
   }
+
+  for (auto node: freeNodes) {
+    while (node != nullptr) {
+      auto next = node->next;
+      operator delete(node);
+      node = next;
+    }
+  }
 }
 
 void EventLoop::run(uint maxTurnCount) {
   running = true;
   KJ_DEFER(running = false);
 
+  executor->poll();
+
   for (uint i = 0; i < maxTurnCount; i++) {
     if (!turn()) {
       break;
@@ -261,6 +351,7 @@ bool EventLoop::turn() {
 
   if (event == nullptr) {
     // No events in the queue.
+    if (stats != nullptr) stats->endWakeup();
     return false;
   } else {
     head = event->next;
@@ -280,7 +371,11 @@ bool EventLoop::turn() {
     {
       event->firing = true;
       KJ_DEFER(event->firing = false);
-      eventToDestroy = event->fire();
+      if (stats == nullptr) {
+        eventToDestroy = event->fire();
+      } else {
+        eventToDestroy = fireWithStats(*event);
+      }
     }
 
     depthFirstInsertPoint = &head;
@@ -292,6 +387,19 @@ bool EventLoop::isRunnable() {
   return head != nullptr;
 }
 
+const Executor& EventLoop::getExecutor() {
+  return *executor;
+}
+
+void EventLoop::setStats(Maybe<EventLoopStats&> stats) {
+  KJ_IF_MAYBE(s, stats) {
+    s->turnsThisWakeup = 0;
+    this->stats = s;
+  } else {
+    this->stats = nullptr;
+  }
+}
+
 void EventLoop::setRunnable(bool runnable) {
   if (runnable != lastRunnableState) {
     port.setRunnable(runnable);
@@ -312,8 +420,186 @@ void EventLoop::leaveScope() {
   threadLocalEventLoop = nullptr;
 }
 
+// =======================================================================================
+
+#define _kJ_EXECUTOR_CLOSED reinterpret_cast< ::kj::_::XThreadEvent*>(1)
+
+Executor::Executor(EventLoop& loop): loop(loop) {}
+Executor::~Executor() noexcept(false) {}
+
+Own<const Executor> Executor::addRef() const {
+  __atomic_add_fetch(&refcount, 1, __ATOMIC_RELAXED);
+  return Own<const Executor>(this, *this);
+}
+
+void Executor::disposeImpl(void* pointer) const {
+  if (__atomic_sub_fetch(&refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+    delete this;
+  }
+}
+
+bool Executor::push(_::XThreadEvent& event) const {
+  __atomic_add_fetch(&activePushers, 1, __ATOMIC_SEQ_CST);
+  KJ_DEFER(__atomic_sub_fetch(&activePushers, 1, __ATOMIC_RELEASE));
+
+  _::XThreadEvent* oldHead = __atomic_load_n(&head, __ATOMIC_SEQ_CST);
+  do {
+    if (oldHead == _kJ_EXECUTOR_CLOSED) return false;
+    event.next = oldHead;
+  } while (!__atomic_compare_exchange_n(&head, &oldHead, &event, true,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+  if (oldHead == nullptr) {
+    // The queue was empty, so the loop may be asleep.  (If it wasn't empty, whoever made it
+    // non-empty already woke the loop, and it will see our event when it drains the queue.)
+    loop.port.wake();
+  }
+  return true;
+}
+
+void Executor::poll() {
+  if (__atomic_load_n(&head, __ATOMIC_RELAXED) == nullptr) return;
+
+  _::XThreadEvent* list = __atomic_exchange_n(&head, nullptr, __ATOMIC_ACQUIRE);
+
+  // The queue is a stack; reverse it to process events in the order they were pushed.
+  _::XThreadEvent* reversed = nullptr;
+  while (list != nullptr) {
+    _::XThreadEvent* next = list->next;
+    list->next = reversed;
+    reversed = list;
+    list = next;
+  }
+
+  while (reversed != nullptr) {
+    _::XThreadEvent* event = reversed;
+    reversed = event->next;
+    event->next = nullptr;
+    if (event->replying) {
+      event->deliver();
+    } else {
+      event->run(loop);
+    }
+  }
+}
+
+void Executor::shutdown() {
+  _::XThreadEvent* list = __atomic_exchange_n(&head, _kJ_EXECUTOR_CLOSED, __ATOMIC_SEQ_CST);
+
+  // A thread that pushed just before we closed the queue may still be calling port.wake().  The
+  // window is only a few instructions wide, so spin.
+  while (__atomic_load_n(&activePushers, __ATOMIC_SEQ_CST) != 0) {}
+
+  while (list != nullptr) {
+    _::XThreadEvent* event = list;
+    list = event->next;
+    event->next = nullptr;
+    if (event->replying) {
+      // A reply to a promise on this loop.  That promise must already be gone, since the loop is.
+      event->release();
+    } else {
+      event->result.addException(KJ_EXCEPTION(DISCONNECTED,
+          "Executor's event loop was destroyed before the work could run."));
+      event->reply();
+    }
+  }
+}
+
+const Executor& getCurrentThreadExecutor() {
+  return currentEventLoop().getExecutor();
+}
+
 namespace _ {  // private
 
+class XThreadEvent::ReplyGuard {
+  // Attached to the promise running an event on the target thread.  Sends the reply once the
+  // promise completes -- or, if the target loop is destroyed first, once the promise is canceled.
+
+public:
+  explicit ReplyGuard(XThreadEvent& event): event(event) {}
+  KJ_DISALLOW_COPY(ReplyGuard);
+  ~ReplyGuard() noexcept(false) {
+    if (!completed) {
+      event.result.addException(KJ_EXCEPTION(DISCONNECTED,
+          "Executor's event loop was destroyed before the work completed."));
+    }
+    event.reply();
+  }
+
+  bool completed = false;
+
+private:
+  XThreadEvent& event;
+};
+
+XThreadEvent::XThreadEvent(ExceptionOrValue& result, Own<const Executor> replyTo)
+    : result(result), replyTo(kj::mv(replyTo)) {}
+
+XThreadEvent::~XThreadEvent() noexcept(false) {}
+
+Own<PromiseNode> XThreadEvent::send(const Executor& target) {
+  Own<PromiseNode> node(this, *this);
+  if (!target.push(*this)) {
+    result.addException(KJ_EXCEPTION(DISCONNECTED, "Executor's event loop has been destroyed."));
+    onReadyEvent.arm();
+    release();
+  }
+  return node;
+}
+
+void XThreadEvent::onReady(Event& event) noexcept {
+  onReadyEvent.init(event);
+}
+
+void XThreadEvent::run(EventLoop& loop) {
+  // On the target thread.
+
+  if (__atomic_load_n(&canceled, __ATOMIC_ACQUIRE)) {
+    // Nobody is waiting for the result, so don't bother.
+    reply();
+    return;
+  }
+
+  auto guard = kj::heap<ReplyGuard>(*this);
+  auto& guardRef = *guard;
+  loop.daemons->add(execute().then([&guardRef]() {
+    guardRef.completed = true;
+  }).attach(kj::mv(guard)));
+}
+
+void XThreadEvent::reply() {
+  // On the target thread, once the result has been stored.
+
+  replying = true;
+  if (!replyTo->push(*this)) {
+    // The calling thread's loop is gone, and with it the promise.
+    release();
+  }
+}
+
+void XThreadEvent::deliver() {
+  // Back on the calling thread.
+
+  if (nodeAlive) {
+    onReadyEvent.arm();
+  }
+  release();
+}
+
+void XThreadEvent::release() {
+  if (__atomic_sub_fetch(&refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+    delete this;
+  }
+}
+
+void XThreadEvent::disposeImpl(void* pointer) const {
+  // The calling thread dropped the promise.
+  auto self = const_cast<XThreadEvent*>(this);
+  self->nodeAlive = false;
+  __atomic_store_n(&self->canceled, true, __ATOMIC_RELEASE);
+  self->release();
+}
+
 void waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result, WaitScope& waitScope) {
   EventLoop& loop = waitScope.loop;
   KJ_REQUIRE(&loop == threadLocalEventLoop, "WaitScope not valid for this thread.");
@@ -327,6 +613,9 @@ void waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result, WaitScope
   KJ_DEFER(loop.running = false);
 
   while (!doneEvent.fired) {
+    // Pick up any work queued by other threads.  This is just an atomic load if there is none.
+    loop.executor->poll();
+
     if (!loop.turn()) {
       // No events in the queue.  Wait for callback.
       loop.port.wait();
@@ -344,11 +633,11 @@ void waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result, WaitScope
 }
 
 Promise<void> yield() {
-  return Promise<void>(false, kj::heap<YieldPromiseNode>());
+  return Promise<void>(false, allocPromiseNode<YieldPromiseNode>());
 }
 
 Own<PromiseNode> neverDone() {
-  return kj::heap<NeverDonePromiseNode>();
+  return allocPromiseNode<NeverDonePromiseNode>();
 }
 
 void NeverDone::wait(WaitScope& waitScope) const {
@@ -471,8 +760,61 @@ kj::String Event::trace() {
   return traceImpl(this, getInnerForTrace());
 }
 
+class TurnTrace {
+  // The types along an event's promise chain, as `Event::trace()` would list them.  Firing an
+  // event usually tears its chain down, so to report which callback stalled the loop we have to
+  // look before firing, but we only want to pay for the strings if there turns out to be a stall.
+
+public:
+  explicit TurnTrace(Event& event) {
+#if !KJ_NO_RTTI
+    types[count++] = &typeid(event);
+    for (auto node = event.getInnerForTrace(); node != nullptr && count < MAX_DEPTH;
+         node = node->getInnerForTrace()) {
+      types[count++] = &typeid(*node);
+    }
+#endif
+  }
+
+  kj::String toString() {
+#if KJ_NO_RTTI
+    return heapString("Trace not available because RTTI is disabled.");
+#else
+    auto names = KJ_MAP(type, kj::arrayPtr(types, count)) {
+      return demangleTypeName(type->name());
+    };
+    return strArray(names, "\n");
+#endif
+  }
+
+private:
+  static constexpr uint MAX_DEPTH = 16;
+#if !KJ_NO_RTTI
+  const std::type_info* types[MAX_DEPTH];
+#endif
+  uint count = 0;
+};
+
 }  // namespace _ (private)
 
+Maybe<Own<_::Event>> EventLoop::fireWithStats(_::Event& event) {
+  _::TurnTrace chain(event);
+
+  TimePoint start = systemSteadyTime();
+  auto result = event.fire();
+  uint64_t nanos = (systemSteadyTime() - start) / NANOSECONDS;
+
+  // The callback may have detached the stats.
+  if (stats != nullptr && stats->recordTurn(nanos)) {
+    double milliseconds = nanos / 1000000.0;
+    auto trace = chain.toString();
+    KJ_LOG(WARNING, "event loop stalled by an event which ran longer than the stall threshold",
+           milliseconds, trace);
+  }
+
+  return kj::mv(result);
+}
+
 // =======================================================================================
 
 TaskSet::TaskSet(ErrorHandler& errorHandler)
@@ -498,6 +840,8 @@ void PromiseNode::setSelfPointer(Own<PromiseNode>* selfPtr) noexcept {}
 
 PromiseNode* PromiseNode::getInnerForTrace() { return nullptr; }
 
+bool PromiseNode::isReady() { return false; }
+
 void PromiseNode::OnReadyEvent::init(Event& newEvent) {
   if (event == _kJ_ALREADY_READY) {
     // A new continuation was added to a promise that was already ready.  In this case, we schedule
@@ -520,6 +864,10 @@ void PromiseNode::OnReadyEvent::arm() {
   }
 }
 
+bool PromiseNode::OnReadyEvent::isReady() const {
+  return event == _kJ_ALREADY_READY;
+}
+
 // -------------------------------------------------------------------
 
 ImmediatePromiseNodeBase::ImmediatePromiseNodeBase() {}
@@ -529,6 +877,8 @@ void ImmediatePromiseNodeBase::onReady(Event& event) noexcept {
   event.armBreadthFirst();
 }
 
+bool ImmediatePromiseNodeBase::isReady() { return true; }
+
 ImmediateBrokenPromiseNode::ImmediateBrokenPromiseNode(Exception&& exception)
     : exception(kj::mv(exception)) {}
 
@@ -718,6 +1068,10 @@ PromiseNode* ChainPromiseNode::getInnerForTrace() {
   return inner;
 }
 
+bool ChainPromiseNode::isReady() {
+  return state == STEP2 && inner->isReady();
+}
+
 Maybe<Own<Event>> ChainPromiseNode::fire() {
   KJ_REQUIRE(state != STEP2);
 
@@ -737,7 +1091,7 @@ Maybe<Own<Event>> ChainPromiseNode::fire() {
     // There is an exception.  If there is also a value, delete it.
     kj::runCatchingExceptions([&,this]() { intermediate.value = nullptr; });
     // Now set step2 to a rejected promise.
-    inner = heap<ImmediateBrokenPromiseNode>(kj::mv(*exception));
+    inner = allocPromiseNode<ImmediateBrokenPromiseNode>(kj::mv(*exception));
   } else KJ_IF_MAYBE(value, intermediate.value) {
     // There is a value and no exception.  The value is itself a promise.  Adopt it as our
     // step2.
@@ -908,7 +1262,7 @@ void ArrayJoinPromiseNode<void>::getNoError(ExceptionOrValue& output) noexcept {
 }  // namespace _ (private)
 
 Promise<void> joinPromises(Array<Promise<void>>&& promises) {
-  return Promise<void>(false, kj::heap<_::ArrayJoinPromiseNode<void>>(
+  return Promise<void>(false, _::allocPromiseNode<_::ArrayJoinPromiseNode<void>>(
       KJ_MAP(p, promises) { return kj::mv(p.node); },
       heapArray<_::ExceptionOr<_::Void>>(promises.size())));
 }
@@ -950,6 +1304,10 @@ void AdapterPromiseNodeBase::onReady(Event& event) noexcept {
   onReadyEvent.init(event);
 }
 
+bool AdapterPromiseNodeBase::isReady() {
+  return onReadyEvent.isReady();
+}
+
 // -------------------------------------------------------------------
 
 Promise<void> IdentityFunc<Promise<void>>::operator()() const { return READY_NOW; }
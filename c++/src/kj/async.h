@@ -35,6 +35,8 @@ namespace kj {
 
 class EventLoop;
 class WaitScope;
+class Executor;
+class EventLoopStats;
 
 template <typename T>
 class Promise;
@@ -305,6 +307,11 @@ private:
   template <typename U>
   friend Promise<Array<U>> joinPromises(Array<Promise<U>>&& promises);
   friend Promise<void> joinPromises(Array<Promise<void>>&& promises);
+  friend class Executor;
+#if KJ_HAS_COROUTINE
+  template <typename>
+  friend class _::Coroutine;
+#endif
 };
 
 template <typename T>
@@ -364,6 +371,36 @@ template <typename T>
 Promise<Array<T>> joinPromises(Array<Promise<T>>&& promises);
 // Join an array of promises into a promise for an array.
 
+#if KJ_HAS_COROUTINE
+// =======================================================================================
+// Coroutines
+//
+// When compiled as C++20, any function returning Promise<T> may be a coroutine, and any
+// Promise<U> may be awaited inside it:
+//
+//     Promise<uint> countLines(AsyncInputStream& input) {
+//       char buffer[4096];
+//       uint count = 0;
+//       for (;;) {
+//         size_t n = co_await input.tryRead(buffer, 1, sizeof(buffer));
+//         if (n == 0) co_return count;
+//         count += std::count(buffer, buffer + n, '\n');
+//       }
+//     }
+//
+// The coroutine runs synchronously until its first co_await on a promise that isn't ready, like
+// evalNow().  Its frame is itself the PromiseNode of the returned promise, and comes from the same
+// free lists as other promise nodes, so a coroutine costs one allocation however many steps it
+// takes -- compared to one node and one lambda capture per step for a then() chain.
+//
+// Dropping the returned promise cancels the coroutine: its frame is destroyed at whatever
+// co_await it is suspended on, running destructors as usual, and the awaited promise is
+// canceled in turn.  A co_await on a promise that rejects throws the exception into the
+// coroutine; an exception escaping the coroutine rejects its promise.
+//
+// Only Promises may be awaited.  co_await consumes the promise, whether or not it is an rvalue.
+#endif
+
 // =======================================================================================
 // Hack for creating a lambda that holds an owned pointer.
 
@@ -518,6 +555,78 @@ private:
   Own<_::TaskSetImpl> impl;
 };
 
+// =======================================================================================
+// Cross-thread execution
+
+class Executor final: private Disposer {
+  // Allows other threads to queue work on a particular EventLoop.  Get the Executor for a loop
+  // with `EventLoop::getExecutor()` (or `getCurrentThreadExecutor()` from the loop's own thread),
+  // then hand it to other threads, which may call its methods concurrently.
+  //
+  // Work is passed to the target thread through a lock-free queue; the target's `EventPort` is
+  // woken (e.g. through an eventfd, in the case of `UnixEventPort`) only when the queue goes from
+  // empty to non-empty.  Both the target loop and the calling thread's loop must use an EventPort
+  // that implements `wake()`, such as `UnixEventPort`.
+
+public:
+  template <typename Func>
+  PromiseForResult<Func, void> executeAsync(Func&& func) const KJ_WARN_UNUSED_RESULT;
+  // Arranges for `func()` to be called on the Executor's thread and returns a promise for its
+  // result.  If `func()` returns a promise, the returned promise waits for that promise to
+  // resolve, which again happens on the Executor's thread.  The returned promise belongs to the
+  // *calling* thread's event loop; the calling thread must have one.
+  //
+  // `func` and its result are moved between threads, so they must not contain anything tied to
+  // a particular thread, such as a `Promise` or a single-threaded refcounted object.  To fulfill
+  // a promise owned by the target thread, pass a reference to its `PromiseFulfiller` and call
+  // `fulfill()` from within `func`.
+  //
+  // Dropping the returned promise before `func()` has started prevents it from being called, but
+  // once it has started, it runs to completion and its result is discarded.  If the target loop
+  // is destroyed before the work completes, the returned promise rejects with DISCONNECTED.
+
+  Own<const Executor> addRef() const;
+  // Returns a new reference to this Executor, which may be held by any thread.  The Executor
+  // itself outlives its EventLoop as long as references exist; once the loop has been destroyed,
+  // `executeAsync()` returns promises which reject with DISCONNECTED.
+
+private:
+  EventLoop& loop;
+
+  mutable _::XThreadEvent* head = nullptr;
+  // Lock-free stack of queued events, most recently pushed first.  Becomes CLOSED when the loop is
+  // destroyed.
+
+  mutable uint activePushers = 0;
+  // Number of threads currently inside push().  The EventLoop's destructor waits for this to
+  // reach zero after closing the queue, since a pusher may still be calling `port.wake()`.
+
+  mutable uint refcount = 1;
+  // The EventLoop holds one reference.
+
+  explicit Executor(EventLoop& loop);
+  ~Executor() noexcept(false);
+
+  bool push(_::XThreadEvent& event) const;
+  // Queue an event and wake the loop if needed.  Returns false if the loop has been destroyed.
+
+  void poll();
+  // Called on the loop's thread to process queued events.
+
+  void shutdown();
+  // Called by the EventLoop's destructor.
+
+  void disposeImpl(void* pointer) const override;
+
+  friend class EventLoop;
+  friend class _::XThreadEvent;
+  friend void _::waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result,
+                          WaitScope& waitScope);
+};
+
+const Executor& getCurrentThreadExecutor();
+// Get the Executor for the current thread's EventLoop.
+
 // =======================================================================================
 // The EventLoop class
 
@@ -622,8 +731,17 @@ public:
   bool isRunnable();
   // Returns true if run() would currently do anything, or false if the queue is empty.
 
+  const Executor& getExecutor();
+  // Returns an Executor which other threads can use to run code on this loop.
+
+  void setStats(Maybe<EventLoopStats&> stats);
+  // Starts timing each event into `stats`, and logging events which stall the loop, or stops if
+  // `stats` is null.  `stats` must stay alive until it is replaced or the loop is destroyed.  See
+  // async-stats.h.
+
 private:
   EventPort& port;
+  Executor* executor;
 
   bool running = false;
   // True while looping -- wait() is then not allowed.
@@ -637,7 +755,29 @@ private:
 
   Own<_::TaskSetImpl> daemons;
 
+  EventLoopStats* stats = nullptr;
+
+  static constexpr size_t NODE_SIZE_QUANTUM = 32;
+  static constexpr uint NODE_SIZE_CLASSES = 32;
+  static constexpr size_t MAX_FREE_NODE_BYTES = 256 * 1024;
+  // Promise nodes of up to NODE_SIZE_CLASSES * NODE_SIZE_QUANTUM bytes (most nodes carry an
+  // ExceptionOr, so a few hundred bytes is typical) are allocated in multiples of
+  // NODE_SIZE_QUANTUM and, when freed on a thread whose loop is current, kept on that loop's free
+  // list for their size.  The lists together hold at most MAX_FREE_NODE_BYTES; beyond that, space
+  // goes back to the heap.
+
+  struct FreeNode {
+    FreeNode* next;
+  };
+  FreeNode* freeNodes[NODE_SIZE_CLASSES] = {};
+  size_t freeNodeBytes = 0;
+
+  size_t nodeHeapAllocations = 0;
+  // Node space which had to come from the heap while this loop was current.  See
+  // _::promiseNodeHeapAllocations().
+
   bool turn();
+  Maybe<Own<_::Event>> fireWithStats(_::Event& event);
   void setRunnable(bool runnable);
   void enterScope();
   void leaveScope();
@@ -646,7 +786,12 @@ private:
   friend void _::waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result,
                           WaitScope& waitScope);
   friend class _::Event;
+  friend class _::XThreadEvent;
+  friend class Executor;
   friend class WaitScope;
+  friend void* _::allocPromiseNodeSpace(size_t size);
+  friend void _::freePromiseNodeSpace(void* space, size_t size);
+  friend size_t _::promiseNodeHeapAllocations();
 };
 
 class WaitScope {
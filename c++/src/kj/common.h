@@ -86,7 +86,7 @@
 #endif
 
 #if defined(_MSC_VER)
-#include <intrin.h>  // __popcnt
+#include <intrin.h>  // __popcnt, _BitScanForward(64), _BitScanReverse(64)
 #endif
 
 // =======================================================================================
@@ -618,6 +618,43 @@ inline int popCount(unsigned int x) {
 #endif
 }
 
+inline uint countLeadingZeros(unsigned long long x) {
+  // Number of zero bits above the highest set bit of the 64-bit value `x`.  `x` must not be zero.
+#if defined(_MSC_VER) && defined(_M_IX86)
+  // No 64-bit bit scans on 32-bit x86.
+  unsigned long index;
+  if (_BitScanReverse(&index, static_cast<unsigned long>(x >> 32))) {
+    return 31 - index;
+  }
+  _BitScanReverse(&index, static_cast<unsigned long>(x));
+  return 63 - index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, x);
+  return 63 - index;
+#else
+  return __builtin_clzll(x);
+#endif
+}
+
+inline uint countTrailingZeros(unsigned long long x) {
+  // Number of zero bits below the lowest set bit of the 64-bit value `x`.  `x` must not be zero.
+#if defined(_MSC_VER) && defined(_M_IX86)
+  unsigned long index;
+  if (_BitScanForward(&index, static_cast<unsigned long>(x))) {
+    return index;
+  }
+  _BitScanForward(&index, static_cast<unsigned long>(x >> 32));
+  return 32 + index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return index;
+#else
+  return __builtin_ctzll(x);
+#endif
+}
+
 // =======================================================================================
 // Useful fake containers
 
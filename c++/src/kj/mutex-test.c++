@@ -22,6 +22,7 @@
 #include "mutex.h"
 #include "debug.h"
 #include "thread.h"
+#include "vector.h"
 #include <kj/compat/gtest.h>
 
 #if _WIN32
@@ -132,6 +133,52 @@ TEST(Mutex, MutexGuarded) {
   EXPECT_EQ(321u, value.getWithoutLock());
 }
 
+TEST(Mutex, When) {
+  MutexGuarded<uint> value(123);
+
+  {
+    uint m = value.when([](uint n) { return n < 200; }, [](uint& n) {
+      ++n;
+      return n + 2;
+    });
+    EXPECT_EQ(126u, m);
+    EXPECT_EQ(124u, *value.lockExclusive());
+  }
+
+  {
+    kj::Thread thread([&]() {
+      delay();
+      *value.lockExclusive() = 321;
+    });
+
+    uint m = value.when([](uint n) { return n > 200; }, [](uint& n) {
+      ++n;
+      return n + 2;
+    });
+    EXPECT_EQ(324u, m);
+    EXPECT_EQ(322u, *value.lockExclusive());
+  }
+
+  {
+    // Stress test: threads take turns, each waiting for the count to reach a value only the
+    // previous thread sets.
+    MutexGuarded<uint> counter(0);
+    constexpr uint THREADS = 8;
+    constexpr uint ROUNDS = 100;
+    kj::Vector<kj::Own<kj::Thread>> threads;
+    for (uint t = 0; t < THREADS; t++) {
+      threads.add(kj::heap<kj::Thread>([&counter,t]() {
+        for (uint round = 0; round < ROUNDS; round++) {
+          uint target = round * THREADS + t;
+          counter.when([target](uint n) { return n == target; }, [](uint& n) { ++n; });
+        }
+      }));
+    }
+    threads = nullptr;
+    EXPECT_EQ(THREADS * ROUNDS, *counter.lockExclusive());
+  }
+}
+
 TEST(Mutex, Lazy) {
   Lazy<uint> lazy;
   volatile bool initStarted = false;
@@ -52,6 +52,41 @@
 namespace kj {
 namespace _ {  // private
 
+struct Mutex::Waiter {
+  Waiter* next;
+  Waiter** prev;
+  Predicate& predicate;
+
+#if KJ_USE_FUTEX
+  uint futex;
+  // Set to 1 once the lock has been handed to this waiter.
+#elif _WIN32
+  CONDITION_VARIABLE condvar;
+#else
+  pthread_cond_t condvar;
+  pthread_mutex_t stupidMutex;
+  // pthread condvars only work with plain mutexes, not rwlocks.
+#endif
+};
+
+void Mutex::addWaiter(Waiter& waiter) {
+  *waitersTail = &waiter;
+  waitersTail = &waiter.next;
+}
+
+void Mutex::removeWaiter(Waiter& waiter) {
+  *waiter.prev = waiter.next;
+  if (waiter.next == nullptr) {
+    waitersTail = waiter.prev;
+  } else {
+    waiter.next->prev = waiter.prev;
+  }
+}
+
+void Mutex::unlock(Exclusivity exclusivity) {
+  unlock(exclusivity, nullptr);
+}
+
 #if KJ_USE_FUTEX
 // =======================================================================================
 // Futex-based implementation (Linux-only)
@@ -105,10 +140,22 @@ void Mutex::lock(Exclusivity exclusivity) {
   }
 }
 
-void Mutex::unlock(Exclusivity exclusivity) {
+void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
   switch (exclusivity) {
     case EXCLUSIVE: {
       KJ_DASSERT(futex & EXCLUSIVE_HELD, "Unlocked a mutex that wasn't locked.");
+
+      // The state may have changed, so see if a lockWhen() can now proceed.  If so, hand the lock
+      // straight to it rather than releasing it, so that its predicate stays true.  (Under a
+      // shared lock the state can't have changed, so we only do this here.)
+      for (Waiter* waiter = waitersHead; waiter != nullptr; waiter = waiter->next) {
+        if (waiter != waiterToSkip && waiter->predicate.check()) {
+          __atomic_store_n(&waiter->futex, 1, __ATOMIC_RELEASE);
+          syscall(SYS_futex, &waiter->futex, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+          return;
+        }
+      }
+
       uint oldState = __atomic_fetch_and(
           &futex, ~(EXCLUSIVE_HELD | EXCLUSIVE_REQUESTED), __ATOMIC_RELEASE);
 
@@ -141,6 +188,23 @@ void Mutex::unlock(Exclusivity exclusivity) {
   }
 }
 
+void Mutex::lockWhen(Predicate& predicate) {
+  lock(EXCLUSIVE);
+
+  Waiter waiter { nullptr, waitersTail, predicate, 0 };
+  addWaiter(waiter);
+  KJ_DEFER(removeWaiter(waiter));  // With the lock held, either way.
+
+  if (!predicate.check()) {
+    unlock(EXCLUSIVE, &waiter);
+
+    // Wait for an unlocking thread to hand us the lock.
+    while (__atomic_load_n(&waiter.futex, __ATOMIC_ACQUIRE) == 0) {
+      syscall(SYS_futex, &waiter.futex, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+    }
+  }
+}
+
 void Mutex::assertLockedByCaller(Exclusivity exclusivity) {
   switch (exclusivity) {
     case EXCLUSIVE:
@@ -237,9 +301,16 @@ void Mutex::lock(Exclusivity exclusivity) {
   }
 }
 
-void Mutex::unlock(Exclusivity exclusivity) {
+void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
   switch (exclusivity) {
     case EXCLUSIVE:
+      // Wake any lockWhen() that can now proceed.  It re-checks its predicate once it has the
+      // lock, in case another thread got there first.
+      for (Waiter* waiter = waitersHead; waiter != nullptr; waiter = waiter->next) {
+        if (waiter != waiterToSkip && waiter->predicate.check()) {
+          WakeConditionVariable(&waiter->condvar);
+        }
+      }
       ReleaseSRWLockExclusive(&coercedSrwLock);
       break;
     case SHARED:
@@ -248,6 +319,20 @@ void Mutex::unlock(Exclusivity exclusivity) {
   }
 }
 
+void Mutex::lockWhen(Predicate& predicate) {
+  lock(EXCLUSIVE);
+
+  Waiter waiter { nullptr, waitersTail, predicate };
+  InitializeConditionVariable(&waiter.condvar);
+  addWaiter(waiter);
+  KJ_DEFER(removeWaiter(waiter));
+
+  while (!predicate.check()) {
+    // Releases the lock while sleeping, and re-acquires it before returning.
+    SleepConditionVariableSRW(&waiter.condvar, &coercedSrwLock, INFINITE, 0);
+  }
+}
+
 void Mutex::assertLockedByCaller(Exclusivity exclusivity) {
   // We could use TryAcquireSRWLock*() here like we do with the pthread version. However, as of
   // this writing, my version of Wine (1.6.2) doesn't implement these functions and will abort if
@@ -331,10 +416,49 @@ void Mutex::lock(Exclusivity exclusivity) {
   }
 }
 
-void Mutex::unlock(Exclusivity exclusivity) {
+void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
+  if (exclusivity == EXCLUSIVE) {
+    // Wake any lockWhen() that can now proceed.  It re-checks its predicate once it has the lock,
+    // in case another thread got there first.
+    for (Waiter* waiter = waitersHead; waiter != nullptr; waiter = waiter->next) {
+      if (waiter != waiterToSkip && waiter->predicate.check()) {
+        KJ_PTHREAD_CALL(pthread_mutex_lock(&waiter->stupidMutex));
+        KJ_PTHREAD_CALL(pthread_cond_signal(&waiter->condvar));
+        KJ_PTHREAD_CALL(pthread_mutex_unlock(&waiter->stupidMutex));
+      }
+    }
+  }
+
   KJ_PTHREAD_CALL(pthread_rwlock_unlock(&mutex));
 }
 
+void Mutex::lockWhen(Predicate& predicate) {
+  lock(EXCLUSIVE);
+
+  Waiter waiter { nullptr, waitersTail, predicate };
+  KJ_PTHREAD_CALL(pthread_cond_init(&waiter.condvar, nullptr));
+  KJ_PTHREAD_CALL(pthread_mutex_init(&waiter.stupidMutex, nullptr));
+  addWaiter(waiter);
+  KJ_DEFER({
+    removeWaiter(waiter);
+    KJ_PTHREAD_CLEANUP(pthread_cond_destroy(&waiter.condvar));
+    KJ_PTHREAD_CLEANUP(pthread_mutex_destroy(&waiter.stupidMutex));
+  });
+
+  while (!predicate.check()) {
+    // Take stupidMutex before releasing the real lock, so that an unlocking thread can't signal
+    // us before we are waiting on the condvar.
+    KJ_PTHREAD_CALL(pthread_mutex_lock(&waiter.stupidMutex));
+    unlock(EXCLUSIVE, &waiter);
+    KJ_PTHREAD_CALL(pthread_cond_wait(&waiter.condvar, &waiter.stupidMutex));
+
+    // Release stupidMutex before re-locking, since an unlocking thread holds the real lock while
+    // it waits for stupidMutex.
+    KJ_PTHREAD_CALL(pthread_mutex_unlock(&waiter.stupidMutex));
+    lock(EXCLUSIVE);
+  }
+}
+
 void Mutex::assertLockedByCaller(Exclusivity exclusivity) {
   switch (exclusivity) {
     case EXCLUSIVE:
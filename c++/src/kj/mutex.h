@@ -62,12 +62,31 @@ public:
   void lock(Exclusivity exclusivity);
   void unlock(Exclusivity exclusivity);
 
+  class Predicate {
+  public:
+    virtual bool check() = 0;
+    // Must not throw.
+  };
+
+  void lockWhen(Predicate& predicate);
+  // Lock (exclusively) when predicate.check() returns true.
+
   void assertLockedByCaller(Exclusivity exclusivity);
   // In debug mode, assert that the mutex is locked by the calling thread, or if that is
   // non-trivial, assert that the mutex is locked (which should be good enough to catch problems
   // in unit tests).  In non-debug builds, do nothing.
 
 private:
+  struct Waiter;
+  Waiter* waitersHead = nullptr;
+  Waiter** waitersTail = &waitersHead;
+  // Threads blocked in lockWhen(), in the order they started waiting.  Only touched while the
+  // mutex is held exclusively.
+
+  void addWaiter(Waiter& waiter);
+  void removeWaiter(Waiter& waiter);
+  void unlock(Exclusivity exclusivity, Waiter* waiterToSkip);
+
 #if KJ_USE_FUTEX
   uint futex;
   // bit 31 (msb) = set if exclusive lock held
@@ -249,6 +268,33 @@ public:
   inline T& getAlreadyLockedExclusive() const;
   // Like `getWithoutLock()`, but asserts that the lock is already held by the calling thread.
 
+  template <typename Cond, typename Func>
+  auto when(Cond&& condition, Func&& callback) const -> decltype(callback(instance<T&>())) {
+    // Waits until condition(state) returns true, then calls callback(state) under an exclusive
+    // lock and returns its result.
+    //
+    // `condition` receives a const reference to the state and is called with the lock held.  It
+    // is re-checked each time another thread releases an exclusive lock, so it must be cheap, must
+    // not throw, and should be a pure function of the state.  It may be called from any thread.
+
+    struct PredicateImpl final: public _::Mutex::Predicate {
+      bool check() override {
+        return condition(value);
+      }
+
+      Cond&& condition;
+      const T& value;
+
+      PredicateImpl(Cond&& condition, const T& value)
+          : condition(kj::fwd<Cond>(condition)), value(value) {}
+    };
+
+    PredicateImpl impl(kj::fwd<Cond>(condition), value);
+    mutex.lockWhen(impl);
+    KJ_DEFER(mutex.unlock(_::Mutex::EXCLUSIVE));
+    return callback(value);
+  }
+
 private:
   mutable _::Mutex mutex;
   mutable T value;
@@ -126,8 +126,12 @@ private:
   ArrayPtr<const char> content;
 };
 
+#if !__cpp_impl_three_way_comparison
+// C++20 considers the reversed form of the member operators instead, and would find these
+// recursively.
 inline bool operator==(const char* a, const StringPtr& b) { return b == a; }
 inline bool operator!=(const char* a, const StringPtr& b) { return b != a; }
+#endif
 
 template <> char StringPtr::parseAs<char>() const;
 template <> signed char StringPtr::parseAs<signed char>() const;
@@ -212,8 +216,10 @@ private:
   Array<char> content;
 };
 
+#if !__cpp_impl_three_way_comparison
 inline bool operator==(const char* a, const String& b) { return b == a; }
 inline bool operator!=(const char* a, const String& b) { return b != a; }
+#endif
 
 String heapString(size_t size);
 // Allocate a String of the given size on the heap, not including NUL terminator.  The NUL
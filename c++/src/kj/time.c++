@@ -20,13 +20,46 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN 1  // lolz
+#endif
+
 #include "time.h"
 #include "debug.h"
 
+#if _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
 namespace kj {
 
 kj::Exception Timer::makeTimeoutException() {
   return KJ_EXCEPTION(OVERLOADED, "operation timed out");
 }
 
+TimePoint systemSteadyTime() {
+#if _WIN32
+  static const int64_t frequency = []() {
+    LARGE_INTEGER result;
+    QueryPerformanceFrequency(&result);
+    return result.QuadPart;
+  }();
+
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+
+  // Convert whole seconds separately, so that the multiplication can't overflow.
+  int64_t seconds = counter.QuadPart / frequency;
+  int64_t remainder = counter.QuadPart % frequency;
+  return origin<TimePoint>() + seconds * SECONDS +
+      remainder * 1000000000 / frequency * NANOSECONDS;
+#else
+  struct timespec ts;
+  KJ_SYSCALL(clock_gettime(CLOCK_MONOTONIC, &ts));
+  return origin<TimePoint>() + ts.tv_sec * SECONDS + ts.tv_nsec * NANOSECONDS;
+#endif
+}
+
 }  // namespace kj
@@ -59,6 +59,11 @@ using Date = Absolute<Duration, _::DateLabel>;
 // A point in real-world time, measured relative to the Unix epoch (Jan 1, 1970 00:00:00 UTC).
 
 constexpr Date UNIX_EPOCH = origin<Date>();
+
+TimePoint systemSteadyTime();
+// Reads the system's monotonic clock, which is also the clock behind `UnixEventPort`'s timer.
+// Unlike `Timer::now()`, which only advances when the event loop waits, this reads the clock
+// afresh on every call, so it can time work done within a single turn of the loop.
 // The `Date` representing Jan 1, 1970 00:00:00 UTC.
 
 class Timer {
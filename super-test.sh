@@ -8,6 +8,7 @@ doit() {
 }
 
 QUICK=
+CXX20=
 
 while [ $# -gt 0 ]; do
   case "$1" in
@@ -65,6 +66,9 @@ while [ $# -gt 0 ]; do
     clang )
       export CXX=clang++
       ;;
+    c++20 )
+      CXX20=yes
+      ;;
     gcc-4.9 )
       export CXX=g++-4.9
       ;;
@@ -180,6 +184,7 @@ while [ $# -gt 0 ]; do
       echo "commands:"
       echo "  test          Runs tests (the default)."
       echo "  clang         Runs tests using Clang compiler."
+      echo "  c++20         Compiles as C++20, which also runs the coroutine tests."
       echo "  gcc-4.7       Runs tests using gcc-4.7."
       echo "  gcc-4.8       Runs tests using gcc-4.8."
       echo "  gcc-4.9       Runs tests using gcc-4.9."
@@ -216,6 +221,18 @@ export PATH=$STAGING/bin:$PATH
 export LD_LIBRARY_PATH=$STAGING/lib${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}
 export PKG_CONFIG_PATH=$STAGING/lib/pkgconfig
 
+if [ "$CXX20" = yes ]; then
+  export CXXFLAGS="$CXXFLAGS -std=c++20"
+
+  # Coroutine support is compiled only where the compiler handles it (see async-prelude.h).  Make
+  # sure this one does, so that the coroutine tests aren't silently skipped.
+  if ! (${CXX:-g++} $CXXFLAGS -Ic++/src -dM -E -x c++ c++/src/kj/async-prelude.h 2>/dev/null | \
+      grep -q 'define KJ_HAS_COROUTINE 1'); then
+    echo "${CXX:-g++} does not support kj coroutines; use clang or GCC 13 or later." >&2
+    exit 1
+  fi
+fi
+
 if [ "$QUICK" = quick ]; then
   echo "************************** QUICK TEST ***********************************"
 fi